@@ -14,6 +14,7 @@
 #define ABCG_HPP_
 
 #include "abcgApplication.hpp"
+#include "abcgBakedAsset.hpp"
 #include "abcgException.hpp"
 #include "abcgExternal.hpp"
 #include "abcgTrackball.hpp"
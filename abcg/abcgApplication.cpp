@@ -13,9 +13,20 @@
 #include <SDL_image.h>
 #include <SDL_thread.h>
 
+#include <charconv>
+#include <cstdlib>
+#include <optional>
+#include <random>
 #include <span>
+#include <string_view>
+#include <utility>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
 
 #include "abcgException.hpp"
+#include "abcgProfiler.hpp"
+#include "abcgTimer.hpp"
 #include "abcgWindow.hpp"
 
 #if defined(__EMSCRIPTEN__)
@@ -44,8 +55,13 @@ void abcg::mainLoopCallback(void *userData) {
  * of which the last one is nullptr and the previous ones, if any, point to
  * null-terminated multibyte strings that represent the arguments passed to the
  * program from the execution environment.
+ *
+ * @throw abcg::RuntimeError if a command-line option recognized by
+ * abcg::ApplicationSettings has an invalid value, if `--headless` is given
+ * without `--frames`, `--benchmark` or `--replay`, or if the input log to be
+ * recorded or replayed cannot be opened.
  */
-abcg::Application::Application([[maybe_unused]] int argc, char **argv) {
+abcg::Application::Application(int argc, char **argv) {
   // Get executable relative path
   std::string const argv_str{*std::span{&argv, 1}[0]};
 #if defined(WIN32)
@@ -61,13 +77,86 @@ abcg::Application::Application([[maybe_unused]] int argc, char **argv) {
 #endif
 
   abcg::Application::m_assetsPath = abcg::Application::m_basePath + "/assets/";
+
+  // Parse command-line options
+  std::optional<std::uint64_t> randomSeed;
+  std::span const args{argv, gsl::narrow<std::size_t>(argc)};
+  for (std::size_t index{1}; index < args.size(); ++index) {
+    std::string_view const arg{args[index]};
+    auto const nextValue{[&]() -> std::string_view {
+      if (++index == args.size()) {
+        throw abcg::RuntimeError(fmt::format("Missing value for {}", arg));
+      }
+      return args[index];
+    }};
+    auto const nextCount{[&](auto &count) {
+      auto const value{nextValue()};
+      auto const *const last{value.data() + value.size()};
+      if (auto const [ptr, ec]{std::from_chars(value.data(), last, count)};
+          ec != std::errc{} || ptr != last) {
+        throw abcg::RuntimeError(
+            fmt::format("Invalid value for {}: {}", arg, value));
+      }
+    }};
+
+    if (arg == "--headless") {
+      m_settings.headless = true;
+    } else if (arg == "--frames") {
+      nextCount(m_settings.frameCount);
+    } else if (arg == "--trace") {
+      m_settings.tracePath = nextValue();
+    } else if (arg == "--warmup") {
+      nextCount(m_settings.warmupFrames);
+    } else if (arg == "--benchmark") {
+      m_settings.benchmarkPath = nextValue();
+    } else if (arg == "--record") {
+      m_settings.recordPath = nextValue();
+    } else if (arg == "--replay") {
+      m_settings.replayPath = nextValue();
+    } else if (arg == "--fixed-delta") {
+      auto const value{nextValue()};
+      std::string const text{value};
+      char *last{};
+      m_settings.fixedDeltaTime = std::strtod(text.c_str(), &last);
+      if (last != text.c_str() + text.size() ||
+          m_settings.fixedDeltaTime < 0.0) {
+        throw abcg::RuntimeError(
+            fmt::format("Invalid value for {}: {}", arg, value));
+      }
+    } else if (arg == "--seed") {
+      std::uint64_t seed{};
+      nextCount(seed);
+      randomSeed = seed;
+    } else if (arg == "--hot-reload") {
+      m_settings.hotReload = true;
+    }
+  }
+
+  // A hidden window cannot be closed by the user, so headless runs must end
+  // by themselves
+  if (m_settings.headless && m_settings.frameCount == 0 &&
+      m_settings.benchmarkPath.empty() && m_settings.replayPath.empty()) {
+    throw abcg::RuntimeError("--headless requires --frames, --benchmark or "
+                             "--replay");
+  }
+
+  if (!m_settings.replayPath.empty()) {
+    m_inputPlayer = std::make_unique<InputPlayer>(m_settings.replayPath);
+    randomSeed = m_inputPlayer->getRandomSeed();
+  }
+  m_settings.randomSeed = randomSeed.value_or(std::random_device{}());
+
+  if (!m_settings.recordPath.empty()) {
+    m_inputRecorder = std::make_unique<InputRecorder>(m_settings.recordPath,
+                                                      m_settings.randomSeed);
+  }
 }
 
 /**
  * @brief Runs the application for the given window.
  *
- * Initializes the SDL library and its subsystems, initializes the window and
- * runs the event loop.
+ * Initializes the SDL library and its subsystems, creates the job system,
+ * initializes the window and runs the event loop.
  *
  * @param window L-value reference to the window object.
  *
@@ -75,6 +164,11 @@ abcg::Application::Application([[maybe_unused]] int argc, char **argv) {
  * @throw abcg::SDLImageError if `IMG_Init` failed.
  */
 void abcg::Application::run(Window &window) {
+  if (m_settings.headless) {
+    // Has lower priority than the SDL_VIDEODRIVER environment variable
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+  }
+
   if (Uint32 const subsystemMask{SDL_INIT_VIDEO | SDL_INIT_AUDIO |
                                  SDL_INIT_GAMECONTROLLER};
       SDL_Init(subsystemMask) != 0) {
@@ -90,19 +184,55 @@ void abcg::Application::run(Window &window) {
   }
 #endif
 
+  Profiler::setThreadName("Main");
+  if (!m_settings.tracePath.empty()) {
+    // Also capture the zones of window creation, such as asset loading
+    Profiler::startCapture(m_settings.tracePath);
+    Profiler::setEnabled(true);
+  }
+
+  if (!m_settings.benchmarkPath.empty()) {
+    constexpr std::size_t defaultMeasuredFrames{600};
+    m_benchmark = std::make_unique<Benchmark>(
+        m_settings.warmupFrames, m_settings.frameCount > 0
+                                     ? m_settings.frameCount
+                                     : defaultMeasuredFrames);
+  }
+
+  m_jobSystem = std::make_unique<JobSystem>();
+
   m_window = &window;
+  m_window->m_jobSystem = m_jobSystem.get();
   m_window->templateCreate();
 
 #if defined(__EMSCRIPTEN__)
   emscripten_set_main_loop_arg(mainLoopCallback, this, 0, true);
 #else
+  Timer loopTime;
   auto done{false};
   while (!done) {
     mainLoopIterator(done);
   };
+
+  if (m_settings.headless && m_frameCount > 0) {
+    auto const elapsed{loopTime.elapsed()};
+    fmt::print("Rendered {} frames in {:.3f} s ({:.3f} ms/frame)\n",
+               m_frameCount, elapsed,
+               elapsed * 1000.0 / static_cast<double>(m_frameCount));
+  }
+
+  if (m_benchmark) {
+    m_benchmark->writeReport(m_settings.benchmarkPath,
+                             m_window->getWindowSettings().title);
+    m_benchmark.reset();
+  }
 #endif
 
   m_window->templateDestroy();
+  m_window->m_jobSystem = nullptr;
+  m_jobSystem.reset();
+
+  Profiler::stopCapture();
 
 #if !defined(__EMSCRIPTEN__)
   IMG_Quit();
@@ -110,14 +240,96 @@ void abcg::Application::run(Window &window) {
   SDL_Quit();
 }
 
-void abcg::Application::mainLoopIterator([[maybe_unused]] bool &done) const {
-  SDL_Event event{};
-  while (SDL_PollEvent(&event) != 0) {
+void abcg::Application::mainLoopIterator([[maybe_unused]] bool &done) {
+  auto const frame{gsl::narrow_cast<std::uint32_t>(m_frameCount)};
+
+  {
+    ABCG_PROFILE_SCOPE("Events");
+    SDL_Event event{};
+
+    if (m_benchmark) {
+      m_benchmarkScenario.inject(m_frameCount, m_window->getSDLWindow());
+    }
+
+    if (m_inputPlayer) {
+      for (auto const &recorded :
+           m_inputPlayer->getEvents(frame, m_window->getSDLWindowID())) {
+        m_window->templateHandleEvent(recorded, done);
+      }
+    }
+
 #if !defined(__EMSCRIPTEN__)
-    if (event.type == SDL_QUIT)
-      done = true;
+    // Block until an event arrives or the timeout expires
+    if (auto const timeout{m_window->templateGetEventTimeout()};
+        timeout > 0) {
+      Timer const waitTime;
+      auto const hasEvent{SDL_WaitEventTimeout(&event, timeout) != 0};
+      // The time spent blocked is not part of the frame time
+      m_window->m_idleTime += waitTime.elapsed();
+      if (hasEvent) {
+        handleEvent(event, done);
+      }
+    }
 #endif
-    m_window->templateHandleEvent(event, done);
+
+    while (SDL_PollEvent(&event) != 0) {
+      handleEvent(event, done);
+    }
   }
+
+  if (m_settings.fixedDeltaTime > 0.0) {
+    m_window->m_drivenDeltaTime = m_settings.fixedDeltaTime;
+  } else if (m_inputPlayer) {
+    m_window->m_drivenDeltaTime = m_inputPlayer->getDeltaTime(frame);
+  }
+
   m_window->templatePaint();
+
+  if (m_inputRecorder) {
+    m_inputRecorder->writeFrame(frame, m_window->getDeltaTime());
+  }
+
+  ++m_frameCount;
+  if (m_benchmark) {
+    m_benchmark->endFrame();
+    if (m_benchmark->isDone())
+      done = true;
+  } else if (m_frameCount == m_settings.frameCount) {
+    done = true;
+  }
+
+  if (m_inputPlayer && m_inputPlayer->isFinished(frame + 1))
+    done = true;
+}
+
+void abcg::Application::handleEvent(SDL_Event const &event,
+                                    [[maybe_unused]] bool &done) {
+#if !defined(__EMSCRIPTEN__)
+  if (event.type == SDL_QUIT)
+    done = true;
+#endif
+
+  if (isInputEvent(event)) {
+    // While replaying, input events come from the log only
+    if (m_inputPlayer)
+      return;
+    if (m_inputRecorder) {
+      auto const frame{gsl::narrow_cast<std::uint32_t>(m_frameCount)};
+      m_inputRecorder->writeEvent(frame, event);
+    }
+  }
+
+  m_window->templateHandleEvent(event, done);
+}
+
+/**
+ * @brief Sets the input events to be injected during a benchmark run.
+ *
+ * The scenario has no effect unless abcg::ApplicationSettings::benchmarkPath
+ * is set, so that the same executable can be run interactively.
+ *
+ * @param scenario Scripted sequence of input events.
+ */
+void abcg::Application::setBenchmarkScenario(BenchmarkScenario scenario) {
+  m_benchmarkScenario = std::move(scenario);
 }
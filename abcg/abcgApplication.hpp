@@ -11,8 +11,15 @@
 #ifndef ABCG_APPLICATION_HPP_
 #define ABCG_APPLICATION_HPP_
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 
+#include "abcgBenchmark.hpp"
+#include "abcgInputRecorder.hpp"
+#include "abcgJobSystem.hpp"
+
 #define ABCG_VERSION_MAJOR 3
 #define ABCG_VERSION_MINOR 0
 #define ABCG_VERSION_PATCH 0
@@ -22,12 +29,137 @@
  */
 namespace abcg {
 class Application;
+struct ApplicationSettings;
 class Window;
 #if defined(__EMSCRIPTEN__)
 void mainLoopCallback(void *userData);
 #endif
 } // namespace abcg
 
+/**
+ * @brief Application settings parsed from the command line.
+ *
+ * The following command-line options are recognized by
+ * abcg::Application::Application. Any other argument is ignored.
+ *
+ * - `--headless`: sets abcg::ApplicationSettings::headless;
+ * - `--frames <N>`: sets abcg::ApplicationSettings::frameCount to `N`;
+ * - `--trace <path>`: sets abcg::ApplicationSettings::tracePath to `path`;
+ * - `--warmup <N>`: sets abcg::ApplicationSettings::warmupFrames to `N`;
+ * - `--benchmark <path>`: sets abcg::ApplicationSettings::benchmarkPath to
+ *   `path`;
+ * - `--record <path>`: sets abcg::ApplicationSettings::recordPath to `path`;
+ * - `--replay <path>`: sets abcg::ApplicationSettings::replayPath to `path`;
+ * - `--fixed-delta <seconds>`: sets abcg::ApplicationSettings::fixedDeltaTime
+ *   to `seconds`;
+ * - `--seed <N>`: sets abcg::ApplicationSettings::randomSeed to `N`;
+ * - `--hot-reload`: sets abcg::ApplicationSettings::hotReload.
+ */
+struct abcg::ApplicationSettings {
+  /**
+   * @brief Whether to run without a visible window.
+   *
+   * In headless mode, the SDL offscreen video driver is used (unless
+   * overridden by the `SDL_VIDEODRIVER` environment variable), the window is
+   * created hidden, and vertical synchronization is disabled. With the
+   * offscreen driver, OpenGL windows render to an EGL pbuffer surface and
+   * therefore do not require a display server. Vulkan windows create no
+   * surface and no swapchain; their frames are rendered to offscreen images.
+   *
+   * A headless run must end by itself: abcg::Application::Application throws
+   * abcg::RuntimeError if this is `true` and neither
+   * abcg::ApplicationSettings::frameCount,
+   * abcg::ApplicationSettings::benchmarkPath nor
+   * abcg::ApplicationSettings::replayPath is set.
+   */
+  bool headless{};
+  /**
+   * @brief Number of frames to render before exiting the application, or 0
+   * to run until the user quits.
+   *
+   * Must be greater than 0 in headless runs that are neither benchmark runs
+   * nor replays. In a benchmark run, this is the number of measured frames,
+   * not including the warm-up frames. If 0, 600 frames are measured.
+   */
+  std::size_t frameCount{};
+  /**
+   * @brief Path of a trace file to capture all frames to, or an empty string
+   * to not capture at startup.
+   *
+   * Captures can also be started and stopped at any time by pressing F12.
+   *
+   * @sa abcg::Profiler::startCapture.
+   */
+  std::string tracePath{};
+  /**
+   * @brief Number of frames rendered before the measured frames of a
+   * benchmark run.
+   */
+  std::size_t warmupFrames{};
+  /**
+   * @brief Path of a JSON file to write the results of a benchmark run to, or
+   * an empty string to not run a benchmark.
+   *
+   * In a benchmark run, the profiler is enabled, the main loop never blocks
+   * waiting for events, the events of the scenario set with
+   * abcg::Application::setBenchmarkScenario are injected, and the application
+   * exits after the measured frames.
+   *
+   * @sa abcg::Benchmark.
+   */
+  std::string benchmarkPath{};
+  /**
+   * @brief Path of a log file to record the input events and frame times to,
+   * or an empty string to not record.
+   *
+   * @sa abcg::InputRecorder.
+   */
+  std::string recordPath{};
+  /**
+   * @brief Path of a log file recorded with
+   * abcg::ApplicationSettings::recordPath to replay, or an empty string to
+   * not replay.
+   *
+   * While replaying, the input events of the user are ignored, the recorded
+   * events are handled on the frames they were recorded on, the delta time of
+   * each frame is the recorded one, and the application exits after the last
+   * recorded frame. abcg::ApplicationSettings::randomSeed is set to the seed
+   * of the recorded run.
+   *
+   * @sa abcg::InputPlayer.
+   */
+  std::string replayPath{};
+  /**
+   * @brief Delta time, in seconds, of every frame, or 0 to measure the delta
+   * time of each frame.
+   *
+   * If greater than zero, abcg::Window::getDeltaTime returns this value
+   * regardless of the actual frame time, and abcg::Window::getElapsedTime
+   * returns the sum of the delta times. This takes precedence over the delta
+   * times of a replay.
+   */
+  double fixedDeltaTime{};
+  /**
+   * @brief Seed for the random number generators of the application.
+   *
+   * If not set with `--seed` or by a replay, this is a nondeterministic value.
+   * Seed the random number generators (e.g., `std::srand` or a
+   * `std::default_random_engine`) with this value so that replays reproduce
+   * the recorded run.
+   */
+  std::uint64_t randomSeed{};
+  /**
+   * @brief Whether to rebuild shaders when their files change.
+   *
+   * OpenGL programs requested through abcg::OpenGLProgramRegistry and shaders
+   * added to abcg::VulkanShaderReloader are rebuilt in the background and
+   * replaced at a frame boundary only if the build succeeds.
+   *
+   * @sa abcg::FileWatcher.
+   */
+  bool hotReload{};
+};
+
 /**
  * @brief Manages the application's control flow.
  *
@@ -39,6 +171,7 @@ public:
   Application(int argc, char **argv);
 
   void run(Window &window);
+  void setBenchmarkScenario(BenchmarkScenario scenario);
 
   /**
    * @brief Returns the path to the application's assets directory, relative to
@@ -73,10 +206,27 @@ public:
    */
   [[nodiscard]] static std::string const &getBasePath() { return m_basePath; }
 
+  /**
+   * @brief Returns the application settings parsed from the command line.
+   *
+   * @return Settings parsed by abcg::Application::Application.
+   */
+  [[nodiscard]] static ApplicationSettings const &getSettings() {
+    return m_settings;
+  }
+
 private:
-  void mainLoopIterator(bool &done) const;
+  void mainLoopIterator(bool &done);
+  void handleEvent(SDL_Event const &event, bool &done);
+
+  std::size_t m_frameCount{};
 
   Window *m_window{};
+  std::unique_ptr<JobSystem> m_jobSystem;
+  std::unique_ptr<Benchmark> m_benchmark;
+  BenchmarkScenario m_benchmarkScenario;
+  std::unique_ptr<InputRecorder> m_inputRecorder;
+  std::unique_ptr<InputPlayer> m_inputPlayer;
 
 #if defined(__EMSCRIPTEN__)
   friend void mainLoopCallback(void *userData);
@@ -86,6 +236,7 @@ private:
   // See https://bugs.llvm.org/show_bug.cgi?id=48040
   static inline std::string m_assetsPath{};
   static inline std::string m_basePath{};
+  static inline ApplicationSettings m_settings{};
   // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 };
 
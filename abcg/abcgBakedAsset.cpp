@@ -0,0 +1,339 @@
+/**
+ * @file abcgBakedAsset.cpp
+ * @brief Definition of abcg::BakedAsset members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgBakedAsset.hpp"
+
+#include <filesystem>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include "abcgException.hpp"
+
+#if defined(__EMSCRIPTEN__)
+#include <fstream>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+bool isAligned(std::uint64_t offset) {
+  return offset % abcg::bakedAssetAlignment == 0;
+}
+
+// Returns whether [offset, offset + size) lies within a file of the given size
+bool isInside(std::uint64_t offset, std::uint64_t size,
+              std::uint64_t fileSize) {
+  return offset <= fileSize && size <= fileSize - offset;
+}
+} // namespace
+
+/**
+ * @brief Returns whether a file is a baked asset.
+ *
+ * Only the extension of the file name is checked.
+ *
+ * @param path Path to the file.
+ *
+ * @return `true` if the extension is abcg::bakedAssetExtension.
+ */
+bool abcg::isBakedAsset(std::string_view path) {
+  return std::filesystem::path{path}.extension() == bakedAssetExtension;
+}
+
+/**
+ * @brief Returns the path of the baked version of an asset, if it exists.
+ *
+ * `abcg_bake` writes the baked version of `assets/foo.png` to
+ * `assets/foo.png.baked`.
+ *
+ * @param path Path to the source asset.
+ *
+ * @return Path to the baked asset, or an empty string if there is no baked
+ * version of @a path.
+ */
+std::string abcg::findBakedAsset(std::string_view path) {
+  if (path.empty() || isBakedAsset(path))
+    return {};
+  auto bakedPath{fmt::format("{}{}", path, bakedAssetExtension)};
+  std::error_code error;
+  if (!std::filesystem::is_regular_file(bakedPath, error))
+    return {};
+  return bakedPath;
+}
+
+/**
+ * @brief Closes the file.
+ */
+abcg::BakedAsset::~BakedAsset() { close(); }
+
+/**
+ * @brief Maps a baked asset into memory.
+ *
+ * The file previously open, if any, is closed.
+ *
+ * @param path Path to the file written by `abcg_bake`.
+ *
+ * @throw abcg::RuntimeError if the file cannot be read, or if it is not a
+ * baked asset of the current version.
+ */
+void abcg::BakedAsset::open(std::string_view path) {
+  close();
+
+  auto const fail{[path]() {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to open baked asset {}", path));
+  }};
+
+#if defined(__EMSCRIPTEN__)
+  std::ifstream stream{std::string{path}, std::ios::binary | std::ios::ate};
+  if (!stream)
+    fail();
+  m_buffer.resize(gsl::narrow<std::size_t>(stream.tellg()));
+  stream.seekg(0);
+  if (!stream.read(reinterpret_cast<char *>(m_buffer.data()),
+                   gsl::narrow<std::streamsize>(m_buffer.size())))
+    fail();
+  m_data = m_buffer;
+#elif defined(_WIN32)
+  m_file = CreateFileA(std::string{path}.c_str(), GENERIC_READ,
+                       FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+  LARGE_INTEGER size{};
+  if (m_file == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    fail();
+  }
+  if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+    close();
+    fail();
+  }
+  m_mapping =
+      CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void const *view{m_mapping == nullptr
+                       ? nullptr
+                       : MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)};
+  if (view == nullptr) {
+    close();
+    fail();
+  }
+  m_data = {static_cast<std::byte const *>(view),
+            gsl::narrow<std::size_t>(size.QuadPart)};
+#else
+  auto const file{::open(std::string{path}.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (file < 0)
+    fail();
+  struct stat status {};
+  if (fstat(file, &status) != 0 || status.st_size == 0) {
+    ::close(file);
+    fail();
+  }
+  auto const size{gsl::narrow<std::size_t>(status.st_size)};
+  auto *const view{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0)};
+  // The mapping remains valid after the descriptor is closed
+  ::close(file);
+  if (view == MAP_FAILED)
+    fail();
+  m_data = {static_cast<std::byte const *>(view), size};
+#endif
+
+  try {
+    validate(path);
+  } catch (...) {
+    close();
+    throw;
+  }
+}
+
+/**
+ * @brief Unmaps the file.
+ *
+ * Views previously returned by the member functions become invalid.
+ */
+void abcg::BakedAsset::close() noexcept {
+#if defined(__EMSCRIPTEN__)
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+#elif defined(_WIN32)
+  if (!m_data.empty()) {
+    UnmapViewOfFile(m_data.data());
+  }
+  if (m_mapping != nullptr) {
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+  }
+  if (m_file != nullptr) {
+    CloseHandle(m_file);
+    m_file = nullptr;
+  }
+#else
+  if (!m_data.empty()) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    munmap(const_cast<std::byte *>(m_data.data()), m_data.size());
+  }
+#endif
+  m_data = {};
+}
+
+// Checks that every table and every range of data lies within the file, so
+// that the accessors need no further checks
+void abcg::BakedAsset::validate(std::string_view path) const {
+  auto const fail{[path](std::string_view reason) {
+    throw abcg::RuntimeError(
+        fmt::format("Invalid baked asset {} ({})", path, reason));
+  }};
+
+  auto const fileSize{std::uint64_t{m_data.size()}};
+  if (fileSize < sizeof(BakedAssetHeader))
+    fail("truncated header");
+  auto const &header{*at<BakedAssetHeader>(0)};
+  if (header.magic != bakedAssetMagic)
+    fail("bad signature");
+  if (header.version != bakedAssetVersion) {
+    fail(fmt::format("version {}, expected {}; bake the asset again",
+                     header.version, bakedAssetVersion));
+  }
+  if (header.fileSize != fileSize)
+    fail("truncated file");
+
+  if (header.kind == BakedAssetKind::Texture) {
+    if (!isInside(sizeof(BakedAssetHeader), sizeof(BakedTextureHeader),
+                  fileSize))
+      fail("truncated header");
+    auto const &texture{getTextureHeader()};
+    if (texture.format > static_cast<std::uint32_t>(TextureFormat::RGBA8sRGB))
+      fail("unsupported texel format");
+    if (texture.levelCount == 0 ||
+        !isInside(sizeof(BakedAssetHeader) + sizeof(BakedTextureHeader),
+                  std::uint64_t{texture.levelCount} * sizeof(BakedTextureLevel),
+                  fileSize))
+      fail("truncated level table");
+    for (auto const &level : getTextureLevels()) {
+      if (!isAligned(level.offset) ||
+          level.size != std::uint64_t{level.width} * level.height * 4 ||
+          !isInside(level.offset, level.size, fileSize))
+        fail("bad level table");
+    }
+  } else if (header.kind == BakedAssetKind::Mesh) {
+    if (!isInside(sizeof(BakedAssetHeader), sizeof(BakedMeshHeader), fileSize))
+      fail("truncated header");
+    auto const &mesh{getMeshHeader()};
+    if (mesh.vertexStride != sizeof(BakedVertex) ||
+        mesh.indexSize != sizeof(std::uint32_t) || mesh.indexCount % 3 != 0)
+      fail("unsupported vertex layout");
+    if (!isAligned(mesh.vertexOffset) || !isAligned(mesh.indexOffset) ||
+        !isInside(mesh.vertexOffset,
+                  std::uint64_t{mesh.vertexCount} * mesh.vertexStride,
+                  fileSize) ||
+        !isInside(mesh.indexOffset,
+                  std::uint64_t{mesh.indexCount} * mesh.indexSize, fileSize))
+      fail("bad data offsets");
+  } else {
+    fail("unknown kind of asset");
+  }
+}
+
+/**
+ * @brief Returns the header common to all baked assets.
+ *
+ * @return Header at the beginning of the file.
+ */
+abcg::BakedAssetHeader const &abcg::BakedAsset::getHeader() const {
+  Expects(isOpen());
+  return *at<BakedAssetHeader>(0);
+}
+
+/**
+ * @brief Returns the description of a baked texture.
+ *
+ * @return Header of the texture.
+ */
+abcg::BakedTextureHeader const &abcg::BakedAsset::getTextureHeader() const {
+  Expects(getHeader().kind == BakedAssetKind::Texture);
+  return *at<BakedTextureHeader>(sizeof(BakedAssetHeader));
+}
+
+/**
+ * @brief Returns the texel format of a baked texture.
+ *
+ * @return abcg::TextureFormat::RGBA8 or abcg::TextureFormat::RGBA8sRGB.
+ */
+abcg::TextureFormat abcg::BakedAsset::getTextureFormat() const {
+  return static_cast<TextureFormat>(getTextureHeader().format);
+}
+
+/**
+ * @brief Returns the mipmap levels of a baked texture.
+ *
+ * @return Levels, from the base level to the smallest level.
+ */
+std::span<abcg::BakedTextureLevel const>
+abcg::BakedAsset::getTextureLevels() const {
+  auto const &texture{getTextureHeader()};
+  return {at<BakedTextureLevel>(sizeof(BakedAssetHeader) +
+                                sizeof(BakedTextureHeader)),
+          texture.levelCount};
+}
+
+/**
+ * @brief Returns the texels of a mipmap level of a baked texture.
+ *
+ * Rows are tightly packed, bottom row first if the texture was flipped upside
+ * down.
+ *
+ * @param level Index of the level. 0 is the base level.
+ *
+ * @return View of the texels, in place in the mapped file.
+ */
+std::span<std::byte const>
+abcg::BakedAsset::getLevelData(std::size_t level) const {
+  auto const &entry{getTextureLevels()[level]};
+  return m_data.subspan(static_cast<std::size_t>(entry.offset),
+                       static_cast<std::size_t>(entry.size));
+}
+
+/**
+ * @brief Returns the description of a baked mesh.
+ *
+ * @return Header of the mesh.
+ */
+abcg::BakedMeshHeader const &abcg::BakedAsset::getMeshHeader() const {
+  Expects(getHeader().kind == BakedAssetKind::Mesh);
+  return *at<BakedMeshHeader>(sizeof(BakedAssetHeader));
+}
+
+/**
+ * @brief Returns the vertices of a baked mesh.
+ *
+ * @return View of the vertices, in place in the mapped file.
+ */
+std::span<abcg::BakedVertex const> abcg::BakedAsset::getVertices() const {
+  auto const &mesh{getMeshHeader()};
+  return {at<BakedVertex>(mesh.vertexOffset), mesh.vertexCount};
+}
+
+/**
+ * @brief Returns the indices of a baked mesh.
+ *
+ * Each group of three indices forms a triangle.
+ *
+ * @return View of the indices, in place in the mapped file.
+ */
+std::span<std::uint32_t const> abcg::BakedAsset::getIndices() const {
+  auto const &mesh{getMeshHeader()};
+  return {at<std::uint32_t>(mesh.indexOffset), mesh.indexCount};
+}
@@ -0,0 +1,250 @@
+/**
+ * @file abcgBakedAsset.hpp
+ * @brief Header file of abcg::BakedAsset.
+ *
+ * Declaration of abcg::BakedAsset and of the binary layout of the files
+ * written by the `abcg_bake` tool.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_BAKED_ASSET_HPP_
+#define ABCG_BAKED_ASSET_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "abcgTextureContainer.hpp"
+
+namespace abcg {
+enum class BakedAssetKind : std::uint32_t;
+struct BakedAssetHeader;
+struct BakedTextureHeader;
+struct BakedTextureLevel;
+struct BakedMeshHeader;
+struct BakedVertex;
+class BakedAsset;
+
+/** @brief Signature at the beginning of every baked asset. */
+inline constexpr std::array<char, 8> bakedAssetMagic{'A', 'B', 'C', 'G',
+                                                     'B', 'A', 'K', 'E'};
+/** @brief Version of the layout written by `abcg_bake`. */
+inline constexpr std::uint32_t bakedAssetVersion{1};
+/** @brief Alignment, in bytes, of the texel, vertex and index data. */
+inline constexpr std::size_t bakedAssetAlignment{256};
+/** @brief Extension appended to the path of a source asset once baked. */
+inline constexpr std::string_view bakedAssetExtension{".baked"};
+
+[[nodiscard]] bool isBakedAsset(std::string_view path);
+[[nodiscard]] std::string findBakedAsset(std::string_view path);
+} // namespace abcg
+
+/**
+ * @brief Enumeration of the kinds of baked assets.
+ */
+enum class abcg::BakedAssetKind : std::uint32_t {
+  /** @brief 2D texture with its mipmap levels. */
+  Texture = 1,
+  /** @brief Indexed triangle mesh. */
+  Mesh = 2
+};
+
+/**
+ * @brief Header at offset 0 of a baked asset.
+ *
+ * The header is followed by an abcg::BakedTextureHeader or an
+ * abcg::BakedMeshHeader, depending on abcg::BakedAssetHeader::kind. All values
+ * are stored in the byte order of the machine that baked the asset.
+ */
+struct abcg::BakedAssetHeader {
+  /** @brief Equal to abcg::bakedAssetMagic. */
+  std::array<char, 8> magic{};
+  /** @brief Equal to abcg::bakedAssetVersion. */
+  std::uint32_t version{};
+  /** @brief Kind of asset. */
+  BakedAssetKind kind{};
+  /** @brief Size of the file, in bytes. */
+  std::uint64_t fileSize{};
+  /** @brief Combination of abcg::BakedAssetHeader::Flags. */
+  std::uint32_t flags{};
+  /** @brief Reserved. Must be zero. */
+  std::uint32_t reserved{};
+
+  /** @brief Options the asset was baked with. */
+  enum Flags : std::uint32_t {
+    /** @brief The rows of the texture were flipped upside down. */
+    FlippedUpsideDown = 1U << 0U,
+    /** @brief The normals of the mesh were computed by `abcg_bake`. */
+    ComputedNormals = 1U << 1U,
+    /** @brief All normals of the mesh were computed from its faces, as the
+     * normalized sum of the normals of the adjacent faces, ignoring the
+     * normals of the source (`abcg_bake --recompute-normals`). */
+    RecomputedNormals = 1U << 2U,
+    /** @brief The positions of the mesh were centered on their bounding box
+     * and scaled to a diagonal of length 2 (`abcg_bake --standardize`). */
+    Standardized = 1U << 3U
+  };
+};
+
+/**
+ * @brief Description of a baked texture.
+ *
+ * Followed by abcg::BakedTextureHeader::levelCount entries of
+ * abcg::BakedTextureLevel.
+ */
+struct abcg::BakedTextureHeader {
+  /** @brief Texel format, as a value of abcg::TextureFormat. */
+  std::uint32_t format{};
+  /** @brief Width of the base level, in texels. */
+  std::uint32_t width{};
+  /** @brief Height of the base level, in texels. */
+  std::uint32_t height{};
+  /** @brief Number of mipmap levels, including the base level. */
+  std::uint32_t levelCount{};
+};
+
+/**
+ * @brief Mipmap level of a baked texture.
+ */
+struct abcg::BakedTextureLevel {
+  /** @brief Width of the level, in texels. */
+  std::uint32_t width{};
+  /** @brief Height of the level, in texels. */
+  std::uint32_t height{};
+  /** @brief Offset of the texels from the beginning of the file, in bytes.
+   * Multiple of abcg::bakedAssetAlignment. */
+  std::uint64_t offset{};
+  /** @brief Size of the level, in bytes. */
+  std::uint64_t size{};
+};
+
+/**
+ * @brief Description of a baked mesh.
+ */
+struct abcg::BakedMeshHeader {
+  /** @brief Number of vertices. */
+  std::uint32_t vertexCount{};
+  /** @brief Number of indices. Multiple of 3. */
+  std::uint32_t indexCount{};
+  /** @brief Size of each vertex, in bytes. Equal to sizeof(BakedVertex). */
+  std::uint32_t vertexStride{};
+  /** @brief Size of each index, in bytes. Equal to sizeof(std::uint32_t). */
+  std::uint32_t indexSize{};
+  /** @brief Offset of the vertices from the beginning of the file, in bytes.
+   * Multiple of abcg::bakedAssetAlignment. */
+  std::uint64_t vertexOffset{};
+  /** @brief Offset of the indices from the beginning of the file, in bytes.
+   * Multiple of abcg::bakedAssetAlignment. */
+  std::uint64_t indexOffset{};
+  /** @brief Minimum corner of the bounding box of the vertex positions. */
+  std::array<float, 3> boundsMin{};
+  /** @brief Maximum corner of the bounding box of the vertex positions. */
+  std::array<float, 3> boundsMax{};
+};
+
+/**
+ * @brief Vertex of a baked mesh.
+ */
+struct abcg::BakedVertex {
+  /** @brief Position in object space. */
+  glm::vec3 position{};
+  /** @brief Unit normal vector. */
+  glm::vec3 normal{};
+  /** @brief Texture coordinates. */
+  glm::vec2 texCoord{};
+
+  friend bool operator==(BakedVertex const &, BakedVertex const &) = default;
+};
+
+static_assert(sizeof(abcg::BakedAssetHeader) == 32);
+static_assert(sizeof(abcg::BakedTextureHeader) == 16);
+static_assert(sizeof(abcg::BakedTextureLevel) == 24);
+static_assert(sizeof(abcg::BakedMeshHeader) == 56);
+static_assert(sizeof(abcg::BakedVertex) == 32);
+
+/**
+ * @brief Read-only view of a file written by the `abcg_bake` tool.
+ *
+ * The file is mapped into memory and validated once when it is opened. The
+ * mipmap levels, vertices and indices are then accessed in place, without
+ * copies, and can be passed directly to `glTexImage2D`, `glBufferData` or to
+ * the staging buffer of a Vulkan resource.
+ *
+ * The views returned by the member functions are valid until the asset is
+ * closed or destroyed.
+ *
+ * @remark On Emscripten, where files are stored in memory, the file is read
+ * into a buffer instead of being mapped.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::BakedAsset {
+public:
+  BakedAsset() = default;
+  BakedAsset(BakedAsset const &) = delete;
+  BakedAsset(BakedAsset &&) = delete;
+  BakedAsset &operator=(BakedAsset const &) = delete;
+  BakedAsset &operator=(BakedAsset &&) = delete;
+  ~BakedAsset();
+
+  void open(std::string_view path);
+  void close() noexcept;
+
+  /**
+   * @brief Returns whether a file is open.
+   *
+   * @return `true` if abcg::BakedAsset::open succeeded and
+   * abcg::BakedAsset::close was not called since.
+   */
+  [[nodiscard]] bool isOpen() const noexcept { return !m_data.empty(); }
+
+  [[nodiscard]] BakedAssetHeader const &getHeader() const;
+  [[nodiscard]] BakedTextureHeader const &getTextureHeader() const;
+  [[nodiscard]] TextureFormat getTextureFormat() const;
+  [[nodiscard]] std::span<BakedTextureLevel const> getTextureLevels() const;
+  [[nodiscard]] std::span<std::byte const>
+  getLevelData(std::size_t level) const;
+  [[nodiscard]] BakedMeshHeader const &getMeshHeader() const;
+  [[nodiscard]] std::span<BakedVertex const> getVertices() const;
+  [[nodiscard]] std::span<std::uint32_t const> getIndices() const;
+
+  /**
+   * @brief Returns the contents of the file.
+   *
+   * @return View of the whole file, or an empty view if no file is open.
+   */
+  [[nodiscard]] std::span<std::byte const> getData() const noexcept {
+    return m_data;
+  }
+
+private:
+  template <typename T>
+  [[nodiscard]] T const *at(std::uint64_t offset) const noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return reinterpret_cast<T const *>(
+        m_data.subspan(static_cast<std::size_t>(offset)).data());
+  }
+
+  void validate(std::string_view path) const;
+
+  std::span<std::byte const> m_data;
+#if defined(__EMSCRIPTEN__)
+  std::vector<std::byte> m_buffer;
+#elif defined(_WIN32)
+  void *m_file{};
+  void *m_mapping{};
+#endif
+};
+
+#endif
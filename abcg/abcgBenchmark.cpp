@@ -0,0 +1,383 @@
+/**
+ * @file abcgBenchmark.cpp
+ * @brief Definition of abcg::Benchmark and abcg::BenchmarkScenario members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgBenchmark.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <numeric>
+#include <ranges>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "abcgException.hpp"
+#include "abcgProfiler.hpp"
+
+namespace {
+#if defined(ABCG_BENCH_ALLOC_COUNT)
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<std::uint64_t> allocationCount{};
+#endif
+
+// Zones of the main thread that are spent waiting rather than working
+constexpr std::array waitZones{std::string_view{"Frame pacing"},
+                               std::string_view{"Wait render thread"},
+                               std::string_view{"Swap"},
+                               std::string_view{"Present"}};
+
+struct Summary {
+  double mean{};
+  double p50{};
+  double p95{};
+  double p99{};
+  double max{};
+};
+
+Summary summarize(std::vector<double> values) {
+  if (values.empty())
+    return {};
+
+  std::sort(values.begin(), values.end());
+  // Nearest-rank percentile
+  auto const percentile{[&values](double fraction) {
+    auto const rank{static_cast<std::size_t>(
+        std::ceil(fraction * static_cast<double>(values.size())))};
+    return values.at(std::clamp<std::size_t>(rank, 1, values.size()) - 1);
+  }};
+
+  return {.mean = std::accumulate(values.begin(), values.end(), 0.0) /
+                  static_cast<double>(values.size()),
+          .p50 = percentile(0.50),
+          .p95 = percentile(0.95),
+          .p99 = percentile(0.99),
+          .max = values.back()};
+}
+
+std::string toJSON(Summary const &summary) {
+  return fmt::format(R"({{"mean":{:.4f},"p50":{:.4f},"p95":{:.4f},)"
+                     R"("p99":{:.4f},"max":{:.4f}}})",
+                     summary.mean, summary.p50, summary.p95, summary.p99,
+                     summary.max);
+}
+} // namespace
+
+#if defined(ABCG_BENCH_ALLOC_COUNT)
+// Counts the allocations made through the global operator new. The array and
+// nothrow forms of the standard library call these overloads.
+void *operator new(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  if (auto *const ptr{std::malloc(size == 0 ? 1 : size)}; ptr != nullptr)
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t /*size*/) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+  std::free(ptr);
+}
+#endif
+
+/**
+ * @brief Schedules a key press.
+ *
+ * @param frame Frame index of the `SDL_KEYDOWN` event.
+ * @param key Key code.
+ * @param holdFrames Number of frames before the `SDL_KEYUP` event.
+ *
+ * @return Reference to this scenario.
+ */
+abcg::BenchmarkScenario &
+abcg::BenchmarkScenario::keyPress(std::size_t frame, SDL_Keycode key,
+                                  std::size_t holdFrames) {
+  SDL_Event event{};
+  event.key.keysym.sym = key;
+  event.key.keysym.scancode = SDL_GetScancodeFromKey(key);
+
+  event.type = SDL_KEYDOWN;
+  event.key.state = SDL_PRESSED;
+  m_events.emplace(frame, event);
+
+  event.type = SDL_KEYUP;
+  event.key.state = SDL_RELEASED;
+  m_events.emplace(frame + std::max<std::size_t>(holdFrames, 1), event);
+  return *this;
+}
+
+/**
+ * @brief Schedules a mouse motion.
+ *
+ * @param frame Frame index of the `SDL_MOUSEMOTION` event.
+ * @param position New mouse position, in window coordinates.
+ *
+ * @return Reference to this scenario.
+ */
+abcg::BenchmarkScenario &
+abcg::BenchmarkScenario::mouseMove(std::size_t frame,
+                                   glm::ivec2 const &position) {
+  SDL_Event event{};
+  event.type = SDL_MOUSEMOTION;
+  event.motion.x = position.x;
+  event.motion.y = position.y;
+  m_events.emplace(frame, event);
+  return *this;
+}
+
+/**
+ * @brief Schedules a mouse click.
+ *
+ * The mouse is moved to the given position, the button is pressed on the
+ * given frame and released on the next frame, so that Dear ImGui detects the
+ * click.
+ *
+ * @param frame Frame index of the `SDL_MOUSEBUTTONDOWN` event.
+ * @param position Mouse position, in window coordinates.
+ * @param button Mouse button (e.g., `SDL_BUTTON_LEFT`).
+ *
+ * @return Reference to this scenario.
+ */
+abcg::BenchmarkScenario &
+abcg::BenchmarkScenario::mouseClick(std::size_t frame,
+                                    glm::ivec2 const &position, Uint8 button) {
+  mouseMove(frame, position);
+
+  SDL_Event event{};
+  event.button.button = button;
+  event.button.clicks = 1;
+  event.button.x = position.x;
+  event.button.y = position.y;
+
+  event.type = SDL_MOUSEBUTTONDOWN;
+  event.button.state = SDL_PRESSED;
+  m_events.emplace(frame, event);
+
+  event.type = SDL_MOUSEBUTTONUP;
+  event.button.state = SDL_RELEASED;
+  m_events.emplace(frame + 1, event);
+  return *this;
+}
+
+/**
+ * @brief Schedules a mouse wheel motion.
+ *
+ * @param frame Frame index of the `SDL_MOUSEWHEEL` event.
+ * @param amount Vertical scroll amount. Positive values scroll away from the
+ * user.
+ *
+ * @return Reference to this scenario.
+ */
+abcg::BenchmarkScenario &
+abcg::BenchmarkScenario::mouseWheel(std::size_t frame, int amount) {
+  SDL_Event event{};
+  event.type = SDL_MOUSEWHEEL;
+  event.wheel.y = amount;
+  event.wheel.direction = SDL_MOUSEWHEEL_NORMAL;
+  m_events.emplace(frame, event);
+  return *this;
+}
+
+/**
+ * @brief Repeats the scenario with the given period.
+ *
+ * @param frames Number of frames after which the scenario restarts, or 0 to
+ * play it only once.
+ *
+ * @return Reference to this scenario.
+ */
+abcg::BenchmarkScenario &abcg::BenchmarkScenario::loop(std::size_t frames) {
+  m_loopFrames = frames;
+  return *this;
+}
+
+/**
+ * @brief Pushes the events scheduled for a frame into the SDL event queue.
+ *
+ * @param frame Frame index.
+ * @param window Window that receives the events.
+ */
+void abcg::BenchmarkScenario::inject(std::size_t frame,
+                                     SDL_Window *window) const {
+  if (m_loopFrames > 0)
+    frame %= m_loopFrames;
+
+  auto const windowID{SDL_GetWindowID(window)};
+  auto const timestamp{SDL_GetTicks()};
+  auto const [first, last]{m_events.equal_range(frame)};
+  for (auto const &[_, scheduled] : std::ranges::subrange(first, last)) {
+    auto event{scheduled};
+    event.common.timestamp = timestamp;
+    switch (event.type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      event.key.windowID = windowID;
+      break;
+    case SDL_MOUSEMOTION:
+      event.motion.windowID = windowID;
+      break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      event.button.windowID = windowID;
+      break;
+    case SDL_MOUSEWHEEL:
+      event.wheel.windowID = windowID;
+      break;
+    default:
+      break;
+    }
+    SDL_PushEvent(&event);
+  }
+}
+
+/**
+ * @brief Constructs a benchmark.
+ *
+ * @param warmupFrames Number of frames rendered before measuring.
+ * @param measuredFrames Number of measured frames.
+ */
+abcg::Benchmark::Benchmark(std::size_t warmupFrames,
+                           std::size_t measuredFrames)
+    : m_warmupFrames{warmupFrames}, m_measuredFrames{measuredFrames} {
+  m_frameTimes.reserve(m_measuredFrames);
+  m_cpuTimes.reserve(m_measuredFrames);
+  m_gpuTimes.reserve(m_measuredFrames);
+  m_allocations.reserve(m_measuredFrames);
+  m_allocationCount = getAllocationCount();
+}
+
+/**
+ * @brief Measures the frame that has just ended.
+ *
+ * Must be called after abcg::Profiler::endFrame.
+ */
+void abcg::Benchmark::endFrame() {
+  auto const allocationCount{getAllocationCount()};
+  auto const allocations{allocationCount - m_allocationCount};
+
+  if (m_frameIndex++ < m_warmupFrames || isDone() ||
+      Profiler::getFrameHistory().empty()) {
+    m_allocationCount = getAllocationCount();
+    return;
+  }
+
+  auto const &frame{Profiler::getFrameHistory().back()};
+  auto const frameTime{frame.end - frame.begin};
+  auto waitTime{0.0};
+  auto gpuTime{0.0};
+  for (auto const &zone : frame.zones) {
+    if (zone.track == frame.track &&
+        std::ranges::find(waitZones, std::string_view{zone.name}) !=
+            waitZones.end()) {
+      waitTime += zone.end - zone.begin;
+    } else if (zone.depth == 0 && isGPUTrack(zone.track)) {
+      gpuTime += zone.end - zone.begin;
+    }
+  }
+
+  m_frameTimes.push_back(frameTime * 1000.0);
+  m_cpuTimes.push_back(std::max(frameTime - waitTime, 0.0) * 1000.0);
+  m_gpuTimes.push_back(gpuTime * 1000.0);
+  m_allocations.push_back(static_cast<double>(allocations));
+
+  // Do not count the allocations of the benchmark itself
+  m_allocationCount = getAllocationCount();
+}
+
+/**
+ * @brief Writes the results of the benchmark as a JSON file.
+ *
+ * Times are given in milliseconds. A summary is also printed to the standard
+ * output.
+ *
+ * @param path Path of the JSON file.
+ * @param name Name of the benchmark.
+ *
+ * @throw abcg::RuntimeError if the file cannot be created.
+ */
+void abcg::Benchmark::writeReport(std::string_view path,
+                                  std::string_view name) const {
+  auto const frameTime{summarize(m_frameTimes)};
+  auto const cpuTime{summarize(m_cpuTimes)};
+  auto const gpuTime{summarize(m_gpuTimes)};
+  auto const allocations{isCountingAllocations()
+                               ? toJSON(summarize(m_allocations))
+                               : std::string{"null"}};
+
+  std::ofstream file{std::string{path}};
+  if (!file) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to create benchmark report {}", path));
+  }
+  file << fmt::format(
+      R"({{"name":"{}","warmupFrames":{},"frames":{},"frameTime":{},)"
+      R"("cpuTime":{},"gpuTime":{},"allocationsPerFrame":{}}})"
+      "\n",
+      name, m_warmupFrames, m_frameTimes.size(), toJSON(frameTime),
+      toJSON(cpuTime), toJSON(gpuTime), allocations);
+
+  fmt::print("{}: {} frames, frame {:.3f} ms (p50 {:.3f}, p95 {:.3f}, "
+             "p99 {:.3f}, max {:.3f}), CPU {:.3f} ms, GPU {:.3f} ms",
+             name, m_frameTimes.size(), frameTime.mean, frameTime.p50,
+             frameTime.p95, frameTime.p99, frameTime.max, cpuTime.mean,
+             gpuTime.mean);
+  if (isCountingAllocations()) {
+    fmt::print(", {:.1f} allocations/frame",
+               summarize(m_allocations).mean);
+  }
+  fmt::print("\n");
+}
+
+/**
+ * @brief Returns the number of calls to the global `operator new` since the
+ * start of the program.
+ *
+ * @return Number of allocations, or 0 if ABCg was built without
+ * `ABCG_BENCH_ALLOC_COUNT`.
+ */
+std::uint64_t abcg::Benchmark::getAllocationCount() noexcept {
+#if defined(ABCG_BENCH_ALLOC_COUNT)
+  return allocationCount.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief Returns whether allocations are counted.
+ *
+ * The global `operator new` is replaced only when ABCg is built with the
+ * `ABCG_BENCH_ALLOC_COUNT` CMake option, so that applications do not pay for
+ * the counter outside of benchmarks.
+ *
+ * @return `true` if ABCg was built with `ABCG_BENCH_ALLOC_COUNT`.
+ */
+bool abcg::Benchmark::isCountingAllocations() noexcept {
+#if defined(ABCG_BENCH_ALLOC_COUNT)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool abcg::Benchmark::isGPUTrack(std::uint32_t track) {
+  if (auto const iter{m_gpuTracks.find(track)}; iter != m_gpuTracks.end())
+    return iter->second;
+  return m_gpuTracks[track] = Profiler::getTrackName(track) == "GPU";
+}
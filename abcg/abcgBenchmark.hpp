@@ -0,0 +1,115 @@
+/**
+ * @file abcgBenchmark.hpp
+ * @brief Header file of abcg::Benchmark and abcg::BenchmarkScenario.
+ *
+ * Declaration of abcg::Benchmark and abcg::BenchmarkScenario.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_BENCHMARK_HPP_
+#define ABCG_BENCHMARK_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "abcgExternal.hpp"
+
+namespace abcg {
+class Benchmark;
+class BenchmarkScenario;
+} // namespace abcg
+
+/**
+ * @brief Scripted sequence of input events to be injected during a benchmark.
+ *
+ * Events are scheduled at frame indices counted from the first frame of the
+ * application, including the warm-up frames. Member functions return a
+ * reference to the scenario so that calls can be chained:
+ *
+ * @code
+ * app.setBenchmarkScenario(abcg::BenchmarkScenario{}
+ *                              .keyPress(30, SDLK_LEFT, 20)
+ *                              .keyPress(90, SDLK_RIGHT, 20)
+ *                              .loop(120));
+ * @endcode
+ *
+ * @sa abcg::Application::setBenchmarkScenario.
+ */
+class abcg::BenchmarkScenario {
+public:
+  BenchmarkScenario &keyPress(std::size_t frame, SDL_Keycode key,
+                              std::size_t holdFrames = 1);
+  BenchmarkScenario &mouseMove(std::size_t frame, glm::ivec2 const &position);
+  BenchmarkScenario &mouseClick(std::size_t frame, glm::ivec2 const &position,
+                                Uint8 button = SDL_BUTTON_LEFT);
+  BenchmarkScenario &mouseWheel(std::size_t frame, int amount);
+  BenchmarkScenario &loop(std::size_t frames);
+
+  void inject(std::size_t frame, SDL_Window *window) const;
+
+private:
+  std::multimap<std::size_t, SDL_Event> m_events;
+  std::size_t m_loopFrames{};
+};
+
+/**
+ * @brief Measures frame times during a benchmark run.
+ *
+ * A benchmark run renders a number of warm-up frames that are not measured,
+ * followed by the measured frames. For each measured frame, it records the
+ * frame time, the CPU time of the main thread (the frame time minus the time
+ * spent waiting for the frame pacer, the render thread or the buffer
+ * swap/present), the GPU time measured by the GPU timer of the window, and the
+ * number of calls to the global `operator new` if ABCg was built with the
+ * `ABCG_BENCH_ALLOC_COUNT` CMake option. The CPU and GPU times are
+ * taken from the zones recorded by abcg::Profiler, which is enabled during the
+ * run.
+ *
+ * abcg::Application creates a benchmark when the `--benchmark <path>` option
+ * is given.
+ *
+ * @sa abcg::ApplicationSettings::benchmarkPath.
+ */
+class abcg::Benchmark {
+public:
+  Benchmark(std::size_t warmupFrames, std::size_t measuredFrames);
+
+  void endFrame();
+
+  /**
+   * @brief Returns whether all measured frames have been rendered.
+   *
+   * @return `true` if the benchmark run is complete.
+   */
+  [[nodiscard]] bool isDone() const noexcept {
+    return m_frameTimes.size() == m_measuredFrames;
+  }
+
+  void writeReport(std::string_view path, std::string_view name) const;
+
+  [[nodiscard]] static std::uint64_t getAllocationCount() noexcept;
+  [[nodiscard]] static bool isCountingAllocations() noexcept;
+
+private:
+  [[nodiscard]] bool isGPUTrack(std::uint32_t track);
+
+  std::size_t m_warmupFrames{};
+  std::size_t m_measuredFrames{};
+  std::size_t m_frameIndex{};
+  std::uint64_t m_allocationCount{};
+  std::unordered_map<std::uint32_t, bool> m_gpuTracks;
+
+  std::vector<double> m_frameTimes;
+  std::vector<double> m_cpuTimes;
+  std::vector<double> m_gpuTimes;
+  std::vector<double> m_allocations;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file abcgFileWatcher.cpp
+ * @brief Definition of abcg::FileWatcher members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgFileWatcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#if !defined(__linux__)
+// Minimum interval, in seconds, between two checks of the modification times
+constexpr double pollInterval{0.5};
+#endif
+
+std::filesystem::file_time_type
+getWriteTime(std::filesystem::path const &path) {
+  std::error_code error;
+  auto const time{std::filesystem::last_write_time(path, error)};
+  return error ? std::filesystem::file_time_type{} : time;
+}
+} // namespace
+
+/**
+ * @brief Creates a watcher with no files.
+ */
+abcg::FileWatcher::FileWatcher() {
+#if defined(__linux__)
+  m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+/**
+ * @brief Stops watching all files.
+ */
+abcg::FileWatcher::~FileWatcher() {
+#if defined(__linux__)
+  if (m_inotify >= 0) {
+    close(m_inotify);
+  }
+#endif
+}
+
+/**
+ * @brief Starts watching a file.
+ *
+ * Watching a file more than once has no effect.
+ *
+ * @param path Path of the file.
+ */
+void abcg::FileWatcher::watch(std::filesystem::path const &path) {
+  std::error_code error;
+  auto canonical{std::filesystem::weakly_canonical(path, error)};
+  if (error) {
+    canonical = path;
+  }
+  if (m_files.contains(canonical))
+    return;
+  m_files.emplace(canonical, getWriteTime(canonical));
+
+#if defined(__linux__)
+  auto const directory{canonical.parent_path()};
+  if (m_inotify < 0 ||
+      std::any_of(m_directories.begin(), m_directories.end(),
+                  [&](auto const &entry) { return entry.second == directory; }))
+    return;
+  // Editors often save to a temporary file and rename it over the original
+  if (auto const descriptor{inotify_add_watch(
+          m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO)};
+      descriptor >= 0) {
+    m_directories.emplace(descriptor, directory);
+  }
+#endif
+}
+
+/**
+ * @brief Returns the watched files that changed since the last call.
+ *
+ * @return Canonical paths of the changed files, without duplicates.
+ */
+std::vector<std::filesystem::path> abcg::FileWatcher::poll() {
+  std::vector<std::filesystem::path> changed;
+  auto const add{[&](std::filesystem::path const &path) {
+    if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+      changed.push_back(path);
+    }
+  }};
+
+#if defined(__linux__)
+  alignas(inotify_event) std::array<char, 4096> buffer{};
+  while (m_inotify >= 0) {
+    auto const length{read(m_inotify, buffer.data(), buffer.size())};
+    if (length <= 0)
+      break;
+    for (long offset{}; offset < length;) {
+      inotify_event event{};
+      std::memcpy(&event, buffer.data() + offset, sizeof(event));
+      if (auto const iter{m_directories.find(event.wd)};
+          iter != m_directories.end() && event.len > 0) {
+        auto const path{iter->second /
+                        (buffer.data() + offset + sizeof(inotify_event))};
+        if (m_files.contains(path)) {
+          add(path);
+        }
+      }
+      offset += static_cast<long>(sizeof(inotify_event) + event.len);
+    }
+  }
+  for (auto const &path : changed) {
+    m_files.at(path) = getWriteTime(path);
+  }
+#else
+  if (m_pollTimer.elapsed() < pollInterval)
+    return changed;
+  m_pollTimer.restart();
+  for (auto &[path, writeTime] : m_files) {
+    if (auto const time{getWriteTime(path)}; time != writeTime) {
+      writeTime = time;
+      add(path);
+    }
+  }
+#endif
+
+  return changed;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file abcgFileWatcher.hpp
+ * @brief Header file of abcg::FileWatcher.
+ *
+ * Declaration of abcg::FileWatcher.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FILE_WATCHER_HPP_
+#define ABCG_FILE_WATCHER_HPP_
+
+#include <filesystem>
+#include <map>
+#include <vector>
+
+#include "abcgTimer.hpp"
+
+namespace abcg {
+class FileWatcher;
+} // namespace abcg
+
+/**
+ * @brief Watcher of changes to a set of files.
+ *
+ * On Linux, the directories of the watched files are monitored with inotify,
+ * so that files replaced by editors that save to a temporary file and rename
+ * it are also detected. On other platforms, the modification times of the
+ * files are compared at most twice per second. abcg::FileWatcher::poll never
+ * blocks.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::FileWatcher {
+public:
+  FileWatcher();
+  FileWatcher(FileWatcher const &) = delete;
+  FileWatcher(FileWatcher &&) = delete;
+  FileWatcher &operator=(FileWatcher const &) = delete;
+  FileWatcher &operator=(FileWatcher &&) = delete;
+  ~FileWatcher();
+
+  void watch(std::filesystem::path const &path);
+  [[nodiscard]] std::vector<std::filesystem::path> poll();
+
+private:
+  // Canonical paths of the watched files, and their last modification times
+  std::map<std::filesystem::path, std::filesystem::file_time_type> m_files;
+#if defined(__linux__)
+  int m_inotify{-1};
+  // Watch descriptors and their directories
+  std::map<int, std::filesystem::path> m_directories;
+#else
+  Timer m_pollTimer;
+#endif
+};
+
+#endif
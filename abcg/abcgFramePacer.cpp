@@ -0,0 +1,103 @@
+/**
+ * @file abcgFramePacer.cpp
+ * @brief Definition of abcg::FramePacer members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgFramePacer.hpp"
+
+#include <cmath>
+#include <thread>
+
+using namespace std::chrono;
+
+/**
+ * @brief Sets the target frame rate.
+ *
+ * @param targetFPS Target number of frames per second. If zero or negative,
+ * abcg::FramePacer::wait returns immediately.
+ */
+void abcg::FramePacer::setTargetFPS(double targetFPS) {
+  auto const period{targetFPS > 0.0
+                        ? duration_cast<clock::duration>(
+                              duration<double>(1.0 / targetFPS))
+                        : clock::duration::zero()};
+  if (period != m_period) {
+    m_period = period;
+    m_deadline = {};
+  }
+}
+
+/**
+ * @brief Blocks until the deadline of the current frame.
+ *
+ * The first call only schedules the deadline of the next frame. If the
+ * deadline has already been missed by more than a frame period, the schedule
+ * is restarted from the current time instead of rendering a burst of frames to
+ * catch up.
+ */
+void abcg::FramePacer::wait() {
+  if (m_period == clock::duration::zero()) {
+    m_pacingError = 0.0;
+    return;
+  }
+
+  auto now{clock::now()};
+  if (m_deadline == clock::time_point{}) {
+    m_deadline = now + m_period;
+    return;
+  }
+
+  // Sleep while the remaining time is longer than a typical sleep
+  while (duration<double>(m_deadline - now).count() > m_sleepEstimate) {
+    auto const start{now};
+    std::this_thread::sleep_for(milliseconds{1});
+    now = clock::now();
+    updateSleepEstimate(duration<double>(now - start).count());
+  }
+
+  // Spin for the rest
+  while (now < m_deadline) {
+    now = clock::now();
+  }
+
+  m_pacingError = duration<double>(now - m_deadline).count();
+
+  m_deadline += m_period;
+  if (m_deadline < now) {
+    m_deadline = now + m_period;
+  }
+}
+
+/**
+ * @brief Returns the pacing error of the last frame.
+ *
+ * @return Time, in seconds, between the deadline of the last frame and the
+ * moment abcg::FramePacer::wait returned. A positive value means the frame was
+ * late. Returns zero if pacing is disabled.
+ */
+double abcg::FramePacer::getPacingError() const noexcept {
+  return m_pacingError;
+}
+
+void abcg::FramePacer::updateSleepEstimate(double observed) noexcept {
+  // Restart the statistics from time to time to follow changes in the
+  // scheduler behavior
+  if (m_sleepCount == 1000) {
+    m_sleepCount = 1;
+    m_sleepM2 = 0.0;
+  }
+
+  // Welford's online algorithm
+  ++m_sleepCount;
+  auto const delta{observed - m_sleepMean};
+  m_sleepMean += delta / m_sleepCount;
+  m_sleepM2 += delta * (observed - m_sleepMean);
+
+  auto const stddev{std::sqrt(m_sleepM2 / (m_sleepCount - 1))};
+  m_sleepEstimate = m_sleepMean + stddev;
+}
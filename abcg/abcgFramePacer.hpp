@@ -0,0 +1,51 @@
+/**
+ * @file abcgFramePacer.hpp
+ * @brief Header file of abcg::FramePacer.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FRAME_PACER_HPP_
+#define ABCG_FRAME_PACER_HPP_
+
+#include <chrono>
+
+namespace abcg {
+class FramePacer;
+} // namespace abcg
+
+/**
+ * @brief Paces the main loop to a target frame rate.
+ *
+ * Each call to abcg::FramePacer::wait blocks until the deadline of the current
+ * frame. Most of the wait is spent sleeping; the last part, whose length is
+ * estimated from the measured oversleep of previous sleeps, is spent spinning
+ * so that the deadline is met precisely without pegging a CPU core.
+ */
+class abcg::FramePacer {
+public:
+  void setTargetFPS(double targetFPS);
+  void wait();
+
+  [[nodiscard]] double getPacingError() const noexcept;
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  void updateSleepEstimate(double observed) noexcept;
+
+  clock::duration m_period{};
+  clock::time_point m_deadline{};
+  double m_pacingError{};
+
+  // Running statistics of the duration of a 1 ms sleep, in seconds
+  double m_sleepEstimate{5e-3};
+  double m_sleepMean{5e-3};
+  double m_sleepM2{};
+  int m_sleepCount{1};
+};
+
+#endif
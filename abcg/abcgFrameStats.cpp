@@ -0,0 +1,275 @@
+/**
+ * @file abcgFrameStats.cpp
+ * @brief Definition of abcg::FrameStats members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgFrameStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <fmt/core.h>
+
+#include "abcgExternal.hpp"
+
+namespace {
+// Minimum number of frames for the median to be used in hitch detection
+constexpr std::size_t minHitchFrames{30};
+} // namespace
+
+/**
+ * @brief Adds a frame to the statistics.
+ *
+ * If the window already has abcg::FrameStats::capacity frames, the oldest
+ * frame is removed from the statistics.
+ *
+ * @param frameTime Frame time, in seconds.
+ */
+void abcg::FrameStats::addFrame(double frameTime) {
+  auto const index{m_written.load(std::memory_order_relaxed)};
+  auto const slot{index % capacity};
+  auto const value{static_cast<float>(frameTime)};
+
+  // Hitch detection uses the median of the previous frames
+  auto const hitch{getFrameCount() >= minHitchFrames &&
+                   frameTime > getPercentile(0.5) * m_hitchFactor};
+
+  if (index >= capacity) {
+    // Remove the oldest frame
+    auto const oldest{getStored(index - capacity)};
+    --m_histogram.at(getBucket(oldest));
+    m_sum -= oldest;
+    if (m_hitches.at(slot))
+      --m_hitchCount;
+    for (auto *queue : {&m_minQueue, &m_maxQueue}) {
+      if (queue->size > 0 &&
+          queue->indices.at(queue->head) == index - capacity) {
+        queue->head = (queue->head + 1) % capacity;
+        --queue->size;
+      }
+    }
+  }
+
+  m_frameTimes.at(slot).store(value, std::memory_order_relaxed);
+  ++m_histogram.at(getBucket(value));
+  m_sum += value;
+  m_hitches.at(slot) = hitch;
+  if (hitch) {
+    ++m_hitchCount;
+    ++m_totalHitchCount;
+  }
+  push(m_minQueue, index, value, std::less_equal<>{});
+  push(m_maxQueue, index, value, std::greater_equal<>{});
+
+  m_written.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Removes all frames from the statistics.
+ *
+ * Must not be called while other threads read the frame times.
+ */
+void abcg::FrameStats::reset() noexcept {
+  m_written.store(0, std::memory_order_relaxed);
+  m_hitches.fill(false);
+  m_histogram.fill(0);
+  m_sum = 0.0;
+  m_minQueue = {};
+  m_maxQueue = {};
+  m_hitchCount = 0;
+  m_totalHitchCount = 0;
+}
+
+/**
+ * @brief Sets the factor of the median frame time above which a frame is a
+ * hitch.
+ *
+ * @param factor Hitch factor. The default is 2.
+ */
+void abcg::FrameStats::setHitchFactor(double factor) noexcept {
+  m_hitchFactor = factor;
+}
+
+/**
+ * @brief Returns the number of frames in the sliding window.
+ *
+ * @return Number of frames, up to abcg::FrameStats::capacity.
+ */
+std::size_t abcg::FrameStats::getFrameCount() const noexcept {
+  return static_cast<std::size_t>(
+      std::min<std::uint64_t>(getTotalFrameCount(), capacity));
+}
+
+/**
+ * @brief Returns the number of frames added since the creation or the last
+ * reset.
+ *
+ * @return Number of frames.
+ */
+std::uint64_t abcg::FrameStats::getTotalFrameCount() const noexcept {
+  return m_written.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Returns the time of a recent frame.
+ *
+ * This function can be called from any thread.
+ *
+ * @param age Number of frames before the last frame (0 is the last frame).
+ *
+ * @return Frame time in seconds, or 0 if @a age is not less than the number
+ * of frames in the window.
+ */
+double abcg::FrameStats::getFrameTime(std::size_t age) const noexcept {
+  auto const written{m_written.load(std::memory_order_acquire)};
+  if (age >= std::min<std::uint64_t>(written, capacity))
+    return 0.0;
+  return getStored(written - 1 - age);
+}
+
+/**
+ * @brief Returns the minimum frame time of the window.
+ *
+ * @return Frame time in seconds, or 0 if there are no frames.
+ */
+double abcg::FrameStats::getMin() const noexcept {
+  if (m_minQueue.size == 0)
+    return 0.0;
+  return getStored(m_minQueue.indices.at(m_minQueue.head));
+}
+
+/**
+ * @brief Returns the maximum frame time of the window.
+ *
+ * @return Frame time in seconds, or 0 if there are no frames.
+ */
+double abcg::FrameStats::getMax() const noexcept {
+  if (m_maxQueue.size == 0)
+    return 0.0;
+  return getStored(m_maxQueue.indices.at(m_maxQueue.head));
+}
+
+/**
+ * @brief Returns the mean frame time of the window.
+ *
+ * @return Frame time in seconds, or 0 if there are no frames.
+ */
+double abcg::FrameStats::getMean() const noexcept {
+  auto const count{getFrameCount()};
+  return count == 0 ? 0.0 : m_sum / static_cast<double>(count);
+}
+
+/**
+ * @brief Returns a percentile of the frame times of the window.
+ *
+ * The percentile is computed from the histogram, so it is rounded up to the
+ * next multiple of 0.1 ms (and clamped to the minimum and maximum frame
+ * times).
+ *
+ * @param fraction Fraction of frames (e.g., 0.99 for the 99th percentile).
+ *
+ * @return Frame time in seconds, or 0 if there are no frames.
+ */
+double abcg::FrameStats::getPercentile(double fraction) const noexcept {
+  auto const count{getFrameCount()};
+  if (count == 0)
+    return 0.0;
+
+  auto const clamped{std::clamp(fraction, 0.0, 1.0)};
+  auto const rank{std::max<std::size_t>(
+      static_cast<std::size_t>(
+          std::ceil(clamped * static_cast<double>(count))),
+      1)};
+  std::size_t accumulated{};
+  for (std::size_t bucket{}; bucket < bucketCount; ++bucket) {
+    accumulated += m_histogram.at(bucket);
+    if (accumulated >= rank) {
+      auto const upperBound{static_cast<double>(bucket + 1) * bucketWidth};
+      return std::clamp(upperBound, getMin(), getMax());
+    }
+  }
+  return getMax();
+}
+
+/**
+ * @brief Returns the number of hitches in the window.
+ *
+ * @return Number of hitches.
+ */
+std::size_t abcg::FrameStats::getHitchCount() const noexcept {
+  return m_hitchCount;
+}
+
+/**
+ * @brief Returns the number of hitches since the creation or the last reset.
+ *
+ * @return Number of hitches.
+ */
+std::uint64_t abcg::FrameStats::getTotalHitchCount() const noexcept {
+  return m_totalHitchCount;
+}
+
+/**
+ * @brief Draws a Dear ImGui overlay with a plot of the last frame times,
+ * the average frame rate, the 99th percentile and the hitch count.
+ */
+void abcg::FrameStats::drawOverlay() const {
+  constexpr std::size_t plotFrames{150};
+
+  ImGui::SetNextWindowPos(ImVec2(5, 5));
+  ImGui::Begin("FPS", nullptr,
+               ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs |
+                   ImGuiWindowFlags_NoBringToFrontOnFocus |
+                   ImGuiWindowFlags_NoFocusOnAppearing);
+
+  auto const mean{getMean()};
+  auto const label{
+      fmt::format("avg {:.1f} FPS", mean > 0.0 ? 1.0 / mean : 0.0)};
+  // Newest frame on the right
+  auto const getter{[](void *data, int index) {
+    auto const &stats{*static_cast<FrameStats const *>(data)};
+    return static_cast<float>(
+        stats.getFrameTime(plotFrames - 1 - static_cast<std::size_t>(index)) *
+        1000.0);
+  }};
+  ImGui::PlotLines("", getter, const_cast<FrameStats *>(this), // NOLINT
+                   static_cast<int>(plotFrames), 0, label.c_str(), 0.0f,
+                   static_cast<float>(getPercentile(0.99) * 2000.0),
+                   ImVec2(static_cast<float>(plotFrames), 50));
+  ImGui::Text("p99 %.2f ms", getPercentile(0.99) * 1000.0);
+  ImGui::Text("hitches %zu (%llu total)", getHitchCount(),
+              static_cast<unsigned long long>(getTotalHitchCount()));
+
+  ImGui::End();
+}
+
+std::size_t abcg::FrameStats::getBucket(float frameTime) noexcept {
+  auto const bucket{static_cast<double>(frameTime) / bucketWidth};
+  return bucket >= static_cast<double>(bucketCount)
+             ? bucketCount
+             : static_cast<std::size_t>(std::max(bucket, 0.0));
+}
+
+float abcg::FrameStats::getStored(std::uint64_t index) const noexcept {
+  return m_frameTimes.at(index % capacity).load(std::memory_order_relaxed);
+}
+
+template <typename Dominates>
+void abcg::FrameStats::push(MonotonicQueue &queue, std::uint64_t index,
+                            float frameTime, Dominates dominates) noexcept {
+  // Remove the candidates that can no longer be the minimum (or maximum)
+  while (queue.size > 0) {
+    auto const back{(queue.head + queue.size - 1) % capacity};
+    if (!dominates(frameTime, getStored(queue.indices.at(back))))
+      break;
+    --queue.size;
+  }
+  queue.indices.at((queue.head + queue.size) % capacity) = index;
+  ++queue.size;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file abcgFrameStats.hpp
+ * @brief Header file of abcg::FrameStats.
+ *
+ * Declaration of abcg::FrameStats.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FRAME_STATS_HPP_
+#define ABCG_FRAME_STATS_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace abcg {
+class FrameStats;
+} // namespace abcg
+
+/**
+ * @brief Statistics of the frame times of a window.
+ *
+ * Keeps the raw frame times of the last abcg::FrameStats::capacity frames in a
+ * ring buffer, and maintains the statistics of these frames incrementally as
+ * frames are added: the minimum and maximum with monotonic queues, the mean
+ * with a running sum, and the percentiles with a histogram of fixed buckets of
+ * 0.1 ms.
+ *
+ * A frame is counted as a hitch if its frame time is greater than the median
+ * frame time multiplied by abcg::FrameStats::setHitchFactor.
+ *
+ * Frames are added by a single thread (the main thread, in abcg::Window). The
+ * raw frame times can be read from any thread with
+ * abcg::FrameStats::getFrameTime without locking. The other queries must be
+ * called from the thread that adds the frames.
+ *
+ * @sa abcg::Window::getFrameStats.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::FrameStats {
+public:
+  /** @brief Number of frames in the sliding window of the statistics. */
+  static constexpr std::size_t capacity{1024};
+
+  FrameStats() = default;
+  FrameStats(FrameStats const &) = delete;
+  FrameStats(FrameStats &&) = delete;
+  FrameStats &operator=(FrameStats const &) = delete;
+  FrameStats &operator=(FrameStats &&) = delete;
+  ~FrameStats() = default;
+
+  void addFrame(double frameTime);
+  void reset() noexcept;
+  void setHitchFactor(double factor) noexcept;
+
+  [[nodiscard]] std::size_t getFrameCount() const noexcept;
+  [[nodiscard]] std::uint64_t getTotalFrameCount() const noexcept;
+  [[nodiscard]] double getFrameTime(std::size_t age = 0) const noexcept;
+  [[nodiscard]] double getMin() const noexcept;
+  [[nodiscard]] double getMax() const noexcept;
+  [[nodiscard]] double getMean() const noexcept;
+  [[nodiscard]] double getPercentile(double fraction) const noexcept;
+  [[nodiscard]] std::size_t getHitchCount() const noexcept;
+  [[nodiscard]] std::uint64_t getTotalHitchCount() const noexcept;
+
+  void drawOverlay() const;
+
+private:
+  // Histogram buckets of 0.1 ms from 0 to 100 ms, plus an overflow bucket
+  static constexpr std::size_t bucketCount{1000};
+  static constexpr double bucketWidth{1e-4};
+
+  // Frame indices of the candidates for the minimum or maximum of the window
+  struct MonotonicQueue {
+    std::array<std::uint64_t, capacity> indices{};
+    std::size_t head{};
+    std::size_t size{};
+  };
+
+  [[nodiscard]] static std::size_t getBucket(float frameTime) noexcept;
+  [[nodiscard]] float getStored(std::uint64_t index) const noexcept;
+  template <typename Dominates>
+  void push(MonotonicQueue &queue, std::uint64_t index, float frameTime,
+            Dominates dominates) noexcept;
+
+  std::array<std::atomic<float>, capacity> m_frameTimes{};
+  std::atomic<std::uint64_t> m_written{};
+
+  std::array<bool, capacity> m_hitches{};
+  std::array<std::uint32_t, bucketCount + 1> m_histogram{};
+  double m_sum{};
+  MonotonicQueue m_minQueue;
+  MonotonicQueue m_maxQueue;
+  std::size_t m_hitchCount{};
+  std::uint64_t m_totalHitchCount{};
+  double m_hitchFactor{2.0};
+};
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file abcgInputRecorder.cpp
+ * @brief Definition of abcg::InputRecorder and abcg::InputPlayer members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgInputRecorder.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include <fmt/core.h>
+
+#include "abcgException.hpp"
+
+namespace {
+constexpr std::array<char, 8> magic{'A', 'B', 'C', 'G', 'I', 'N', 'P', '1'};
+constexpr char eventTag{'E'};
+constexpr char frameTag{'F'};
+
+template <typename T> void write(std::ofstream &file, T const &value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+template <typename T> bool read(std::ifstream &file, T &value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return static_cast<bool>(
+      file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+} // namespace
+
+/**
+ * @brief Returns whether an event is an input event.
+ *
+ * Input events are the keyboard, text input, mouse, game controller and touch
+ * events. These are the events written by abcg::InputRecorder and ignored
+ * while replaying a log with abcg::InputPlayer. Window events are not input
+ * events.
+ *
+ * @param event SDL event.
+ *
+ * @return `true` if the event is an input event.
+ */
+bool abcg::isInputEvent(SDL_Event const &event) noexcept {
+  switch (event.type) {
+  case SDL_KEYDOWN:
+  case SDL_KEYUP:
+  case SDL_TEXTEDITING:
+  case SDL_TEXTINPUT:
+  case SDL_MOUSEMOTION:
+  case SDL_MOUSEBUTTONDOWN:
+  case SDL_MOUSEBUTTONUP:
+  case SDL_MOUSEWHEEL:
+  case SDL_CONTROLLERAXISMOTION:
+  case SDL_CONTROLLERBUTTONDOWN:
+  case SDL_CONTROLLERBUTTONUP:
+  case SDL_FINGERDOWN:
+  case SDL_FINGERUP:
+  case SDL_FINGERMOTION:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Creates the log file and writes its header.
+ *
+ * @param path Path of the log file.
+ * @param randomSeed Random seed of the run.
+ *
+ * @throw abcg::RuntimeError if the file cannot be created.
+ */
+abcg::InputRecorder::InputRecorder(std::string_view path,
+                                   std::uint64_t randomSeed)
+    : m_path{path}, m_file{m_path, std::ios::binary} {
+  if (!m_file) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to create input log {}", m_path));
+  }
+  write(m_file, magic);
+  write(m_file, randomSeed);
+}
+
+/**
+ * @brief Writes an event record.
+ *
+ * @param frame Index of the frame in which the event is handled.
+ * @param event Input event.
+ */
+void abcg::InputRecorder::writeEvent(std::uint32_t frame,
+                                     SDL_Event const &event) {
+  write(m_file, eventTag);
+  write(m_file, frame);
+  write(m_file, event);
+}
+
+/**
+ * @brief Writes a frame record.
+ *
+ * @param frame Frame index.
+ * @param deltaTime Delta time of the frame, in seconds (see
+ * abcg::Window::getDeltaTime).
+ */
+void abcg::InputRecorder::writeFrame(std::uint32_t frame, double deltaTime) {
+  write(m_file, frameTag);
+  write(m_file, frame);
+  write(m_file, deltaTime);
+}
+
+/**
+ * @brief Loads a log written by abcg::InputRecorder.
+ *
+ * @param path Path of the log file.
+ *
+ * @throw abcg::RuntimeError if the file cannot be opened or is not a valid
+ * log.
+ */
+abcg::InputPlayer::InputPlayer(std::string_view path) {
+  std::ifstream file{std::string{path}, std::ios::binary};
+  if (!file) {
+    throw abcg::RuntimeError(fmt::format("Failed to open input log {}", path));
+  }
+
+  std::array<char, magic.size()> header{};
+  if (!read(file, header) || header != magic || !read(file, m_randomSeed)) {
+    throw abcg::RuntimeError(fmt::format("Invalid input log {}", path));
+  }
+
+  char tag{};
+  std::uint32_t frame{};
+  while (read(file, tag) && read(file, frame)) {
+    if (tag == eventTag) {
+      SDL_Event event{};
+      if (!read(file, event))
+        break;
+      m_events.emplace_back(frame, event);
+    } else if (tag == frameTag) {
+      double deltaTime{};
+      if (!read(file, deltaTime))
+        break;
+      m_deltaTimes.resize(
+          std::max<std::size_t>(m_deltaTimes.size(), frame + 1));
+      m_deltaTimes.at(frame) = deltaTime;
+    } else {
+      throw abcg::RuntimeError(
+          fmt::format("Invalid record in input log {}", path));
+    }
+  }
+}
+
+/**
+ * @brief Returns the events recorded for a frame.
+ *
+ * Must be called with increasing frame indices.
+ *
+ * @param frame Frame index.
+ * @param windowID ID of the window that receives the events. It replaces the
+ * window ID of the recorded events.
+ *
+ * @return Events in the order they were recorded.
+ */
+std::vector<SDL_Event> abcg::InputPlayer::getEvents(std::uint32_t frame,
+                                                    Uint32 windowID) {
+  std::vector<SDL_Event> events;
+  for (; m_nextEvent < m_events.size() &&
+         m_events.at(m_nextEvent).first <= frame;
+       ++m_nextEvent) {
+    auto event{m_events.at(m_nextEvent).second};
+    switch (event.type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      event.key.windowID = windowID;
+      break;
+    case SDL_TEXTEDITING:
+      event.edit.windowID = windowID;
+      break;
+    case SDL_TEXTINPUT:
+      event.text.windowID = windowID;
+      break;
+    case SDL_MOUSEMOTION:
+      event.motion.windowID = windowID;
+      break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      event.button.windowID = windowID;
+      break;
+    case SDL_MOUSEWHEEL:
+      event.wheel.windowID = windowID;
+      break;
+    default:
+      break;
+    }
+    events.push_back(event);
+  }
+  return events;
+}
+
+/**
+ * @brief Returns the recorded delta time of a frame.
+ *
+ * @param frame Frame index.
+ *
+ * @return Delta time in seconds, or an empty optional if the frame has not
+ * been recorded.
+ */
+std::optional<double>
+abcg::InputPlayer::getDeltaTime(std::uint32_t frame) const noexcept {
+  if (frame < m_deltaTimes.size())
+    return m_deltaTimes[frame];
+  return std::nullopt;
+}
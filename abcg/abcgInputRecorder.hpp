@@ -0,0 +1,114 @@
+/**
+ * @file abcgInputRecorder.hpp
+ * @brief Header file of abcg::InputRecorder and abcg::InputPlayer.
+ *
+ * Declaration of abcg::InputRecorder and abcg::InputPlayer.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_INPUT_RECORDER_HPP_
+#define ABCG_INPUT_RECORDER_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "abcgExternal.hpp"
+
+namespace abcg {
+class InputRecorder;
+class InputPlayer;
+[[nodiscard]] bool isInputEvent(SDL_Event const &event) noexcept;
+} // namespace abcg
+
+/**
+ * @brief Writes the input events and frame times of a run to a binary log.
+ *
+ * The log starts with a header that contains the random seed of the run (see
+ * abcg::ApplicationSettings::randomSeed), followed by one record per input
+ * event and one record per frame:
+ *
+ * - Event record: tag `E`, frame index (32 bits), and the `SDL_Event`
+ *   structure, which includes the event timestamp;
+ * - Frame record: tag `F`, frame index (32 bits), and the delta time of the
+ *   frame (64-bit floating point).
+ *
+ * Values are written in the native byte order, so logs are meant to be
+ * replayed on the machine (or architecture) they were recorded on. Only input
+ * events are recorded (see abcg::isInputEvent).
+ *
+ * abcg::Application creates a recorder when the `--record <path>` option is
+ * given.
+ *
+ * @sa abcg::InputPlayer.
+ *
+ * @remark Objects of this type cannot be copied.
+ */
+class abcg::InputRecorder {
+public:
+  InputRecorder(std::string_view path, std::uint64_t randomSeed);
+
+  void writeEvent(std::uint32_t frame, SDL_Event const &event);
+  void writeFrame(std::uint32_t frame, double deltaTime);
+
+private:
+  std::string m_path;
+  std::ofstream m_file;
+};
+
+/**
+ * @brief Reads a log written by abcg::InputRecorder and replays it.
+ *
+ * The whole log is loaded on construction. During the replay, the recorded
+ * events are dispatched on the same frames they were recorded on, and the
+ * recorded delta times replace the measured ones, so that the simulation
+ * advances exactly as in the recorded run.
+ *
+ * abcg::Application creates a player when the `--replay <path>` option is
+ * given.
+ */
+class abcg::InputPlayer {
+public:
+  explicit InputPlayer(std::string_view path);
+
+  [[nodiscard]] std::vector<SDL_Event> getEvents(std::uint32_t frame,
+                                                 Uint32 windowID);
+  [[nodiscard]] std::optional<double>
+  getDeltaTime(std::uint32_t frame) const noexcept;
+
+  /**
+   * @brief Returns the random seed of the recorded run.
+   *
+   * @return Seed read from the header of the log.
+   */
+  [[nodiscard]] std::uint64_t getRandomSeed() const noexcept {
+    return m_randomSeed;
+  }
+
+  /**
+   * @brief Returns whether all recorded frames have been replayed.
+   *
+   * @param frame Index of the next frame.
+   *
+   * @return `true` if @a frame is past the last recorded frame.
+   */
+  [[nodiscard]] bool isFinished(std::uint32_t frame) const noexcept {
+    return frame >= m_deltaTimes.size();
+  }
+
+private:
+  std::uint64_t m_randomSeed{};
+  std::vector<std::pair<std::uint32_t, SDL_Event>> m_events;
+  std::size_t m_nextEvent{};
+  std::vector<double> m_deltaTimes;
+};
+
+#endif
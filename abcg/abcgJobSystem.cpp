@@ -0,0 +1,314 @@
+/**
+ * @file abcgJobSystem.cpp
+ * @brief Definition of abcg::JobSystem and abcg::JobCounter members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgJobSystem.hpp"
+
+#include <utility>
+
+#include <fmt/core.h>
+
+#include "abcgProfiler.hpp"
+
+namespace {
+// Job system and queue index of the current worker thread, if any
+thread_local abcg::JobSystem const *currentJobSystem{};
+thread_local std::size_t currentQueueIndex{};
+} // namespace
+
+abcg::JobCounter::JobCounter(std::size_t pending)
+    : m_pending{pending}, m_done{pending == 0} {}
+
+void abcg::JobCounter::addContinuation(std::function<void()> continuation) {
+  {
+    std::scoped_lock lock{m_mutex};
+    if (!m_done) {
+      m_continuations.push_back(std::move(continuation));
+      return;
+    }
+  }
+  continuation();
+}
+
+void abcg::JobCounter::complete(std::exception_ptr const &exception) {
+  if (exception) {
+    std::scoped_lock lock{m_mutex};
+    if (!m_exception) {
+      m_exception = exception;
+    }
+  }
+
+  if (m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+
+  std::vector<std::function<void()>> continuations;
+  {
+    std::scoped_lock lock{m_mutex};
+    m_done = true;
+    continuations.swap(m_continuations);
+  }
+  for (auto const &continuation : continuations) {
+    continuation();
+  }
+}
+
+/**
+ * @brief Constructs a job system and starts the worker threads.
+ *
+ * @param workerCount Number of worker threads. If zero, jobs are executed
+ * immediately on the thread that schedules them.
+ */
+abcg::JobSystem::JobSystem(std::size_t workerCount) {
+  m_queues.reserve(workerCount);
+  for (std::size_t index{}; index < workerCount; ++index) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+
+  m_workers.reserve(workerCount);
+  for (std::size_t index{}; index < workerCount; ++index) {
+    m_workers.emplace_back([this, index] { workerLoop(index); });
+  }
+}
+
+/**
+ * @brief Waits for the scheduled jobs to finish and joins the worker threads.
+ *
+ * Jobs scheduled with abcg::JobSystem::scheduleOnMainThread that have not run
+ * yet are discarded.
+ */
+abcg::JobSystem::~JobSystem() {
+  {
+    std::scoped_lock lock{m_sleepMutex};
+    m_quit = true;
+  }
+  m_sleepCondition.notify_all();
+
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+}
+
+/**
+ * @brief Returns the default number of worker threads.
+ *
+ * @return Number of hardware threads minus one (for the main thread), or at
+ * least one. In WebAssembly builds, the default is zero.
+ */
+std::size_t abcg::JobSystem::getDefaultWorkerCount() {
+#if defined(__EMSCRIPTEN__)
+  return 0;
+#else
+  auto const hardwareThreads{std::thread::hardware_concurrency()};
+  return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+#endif
+}
+
+/**
+ * @brief Schedules a job to be executed by a worker thread.
+ *
+ * @param job Function to be executed.
+ * @param dependencies Counters of the jobs that must finish before this job
+ * starts.
+ *
+ * @return Counter that tracks the completion of the job.
+ */
+abcg::JobSystem::Counter
+abcg::JobSystem::schedule(Job job, std::vector<Counter> const &dependencies) {
+  auto counter{makeCounter(1)};
+  enqueueWhenReady({.job = std::move(job), .counter = counter}, dependencies,
+                   false);
+  return counter;
+}
+
+/**
+ * @brief Schedules a job to be executed by abcg::JobSystem::runMainThreadJobs.
+ *
+ * @param job Function to be executed.
+ * @param dependencies Counters of the jobs that must finish before this job
+ * is queued.
+ *
+ * @return Counter that tracks the completion of the job.
+ *
+ * @remark Do not wait on the returned counter from the thread that calls
+ * abcg::JobSystem::runMainThreadJobs, as this would never return.
+ */
+abcg::JobSystem::Counter abcg::JobSystem::scheduleOnMainThread(
+    Job job, std::vector<Counter> const &dependencies) {
+  auto counter{makeCounter(1)};
+  enqueueWhenReady({.job = std::move(job), .counter = counter}, dependencies,
+                   true);
+  return counter;
+}
+
+/**
+ * @brief Blocks until the jobs tracked by a counter have finished.
+ *
+ * While waiting, the calling thread executes pending jobs.
+ *
+ * @param counter Counter to wait on.
+ *
+ * @throw The first exception thrown by the jobs tracked by the counter.
+ */
+void abcg::JobSystem::wait(Counter const &counter) {
+  while (!counter->isDone()) {
+    if (m_queues.empty()) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    auto const queueIndex{currentJobSystem == this
+                              ? currentQueueIndex
+                              : m_nextQueue.fetch_add(1) % m_queues.size()};
+    if (auto task{pop(queueIndex)}) {
+      run(*task);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  std::scoped_lock lock{counter->m_mutex};
+  if (counter->m_exception) {
+    std::rethrow_exception(counter->m_exception);
+  }
+}
+
+/**
+ * @brief Executes the jobs scheduled with
+ * abcg::JobSystem::scheduleOnMainThread whose dependencies have finished.
+ *
+ * Jobs scheduled by these jobs are executed in the next call.
+ */
+void abcg::JobSystem::runMainThreadJobs() {
+  std::vector<Task> tasks;
+  {
+    std::scoped_lock lock{m_mainThreadMutex};
+    tasks.swap(m_mainThreadTasks);
+  }
+  for (auto &task : tasks) {
+    run(task);
+  }
+}
+
+abcg::JobSystem::Counter abcg::JobSystem::makeCounter(std::size_t pending) {
+  return Counter{new JobCounter{pending}};
+}
+
+void abcg::JobSystem::run(Task &task) {
+  ABCG_PROFILE_SCOPE("Job");
+  std::exception_ptr exception;
+  try {
+    task.job();
+  } catch (...) {
+    exception = std::current_exception();
+  }
+  task.counter->complete(exception);
+}
+
+void abcg::JobSystem::push(Task task) {
+  if (m_queues.empty()) {
+    run(task);
+    return;
+  }
+
+  auto const queueIndex{currentJobSystem == this
+                            ? currentQueueIndex
+                            : m_nextQueue.fetch_add(1) % m_queues.size()};
+  {
+    auto &queue{*m_queues[queueIndex]};
+    std::scoped_lock lock{queue.mutex};
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::scoped_lock lock{m_sleepMutex};
+    m_queuedTasks.fetch_add(1);
+  }
+  m_sleepCondition.notify_one();
+}
+
+void abcg::JobSystem::enqueue(Task task, bool mainThread) {
+  if (mainThread) {
+    std::scoped_lock lock{m_mainThreadMutex};
+    m_mainThreadTasks.push_back(std::move(task));
+  } else {
+    push(std::move(task));
+  }
+}
+
+void abcg::JobSystem::enqueueWhenReady(Task task,
+                                       std::vector<Counter> const &dependencies,
+                                       bool mainThread) {
+  if (dependencies.empty()) {
+    enqueue(std::move(task), mainThread);
+    return;
+  }
+
+  struct Pending {
+    std::atomic<std::size_t> remaining;
+    Task task;
+  };
+  // One extra reference to prevent the task from being enqueued before all
+  // continuations are registered
+  auto pending{std::make_shared<Pending>()};
+  pending->remaining = dependencies.size() + 1;
+  pending->task = std::move(task);
+
+  auto const release{[this, pending, mainThread] {
+    if (pending->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      enqueue(std::move(pending->task), mainThread);
+    }
+  }};
+  for (auto const &dependency : dependencies) {
+    dependency->addContinuation(release);
+  }
+  release();
+}
+
+std::optional<abcg::JobSystem::Task>
+abcg::JobSystem::pop(std::size_t queueIndex) {
+  auto const queueCount{m_queues.size()};
+  for (std::size_t offset{}; offset < queueCount; ++offset) {
+    auto &queue{*m_queues[(queueIndex + offset) % queueCount]};
+    std::scoped_lock lock{queue.mutex};
+    if (queue.tasks.empty())
+      continue;
+
+    // Take from the back of the own queue, and steal from the front of the
+    // others
+    Task task;
+    if (offset == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    m_queuedTasks.fetch_sub(1);
+    return task;
+  }
+  return std::nullopt;
+}
+
+void abcg::JobSystem::workerLoop(std::size_t index) {
+  currentJobSystem = this;
+  currentQueueIndex = index;
+  Profiler::setThreadName(fmt::format("Worker {}", index));
+
+  while (true) {
+    if (auto task{pop(index)}) {
+      run(*task);
+      continue;
+    }
+
+    std::unique_lock lock{m_sleepMutex};
+    m_sleepCondition.wait(
+        lock, [this] { return m_quit || m_queuedTasks.load() > 0; });
+    if (m_quit && m_queuedTasks.load() == 0)
+      break;
+  }
+}
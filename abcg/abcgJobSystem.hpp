@@ -0,0 +1,210 @@
+/**
+ * @file abcgJobSystem.hpp
+ * @brief Header file of abcg::JobSystem and abcg::JobCounter.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_JOB_SYSTEM_HPP_
+#define ABCG_JOB_SYSTEM_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace abcg {
+class JobCounter;
+class JobSystem;
+} // namespace abcg
+
+/**
+ * @brief Tracks the completion of one or more jobs of an abcg::JobSystem.
+ *
+ * A counter is returned by each scheduling function of abcg::JobSystem. It can
+ * be waited on with abcg::JobSystem::wait, polled with
+ * abcg::JobCounter::isDone, or passed as a dependency of other jobs.
+ *
+ * @remark Objects of this type cannot be copied or moved. They are shared
+ * through `std::shared_ptr`.
+ */
+class abcg::JobCounter {
+public:
+  JobCounter(JobCounter const &) = delete;
+  JobCounter(JobCounter &&) = delete;
+  JobCounter &operator=(JobCounter const &) = delete;
+  JobCounter &operator=(JobCounter &&) = delete;
+  ~JobCounter() = default;
+
+  /**
+   * @brief Returns whether all jobs tracked by the counter have finished.
+   *
+   * @return `true` if all jobs have finished, `false` otherwise.
+   */
+  [[nodiscard]] bool isDone() const noexcept {
+    return m_pending.load(std::memory_order_acquire) == 0;
+  }
+
+private:
+  explicit JobCounter(std::size_t pending);
+
+  void addContinuation(std::function<void()> continuation);
+  void complete(std::exception_ptr const &exception);
+
+  std::atomic<std::size_t> m_pending;
+  std::mutex m_mutex;
+  bool m_done;
+  std::vector<std::function<void()>> m_continuations;
+  std::exception_ptr m_exception;
+
+  friend JobSystem;
+};
+
+/**
+ * @brief Work-stealing job system.
+ *
+ * Each worker thread owns a double-ended queue of jobs. Workers take jobs
+ * from the back of their own queue and, when it is empty, steal jobs from the
+ * front of the queues of other workers. Jobs submitted from threads that are
+ * not workers are distributed among the queues in a round-robin fashion.
+ *
+ * Jobs submitted with abcg::JobSystem::scheduleOnMainThread are not run by the
+ * workers. They are run by abcg::JobSystem::runMainThreadJobs, which the
+ * window calls once per frame on the thread that renders. Use them for calls
+ * that require the graphics context, such as uploading data decoded by other
+ * jobs.
+ *
+ * An exception thrown by a job is stored in its counter and rethrown by
+ * abcg::JobSystem::wait.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::JobSystem {
+public:
+  /** @brief Function executed by a job. */
+  using Job = std::function<void()>;
+  /** @brief Shared pointer to the counter that tracks a group of jobs. */
+  using Counter = std::shared_ptr<JobCounter>;
+
+  explicit JobSystem(std::size_t workerCount = getDefaultWorkerCount());
+  JobSystem(JobSystem const &) = delete;
+  JobSystem(JobSystem &&) = delete;
+  JobSystem &operator=(JobSystem const &) = delete;
+  JobSystem &operator=(JobSystem &&) = delete;
+  ~JobSystem();
+
+  Counter schedule(Job job, std::vector<Counter> const &dependencies = {});
+  Counter scheduleOnMainThread(Job job,
+                               std::vector<Counter> const &dependencies = {});
+  template <typename Function>
+  Counter parallelFor(std::size_t first, std::size_t last, Function function,
+                      std::size_t grainSize = 0);
+
+  void wait(Counter const &counter);
+  void runMainThreadJobs();
+
+  /**
+   * @brief Returns the number of worker threads.
+   *
+   * @return Number of worker threads. If zero, jobs are executed immediately
+   * on the thread that schedules them.
+   */
+  [[nodiscard]] std::size_t getWorkerCount() const noexcept {
+    return m_workers.size();
+  }
+
+  [[nodiscard]] static std::size_t getDefaultWorkerCount();
+
+private:
+  struct Task {
+    Job job;
+    Counter counter;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  [[nodiscard]] static Counter makeCounter(std::size_t pending);
+  static void run(Task &task);
+
+  void push(Task task);
+  void enqueue(Task task, bool mainThread);
+  void enqueueWhenReady(Task task, std::vector<Counter> const &dependencies,
+                        bool mainThread);
+  [[nodiscard]] std::optional<Task> pop(std::size_t queueIndex);
+  void workerLoop(std::size_t index);
+
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::atomic<std::size_t> m_nextQueue{};
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_sleepCondition;
+  std::atomic<std::size_t> m_queuedTasks{};
+  bool m_quit{};
+
+  std::mutex m_mainThreadMutex;
+  std::vector<Task> m_mainThreadTasks;
+
+  std::vector<std::thread> m_workers;
+};
+
+/**
+ * @brief Schedules a function to be called for each index of a range.
+ *
+ * The range is split into chunks of @a grainSize consecutive indices. Each
+ * chunk is executed as a separate job.
+ *
+ * @param first First index of the range.
+ * @param last One past the last index of the range.
+ * @param function Function to be called with each index, as `function(index)`.
+ * It is called concurrently from different threads.
+ * @param grainSize Number of indices per job. If zero, the range is split into
+ * about four chunks per thread.
+ *
+ * @return Counter that tracks the completion of all chunks.
+ */
+template <typename Function>
+abcg::JobSystem::Counter
+abcg::JobSystem::parallelFor(std::size_t first, std::size_t last,
+                             Function function, std::size_t grainSize) {
+  if (first >= last)
+    return makeCounter(0);
+
+  auto const count{last - first};
+  if (grainSize == 0) {
+    auto const chunksPerThread{4};
+    grainSize = std::max<std::size_t>(
+        1, count / ((getWorkerCount() + 1) * chunksPerThread));
+  }
+  auto const chunks{(count + grainSize - 1) / grainSize};
+
+  auto counter{makeCounter(chunks)};
+  auto sharedFunction{std::make_shared<Function>(std::move(function))};
+  for (std::size_t chunk{}; chunk < chunks; ++chunk) {
+    auto const begin{first + chunk * grainSize};
+    auto const end{std::min(begin + grainSize, last)};
+    push({.job = [sharedFunction, begin, end] {
+            for (auto index{begin}; index < end; ++index) {
+              (*sharedFunction)(index);
+            }
+          },
+          .counter = counter});
+  }
+
+  return counter;
+}
+
+#endif
@@ -15,7 +15,10 @@
 
 #include "abcg.hpp"
 #include "abcgOpenGLImage.hpp"
+#include "abcgOpenGLProgram.hpp"
+#include "abcgOpenGLProgramCache.hpp"
 #include "abcgOpenGLShader.hpp"
+#include "abcgOpenGLTextureStreamer.hpp"
 #include "abcgOpenGLWindow.hpp"
 
 #endif
@@ -0,0 +1,411 @@
+/**
+ * @file abcgOpenGLFrameCapture.cpp
+ * @brief Definition of abcg::OpenGLFrameCapture members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLFrameCapture.hpp"
+
+#include <SDL_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include "abcgException.hpp"
+#include "abcgOpenGLFunction.hpp"
+#include "abcgProfiler.hpp"
+
+namespace {
+constexpr auto channels{4};
+
+// Converts a full-range RGB color to limited-range BT.601 YCbCr
+std::array<unsigned char, 3> toYCbCr(int red, int green, int blue) {
+  auto const luma{((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16};
+  auto const blueDiff{((-38 * red - 74 * green + 112 * blue + 128) >> 8) + 128};
+  auto const redDiff{((112 * red - 94 * green - 18 * blue + 128) >> 8) + 128};
+  return {static_cast<unsigned char>(luma),
+          static_cast<unsigned char>(blueDiff),
+          static_cast<unsigned char>(redDiff)};
+}
+} // namespace
+
+/**
+ * @brief Constructs an idle frame capture.
+ *
+ * The writer thread is started when the first frame is captured.
+ */
+abcg::OpenGLFrameCapture::OpenGLFrameCapture() = default;
+
+/**
+ * @brief Writes the pending jobs, closes the video file and joins the writer
+ * thread.
+ *
+ * Call abcg::OpenGLFrameCapture::destroy before destroying the object, so that
+ * the frames still in the pixel buffer objects are written.
+ */
+abcg::OpenGLFrameCapture::~OpenGLFrameCapture() {
+#if !defined(__EMSCRIPTEN__)
+  if (!m_thread.joinable())
+    return;
+  {
+    std::scoped_lock lock{m_queueMutex};
+    m_quit = true;
+  }
+  m_condition.notify_one();
+  m_thread.join();
+#endif
+}
+
+/**
+ * @brief Requests a screenshot of the next frame.
+ *
+ * The screenshot is saved as a PNG file by the writer thread a few frames
+ * later.
+ *
+ * @param filename Name of the PNG file.
+ */
+void abcg::OpenGLFrameCapture::requestScreenshot(std::string_view filename) {
+  std::scoped_lock lock{m_requestMutex};
+  m_screenshotRequests.emplace_back(filename);
+}
+
+/**
+ * @brief Starts recording every frame to a YUV4MPEG2 file.
+ *
+ * If a video is already being recorded, it is finished first.
+ *
+ * @param filename Name of the video file (usually with extension `.y4m`).
+ * @param framesPerSecond Frame rate written to the header of the file.
+ *
+ * @throw abcg::RuntimeError if the file cannot be created.
+ */
+void abcg::OpenGLFrameCapture::startRecording(std::string_view filename,
+                                              int framesPerSecond) {
+  auto file{std::make_unique<std::ofstream>(std::string{filename},
+                                            std::ios::binary)};
+  if (!*file) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to create video file {}", filename));
+  }
+
+  std::scoped_lock lock{m_requestMutex};
+  m_stopRequest = m_recording.load(std::memory_order_relaxed);
+  m_videoRequest = std::move(file);
+  m_videoFramesPerSecond = std::max(framesPerSecond, 1);
+  m_recording.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Stops recording.
+ *
+ * The frames still being read back are written before the file is closed.
+ */
+void abcg::OpenGLFrameCapture::stopRecording() {
+  std::scoped_lock lock{m_requestMutex};
+  m_videoRequest.reset();
+  m_stopRequest = true;
+  m_recording.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Reads the current frame back if it has been requested.
+ *
+ * Must be called after rendering the frame and before swapping the buffers.
+ * Also retires the buffers of previous frames whose fences are signaled.
+ *
+ * @param size Size of the framebuffer, in pixels.
+ * @param readBuffer Color buffer to read from (`GL_BACK` or `GL_FRONT`).
+ */
+void abcg::OpenGLFrameCapture::capture(glm::ivec2 const &size,
+                                       GLenum readBuffer) {
+  std::vector<std::string> screenshots;
+  std::unique_ptr<std::ofstream> videoFile;
+  int framesPerSecond{};
+  bool stop{};
+  {
+    std::scoped_lock lock{m_requestMutex};
+    screenshots = std::exchange(m_screenshotRequests, {});
+    videoFile = std::move(m_videoRequest);
+    framesPerSecond = m_videoFramesPerSecond;
+    stop = std::exchange(m_stopRequest, false);
+  }
+
+  if (stop || videoFile) {
+    // Finish the frames of the previous video before closing it
+    retire(true);
+    if (m_videoActive) {
+      Job job;
+      job.type = Job::Type::StopVideo;
+      enqueue(std::move(job));
+      m_videoActive = false;
+    }
+  }
+  if (videoFile) {
+    Job job;
+    job.type = Job::Type::StartVideo;
+    job.file = std::move(videoFile);
+    job.framesPerSecond = framesPerSecond;
+    enqueue(std::move(job));
+    m_videoActive = true;
+  }
+
+  retire(false);
+
+  if ((screenshots.empty() && !m_videoActive) || size.x <= 0 || size.y <= 0)
+    return;
+
+  ABCG_PROFILE_SCOPE("Frame capture");
+  auto const bufferSize{gsl::narrow<std::size_t>(size.x * size.y * channels)};
+  abcg::glReadBuffer(readBuffer);
+
+#if defined(__EMSCRIPTEN__)
+  Job job;
+  job.pixels.resize(bufferSize);
+  job.size = size;
+  job.screenshots = std::move(screenshots);
+  job.video = m_videoActive;
+  abcg::glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE,
+                     job.pixels.data());
+  enqueue(std::move(job));
+#else
+  if (m_pendingSlots.size() == m_slots.size()) {
+    // All buffers are in use: wait for the oldest one
+    retire(true);
+  }
+
+  auto &slot{m_slots.at(m_nextSlot)};
+  m_nextSlot = (m_nextSlot + 1) % m_slots.size();
+
+  if (slot.buffer == 0) {
+    abcg::glGenBuffers(1, &slot.buffer);
+  }
+  abcg::glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  if (slot.bufferSize != bufferSize) {
+    abcg::glBufferData(GL_PIXEL_PACK_BUFFER,
+                       gsl::narrow<GLsizeiptr>(bufferSize), nullptr,
+                       GL_STREAM_READ);
+    slot.bufferSize = bufferSize;
+  }
+  abcg::glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  abcg::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.fence = abcg::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.size = size;
+  slot.screenshots = std::move(screenshots);
+  slot.video = m_videoActive;
+  m_pendingSlots.push_back(
+      gsl::narrow<std::size_t>(&slot - m_slots.data()));
+#endif
+}
+
+/**
+ * @brief Writes the frames still being read back and deletes the pixel buffer
+ * objects.
+ *
+ * Must be called with a current OpenGL context.
+ */
+void abcg::OpenGLFrameCapture::destroy() {
+  retire(true);
+  if (m_videoActive) {
+    Job job;
+    job.type = Job::Type::StopVideo;
+    enqueue(std::move(job));
+    m_videoActive = false;
+  }
+
+  for (auto &slot : m_slots) {
+    if (slot.buffer != 0) {
+      abcg::glDeleteBuffers(1, &slot.buffer);
+    }
+    slot = {};
+  }
+  m_nextSlot = 0;
+}
+
+// Maps the buffers whose fences are signaled, or all pending buffers if wait
+// is true, and hands their pixels to the writer thread
+void abcg::OpenGLFrameCapture::retire([[maybe_unused]] bool wait) {
+#if !defined(__EMSCRIPTEN__)
+  while (!m_pendingSlots.empty()) {
+    auto &slot{m_slots.at(m_pendingSlots.front())};
+
+    auto const timeout{wait ? GL_TIMEOUT_IGNORED : GLuint64{}};
+    if (auto const status{abcg::glClientWaitSync(
+            slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout)};
+        status == GL_TIMEOUT_EXPIRED) {
+      break;
+    }
+    abcg::glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    m_pendingSlots.pop_front();
+
+    Job job;
+    job.size = slot.size;
+    job.screenshots = std::move(slot.screenshots);
+    job.video = slot.video;
+    abcg::glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (auto const *const data{abcg::glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, gsl::narrow<GLsizeiptr>(slot.bufferSize),
+            GL_MAP_READ_BIT)}) {
+      job.pixels = acquirePixels(slot.bufferSize);
+      std::memcpy(job.pixels.data(), data, slot.bufferSize);
+      abcg::glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      enqueue(std::move(job));
+    }
+    abcg::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+#endif
+}
+
+// Returns a buffer of the pool, resized to the given size. Blocks while
+// maxQueuedFrames frames are waiting to be written
+std::vector<unsigned char>
+abcg::OpenGLFrameCapture::acquirePixels(std::size_t size) {
+  std::vector<unsigned char> pixels;
+  {
+    std::unique_lock lock{m_queueMutex};
+    if (m_queuedFrames == maxQueuedFrames) {
+      ABCG_PROFILE_SCOPE("Wait frame writer");
+      m_released.wait(lock,
+                      [this] { return m_queuedFrames < maxQueuedFrames; });
+    }
+    ++m_queuedFrames;
+    if (!m_pixelPool.empty()) {
+      pixels = std::move(m_pixelPool.back());
+      m_pixelPool.pop_back();
+    }
+  }
+  // Recycled buffers of the same size are not cleared again
+  pixels.resize(size);
+  return pixels;
+}
+
+void abcg::OpenGLFrameCapture::enqueue(Job job) {
+#if defined(__EMSCRIPTEN__)
+  process(job);
+#else
+  if (!m_thread.joinable()) {
+    m_thread = std::thread{[this] { loop(); }};
+  }
+  {
+    std::scoped_lock lock{m_queueMutex};
+    m_queue.push_back(std::move(job));
+  }
+  m_condition.notify_one();
+#endif
+}
+
+void abcg::OpenGLFrameCapture::loop() {
+  std::unique_lock lock{m_queueMutex};
+  while (true) {
+    m_condition.wait(lock, [this] { return m_quit || !m_queue.empty(); });
+    if (m_queue.empty())
+      break;
+
+    auto job{std::move(m_queue.front())};
+    m_queue.pop_front();
+
+    lock.unlock();
+    process(job);
+    lock.lock();
+
+    if (job.type == Job::Type::Frame) {
+      // Return the buffer to the pool
+      m_pixelPool.push_back(std::move(job.pixels));
+      --m_queuedFrames;
+      m_released.notify_one();
+    }
+  }
+  m_videoFile.reset();
+}
+
+void abcg::OpenGLFrameCapture::process(Job &job) {
+  switch (job.type) {
+  case Job::Type::StartVideo:
+    m_videoFile = std::move(job.file);
+    m_framesPerSecond = job.framesPerSecond;
+    m_videoSize = {};
+    return;
+  case Job::Type::StopVideo:
+    m_videoFile.reset();
+    return;
+  case Job::Type::Frame:
+    break;
+  }
+
+  if (job.video && m_videoFile) {
+    writeVideoFrame(job);
+  }
+
+  if (job.screenshots.empty())
+    return;
+
+  // Flip upside down
+  auto const pitch{gsl::narrow<std::size_t>(job.size.x * channels)};
+  auto const height{gsl::narrow<std::size_t>(job.size.y)};
+  for (std::size_t line{}; line < height / 2; ++line) {
+    auto const top{job.pixels.begin() + gsl::narrow<long>(pitch * line)};
+    auto const bottom{job.pixels.begin() +
+                      gsl::narrow<long>(pitch * (height - line - 1))};
+    std::swap_ranges(top, top + gsl::narrow<long>(pitch), bottom);
+  }
+
+  auto const bitsPerPixel{8};
+  if (auto *const surface{SDL_CreateRGBSurfaceFrom(
+          job.pixels.data(), job.size.x, job.size.y, channels * bitsPerPixel,
+          gsl::narrow<int>(pitch), 0x000000FF, 0x0000FF00, 0x00FF0000,
+          0xFF000000)}) {
+    for (auto const &filename : job.screenshots) {
+      IMG_SavePNG(surface, filename.c_str());
+    }
+    SDL_FreeSurface(surface);
+  }
+}
+
+void abcg::OpenGLFrameCapture::writeVideoFrame(Job const &job) {
+  if (m_videoSize == glm::ivec2{}) {
+    m_videoSize = job.size;
+    *m_videoFile << fmt::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n",
+                                m_videoSize.x, m_videoSize.y,
+                                m_framesPerSecond);
+  }
+
+  // The size of a YUV4MPEG2 stream is fixed
+  if (job.size != m_videoSize) {
+    fmt::print("Warning: skipping video frame of size {}x{} (expected {}x{})\n",
+               job.size.x, job.size.y, m_videoSize.x, m_videoSize.y);
+    return;
+  }
+
+  // Convert to three planes, from the top row to the bottom row
+  auto const width{gsl::narrow<std::size_t>(job.size.x)};
+  auto const height{gsl::narrow<std::size_t>(job.size.y)};
+  auto const planeSize{width * height};
+  m_planes.resize(planeSize * 3);
+  for (std::size_t row{}; row < height; ++row) {
+    auto const *const source{job.pixels.data() +
+                             (height - row - 1) * width * channels};
+    for (std::size_t column{}; column < width; ++column) {
+      auto const *const pixel{source + column * channels};
+      auto const [luma, blueDiff, redDiff]{
+          toYCbCr(pixel[0], pixel[1], pixel[2])};
+      auto const offset{row * width + column};
+      m_planes[offset] = luma;
+      m_planes[planeSize + offset] = blueDiff;
+      m_planes[planeSize * 2 + offset] = redDiff;
+    }
+  }
+
+  *m_videoFile << "FRAME\n";
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  m_videoFile->write(reinterpret_cast<char const *>(m_planes.data()),
+                     gsl::narrow<std::streamsize>(m_planes.size()));
+}
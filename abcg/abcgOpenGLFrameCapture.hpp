@@ -0,0 +1,153 @@
+/**
+ * @file abcgOpenGLFrameCapture.hpp
+ * @brief Header file of abcg::OpenGLFrameCapture.
+ *
+ * Declaration of abcg::OpenGLFrameCapture.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_FRAME_CAPTURE_HPP_
+#define ABCG_OPENGL_FRAME_CAPTURE_HPP_
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "abcgExternal.hpp"
+#include "abcgOpenGLExternal.hpp"
+
+namespace abcg {
+class OpenGLFrameCapture;
+} // namespace abcg
+
+/**
+ * @brief Asynchronous readback of the default framebuffer for screenshots and
+ * video recording.
+ *
+ * Frames are read with `glReadPixels` into a ring of pixel buffer objects,
+ * followed by a fence. The buffers are mapped only after their fences are
+ * signaled, which is usually abcg::OpenGLFrameCapture::frameLatency - 1 frames
+ * later, so that the readback does not stall the pipeline. The pixels are
+ * then copied to one of abcg::OpenGLFrameCapture::maxQueuedFrames recycled
+ * buffers and handed to a writer thread, which flips the rows, encodes
+ * screenshots as PNG, and appends video frames to a YUV4MPEG2 (`.y4m`) file
+ * with 4:4:4 chroma. The writer thread is started on the first capture. If all
+ * pixel buffer objects are in use, the oldest one is waited for, and if all
+ * recycled buffers are waiting to be written, the writer thread is waited
+ * for, so that no video frame is dropped and memory use stays bounded when
+ * encoding is slower than rendering.
+ *
+ * Requests can be made from any thread. abcg::OpenGLFrameCapture::capture and
+ * abcg::OpenGLFrameCapture::destroy must be called from the thread where the
+ * OpenGL context is current.
+ *
+ * In WebAssembly builds, frames are read and written synchronously.
+ *
+ * @sa abcg::OpenGLWindow::saveScreenshotPNG.
+ * @sa abcg::OpenGLWindow::startRecording.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::OpenGLFrameCapture {
+public:
+  /** @brief Number of pixel buffer objects in the ring. */
+  static constexpr std::size_t frameLatency{3};
+  /** @brief Maximum number of frames waiting to be written. */
+  static constexpr std::size_t maxQueuedFrames{4};
+
+  OpenGLFrameCapture();
+  OpenGLFrameCapture(OpenGLFrameCapture const &) = delete;
+  OpenGLFrameCapture(OpenGLFrameCapture &&) = delete;
+  OpenGLFrameCapture &operator=(OpenGLFrameCapture const &) = delete;
+  OpenGLFrameCapture &operator=(OpenGLFrameCapture &&) = delete;
+  ~OpenGLFrameCapture();
+
+  void requestScreenshot(std::string_view filename);
+  void startRecording(std::string_view filename, int framesPerSecond);
+  void stopRecording();
+
+  /**
+   * @brief Returns whether a video is being recorded.
+   *
+   * @return `true` between calls to abcg::OpenGLFrameCapture::startRecording
+   * and abcg::OpenGLFrameCapture::stopRecording.
+   */
+  [[nodiscard]] bool isRecording() const noexcept {
+    return m_recording.load(std::memory_order_relaxed);
+  }
+
+  void capture(glm::ivec2 const &size, GLenum readBuffer);
+  void destroy();
+
+private:
+  struct Slot {
+    GLuint buffer{};
+    GLsync fence{};
+    std::size_t bufferSize{};
+    glm::ivec2 size{};
+    std::vector<std::string> screenshots;
+    bool video{};
+  };
+
+  struct Job {
+    enum class Type { Frame, StartVideo, StopVideo };
+    Type type{Type::Frame};
+    std::vector<unsigned char> pixels;
+    glm::ivec2 size{};
+    std::vector<std::string> screenshots;
+    bool video{};
+    std::unique_ptr<std::ofstream> file;
+    int framesPerSecond{};
+  };
+
+  void retire(bool wait);
+  [[nodiscard]] std::vector<unsigned char> acquirePixels(std::size_t size);
+  void enqueue(Job job);
+  void loop();
+  void process(Job &job);
+  void writeVideoFrame(Job const &job);
+
+  // Accessed only by the thread of the OpenGL context
+  std::array<Slot, frameLatency> m_slots;
+  std::deque<std::size_t> m_pendingSlots;
+  std::size_t m_nextSlot{};
+  bool m_videoActive{};
+
+  // Requests
+  std::mutex m_requestMutex;
+  std::vector<std::string> m_screenshotRequests;
+  std::unique_ptr<std::ofstream> m_videoRequest;
+  int m_videoFramesPerSecond{};
+  bool m_stopRequest{};
+  std::atomic<bool> m_recording{};
+
+  // Accessed only by the writer thread
+  std::unique_ptr<std::ofstream> m_videoFile;
+  int m_framesPerSecond{};
+  glm::ivec2 m_videoSize{};
+  std::vector<unsigned char> m_planes;
+
+  std::mutex m_queueMutex;
+  std::condition_variable m_condition;
+  std::condition_variable m_released;
+  std::deque<Job> m_queue;
+  std::vector<std::vector<unsigned char>> m_pixelPool;
+  std::size_t m_queuedFrames{};
+  bool m_quit{};
+  std::thread m_thread;
+};
+
+#endif
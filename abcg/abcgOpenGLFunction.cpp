@@ -1,6 +1,7 @@
 /**
  * @file abcgOpenGLFunction.cpp
- * @brief Definition of OpenGL-related error checking functions.
+ * @brief Definition of OpenGL-related error checking functions and
+ * abcg::OpenGLDebugOutput members.
  *
  * This file is part of ABCg (https://github.com/hbatagelo/abcg).
  *
@@ -11,6 +12,10 @@
 #include "abcgOpenGLFunction.hpp"
 #include "abcgOpenGLError.hpp"
 
+#include <fmt/core.h>
+
+#include "abcgException.hpp"
+
 #if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
 /**
  * @brief Checks OpenGL error status and throws on error with a log message.
@@ -29,4 +34,127 @@ void abcg::checkGLError(source_location const &sourceLocation,
     throw abcg::OpenGLError(appendString, status, sourceLocation);
   }
 }
+
+/**
+ * @brief Registers the debug message callback used by the wrappers.
+ *
+ * Debug output is enabled in synchronous mode, and notifications are
+ * filtered out. Does nothing and returns `false` if the current context is
+ * not a debug context, or if neither OpenGL 4.3 nor `KHR_debug` is supported.
+ *
+ * @param sampleInterval Number of wrapped calls between calls to
+ * `glGetError`, or 0 to never call `glGetError`.
+ *
+ * @return `true` if the wrappers now use the debug output.
+ */
+bool abcg::OpenGLDebugOutput::enable(std::uint32_t sampleInterval) {
+  if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug)
+    return false;
+
+  GLint contextFlags{};
+  glGetIntegerv(GL_CONTEXT_FLAGS, &contextFlags);
+  if ((contextFlags & GL_CONTEXT_FLAG_DEBUG_BIT) == 0)
+    return false;
+
+  // Discard errors of previous calls
+  while (glGetError() != GL_NO_ERROR) {
+  }
+
+  glEnable(GL_DEBUG_OUTPUT);
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(callback, nullptr);
+  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
+                        GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+
+  m_sampleInterval = sampleInterval;
+  m_callCount = 0;
+  m_pendingError.clear();
+  m_enabled = true;
+  return true;
+}
+
+/**
+ * @brief Unregisters the debug message callback.
+ *
+ * The wrappers go back to abcg::OpenGLErrorCheck::GetError.
+ */
+void abcg::OpenGLDebugOutput::disable() {
+  if (!m_enabled)
+    return;
+  glDebugMessageCallback(nullptr, nullptr);
+  glDisable(GL_DEBUG_OUTPUT);
+  m_pendingError.clear();
+  m_enabled = false;
+}
+
+void GLAPIENTRY abcg::OpenGLDebugOutput::callback(
+    GLenum source, GLenum type, [[maybe_unused]] GLuint id, GLenum severity,
+    GLsizei length, GLchar const *message,
+    [[maybe_unused]] void const *userParam) {
+  std::string_view const text{
+      length < 0 ? std::string_view{message}
+                 : std::string_view{message, static_cast<std::size_t>(length)}};
+
+  // Exceptions must not be thrown through the driver. The error is thrown by
+  // the wrapper when the function returns.
+  if (type == GL_DEBUG_TYPE_ERROR) {
+    if (m_pendingError.empty()) {
+      m_pendingError = text;
+    }
+    return;
+  }
+
+  if (severity != GL_DEBUG_SEVERITY_HIGH &&
+      severity != GL_DEBUG_SEVERITY_MEDIUM)
+    return;
+
+  std::string_view sourceName{"other"};
+  switch (source) {
+  case GL_DEBUG_SOURCE_API:
+    sourceName = "api";
+    break;
+  case GL_DEBUG_SOURCE_SHADER_COMPILER:
+    sourceName = "shader compiler";
+    break;
+  case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+    sourceName = "window system";
+    break;
+  case GL_DEBUG_SOURCE_THIRD_PARTY:
+    sourceName = "third party";
+    break;
+  default:
+    break;
+  }
+
+  std::string_view typeName{"other"};
+  switch (type) {
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    typeName = "deprecated behavior";
+    break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    typeName = "undefined behavior";
+    break;
+  case GL_DEBUG_TYPE_PORTABILITY:
+    typeName = "portability";
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    typeName = "performance";
+    break;
+  default:
+    break;
+  }
+
+  auto const messageHeader{
+      fmt::format("[opengl {} {}]:", sourceName, typeName)};
+  fmt::print(stderr, "{} {} in {}:{}, {}\n", toYellowString(messageHeader),
+             text, m_breadcrumb.file_name(), m_breadcrumb.line(),
+             m_breadcrumb.function_name());
+}
+
+void abcg::OpenGLDebugOutput::throwPendingError(
+    source_location const &sourceLocation, std::string_view appendString) {
+  auto const what{fmt::format("{}: {}", appendString, m_pendingError)};
+  m_pendingError.clear();
+  throw abcg::OpenGLError(what, glGetError(), sourceLocation);
+}
 #endif
@@ -3,7 +3,9 @@
  * @brief Declaration of OpenGL-related error checking functions.
  *
  * Error checking wrappers for OpenGL functions are defined here as inline
- * functions.
+ * functions. The wrappers of state-setting functions skip redundant calls
+ * through abcg::OpenGLStateCache. In debug builds, errors are checked as
+ * selected by abcg::OpenGLErrorCheck.
  *
  * This file is part of ABCg (https://github.com/hbatagelo/abcg).
  *
@@ -28,10 +30,13 @@ using source_location = std::source_location;
 #endif
 #endif
 
+#include <cstdint>
+#include <string>
 #include <string_view>
 #include <type_traits>
 
 #include "abcgOpenGLExternal.hpp"
+#include "abcgOpenGLStateCache.hpp"
 
 #if defined(_MSC_VER)
 // Disable "unreachable code" warnings for the case callGl is not specialized
@@ -40,15 +45,123 @@ using source_location = std::source_location;
 #pragma warning(disable : 4702)
 #endif
 
+namespace abcg {
+enum class OpenGLErrorCheck;
+} // namespace abcg
+
+/**
+ * @brief Enumeration of the error checking modes of the `abcg::gl*`
+ * wrappers.
+ *
+ * The mode applies to debug builds, except on Emscripten and macOS. In other
+ * builds, the wrappers do not check for errors.
+ *
+ * @sa abcg::OpenGLSettings::errorCheck.
+ */
+enum class abcg::OpenGLErrorCheck {
+  /** @brief Calls `glGetError` before and after each wrapped function.
+   *
+   * Each call may stall the pipeline, which makes debug builds much slower
+   * than release builds.
+   */
+  GetError,
+  /** @brief Reports errors through a `glDebugMessageCallback` callback.
+   *
+   * Requires a debug context with OpenGL 4.3 or `KHR_debug`. Otherwise,
+   * abcg::OpenGLErrorCheck::GetError is used.
+   *
+   * @sa abcg::OpenGLDebugOutput.
+   */
+  DebugOutput
+};
+
 namespace abcg {
 #if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
 
 void checkGLError(source_location const &sourceLocation,
                   std::string_view appendString);
 
+/**
+ * @brief OpenGL debug output used by the `abcg::gl*` wrappers in
+ * abcg::OpenGLErrorCheck::DebugOutput mode.
+ *
+ * Once enabled, the wrappers do not call `glGetError`. Instead, each wrapper
+ * records its source location in a thread-local breadcrumb before calling the
+ * function. Debug output is synchronous, so the callback runs on the thread of
+ * the call and reads the breadcrumb to locate the message:
+ *
+ * - error messages are stored and thrown as abcg::OpenGLError when the
+ * wrapped function returns;
+ * - other messages of high or medium severity are printed to `stderr`.
+ *
+ * Errors of OpenGL functions called without the `abcg::` prefix are thrown
+ * by the next wrapper, before it calls its function.
+ *
+ * Drivers may not report every error through the callback. If a sample
+ * interval is set, `glGetError` is also called after every N wrapped calls.
+ */
+class OpenGLDebugOutput {
+public:
+  [[nodiscard]] static bool enable(std::uint32_t sampleInterval);
+  static void disable();
+
+  /**
+   * @brief Returns whether the wrappers use the debug output.
+   *
+   * @return `true` if abcg::OpenGLDebugOutput::enable succeeded.
+   */
+  [[nodiscard]] static bool isEnabled() noexcept { return m_enabled; }
+
+  /**
+   * @brief Called by the wrappers before calling an OpenGL function.
+   *
+   * @param sourceLocation Information about the source code of the call.
+   */
+  static void beforeCall(source_location const &sourceLocation) {
+    if (!m_pendingError.empty()) [[unlikely]] {
+      throwPendingError(sourceLocation, "BEFORE function call");
+    }
+    m_breadcrumb = sourceLocation;
+  }
+
+  /**
+   * @brief Called by the wrappers after calling an OpenGL function.
+   *
+   * @param sourceLocation Information about the source code of the call.
+   */
+  static void afterCall(source_location const &sourceLocation) {
+    if (!m_pendingError.empty()) [[unlikely]] {
+      throwPendingError(sourceLocation, "AFTER function call");
+    }
+    if (m_sampleInterval > 0 && ++m_callCount >= m_sampleInterval) {
+      m_callCount = 0;
+      checkGLError(sourceLocation, "AFTER function call (sampled)");
+    }
+  }
+
+private:
+  static void GLAPIENTRY callback(GLenum source, GLenum type, GLuint id,
+                                  GLenum severity, GLsizei length,
+                                  GLchar const *message,
+                                  void const *userParam);
+  [[noreturn]] static void
+  throwPendingError(source_location const &sourceLocation,
+                    std::string_view appendString);
+
+  static inline bool m_enabled{};
+  static inline std::uint32_t m_sampleInterval{};
+
+  static inline thread_local source_location m_breadcrumb{};
+  static inline thread_local std::uint32_t m_callCount{};
+  static inline thread_local std::string m_pendingError{};
+};
+
 /**
  * @brief Checks for OpenGL errors before and after a function call.
  *
+ * If abcg::OpenGLDebugOutput is enabled, errors are reported by the debug
+ * output instead of `glGetError`.
+ *
  * @tparam TFun Function typename.
  * @tparam TArgs Variadic arguments typename.
  *
@@ -61,6 +174,19 @@ void checkGLError(source_location const &sourceLocation,
 template <typename TFun, typename... TArgs>
 auto callGL(source_location const &sourceLocation, TFun &&function,
             TArgs &&...args) {
+  if (OpenGLDebugOutput::isEnabled()) {
+    OpenGLDebugOutput::beforeCall(sourceLocation);
+    if constexpr (!std::is_void_v<std::invoke_result_t<TFun, TArgs...>>) {
+      auto &&res{std::forward<TFun>(function)(std::forward<TArgs>(args)...)};
+      OpenGLDebugOutput::afterCall(sourceLocation);
+      return res;
+    } else {
+      std::forward<TFun>(function)(std::forward<TArgs>(args)...);
+      OpenGLDebugOutput::afterCall(sourceLocation);
+      return;
+    }
+  }
+
   checkGLError(sourceLocation, "BEFORE function call");
   if constexpr (!std::is_void_v<std::invoke_result_t<TFun, TArgs...>>) {
     // Specialization for functions that do not return void
@@ -112,7 +238,9 @@ auto callGL([[maybe_unused]] source_location, TFun &&function,
 inline void glActiveTexture(
     GLenum texture,
     source_location const &sourceLocation = source_location::current()) {
-  callGL(sourceLocation, ::glActiveTexture, texture);
+  if (OpenGLStateCache::activeTexture(texture)) {
+    callGL(sourceLocation, ::glActiveTexture, texture);
+  }
 }
 inline void glAttachShader(
     GLuint program, GLuint shader,
@@ -127,7 +255,9 @@ inline void glBindAttribLocation(
 inline void glBindBuffer(
     GLenum target, GLuint buffer,
     source_location const &sourceLocation = source_location::current()) {
-  callGL(sourceLocation, ::glBindBuffer, target, buffer);
+  if (OpenGLStateCache::bindBuffer(target, buffer)) {
+    callGL(sourceLocation, ::glBindBuffer, target, buffer);
+  }
 }
 inline void glBindFramebuffer(
     GLenum target, GLuint framebuffer,
@@ -142,7 +272,9 @@ inline void glBindRenderbuffer(
 inline void glBindTexture(
     GLenum target, GLuint texture,
     source_location const &sourceLocation = source_location::current()) {
-  callGL(sourceLocation, ::glBindTexture, target, texture);
+  if (OpenGLStateCache::bindTexture(target, texture)) {
+    callGL(sourceLocation, ::glBindTexture, target, texture);
+  }
 }
 inline void glBlendColor(
     GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha,
@@ -259,6 +391,7 @@ inline void glDeleteBuffers(
     source_location const &sourceLocation = source_location::current()) {
   if (buffers == nullptr || *buffers == 0)
     return;
+  OpenGLStateCache::deleteBuffers(n, buffers);
   callGL(sourceLocation, ::glDeleteBuffers, n, buffers);
 }
 inline void glDeleteFramebuffers(
@@ -294,6 +427,7 @@ inline void glDeleteTextures(
     source_location const &sourceLocation = source_location::current()) {
   if (textures == nullptr || *textures == 0)
     return;
+  OpenGLStateCache::deleteTextures(n, textures);
   callGL(sourceLocation, ::glDeleteTextures, n, textures);
 }
 inline void glDepthFunc(GLenum func, source_location const &sourceLocation =
@@ -317,7 +451,9 @@ inline void glDetachShader(
 inline void
 glDisable(GLenum cap,
           source_location const &sourceLocation = source_location::current()) {
-  callGL(sourceLocation, ::glDisable, cap);
+  if (OpenGLStateCache::setCapability(cap, false)) {
+    callGL(sourceLocation, ::glDisable, cap);
+  }
 }
 inline void glDisableVertexAttribArray(
     GLuint index,
@@ -337,7 +473,9 @@ inline void glDrawElements(
 inline void
 glEnable(GLenum cap,
          source_location const &sourceLocation = source_location::current()) {
-  callGL(sourceLocation, ::glEnable, cap);
+  if (OpenGLStateCache::setCapability(cap, true)) {
+    callGL(sourceLocation, ::glEnable, cap);
+  }
 }
 inline void glEnableVertexAttribArray(
     GLuint index,
@@ -790,7 +928,9 @@ inline void glUniformMatrix4fv(
 }
 inline void glUseProgram(GLuint program, source_location const &sourceLocation =
                                              source_location::current()) {
-  callGL(sourceLocation, ::glUseProgram, program);
+  if (OpenGLStateCache::useProgram(program)) {
+    callGL(sourceLocation, ::glUseProgram, program);
+  }
 }
 inline void glValidateProgram(
     GLuint program,
@@ -847,7 +987,9 @@ inline void glVertexAttribPointer(
 inline void
 glViewport(GLint x, GLint y, GLsizei width, GLsizei height,
            source_location const &sourceLocation = source_location::current()) {
-  callGL(sourceLocation, ::glViewport, x, y, width, height);
+  if (OpenGLStateCache::viewport(x, y, width, height)) {
+    callGL(sourceLocation, ::glViewport, x, y, width, height);
+  }
 }
 
 // OpenGL ES 3.0 function definitions
@@ -1022,11 +1164,14 @@ inline void glFlushMappedBufferRange(
 inline void glBindVertexArray(
     GLuint array,
     source_location const &sourceLocation = source_location::current()) {
-  callGL(sourceLocation, ::glBindVertexArray, array);
+  if (OpenGLStateCache::bindVertexArray(array)) {
+    callGL(sourceLocation, ::glBindVertexArray, array);
+  }
 }
 inline void glDeleteVertexArrays(
     GLsizei n, GLuint const *arrays,
     source_location const &sourceLocation = source_location::current()) {
+  OpenGLStateCache::deleteVertexArrays(n, arrays);
   callGL(sourceLocation, ::glDeleteVertexArrays, n, arrays);
 }
 inline void glGenVertexArrays(
@@ -1057,12 +1202,14 @@ inline void glBindBufferRange(
     GLenum target, GLuint index, GLuint buffer, GLintptr offset,
     GLsizeiptr size,
     source_location const &sourceLocation = source_location::current()) {
+  OpenGLStateCache::bindBufferBase(target, buffer);
   callGL(sourceLocation, ::glBindBufferRange, target, index, buffer, offset,
          size);
 }
 inline void glBindBufferBase(
     GLenum target, GLuint index, GLuint buffer,
     source_location const &sourceLocation = source_location::current()) {
+  OpenGLStateCache::bindBufferBase(target, buffer);
   callGL(sourceLocation, ::glBindBufferBase, target, index, buffer);
 }
 inline void glTransformFeedbackVaryings(
@@ -1479,6 +1626,22 @@ inline void glGetDoublev(
   callGL(sourceLocation, ::glGetDoublev, pname, params);
 }
 #endif
+
+#if !defined(__EMSCRIPTEN__)
+
+// OpenGL 3.3+ function definitions
+
+inline void glQueryCounter(
+    GLuint id, GLenum target,
+    source_location const &sourceLocation = source_location::current()) {
+  callGL(sourceLocation, ::glQueryCounter, id, target);
+}
+inline void glGetQueryObjectui64v(
+    GLuint id, GLenum pname, GLuint64 *params,
+    source_location const &sourceLocation = source_location::current()) {
+  callGL(sourceLocation, ::glGetQueryObjectui64v, id, pname, params);
+}
+#endif
 // NOLINTEND(readability-identifier-length)
 
 } // namespace abcg
@@ -0,0 +1,286 @@
+/**
+ * @file abcgOpenGLGPUTimer.cpp
+ * @brief Definition of abcg::OpenGLGPUTimer and abcg::OpenGLGPUScope members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLGPUTimer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <gsl/gsl>
+
+#include "abcgOpenGLFunction.hpp"
+#include "abcgProfiler.hpp"
+
+namespace {
+constexpr auto noZone{std::numeric_limits<std::size_t>::max()};
+
+#if !defined(__EMSCRIPTEN__)
+constexpr std::array<GLenum, 6> statisticsTargets{
+    GL_VERTICES_SUBMITTED_ARB,         GL_PRIMITIVES_SUBMITTED_ARB,
+    GL_VERTEX_SHADER_INVOCATIONS_ARB,  GL_CLIPPING_INPUT_PRIMITIVES_ARB,
+    GL_CLIPPING_OUTPUT_PRIMITIVES_ARB, GL_FRAGMENT_SHADER_INVOCATIONS_ARB};
+
+bool isQueryAvailable(GLuint query) {
+  GLuint available{};
+  abcg::glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+  return available == GL_TRUE;
+}
+
+std::uint64_t getQueryResult(GLuint query) {
+  GLuint64 result{};
+  abcg::glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+  return result;
+}
+#endif
+} // namespace
+
+/**
+ * @brief Creates the query objects.
+ *
+ * Must be called with a current OpenGL context.
+ *
+ * @param pipelineStatistics Whether to also collect the pipeline statistics of
+ * each frame, if `ARB_pipeline_statistics_query` is supported.
+ */
+void abcg::OpenGLGPUTimer::create([[maybe_unused]] bool pipelineStatistics) {
+  destroy();
+
+#if !defined(__EMSCRIPTEN__)
+  m_supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+  if (!m_supported)
+    return;
+
+  m_statisticsEnabled =
+      pipelineStatistics && GLEW_ARB_pipeline_statistics_query;
+  if (m_statisticsEnabled) {
+    for (auto &frame : m_frames) {
+      abcg::glGenQueries(gsl::narrow<GLsizei>(frame.statisticsQueries.size()),
+                         frame.statisticsQueries.data());
+    }
+  }
+
+  m_track = Profiler::registerTrack("GPU");
+#endif
+}
+
+/**
+ * @brief Deletes the query objects.
+ *
+ * Must be called with a current OpenGL context.
+ */
+void abcg::OpenGLGPUTimer::destroy() {
+  for (auto &frame : m_frames) {
+    if (!frame.queries.empty()) {
+      abcg::glDeleteQueries(gsl::narrow<GLsizei>(frame.queries.size()),
+                            frame.queries.data());
+    }
+    if (m_statisticsEnabled) {
+      abcg::glDeleteQueries(
+          gsl::narrow<GLsizei>(frame.statisticsQueries.size()),
+          frame.statisticsQueries.data());
+    }
+    frame = {};
+  }
+  m_frameIndex = 0;
+  m_depth = 0;
+  m_supported = false;
+  m_recording = false;
+  m_statisticsEnabled = false;
+}
+
+/**
+ * @brief Starts measuring a new frame.
+ *
+ * Reads back the results of the frame issued abcg::OpenGLGPUTimer::frameLatency
+ * frames before, if they are available, and records them into abcg::Profiler.
+ */
+void abcg::OpenGLGPUTimer::beginFrame() {
+  if (!m_supported)
+    return;
+
+  auto &frame{m_frames.at(m_frameIndex % frameLatency)};
+  if (frame.pending) {
+    resolve(frame);
+    frame.pending = false;
+  }
+
+  m_recording = Profiler::isEnabled();
+  if (!m_recording)
+    return;
+
+#if !defined(__EMSCRIPTEN__)
+  frame.queryCount = 0;
+  frame.zones.clear();
+  m_depth = 0;
+
+  // Reference for converting GPU timestamps to the profiler clock
+  GLint64 gpuReference{};
+  abcg::glGetInteger64v(GL_TIMESTAMP, &gpuReference);
+  frame.gpuReference = gpuReference;
+  frame.cpuReference = Profiler::now();
+
+  if (m_statisticsEnabled) {
+    for (std::size_t index{}; index < statisticsTargets.size(); ++index) {
+      abcg::glBeginQuery(statisticsTargets.at(index),
+                         frame.statisticsQueries.at(index));
+    }
+  }
+#endif
+}
+
+/**
+ * @brief Finishes measuring the current frame.
+ */
+void abcg::OpenGLGPUTimer::endFrame() {
+  if (!m_recording)
+    return;
+
+  auto &frame{m_frames.at(m_frameIndex % frameLatency)};
+#if !defined(__EMSCRIPTEN__)
+  if (m_statisticsEnabled) {
+    for (auto const target : statisticsTargets) {
+      abcg::glEndQuery(target);
+    }
+  }
+#endif
+  frame.pending = true;
+  m_recording = false;
+  ++m_frameIndex;
+}
+
+/**
+ * @brief Starts a GPU zone.
+ *
+ * Zones can be nested, and must be ended in the reverse order they were
+ * started.
+ *
+ * @param name Zone name. Must be a string with static storage duration, such
+ * as a string literal.
+ *
+ * @return Identifier of the zone to be passed to
+ * abcg::OpenGLGPUTimer::endZone.
+ *
+ * @sa abcg::OpenGLGPUScope
+ */
+std::size_t abcg::OpenGLGPUTimer::beginZone(char const *name) {
+  if (!m_recording)
+    return noZone;
+
+  auto &frame{m_frames.at(m_frameIndex % frameLatency)};
+  auto const query{issueTimestamp(frame)};
+  frame.zones.push_back({.name = name,
+                         .depth = m_depth++,
+                         .beginQuery = query,
+                         .endQuery = query});
+  return frame.zones.size() - 1;
+}
+
+/**
+ * @brief Ends a GPU zone.
+ *
+ * @param zone Identifier returned by abcg::OpenGLGPUTimer::beginZone.
+ */
+void abcg::OpenGLGPUTimer::endZone(std::size_t zone) {
+  if (!m_recording || zone == noZone)
+    return;
+
+  auto &frame{m_frames.at(m_frameIndex % frameLatency)};
+  frame.zones.at(zone).endQuery = issueTimestamp(frame);
+  --m_depth;
+}
+
+std::size_t abcg::OpenGLGPUTimer::issueTimestamp(Frame &frame) {
+#if !defined(__EMSCRIPTEN__)
+  if (frame.queryCount == frame.queries.size()) {
+    // Grow the pool of queries of this frame
+    auto const oldSize{frame.queries.size()};
+    frame.queries.resize(std::max<std::size_t>(oldSize * 2, 16));
+    abcg::glGenQueries(gsl::narrow<GLsizei>(frame.queries.size() - oldSize),
+                       &frame.queries.at(oldSize));
+  }
+  abcg::glQueryCounter(frame.queries.at(frame.queryCount), GL_TIMESTAMP);
+#endif
+  return frame.queryCount++;
+}
+
+void abcg::OpenGLGPUTimer::resolve([[maybe_unused]] Frame &frame) {
+#if !defined(__EMSCRIPTEN__)
+  // Never wait for the results. If the GPU is more than frameLatency frames
+  // behind, the results of this frame are discarded
+  if (frame.queryCount > 0 &&
+      !isQueryAvailable(frame.queries.at(frame.queryCount - 1))) {
+    return;
+  }
+  if (m_statisticsEnabled &&
+      !std::ranges::all_of(frame.statisticsQueries, isQueryAvailable)) {
+    return;
+  }
+
+  auto const toSeconds{[&frame](std::uint64_t timestamp) {
+    auto const elapsed{static_cast<std::int64_t>(timestamp) -
+                       frame.gpuReference};
+    return frame.cpuReference + static_cast<double>(elapsed) * 1e-9;
+  }};
+
+  for (auto const &zone : frame.zones) {
+    if (zone.endQuery == zone.beginQuery)
+      continue;
+    Profiler::record(
+        {.name = zone.name,
+         .begin = toSeconds(getQueryResult(frame.queries.at(zone.beginQuery))),
+         .end = toSeconds(getQueryResult(frame.queries.at(zone.endQuery))),
+         .depth = zone.depth,
+         .track = m_track});
+  }
+
+  if (m_statisticsEnabled) {
+    auto const &queries{frame.statisticsQueries};
+    m_pipelineStatistics = {
+        .verticesSubmitted = getQueryResult(queries.at(0)),
+        .primitivesSubmitted = getQueryResult(queries.at(1)),
+        .vertexShaderInvocations = getQueryResult(queries.at(2)),
+        .clippingInputPrimitives = getQueryResult(queries.at(3)),
+        .clippingOutputPrimitives = getQueryResult(queries.at(4)),
+        .fragmentShaderInvocations = getQueryResult(queries.at(5))};
+
+    auto const &stats{m_pipelineStatistics};
+    auto const toDouble{[](std::uint64_t value) {
+      return static_cast<double>(value);
+    }};
+    Profiler::setCounter("GPU vertices submitted",
+                         toDouble(stats.verticesSubmitted));
+    Profiler::setCounter("GPU primitives submitted",
+                         toDouble(stats.primitivesSubmitted));
+    Profiler::setCounter("GPU vertex shader invocations",
+                         toDouble(stats.vertexShaderInvocations));
+    Profiler::setCounter("GPU clipping input primitives",
+                         toDouble(stats.clippingInputPrimitives));
+    Profiler::setCounter("GPU clipping output primitives",
+                         toDouble(stats.clippingOutputPrimitives));
+    Profiler::setCounter("GPU fragment shader invocations",
+                         toDouble(stats.fragmentShaderInvocations));
+  }
+#endif
+}
+
+/**
+ * @brief Starts a GPU zone.
+ *
+ * @param timer GPU timer used for measuring the zone.
+ * @param name Zone name. Must be a string with static storage duration, such
+ * as a string literal.
+ */
+abcg::OpenGLGPUScope::OpenGLGPUScope(OpenGLGPUTimer &timer, char const *name)
+    : m_timer{timer}, m_zone{timer.beginZone(name)} {}
+
+/**
+ * @brief Ends the GPU zone.
+ */
+abcg::OpenGLGPUScope::~OpenGLGPUScope() { m_timer.endZone(m_zone); }
@@ -0,0 +1,145 @@
+/**
+ * @file abcgOpenGLGPUTimer.hpp
+ * @brief Header file of abcg::OpenGLGPUTimer and abcg::OpenGLGPUScope.
+ *
+ * Declaration of abcg::OpenGLGPUTimer and abcg::OpenGLGPUScope.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_GPU_TIMER_HPP_
+#define ABCG_OPENGL_GPU_TIMER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "abcgOpenGLExternal.hpp"
+
+namespace abcg {
+struct OpenGLPipelineStatistics;
+class OpenGLGPUTimer;
+class OpenGLGPUScope;
+} // namespace abcg
+
+/**
+ * @brief Pipeline statistics of a frame.
+ *
+ * @sa abcg::OpenGLSettings::pipelineStatistics.
+ */
+struct abcg::OpenGLPipelineStatistics {
+  /** @brief Number of vertices submitted. */
+  std::uint64_t verticesSubmitted{};
+  /** @brief Number of primitives submitted. */
+  std::uint64_t primitivesSubmitted{};
+  /** @brief Number of vertex shader invocations. */
+  std::uint64_t vertexShaderInvocations{};
+  /** @brief Number of primitives that entered the clipping stage. */
+  std::uint64_t clippingInputPrimitives{};
+  /** @brief Number of primitives that left the clipping stage. */
+  std::uint64_t clippingOutputPrimitives{};
+  /** @brief Number of fragment shader invocations. */
+  std::uint64_t fragmentShaderInvocations{};
+};
+
+/**
+ * @brief GPU timer based on OpenGL timestamp queries.
+ *
+ * The timer measures named zones of GPU work and records them into a "GPU"
+ * track of abcg::Profiler. Queries are kept in a ring of
+ * abcg::OpenGLGPUTimer::frameLatency frames, so that results are read a few
+ * frames after being issued, without stalling the pipeline. Results that are
+ * still not available after that are discarded.
+ *
+ * abcg::OpenGLWindow owns a timer that measures the scene pass
+ * (abcg::OpenGLWindow::onPaint) and the Dear ImGui pass. Additional zones can
+ * be measured in `onPaint` with abcg::OpenGLGPUScope.
+ *
+ * Zones are only measured while abcg::Profiler is enabled, and only if
+ * timestamp queries are supported (OpenGL 3.3 or `ARB_timer_query`). Timer
+ * queries are not supported in WebAssembly builds.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::OpenGLGPUTimer {
+public:
+  /** @brief Number of frames between issuing and reading back a query. */
+  static constexpr std::size_t frameLatency{4};
+
+  OpenGLGPUTimer() = default;
+  OpenGLGPUTimer(OpenGLGPUTimer const &) = delete;
+  OpenGLGPUTimer(OpenGLGPUTimer &&) = delete;
+  OpenGLGPUTimer &operator=(OpenGLGPUTimer const &) = delete;
+  OpenGLGPUTimer &operator=(OpenGLGPUTimer &&) = delete;
+  ~OpenGLGPUTimer() = default;
+
+  void create(bool pipelineStatistics = false);
+  void destroy();
+
+  void beginFrame();
+  void endFrame();
+
+  [[nodiscard]] std::size_t beginZone(char const *name);
+  void endZone(std::size_t zone);
+
+  [[nodiscard]] bool isSupported() const noexcept { return m_supported; }
+  [[nodiscard]] OpenGLPipelineStatistics const &
+  getPipelineStatistics() const noexcept {
+    return m_pipelineStatistics;
+  }
+
+private:
+  struct Zone {
+    char const *name{};
+    std::uint32_t depth{};
+    std::size_t beginQuery{};
+    std::size_t endQuery{};
+  };
+
+  struct Frame {
+    std::vector<GLuint> queries;
+    std::size_t queryCount{};
+    std::vector<Zone> zones;
+    std::array<GLuint, 6> statisticsQueries{};
+    double cpuReference{};
+    std::int64_t gpuReference{};
+    bool pending{};
+  };
+
+  [[nodiscard]] std::size_t issueTimestamp(Frame &frame);
+  void resolve(Frame &frame);
+
+  std::array<Frame, frameLatency> m_frames{};
+  std::size_t m_frameIndex{};
+  std::uint32_t m_depth{};
+  std::uint32_t m_track{};
+  bool m_supported{};
+  bool m_recording{};
+  bool m_statisticsEnabled{};
+  OpenGLPipelineStatistics m_pipelineStatistics{};
+};
+
+/**
+ * @brief RAII object that measures a GPU zone with an abcg::OpenGLGPUTimer
+ * from its construction to its destruction.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::OpenGLGPUScope {
+public:
+  OpenGLGPUScope(OpenGLGPUTimer &timer, char const *name);
+  OpenGLGPUScope(OpenGLGPUScope const &) = delete;
+  OpenGLGPUScope(OpenGLGPUScope &&) = delete;
+  OpenGLGPUScope &operator=(OpenGLGPUScope const &) = delete;
+  OpenGLGPUScope &operator=(OpenGLGPUScope &&) = delete;
+  ~OpenGLGPUScope();
+
+private:
+  OpenGLGPUTimer &m_timer;
+  std::size_t m_zone{};
+};
+
+#endif
@@ -17,9 +17,275 @@
 #include <gsl/gsl>
 #include <vector>
 
+#include "abcgBakedAsset.hpp"
 #include "abcgException.hpp"
+#include "abcgOpenGLFunction.hpp"
+#include "abcgProfiler.hpp"
+#include "abcgTextureContainer.hpp"
 
+namespace {
+using abcg::TextureFormat;
+
+// Loads a KTX2 or DDS file, uploading every level stored in the file
+GLuint loadContainer(abcg::OpenGLTextureCreateInfo const &createInfo) {
+  auto const container{abcg::loadTextureContainer(createInfo.path)};
+  auto const format{createInfo.sRGBToLinear ? abcg::toSRGB(container.format)
+                                            : container.format};
+  if (!abcg::isOpenGLTextureFormatSupported(format)) {
+    throw abcg::RuntimeError(fmt::format(
+        "Texture format of {} is not supported by the OpenGL context",
+        createInfo.path));
+  }
+  auto const internalFormat{abcg::getOpenGLInternalFormat(format)};
+  auto const levelCount{gsl::narrow<GLint>(container.levels.size())};
+
+  GLuint textureID{};
+  abcg::glGenTextures(1, &textureID);
+  abcg::glBindTexture(GL_TEXTURE_2D, textureID);
+
+  for (auto const level : iter::range(levelCount)) {
+    auto const &[width, height, offset,
+                 size]{container.levels.at(gsl::narrow<std::size_t>(level))};
+    auto const *data{
+        std::next(container.data.data(), gsl::narrow<std::ptrdiff_t>(offset))};
+    if (abcg::isCompressed(format)) {
+      abcg::glCompressedTexImage2D(
+          GL_TEXTURE_2D, level, internalFormat, gsl::narrow<GLsizei>(width),
+          gsl::narrow<GLsizei>(height), 0, gsl::narrow<GLsizei>(size), data);
+    } else {
+      abcg::glTexImage2D(GL_TEXTURE_2D, level,
+                         gsl::narrow<GLint>(internalFormat),
+                         gsl::narrow<GLsizei>(width),
+                         gsl::narrow<GLsizei>(height), 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, data);
+    }
+  }
+
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  if (levelCount == 1 && createInfo.generateMipmaps &&
+      !abcg::isCompressed(format)) {
+    abcg::glGenerateMipmap(GL_TEXTURE_2D);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                          GL_LINEAR_MIPMAP_LINEAR);
+  } else {
+    // Sample only the levels stored in the file
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                          levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR
+                                         : GL_LINEAR);
+  }
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+  return textureID;
+}
+
+// Loads a texture written by abcg_bake, uploading its levels in place from the
+// mapped file. Returns 0 if the orientation of the rows must be checked and
+// differs from the requested one.
+GLuint loadBaked(abcg::OpenGLTextureCreateInfo const &createInfo,
+                 std::string_view path, bool checkOrientation) {
+  abcg::BakedAsset asset;
+  asset.open(path);
+  auto const &header{asset.getHeader()};
+  if (header.kind != abcg::BakedAssetKind::Texture) {
+    throw abcg::RuntimeError(fmt::format("{} is not a baked texture", path));
+  }
+  auto const flipped{
+      (header.flags & abcg::BakedAssetHeader::FlippedUpsideDown) != 0};
+  if (checkOrientation && flipped != createInfo.flipUpsideDown)
+    return 0;
+
+  auto const format{createInfo.sRGBToLinear
+                        ? abcg::toSRGB(asset.getTextureFormat())
+                        : asset.getTextureFormat()};
+  auto const internalFormat{abcg::getOpenGLInternalFormat(format)};
+  auto const levels{asset.getTextureLevels()};
+  auto const levelCount{
+      createInfo.generateMipmaps ? gsl::narrow<GLint>(levels.size()) : 1};
+
+  GLuint textureID{};
+  abcg::glGenTextures(1, &textureID);
+  abcg::glBindTexture(GL_TEXTURE_2D, textureID);
+
+  for (auto const level : iter::range(levelCount)) {
+    auto const index{gsl::narrow<std::size_t>(level)};
+    abcg::glTexImage2D(GL_TEXTURE_2D, level, gsl::narrow<GLint>(internalFormat),
+                       gsl::narrow<GLsizei>(levels[index].width),
+                       gsl::narrow<GLsizei>(levels[index].height), 0, GL_RGBA,
+                       GL_UNSIGNED_BYTE, asset.getLevelData(index).data());
+  }
+
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                        levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+  return textureID;
+}
+} // namespace
+
+/**
+ * @brief Returns whether the current OpenGL context can sample textures of a
+ * given format.
+ *
+ * Must be called with a current OpenGL context.
+ *
+ * @param format Texel format.
+ *
+ * @return `true` if the format is supported.
+ */
+bool abcg::isOpenGLTextureFormatSupported(TextureFormat format) {
+#if defined(__EMSCRIPTEN__)
+  auto const enable{[](char const *extension) {
+    return emscripten_webgl_enable_extension(
+               emscripten_webgl_get_current_context(), extension) == EM_TRUE;
+  }};
+#endif
+  switch (format) {
+  case TextureFormat::RGBA8:
+  case TextureFormat::RGBA8sRGB:
+    return true;
+#if defined(__EMSCRIPTEN__)
+  case TextureFormat::BC1:
+  case TextureFormat::BC3:
+    return enable("WEBGL_compressed_texture_s3tc");
+  case TextureFormat::BC1sRGB:
+  case TextureFormat::BC3sRGB:
+    return enable("WEBGL_compressed_texture_s3tc_srgb");
+  case TextureFormat::BC4:
+  case TextureFormat::BC5:
+    return enable("EXT_texture_compression_rgtc");
+  case TextureFormat::BC7:
+  case TextureFormat::BC7sRGB:
+    return enable("EXT_texture_compression_bptc");
+  case TextureFormat::ETC2RGB8:
+  case TextureFormat::ETC2RGB8sRGB:
+  case TextureFormat::ETC2RGBA8:
+  case TextureFormat::ETC2RGBA8sRGB:
+    return enable("WEBGL_compressed_texture_etc");
+  case TextureFormat::ASTC4x4:
+  case TextureFormat::ASTC4x4sRGB:
+    return enable("WEBGL_compressed_texture_astc");
+#else
+  case TextureFormat::BC1:
+  case TextureFormat::BC1sRGB:
+  case TextureFormat::BC3:
+  case TextureFormat::BC3sRGB:
+    return GLEW_EXT_texture_compression_s3tc;
+  case TextureFormat::BC4:
+  case TextureFormat::BC5:
+    // Core since OpenGL 3.0
+    return true;
+  case TextureFormat::BC7:
+  case TextureFormat::BC7sRGB:
+    return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+  case TextureFormat::ETC2RGB8:
+  case TextureFormat::ETC2RGB8sRGB:
+  case TextureFormat::ETC2RGBA8:
+  case TextureFormat::ETC2RGBA8sRGB:
+    return GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility;
+  case TextureFormat::ASTC4x4:
+  case TextureFormat::ASTC4x4sRGB:
+    return GLEW_KHR_texture_compression_astc_ldr;
+#endif
+  }
+  return false;
+}
+
+/**
+ * @brief Returns the sized internal format of a texture format.
+ *
+ * Values of extension formats are given explicitly, as their names differ
+ * between OpenGL and OpenGL ES headers.
+ *
+ * @param format Texel format.
+ *
+ * @return Internal format to pass to `glTexImage2D` or
+ * `glCompressedTexImage2D`.
+ */
+GLenum abcg::getOpenGLInternalFormat(TextureFormat format) noexcept {
+  switch (format) {
+  case TextureFormat::RGBA8:
+    return GL_RGBA8;
+  case TextureFormat::RGBA8sRGB:
+    return GL_SRGB8_ALPHA8;
+  case TextureFormat::BC1:
+    return 0x83F1; // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+  case TextureFormat::BC1sRGB:
+    return 0x8C4D; // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+  case TextureFormat::BC3:
+    return 0x83F3; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+  case TextureFormat::BC3sRGB:
+    return 0x8C4F; // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+  case TextureFormat::BC4:
+    return 0x8DBB; // GL_COMPRESSED_RED_RGTC1
+  case TextureFormat::BC5:
+    return 0x8DBD; // GL_COMPRESSED_RG_RGTC2
+  case TextureFormat::BC7:
+    return 0x8E8C; // GL_COMPRESSED_RGBA_BPTC_UNORM
+  case TextureFormat::BC7sRGB:
+    return 0x8E8D; // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+  case TextureFormat::ETC2RGB8:
+    return GL_COMPRESSED_RGB8_ETC2;
+  case TextureFormat::ETC2RGB8sRGB:
+    return GL_COMPRESSED_SRGB8_ETC2;
+  case TextureFormat::ETC2RGBA8:
+    return GL_COMPRESSED_RGBA8_ETC2_EAC;
+  case TextureFormat::ETC2RGBA8sRGB:
+    return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+  case TextureFormat::ASTC4x4:
+    return 0x93B0; // GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+  case TextureFormat::ASTC4x4sRGB:
+    return 0x93D0; // GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR
+  }
+  return 0;
+}
+
+/**
+ * @brief Loads a 2D texture from a file.
+ *
+ * Files with extension `.ktx2` or `.dds` are read with
+ * abcg::loadTextureContainer, and their mipmap levels are uploaded as stored
+ * (e.g., with `glCompressedTexImage2D` for BCn, ETC2 and ASTC formats). For
+ * these files, abcg::OpenGLTextureCreateInfo::flipUpsideDown is ignored, and
+ * abcg::OpenGLTextureCreateInfo::generateMipmaps only applies to uncompressed
+ * files with a single level.
+ *
+ * If the file was baked by `abcg_bake` with the orientation given by
+ * abcg::OpenGLTextureCreateInfo::flipUpsideDown (see abcg::findBakedAsset), the
+ * baked file is mapped and its precomputed mipmap levels are uploaded instead.
+ * Files with extension `.baked` are loaded likewise, regardless of their
+ * orientation. With abcg::OpenGLTextureCreateInfo::generateMipmaps set to
+ * `false`, only the base level is uploaded. Other files are loaded with
+ * SDL_image.
+ *
+ * @param createInfo Creation info.
+ *
+ * @throw abcg::RuntimeError if the file cannot be loaded or its format is not
+ * supported by the context.
+ *
+ * @return ID of the texture object.
+ */
 GLuint abcg::loadOpenGLTexture(OpenGLTextureCreateInfo const &createInfo) {
+  ABCG_PROFILE_SCOPE("Load texture");
+  if (isBakedAsset(createInfo.path)) {
+    return loadBaked(createInfo, createInfo.path, false);
+  }
+  if (isTextureContainer(createInfo.path)) {
+    return loadContainer(createInfo);
+  }
+  if (auto const bakedPath{findBakedAsset(createInfo.path)};
+      !bakedPath.empty()) {
+    if (auto const textureID{loadBaked(createInfo, bakedPath, true)};
+        textureID != 0)
+      return textureID;
+  }
+
   GLuint textureID{};
 
   if (SDL_Surface *const surface{IMG_Load(createInfo.path.data())}) {
@@ -81,6 +347,7 @@ GLuint abcg::loadOpenGLTexture(OpenGLTextureCreateInfo const &createInfo) {
 }
 
 GLuint abcg::loadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo) {
+  ABCG_PROFILE_SCOPE("Load cubemap");
   GLuint textureID{};
   glGenTextures(1, &textureID);
   glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
@@ -17,6 +17,7 @@
 #include <string_view>
 
 namespace abcg {
+enum class TextureFormat;
 struct OpenGLTextureCreateInfo;
 struct OpenGLCubemapCreateInfo;
 
@@ -24,6 +25,8 @@ struct OpenGLCubemapCreateInfo;
 loadOpenGLTexture(OpenGLTextureCreateInfo const &createInfo);
 [[nodiscard]] GLuint
 loadOpenGLCubemap(OpenGLCubemapCreateInfo const &createInfo);
+[[nodiscard]] bool isOpenGLTextureFormatSupported(TextureFormat format);
+[[nodiscard]] GLenum getOpenGLInternalFormat(TextureFormat format) noexcept;
 } // namespace abcg
 
 /**
@@ -0,0 +1,398 @@
+/**
+ * @file abcgOpenGLProgram.cpp
+ * @brief Definition of abcg::OpenGLProgram members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLProgram.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <cppitertools/itertools.hpp>
+#include <gsl/gsl>
+
+#include "abcgOpenGLFunction.hpp"
+#include "abcgOpenGLShader.hpp"
+
+namespace {
+template <typename T>
+auto findByName(std::vector<T> const &table, std::string_view name) {
+  auto const iter{std::lower_bound(table.begin(), table.end(), name,
+                                   [](auto const &entry, std::string_view key) {
+                                     return entry.name < key;
+                                   })};
+  return (iter != table.end() && iter->name == name) ? iter : table.end();
+}
+
+template <typename T> void sortByName(std::vector<T> &table) {
+  std::sort(table.begin(), table.end(), [](auto const &lhs, auto const &rhs) {
+    return lhs.name < rhs.name;
+  });
+}
+
+// Removes the "[0]" suffix that glGetActiveUniform appends to array names
+std::string toBaseName(std::string name) {
+  if (name.ends_with("[0]")) {
+    name.resize(name.size() - 3);
+  }
+  return name;
+}
+
+std::string getName(std::vector<GLchar> const &buffer, GLsizei length) {
+  return {buffer.data(), gsl::narrow<std::size_t>(length)};
+}
+} // namespace
+
+/**
+ * @brief Creates the program with abcg::createOpenGLProgram and reflects it.
+ *
+ * @param pathsOrSources Paths or source codes of the shaders of the program.
+ *
+ * @throw abcg::RuntimeError if a shader file could not be read, or if the
+ * compilation or linking failed.
+ */
+void abcg::OpenGLProgram::create(
+    std::vector<ShaderSource> const &pathsOrSources) {
+  create(createOpenGLProgram(pathsOrSources));
+}
+
+/**
+ * @brief Takes ownership of a linked program object and reflects it.
+ *
+ * The previous program object, if any, is deleted. Uniform handles keep
+ * referring to the uniforms of the same name in the new program, and their
+ * cached values are discarded.
+ *
+ * @param program ID of a linked program object.
+ */
+void abcg::OpenGLProgram::create(GLuint program) {
+  if (m_program != 0 && m_program != program) {
+    abcg::glDeleteProgram(m_program);
+  }
+  m_program = program;
+  reflect();
+}
+
+/**
+ * @brief Deletes the program object.
+ *
+ * Uniform handles remain valid and are resolved again by the next call to
+ * abcg::OpenGLProgram::create.
+ */
+void abcg::OpenGLProgram::destroy() {
+  if (m_program != 0) {
+    abcg::glDeleteProgram(m_program);
+  }
+  m_program = 0;
+  reflect();
+}
+
+/**
+ * @brief Installs the program as part of the current rendering state.
+ */
+void abcg::OpenGLProgram::use() const { abcg::glUseProgram(m_program); }
+
+/**
+ * @brief Returns the location of an active attribute.
+ *
+ * @param name Name of the attribute.
+ *
+ * @return Location of the attribute, or -1 if it is not active.
+ */
+GLint abcg::OpenGLProgram::getAttributeLocation(std::string_view name) const {
+  auto const iter{findByName(m_attributes, name)};
+  return iter == m_attributes.end() ? -1 : iter->location;
+}
+
+/**
+ * @brief Returns the location of an active uniform.
+ *
+ * @param name Name of the uniform. For arrays, the location of the first
+ * element is returned.
+ *
+ * @return Location of the uniform, or -1 if it is not active.
+ */
+GLint abcg::OpenGLProgram::getUniformLocation(std::string_view name) const {
+  auto const iter{findByName(m_uniforms, name)};
+  return iter == m_uniforms.end() ? -1 : iter->location;
+}
+
+/**
+ * @brief Returns the index of an active uniform block.
+ *
+ * @param name Name of the uniform block.
+ *
+ * @return Index of the uniform block, or `GL_INVALID_INDEX` if it is not
+ * active.
+ */
+GLuint abcg::OpenGLProgram::getUniformBlockIndex(std::string_view name) const {
+  auto const iter{findByName(m_uniformBlocks, name)};
+  return iter == m_uniformBlocks.end() ? GL_INVALID_INDEX : iter->index;
+}
+
+/**
+ * @brief Returns a handle to a uniform, to be used with the setters.
+ *
+ * Call this once, e.g., in abcg::OpenGLWindow::onCreate, and keep the handle.
+ * Setting a uniform that is not active in the program is a no-op.
+ *
+ * @param name Name of the uniform.
+ *
+ * @return Handle to the uniform.
+ */
+abcg::OpenGLProgram::Uniform
+abcg::OpenGLProgram::getUniform(std::string_view name) {
+  auto const iter{
+      std::find(m_handleNames.begin(), m_handleNames.end(), name)};
+  if (iter != m_handleNames.end()) {
+    return gsl::narrow<Uniform>(std::distance(m_handleNames.begin(), iter));
+  }
+
+  m_handleNames.emplace_back(name);
+  m_handleLocations.push_back(getUniformLocation(name));
+  m_handleValues.emplace_back();
+  return m_handleNames.size() - 1;
+}
+
+/**
+ * @brief Sets the value of an `int` or sampler uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, GLint value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform1i(location, value);
+  }
+}
+
+/**
+ * @brief Sets the value of a `uint` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, GLuint value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform1ui(location, value);
+  }
+}
+
+/**
+ * @brief Sets the value of a `float` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, GLfloat value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform1f(location, value);
+  }
+}
+
+/**
+ * @brief Sets the value of a `vec2` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, glm::vec2 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform2fv(location, 1, &value.x);
+  }
+}
+
+/**
+ * @brief Sets the value of a `vec3` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, glm::vec3 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform3fv(location, 1, &value.x);
+  }
+}
+
+/**
+ * @brief Sets the value of a `vec4` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, glm::vec4 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform4fv(location, 1, &value.x);
+  }
+}
+
+/**
+ * @brief Sets the value of an `ivec2` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform,
+                                     glm::ivec2 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform2iv(location, 1, &value.x);
+  }
+}
+
+/**
+ * @brief Sets the value of an `ivec3` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform,
+                                     glm::ivec3 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform3iv(location, 1, &value.x);
+  }
+}
+
+/**
+ * @brief Sets the value of an `ivec4` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform,
+                                     glm::ivec4 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniform4iv(location, 1, &value.x);
+  }
+}
+
+/**
+ * @brief Sets the value of a `mat3` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, glm::mat3 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+  }
+}
+
+/**
+ * @brief Sets the value of a `mat4` uniform.
+ *
+ * @param uniform Handle returned by abcg::OpenGLProgram::getUniform.
+ * @param value Value of the uniform.
+ */
+void abcg::OpenGLProgram::setUniform(Uniform uniform, glm::mat4 const &value) {
+  if (auto const location{update(uniform, &value, sizeof(value))};
+      location >= 0) {
+    abcg::glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+  }
+}
+
+// Queries the active attributes, uniforms and uniform blocks, and resolves
+// the uniform handles
+void abcg::OpenGLProgram::reflect() {
+  m_attributes.clear();
+  m_uniforms.clear();
+  m_uniformBlocks.clear();
+
+  if (m_program != 0) {
+    GLint count{};
+    GLint maxLength{};
+    GLsizei length{};
+
+    abcg::glGetProgramiv(m_program, GL_ACTIVE_ATTRIBUTES, &count);
+    abcg::glGetProgramiv(m_program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> name(gsl::narrow<std::size_t>(maxLength + 1));
+    for (auto const index : iter::range(gsl::narrow<GLuint>(count))) {
+      Variable attribute;
+      abcg::glGetActiveAttrib(m_program, index,
+                              gsl::narrow<GLsizei>(name.size()), &length,
+                              &attribute.size, &attribute.type, name.data());
+      attribute.name = getName(name, length);
+      attribute.location =
+          abcg::glGetAttribLocation(m_program, attribute.name.c_str());
+      m_attributes.push_back(std::move(attribute));
+    }
+
+    abcg::glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+    abcg::glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    name.resize(gsl::narrow<std::size_t>(maxLength + 1));
+    for (auto const index : iter::range(gsl::narrow<GLuint>(count))) {
+      Variable uniform;
+      abcg::glGetActiveUniform(m_program, index,
+                               gsl::narrow<GLsizei>(name.size()), &length,
+                               &uniform.size, &uniform.type, name.data());
+      uniform.name = toBaseName(getName(name, length));
+      uniform.location =
+          abcg::glGetUniformLocation(m_program, uniform.name.c_str());
+      // Members of uniform blocks are reflected through their blocks
+      if (uniform.location >= 0) {
+        m_uniforms.push_back(std::move(uniform));
+      }
+    }
+
+    abcg::glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    abcg::glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+                         &maxLength);
+    name.resize(gsl::narrow<std::size_t>(maxLength + 1));
+    for (auto const index : iter::range(gsl::narrow<GLuint>(count))) {
+      UniformBlock block;
+      block.index = index;
+      abcg::glGetActiveUniformBlockName(m_program, index,
+                                        gsl::narrow<GLsizei>(name.size()),
+                                        &length, name.data());
+      block.name = getName(name, length);
+      abcg::glGetActiveUniformBlockiv(m_program, index,
+                                      GL_UNIFORM_BLOCK_DATA_SIZE,
+                                      &block.dataSize);
+      abcg::glGetActiveUniformBlockiv(m_program, index,
+                                      GL_UNIFORM_BLOCK_BINDING, &block.binding);
+      m_uniformBlocks.push_back(std::move(block));
+    }
+
+    sortByName(m_attributes);
+    sortByName(m_uniforms);
+    sortByName(m_uniformBlocks);
+  }
+
+  // Locations may differ in the new program, and it starts with the default
+  // values of its uniforms
+  for (auto const handle : iter::range(m_handleNames.size())) {
+    m_handleLocations.at(handle) = getUniformLocation(m_handleNames.at(handle));
+    m_handleValues.at(handle) = {};
+  }
+}
+
+// Stores the value of a uniform. Returns its location if it must be set, or -1
+// if the uniform is not active or already has this value.
+GLint abcg::OpenGLProgram::update(Uniform uniform, void const *data,
+                                  std::size_t size) {
+  auto const location{m_handleLocations.at(uniform)};
+  if (location < 0)
+    return -1;
+
+  auto &value{m_handleValues.at(uniform)};
+  if (value.size == size && std::memcmp(value.data.data(), data, size) == 0)
+    return -1;
+
+  std::memcpy(value.data.data(), data, size);
+  value.size = size;
+  return location;
+}
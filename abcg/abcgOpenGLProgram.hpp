@@ -0,0 +1,168 @@
+/**
+ * @file abcgOpenGLProgram.hpp
+ * @brief Header file of abcg::OpenGLProgram.
+ *
+ * Declaration of abcg::OpenGLProgram.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_PROGRAM_HPP_
+#define ABCG_OPENGL_PROGRAM_HPP_
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abcgExternal.hpp"
+#include "abcgOpenGLExternal.hpp"
+#include "abcgShader.hpp"
+
+namespace abcg {
+class OpenGLProgram;
+} // namespace abcg
+
+/**
+ * @brief Program object with reflected attributes, uniforms and uniform
+ * blocks.
+ *
+ * The active attributes, uniforms and uniform blocks are queried once, when
+ * the program is created, and are kept in tables sorted by name. Name lookups
+ * are binary searches on these tables and never call OpenGL.
+ *
+ * Uniforms are set through handles returned by
+ * abcg::OpenGLProgram::getUniform. A handle is resolved from the name once and
+ * stays valid when the program object is replaced (e.g., by a hot reload of
+ * abcg::OpenGLProgramRegistry). The setters keep a copy of the last value of
+ * each uniform and skip the OpenGL call when the value did not change.
+ *
+ * @remark The setters call `glUniform*`, so the program must be in use (see
+ * abcg::OpenGLProgram::use). Values set with `glUniform*` directly are not
+ * seen by the cache.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::OpenGLProgram {
+public:
+  /** @brief Handle to a uniform, returned by abcg::OpenGLProgram::getUniform.
+   */
+  using Uniform = std::size_t;
+
+  /** @brief Active attribute or uniform. */
+  struct Variable {
+    /** @brief Name, without the `[0]` suffix of arrays. */
+    std::string name;
+    /** @brief Location, or -1 for members of uniform blocks. */
+    GLint location{-1};
+    /** @brief Data type (e.g., `GL_FLOAT_VEC3`). */
+    GLenum type{};
+    /** @brief Number of array elements, or 1 if not an array. */
+    GLint size{};
+  };
+
+  /** @brief Active uniform block. */
+  struct UniformBlock {
+    /** @brief Name of the block. */
+    std::string name;
+    /** @brief Index of the block in the program. */
+    GLuint index{};
+    /** @brief Minimum size of the buffer bound to the block, in bytes. */
+    GLint dataSize{};
+    /** @brief Uniform buffer binding point of the block. */
+    GLint binding{};
+  };
+
+  OpenGLProgram() = default;
+  OpenGLProgram(OpenGLProgram const &) = delete;
+  OpenGLProgram(OpenGLProgram &&) = delete;
+  OpenGLProgram &operator=(OpenGLProgram const &) = delete;
+  OpenGLProgram &operator=(OpenGLProgram &&) = delete;
+  ~OpenGLProgram() = default;
+
+  void create(std::vector<ShaderSource> const &pathsOrSources);
+  void create(GLuint program);
+  void destroy();
+  void use() const;
+
+  /**
+   * @brief Returns the ID of the program object.
+   *
+   * @return ID of the program object, or 0 if the program was not created.
+   */
+  [[nodiscard]] GLuint getID() const noexcept { return m_program; }
+
+  [[nodiscard]] GLint getAttributeLocation(std::string_view name) const;
+  [[nodiscard]] GLint getUniformLocation(std::string_view name) const;
+  [[nodiscard]] GLuint getUniformBlockIndex(std::string_view name) const;
+
+  /**
+   * @brief Returns the active attributes.
+   *
+   * @return Attributes sorted by name.
+   */
+  [[nodiscard]] std::vector<Variable> const &getAttributes() const noexcept {
+    return m_attributes;
+  }
+
+  /**
+   * @brief Returns the active uniforms in the default uniform block.
+   *
+   * @return Uniforms sorted by name.
+   */
+  [[nodiscard]] std::vector<Variable> const &getUniforms() const noexcept {
+    return m_uniforms;
+  }
+
+  /**
+   * @brief Returns the active uniform blocks.
+   *
+   * @return Uniform blocks sorted by name.
+   */
+  [[nodiscard]] std::vector<UniformBlock> const &
+  getUniformBlocks() const noexcept {
+    return m_uniformBlocks;
+  }
+
+  [[nodiscard]] Uniform getUniform(std::string_view name);
+
+  void setUniform(Uniform uniform, GLint value);
+  void setUniform(Uniform uniform, GLuint value);
+  void setUniform(Uniform uniform, GLfloat value);
+  void setUniform(Uniform uniform, glm::vec2 const &value);
+  void setUniform(Uniform uniform, glm::vec3 const &value);
+  void setUniform(Uniform uniform, glm::vec4 const &value);
+  void setUniform(Uniform uniform, glm::ivec2 const &value);
+  void setUniform(Uniform uniform, glm::ivec3 const &value);
+  void setUniform(Uniform uniform, glm::ivec4 const &value);
+  void setUniform(Uniform uniform, glm::mat3 const &value);
+  void setUniform(Uniform uniform, glm::mat4 const &value);
+
+private:
+  // Last value set to a uniform
+  struct Value {
+    std::array<std::byte, sizeof(glm::mat4)> data{};
+    std::size_t size{};
+  };
+
+  void reflect();
+  [[nodiscard]] GLint update(Uniform uniform, void const *data,
+                             std::size_t size);
+
+  GLuint m_program{};
+
+  std::vector<Variable> m_attributes;
+  std::vector<Variable> m_uniforms;
+  std::vector<UniformBlock> m_uniformBlocks;
+
+  // Names of the uniform handles, and their locations in the current program
+  std::vector<std::string> m_handleNames;
+  std::vector<GLint> m_handleLocations;
+  std::vector<Value> m_handleValues;
+};
+
+#endif
@@ -0,0 +1,314 @@
+/**
+ * @file abcgOpenGLProgramCache.cpp
+ * @brief Definition of abcg::OpenGLProgramCache members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLProgramCache.hpp"
+
+#include <SDL.h>
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include "abcgOpenGLFunction.hpp"
+#include "abcgProfiler.hpp"
+
+namespace {
+constexpr std::array<char, 8> magic{'A', 'B', 'C', 'G', 'P', 'R', 'G', '1'};
+
+struct CacheState {
+  std::atomic<bool> enabled{true};
+  std::atomic<std::uint64_t> hits{};
+  std::atomic<std::uint64_t> misses{};
+
+  std::mutex mutex;
+  std::filesystem::path path;
+};
+
+CacheState &getState() {
+  static CacheState state;
+  return state;
+}
+
+// 64-bit FNV-1a, which unlike std::hash is stable across standard libraries
+class Hasher {
+public:
+  void add(std::string_view text) noexcept {
+    for (auto const character : text) {
+      m_hash ^= static_cast<unsigned char>(character);
+      m_hash *= 0x100000001b3ULL;
+    }
+    // Separator, so that ("ab", "c") and ("a", "bc") differ
+    m_hash ^= 0xFFU;
+    m_hash *= 0x100000001b3ULL;
+  }
+
+  [[nodiscard]] std::uint64_t get() const noexcept { return m_hash; }
+
+private:
+  std::uint64_t m_hash{0xcbf29ce484222325ULL};
+};
+
+std::string_view getString(GLenum name) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  auto const *text{reinterpret_cast<char const *>(abcg::glGetString(name))};
+  return text == nullptr ? std::string_view{} : std::string_view{text};
+}
+
+std::uint64_t computeKey(std::vector<abcg::ShaderSource> const &sources) {
+  Hasher hasher;
+  hasher.add(getString(GL_VENDOR));
+  hasher.add(getString(GL_RENDERER));
+  hasher.add(getString(GL_VERSION));
+  for (auto const &source : sources) {
+    hasher.add(std::to_string(static_cast<int>(source.stage)));
+    hasher.add(source.source);
+  }
+  return hasher.get();
+}
+
+std::filesystem::path getEntryPath(std::uint64_t key) {
+  return abcg::OpenGLProgramCache::getPath() / fmt::format("{:016x}.bin", key);
+}
+
+template <typename T> void write(std::ofstream &file, T const &value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+template <typename T> bool read(std::ifstream &file, T &value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return static_cast<bool>(
+      file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+void countMiss() {
+  auto &state{getState()};
+  abcg::Profiler::setCounter("Program cache misses",
+                             static_cast<double>(++state.misses));
+}
+
+void countHit() {
+  auto &state{getState()};
+  abcg::Profiler::setCounter("Program cache hits",
+                             static_cast<double>(++state.hits));
+}
+} // namespace
+
+/**
+ * @brief Enables or disables the cache.
+ *
+ * @param enabled Whether abcg::createOpenGLProgram should use the cache.
+ */
+void abcg::OpenGLProgramCache::setEnabled(bool enabled) noexcept {
+  getState().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns whether the cache is enabled.
+ *
+ * @return `true` if the cache is enabled, even if it is not supported by the
+ * current context.
+ */
+bool abcg::OpenGLProgramCache::isEnabled() noexcept {
+  return getState().enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns whether the current OpenGL context supports program binaries.
+ *
+ * @return `true` if `ARB_get_program_binary` is supported and the driver
+ * exposes at least one binary format.
+ */
+bool abcg::OpenGLProgramCache::isSupported() {
+#if defined(__EMSCRIPTEN__)
+  return false;
+#else
+  if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+    return false;
+  GLint numFormats{};
+  abcg::glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  return numFormats > 0;
+#endif
+}
+
+/**
+ * @brief Sets the directory of the cache files.
+ *
+ * The directory is created when the first entry is stored.
+ *
+ * @param path Path of the directory.
+ */
+void abcg::OpenGLProgramCache::setPath(std::filesystem::path const &path) {
+  auto &state{getState()};
+  std::scoped_lock lock{state.mutex};
+  state.path = path;
+}
+
+/**
+ * @brief Returns the directory of the cache files.
+ *
+ * Unless set with abcg::OpenGLProgramCache::setPath, the directory is the
+ * per-user directory returned by `SDL_GetPrefPath("abcg", "programs")`, which
+ * is not shared with other users.
+ *
+ * @return Path of the directory, or an empty path if there is no per-user
+ * directory. In that case, the cache is not used.
+ */
+std::filesystem::path abcg::OpenGLProgramCache::getPath() {
+  auto &state{getState()};
+  std::scoped_lock lock{state.mutex};
+  if (state.path.empty()) {
+    if (auto *const prefPath{SDL_GetPrefPath("abcg", "programs")}) {
+      state.path = prefPath;
+      SDL_free(prefPath);
+    }
+  }
+  return state.path;
+}
+
+/**
+ * @brief Removes all cache files.
+ */
+void abcg::OpenGLProgramCache::clear() {
+  std::error_code error;
+  for (auto const &entry :
+       std::filesystem::directory_iterator(getPath(), error)) {
+    if (entry.path().extension() == ".bin") {
+      std::filesystem::remove(entry.path(), error);
+    }
+  }
+}
+
+/**
+ * @brief Returns the number of programs loaded from the cache.
+ *
+ * @return Number of cache hits since the start of the application.
+ */
+std::uint64_t abcg::OpenGLProgramCache::getHitCount() noexcept {
+  return getState().hits.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of programs that had to be compiled because they
+ * were not in the cache or their binaries were rejected.
+ *
+ * @return Number of cache misses since the start of the application.
+ */
+std::uint64_t abcg::OpenGLProgramCache::getMissCount() noexcept {
+  return getState().misses.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Creates a program object from a cached binary.
+ *
+ * Counts a hit if the program is created, or a miss otherwise.
+ *
+ * @param sources Source codes (not paths) and stages of the shaders.
+ *
+ * @return ID of the linked program object, or 0 if the cache is disabled,
+ * the entry does not exist, or the binary was rejected by the driver.
+ */
+GLuint
+abcg::OpenGLProgramCache::load(std::vector<ShaderSource> const &sources) {
+  if (!isEnabled() || !isSupported() || getPath().empty())
+    return 0;
+
+  ABCG_PROFILE_SCOPE("Load program binary");
+  auto const key{computeKey(sources)};
+  std::ifstream file{getEntryPath(key), std::ios::binary};
+
+  std::array<char, magic.size()> header{};
+  std::uint64_t storedKey{};
+  GLenum format{};
+  std::uint32_t length{};
+  if (!file || !read(file, header) || header != magic ||
+      !read(file, storedKey) || storedKey != key || !read(file, format) ||
+      !read(file, length)) {
+    countMiss();
+    return 0;
+  }
+
+  std::vector<char> binary(length);
+  if (!file.read(binary.data(), gsl::narrow<std::streamsize>(length))) {
+    countMiss();
+    return 0;
+  }
+
+  auto const program{abcg::glCreateProgram()};
+  abcg::glProgramBinary(program, format, binary.data(),
+                        gsl::narrow<GLsizei>(length));
+  GLint linkStatus{};
+  abcg::glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  if (linkStatus == GL_FALSE) {
+    abcg::glDeleteProgram(program);
+    countMiss();
+    return 0;
+  }
+
+  countHit();
+  return program;
+}
+
+/**
+ * @brief Stores the binary of a linked program in the cache.
+ *
+ * For the binary to be retrievable on all drivers, the
+ * `GL_PROGRAM_BINARY_RETRIEVABLE_HINT` parameter of the program should be set
+ * before linking.
+ *
+ * @param sources Source codes (not paths) and stages of the shaders.
+ * @param program ID of the linked program object.
+ */
+void abcg::OpenGLProgramCache::store(std::vector<ShaderSource> const &sources,
+                                     GLuint program) {
+  if (!isEnabled() || !isSupported() || getPath().empty())
+    return;
+
+  ABCG_PROFILE_SCOPE("Store program binary");
+  GLint length{};
+  abcg::glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  std::vector<char> binary(gsl::narrow<std::size_t>(length));
+  GLenum format{};
+  abcg::glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  std::error_code error;
+  auto const directory{getPath()};
+  std::filesystem::create_directories(directory, error);
+
+  // Write to a temporary file first, so that a concurrent reader never sees a
+  // partial entry
+  auto const key{computeKey(sources)};
+  auto const path{getEntryPath(key)};
+  auto temporaryPath{path};
+  temporaryPath += ".tmp";
+  {
+    std::ofstream file{temporaryPath, std::ios::binary};
+    if (!file) {
+      fmt::print("Warning: failed to write program cache entry {}\n",
+                 temporaryPath.string());
+      return;
+    }
+    write(file, magic);
+    write(file, key);
+    write(file, format);
+    write(file, gsl::narrow<std::uint32_t>(length));
+    file.write(binary.data(), length);
+  }
+  std::filesystem::rename(temporaryPath, path, error);
+}
@@ -0,0 +1,64 @@
+/**
+ * @file abcgOpenGLProgramCache.hpp
+ * @brief Header file of abcg::OpenGLProgramCache.
+ *
+ * Declaration of abcg::OpenGLProgramCache.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_PROGRAM_CACHE_HPP_
+#define ABCG_OPENGL_PROGRAM_CACHE_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "abcgOpenGLExternal.hpp"
+#include "abcgShader.hpp"
+
+namespace abcg {
+class OpenGLProgramCache;
+} // namespace abcg
+
+/**
+ * @brief On-disk cache of linked program binaries.
+ *
+ * abcg::createOpenGLProgram looks up the cache before compiling the shaders.
+ * Each entry is a file with the blob returned by `glGetProgramBinary`, named
+ * after a 64-bit FNV-1a hash of the OpenGL vendor, renderer and version
+ * strings, and of the stages and source codes of the shaders. On a hit, the
+ * program is created with `glProgramBinary`. If the driver rejects the binary
+ * (e.g., after a driver update that kept the version string), the entry is
+ * counted as a miss and is replaced after the shaders are compiled and linked
+ * again.
+ *
+ * The cache is enabled by default when `ARB_get_program_binary` is supported
+ * and at least one binary format is available. The default directory is the
+ * per-user directory returned by `SDL_GetPrefPath("abcg", "programs")` (e.g.,
+ * `~/.local/share/abcg/programs/` on Linux), so that the binaries cannot be
+ * replaced by other users of the system.
+ *
+ * @remark The cache is not available in WebAssembly builds.
+ */
+class abcg::OpenGLProgramCache {
+public:
+  static void setEnabled(bool enabled) noexcept;
+  [[nodiscard]] static bool isEnabled() noexcept;
+  [[nodiscard]] static bool isSupported();
+
+  static void setPath(std::filesystem::path const &path);
+  [[nodiscard]] static std::filesystem::path getPath();
+  static void clear();
+
+  [[nodiscard]] static std::uint64_t getHitCount() noexcept;
+  [[nodiscard]] static std::uint64_t getMissCount() noexcept;
+
+  [[nodiscard]] static GLuint load(std::vector<ShaderSource> const &sources);
+  static void store(std::vector<ShaderSource> const &sources, GLuint program);
+};
+
+#endif
@@ -0,0 +1,346 @@
+/**
+ * @file abcgOpenGLProgramRegistry.cpp
+ * @brief Definition of abcg::OpenGLProgramRegistry and
+ * abcg::OpenGLSharedProgram members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLProgramRegistry.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <fmt/core.h>
+
+#include "abcgException.hpp"
+#include "abcgProfiler.hpp"
+
+namespace {
+// Same rule as abcg::createOpenGLProgram to tell paths from source codes
+constexpr std::size_t maxPathSize{260};
+
+std::string normalizeLineEndings(std::string_view text) {
+  std::string normalized;
+  normalized.reserve(text.size());
+  for (auto const character : text) {
+    if (character != '\r') {
+      normalized.push_back(character);
+    }
+  }
+  return normalized;
+}
+} // namespace
+
+/**
+ * @brief Deletes the program object.
+ */
+abcg::OpenGLSharedProgram::~OpenGLSharedProgram() { m_program.destroy(); }
+
+/**
+ * @brief Returns the program of a group of shaders, and starts building it if
+ * it does not exist yet.
+ *
+ * @param pathsOrSources Paths or source codes of the shaders of the program.
+ *
+ * @throw abcg::RuntimeError if a shader file could not be read.
+ *
+ * @return Shared program. If the program is new, it is ready after a later
+ * call to abcg::OpenGLProgramRegistry::update or
+ * abcg::OpenGLProgramRegistry::wait.
+ */
+std::shared_ptr<abcg::OpenGLSharedProgram> abcg::OpenGLProgramRegistry::request(
+    std::vector<ShaderSource> const &pathsOrSources) {
+  // The order of the shaders does not change the program
+  auto sorted{pathsOrSources};
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](auto const &lhs, auto const &rhs) {
+                     return lhs.stage < rhs.stage;
+                   });
+
+  std::string key;
+  std::vector<std::string> files;
+  for (auto const &pathOrSource : sorted) {
+    auto const path{getPath(pathOrSource)};
+    if (path) {
+      files.push_back(*path);
+      if (m_watcher) {
+        m_watcher->watch(*path);
+      }
+    }
+    auto const identity{path ? *path
+                             : normalizeLineEndings(pathOrSource.source)};
+    key += fmt::format("{}:{}\n", static_cast<int>(pathOrSource.stage),
+                       identity);
+  }
+
+  if (auto const iter{m_programs.find(key)}; iter != m_programs.end()) {
+    if (auto program{iter->second.lock()}) {
+      ++m_sharedCount;
+      return program;
+    }
+  }
+
+  auto program{std::make_shared<OpenGLSharedProgram>()};
+  program->m_pathsOrSources = std::move(sorted);
+  program->m_files = std::move(files);
+  m_programs.insert_or_assign(key, program);
+  queue(program);
+  return program;
+}
+
+/**
+ * @brief Returns the program of a group of shaders, building it if it does not
+ * exist yet.
+ *
+ * This is the blocking version of abcg::OpenGLProgramRegistry::request.
+ *
+ * @param pathsOrSources Paths or source codes of the shaders of the program.
+ *
+ * @throw abcg::RuntimeError if a shader file could not be read, or if the
+ * compilation or linking failed.
+ *
+ * @return Shared program, ready to be used.
+ */
+std::shared_ptr<abcg::OpenGLSharedProgram> abcg::OpenGLProgramRegistry::load(
+    std::vector<ShaderSource> const &pathsOrSources) {
+  auto program{request(pathsOrSources)};
+  wait();
+  return program;
+}
+
+/**
+ * @brief Polls the programs being built and starts building the requested
+ * ones.
+ *
+ * Called by abcg::OpenGLWindow at the beginning of each frame. A rebuilt
+ * program replaces the previous program object only if the compilation and
+ * linking succeeded.
+ *
+ * @throw abcg::RuntimeError if the first build of a program failed.
+ */
+void abcg::OpenGLProgramRegistry::update() {
+  if (m_watcher) {
+    watchChanges();
+  }
+
+  if (!m_batch && m_queued.empty())
+    return;
+
+  ABCG_PROFILE_SCOPE("Program registry");
+  if (!m_batch) {
+    startBuilds();
+  }
+  if (m_batch->poll()) {
+    finishBuilds();
+  }
+}
+
+/**
+ * @brief Waits until all requested programs are built.
+ *
+ * @throw abcg::RuntimeError if the first build of a program failed.
+ */
+void abcg::OpenGLProgramRegistry::wait() {
+  while (m_batch || !m_queued.empty()) {
+    if (!m_batch) {
+      startBuilds();
+    }
+    m_batch->wait();
+    finishBuilds();
+  }
+}
+
+/**
+ * @brief Rebuilds all live programs from their shader files.
+ *
+ * The files are read again, and each program is replaced when its new build
+ * succeeds. A program that fails to build keeps its previous program object.
+ */
+void abcg::OpenGLProgramRegistry::reload() {
+  m_fileSources.clear();
+  for (auto const &program : getPrograms()) {
+    queue(program);
+  }
+}
+
+/**
+ * @brief Deletes all program objects.
+ *
+ * Called by abcg::OpenGLWindow after abcg::OpenGLWindow::onDestroy, so that
+ * the references still alive do not use the OpenGL context after it is
+ * destroyed.
+ */
+void abcg::OpenGLProgramRegistry::destroy() {
+  m_queued.clear();
+  if (m_batch) {
+    m_batch->wait();
+    finishBuilds();
+  }
+  for (auto const &program : getPrograms()) {
+    program->m_program.destroy();
+  }
+  m_programs.clear();
+  m_fileSources.clear();
+  m_watcher.reset();
+}
+
+/**
+ * @brief Enables or disables hot reload.
+ *
+ * @param enabled Whether to watch the shader files of the programs and
+ * rebuild the programs when the files change.
+ */
+void abcg::OpenGLProgramRegistry::setHotReload(bool enabled) {
+  if (!enabled) {
+    m_watcher.reset();
+    return;
+  }
+  if (m_watcher)
+    return;
+
+  m_watcher = std::make_unique<FileWatcher>();
+  for (auto const &program : getPrograms()) {
+    for (auto const &file : program->m_files) {
+      m_watcher->watch(file);
+    }
+  }
+}
+
+/**
+ * @brief Returns the programs that are still referenced.
+ *
+ * @return References to the live programs.
+ */
+std::vector<std::shared_ptr<abcg::OpenGLSharedProgram>>
+abcg::OpenGLProgramRegistry::getPrograms() const {
+  std::vector<std::shared_ptr<OpenGLSharedProgram>> programs;
+  for (auto const &[key, weakProgram] : m_programs) {
+    if (auto program{weakProgram.lock()}) {
+      programs.push_back(std::move(program));
+    }
+  }
+  return programs;
+}
+
+// Returns the canonical path of the shader file, or an empty optional if
+// pathOrSource is a source code
+std::optional<std::string> abcg::OpenGLProgramRegistry::getPath(
+    ShaderSource const &pathOrSource) const {
+  std::string_view const text{pathOrSource.source};
+  std::error_code error;
+  if (text.size() > maxPathSize || !std::filesystem::exists(text, error)) {
+    return std::nullopt;
+  }
+  auto path{std::filesystem::weakly_canonical(text, error).string()};
+  return error ? std::string{text} : path;
+}
+
+// Returns the contents of a shader file, reading it only once
+std::string const &
+abcg::OpenGLProgramRegistry::readFile(std::string const &path) {
+  if (auto const iter{m_fileSources.find(path)};
+      iter != m_fileSources.end()) {
+    return iter->second;
+  }
+
+  std::ifstream stream{path};
+  if (!stream) {
+    throw abcg::RuntimeError(fmt::format("Failed to read file {}", path));
+  }
+  std::stringstream contents;
+  contents << stream.rdbuf();
+  return m_fileSources.emplace(path, contents.str()).first->second;
+}
+
+// Queues the programs that use the files modified since the last call
+void abcg::OpenGLProgramRegistry::watchChanges() {
+  auto const changed{m_watcher->poll()};
+  if (changed.empty())
+    return;
+
+  for (auto const &file : changed) {
+    fmt::print("Shader file changed: {}\n", file.string());
+    m_fileSources.erase(file.string());
+  }
+  for (auto const &program : getPrograms()) {
+    if (std::any_of(
+            program->m_files.begin(), program->m_files.end(),
+            [&](auto const &path) {
+              return std::find(changed.begin(), changed.end(), path) !=
+                     changed.end();
+            })) {
+      queue(program);
+    }
+  }
+}
+
+void abcg::OpenGLProgramRegistry::queue(
+    std::shared_ptr<OpenGLSharedProgram> const &program) {
+  if (std::find(m_queued.begin(), m_queued.end(), program) == m_queued.end()) {
+    m_queued.push_back(program);
+  }
+}
+
+void abcg::OpenGLProgramRegistry::startBuilds() {
+  // Errors are reported by finishBuilds, so that a failed rebuild keeps the
+  // previous program
+  m_batch = std::make_unique<OpenGLProgramBatch>(false);
+
+  for (auto &program : std::exchange(m_queued, {})) {
+    std::vector<ShaderSource> sources;
+    sources.reserve(program->m_pathsOrSources.size());
+    try {
+      for (auto const &pathOrSource : program->m_pathsOrSources) {
+        auto const path{getPath(pathOrSource)};
+        sources.push_back(
+            {.source = path ? readFile(*path) : pathOrSource.source,
+             .stage = pathOrSource.stage});
+      }
+    } catch (abcg::RuntimeError const &exception) {
+      if (!program->isReady())
+        throw;
+      // The file may be in the middle of being saved
+      fmt::print("Warning: {}\n", exception.what());
+      continue;
+    }
+    m_builds.push_back(
+        {.program = std::move(program), .handle = m_batch->add(sources)});
+  }
+
+  m_batch->start();
+}
+
+void abcg::OpenGLProgramRegistry::finishBuilds() {
+  auto failedFirstBuild{false};
+  for (auto const &build : m_builds) {
+    auto const program{m_batch->getProgram(build.handle)};
+    if (program == 0) {
+      if (build.program->isReady()) {
+        fmt::print("Warning: failed to rebuild program, keeping the previous "
+                   "one\n");
+      } else {
+        failedFirstBuild = true;
+      }
+      continue;
+    }
+    // Deletes the previous program object and reflects the new one
+    build.program->m_program.create(program);
+  }
+  m_builds.clear();
+  m_batch.reset();
+
+  // Like abcg::createOpenGLProgram, the first build of a program must succeed
+  if (failedFirstBuild) {
+    throw abcg::RuntimeError("Failed to build program");
+  }
+
+  // Forget the programs that are no longer referenced
+  std::erase_if(m_programs,
+                [](auto const &entry) { return entry.second.expired(); });
+}
@@ -0,0 +1,183 @@
+/**
+ * @file abcgOpenGLProgramRegistry.hpp
+ * @brief Header file of abcg::OpenGLProgramRegistry.
+ *
+ * Declaration of abcg::OpenGLProgramRegistry and abcg::OpenGLSharedProgram.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_PROGRAM_REGISTRY_HPP_
+#define ABCG_OPENGL_PROGRAM_REGISTRY_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "abcgFileWatcher.hpp"
+#include "abcgOpenGLExternal.hpp"
+#include "abcgOpenGLProgram.hpp"
+#include "abcgOpenGLShader.hpp"
+
+namespace abcg {
+class OpenGLSharedProgram;
+class OpenGLProgramRegistry;
+} // namespace abcg
+
+/**
+ * @brief Program object shared by all users of abcg::OpenGLProgramRegistry
+ * that requested the same shaders.
+ *
+ * The program object is deleted when the last reference is released. Release
+ * all references before the OpenGL context is destroyed (e.g., in
+ * abcg::OpenGLWindow::onDestroy).
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::OpenGLSharedProgram {
+public:
+  OpenGLSharedProgram() = default;
+  OpenGLSharedProgram(OpenGLSharedProgram const &) = delete;
+  OpenGLSharedProgram(OpenGLSharedProgram &&) = delete;
+  OpenGLSharedProgram &operator=(OpenGLSharedProgram const &) = delete;
+  OpenGLSharedProgram &operator=(OpenGLSharedProgram &&) = delete;
+  ~OpenGLSharedProgram();
+
+  /**
+   * @brief Returns the ID of the program object.
+   *
+   * @return ID of the program object, or 0 if the program is not ready.
+   */
+  [[nodiscard]] GLuint getID() const noexcept { return m_program.getID(); }
+
+  /**
+   * @brief Returns whether the program has been built.
+   *
+   * @return `true` if the program can be used.
+   */
+  [[nodiscard]] bool isReady() const noexcept {
+    return m_program.getID() != 0;
+  }
+
+  /**
+   * @brief Returns the reflected program.
+   *
+   * The program is reflected again whenever it is rebuilt, and its uniform
+   * handles remain valid.
+   *
+   * @return Reference to the program.
+   */
+  [[nodiscard]] OpenGLProgram &getProgram() noexcept { return m_program; }
+
+  /**
+   * @brief Returns the paths or source codes the program was requested with.
+   *
+   * @return Shader paths or source codes, sorted by stage.
+   */
+  [[nodiscard]] std::vector<ShaderSource> const &
+  getPathsOrSources() const noexcept {
+    return m_pathsOrSources;
+  }
+
+private:
+  friend OpenGLProgramRegistry;
+
+  OpenGLProgram m_program;
+  std::vector<ShaderSource> m_pathsOrSources;
+  // Canonical paths of the shader files
+  std::vector<std::string> m_files;
+};
+
+/**
+ * @brief Registry that interns shader programs.
+ *
+ * Programs are identified by their set of stages and, for each stage, either
+ * the canonical path of the shader file or the source code with normalized
+ * line endings. Requesting a program that is already alive returns the same
+ * reference-counted abcg::OpenGLSharedProgram, so identical programs are
+ * compiled and linked once. Each shader file is read once.
+ *
+ * Programs are built asynchronously with abcg::OpenGLProgramBatch.
+ * abcg::OpenGLWindow owns a registry (see
+ * abcg::OpenGLWindow::getProgramRegistry) and calls
+ * abcg::OpenGLProgramRegistry::update at the beginning of each frame, so
+ * requested programs become ready a few frames later, without blocking.
+ *
+ * With hot reload enabled (see abcg::ApplicationSettings::hotReload), the
+ * shader files are watched with abcg::FileWatcher, and the programs that use a
+ * modified file are rebuilt in the background. The program object of an
+ * abcg::OpenGLSharedProgram is replaced at the beginning of a frame, and only
+ * if the new build succeeds, so always read it with
+ * abcg::OpenGLSharedProgram::getID instead of keeping a copy.
+ *
+ * All member functions must be called from the thread where the OpenGL context
+ * is current.
+ */
+class abcg::OpenGLProgramRegistry {
+public:
+  [[nodiscard]] std::shared_ptr<OpenGLSharedProgram>
+  request(std::vector<ShaderSource> const &pathsOrSources);
+  [[nodiscard]] std::shared_ptr<OpenGLSharedProgram>
+  load(std::vector<ShaderSource> const &pathsOrSources);
+
+  void update();
+  void wait();
+  void reload();
+  void destroy();
+
+  void setHotReload(bool enabled);
+
+  /**
+   * @brief Returns whether the shader files are watched for changes.
+   *
+   * @return `true` if hot reload is enabled.
+   */
+  [[nodiscard]] bool isHotReloadEnabled() const noexcept {
+    return m_watcher != nullptr;
+  }
+
+  [[nodiscard]] std::vector<std::shared_ptr<OpenGLSharedProgram>>
+  getPrograms() const;
+
+  /**
+   * @brief Returns the number of requests that were served by a program that
+   * already existed.
+   *
+   * @return Number of deduplicated requests.
+   */
+  [[nodiscard]] std::size_t getSharedCount() const noexcept {
+    return m_sharedCount;
+  }
+
+private:
+  struct Build {
+    std::shared_ptr<OpenGLSharedProgram> program;
+    std::size_t handle{};
+  };
+
+  [[nodiscard]] std::optional<std::string>
+  getPath(ShaderSource const &pathOrSource) const;
+  [[nodiscard]] std::string const &readFile(std::string const &path);
+  void watchChanges();
+  void queue(std::shared_ptr<OpenGLSharedProgram> const &program);
+  void startBuilds();
+  void finishBuilds();
+
+  std::unordered_map<std::string, std::weak_ptr<OpenGLSharedProgram>>
+      m_programs;
+  std::unordered_map<std::string, std::string> m_fileSources;
+  std::vector<std::shared_ptr<OpenGLSharedProgram>> m_queued;
+
+  std::unique_ptr<FileWatcher> m_watcher;
+  std::unique_ptr<OpenGLProgramBatch> m_batch;
+  std::vector<Build> m_builds;
+  std::size_t m_sharedCount{};
+};
+
+#endif
@@ -15,13 +15,17 @@
 #include <fmt/core.h>
 #include <gsl/gsl>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <optional>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 #include "abcgException.hpp"
+#include "abcgOpenGLProgramCache.hpp"
+#include "abcgProfiler.hpp"
 
 static void printShaderInfoLog(GLuint const shader, std::string_view prefix) {
   GLint infoLogLength{};
@@ -146,6 +150,10 @@ static void deleteShaders(std::vector<abcg::OpenGLShader> const &shaderIDs) {
 /**
  * @brief Creates a program object from a group of shader paths or source codes.
  *
+ * If the program is in abcg::OpenGLProgramCache, it is created from the cached
+ * binary, without compiling the shaders. Otherwise, the binary of the linked
+ * program is stored in the cache.
+ *
  * @param pathsOrSources Paths or source codes of the shaders to be compiled and
  * linked to the program.
  * @param throwOnError Whether to throw exceptions on compile/link errors.
@@ -159,6 +167,7 @@ static void deleteShaders(std::vector<abcg::OpenGLShader> const &shaderIDs) {
 GLuint
 abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
                           bool throwOnError) {
+  ABCG_PROFILE_SCOPE("Create program");
   std::vector<ShaderSource> sources;
   sources.reserve(pathsOrSources.size());
   for (auto const &pathOrSource : pathsOrSources) {
@@ -166,6 +175,11 @@ abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
         {.source = toSource(pathOrSource.source), .stage = pathOrSource.stage});
   }
 
+  if (auto const cachedProgram{OpenGLProgramCache::load(sources)};
+      cachedProgram != 0) {
+    return cachedProgram;
+  }
+
   std::vector<OpenGLShader> compiledShaders;
   compiledShaders.reserve(sources.size());
   for (auto const &source : sources) {
@@ -189,6 +203,11 @@ abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
     glAttachShader(shaderProgram, shader.shader);
   }
 
+  if (OpenGLProgramCache::isEnabled() && OpenGLProgramCache::isSupported()) {
+    glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+  }
+
   glLinkProgram(shaderProgram);
 
   for (auto const &shader : compiledShaders) {
@@ -209,6 +228,8 @@ abcg::createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
     return 0U;
   }
 
+  OpenGLProgramCache::store(sources, shaderProgram);
+
   return shaderProgram;
 }
 
@@ -361,4 +382,225 @@ bool abcg::checkOpenGLShaderLink(GLuint shaderProgram, bool throwOnError) {
   }
 
   return true;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Creates an empty batch.
+ *
+ * @param throwOnError Whether abcg::OpenGLProgramBatch::poll throws exceptions
+ * on compile/link errors.
+ */
+abcg::OpenGLProgramBatch::OpenGLProgramBatch(bool throwOnError)
+    : m_throwOnError{throwOnError} {}
+
+/**
+ * @brief Adds a program to the batch.
+ *
+ * Must be called before abcg::OpenGLProgramBatch::start.
+ *
+ * @param pathsOrSources Paths or source codes of the shaders of the program.
+ *
+ * @return Handle of the program in the batch.
+ */
+std::size_t
+abcg::OpenGLProgramBatch::add(std::vector<ShaderSource> const &pathsOrSources) {
+  auto &entry{m_entries.emplace_back()};
+  entry.sources = pathsOrSources;
+  return m_entries.size() - 1;
+}
+
+/**
+ * @brief Issues the compilation and linking of all programs added so far.
+ *
+ * @throw abcg::RuntimeError if a shader could not be read from file, or if a
+ * program could not be created.
+ */
+void abcg::OpenGLProgramBatch::start() {
+  ABCG_PROFILE_SCOPE("Start program batch");
+#if !defined(__EMSCRIPTEN__)
+  m_parallel = GLEW_KHR_parallel_shader_compile;
+  if (m_parallel) {
+    // Let the driver choose the number of compiler threads
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  }
+#endif
+
+  // Compile all shaders first, so that the driver can work on all of them
+  // while the programs are being linked
+  for (auto &entry : m_entries) {
+    if (entry.status != Status::Queued)
+      continue;
+    for (auto &source : entry.sources) {
+      source.source = toSource(source.source);
+    }
+    if (auto const program{OpenGLProgramCache::load(entry.sources)};
+        program != 0) {
+      entry.program = program;
+      entry.status = Status::Ready;
+      ++m_completed;
+      continue;
+    }
+    entry.shaders.reserve(entry.sources.size());
+    for (auto const &source : entry.sources) {
+      entry.shaders.push_back(
+          compileHelper(source.source, abcgStageToOpenGLStage(source.stage)));
+    }
+    entry.status = Status::Building;
+  }
+
+  for (auto &entry : m_entries) {
+    if (entry.status != Status::Building || entry.program != 0)
+      continue;
+    entry.program = glCreateProgram();
+    if (entry.program == 0) {
+      deleteShaders(entry.shaders);
+      entry.shaders.clear();
+      entry.status = Status::Failed;
+      ++m_completed;
+      if (m_throwOnError) {
+        throw abcg::RuntimeError("Failed to create program");
+      }
+      continue;
+    }
+    for (auto const &shader : entry.shaders) {
+      glAttachShader(entry.program, shader.shader);
+    }
+    if (OpenGLProgramCache::isEnabled() && OpenGLProgramCache::isSupported()) {
+      glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                          GL_TRUE);
+    }
+    glLinkProgram(entry.program);
+  }
+}
+
+/**
+ * @brief Checks the programs being built, without blocking if
+ * `KHR_parallel_shader_compile` is supported.
+ *
+ * @throw abcg::RuntimeError if the compilation or linking of a program failed.
+ *
+ * @return `true` if all programs are either ready or failed.
+ */
+bool abcg::OpenGLProgramBatch::poll() {
+  ABCG_PROFILE_SCOPE("Poll program batch");
+  for (auto &entry : m_entries) {
+    if (entry.status != Status::Building)
+      continue;
+#if !defined(__EMSCRIPTEN__)
+    if (m_parallel) {
+      GLint completed{};
+      glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &completed);
+      if (completed == GL_FALSE)
+        continue;
+      finish(entry);
+      continue;
+    }
+#endif
+    // Without the extension, any query blocks: finish one program per call
+    finish(entry);
+    break;
+  }
+  return isDone();
+}
+
+/**
+ * @brief Waits until all programs are either ready or failed.
+ *
+ * @throw abcg::RuntimeError if the compilation or linking of a program failed.
+ */
+void abcg::OpenGLProgramBatch::wait() {
+  for (auto &entry : m_entries) {
+    if (entry.status == Status::Building) {
+      finish(entry);
+    }
+  }
+}
+
+/**
+ * @brief Returns whether all programs are either ready or failed.
+ *
+ * @return `true` if no program is being built.
+ */
+bool abcg::OpenGLProgramBatch::isDone() const noexcept {
+  return m_completed == m_entries.size();
+}
+
+/**
+ * @brief Returns whether a program is ready to be used.
+ *
+ * @param handle Handle returned by abcg::OpenGLProgramBatch::add.
+ *
+ * @return `true` if the program was linked successfully.
+ */
+bool abcg::OpenGLProgramBatch::isReady(std::size_t handle) const {
+  return m_entries.at(handle).status == Status::Ready;
+}
+
+/**
+ * @brief Returns the ID of a program.
+ *
+ * @param handle Handle returned by abcg::OpenGLProgramBatch::add.
+ *
+ * @return ID of the program object, or 0 if it is not ready.
+ */
+GLuint abcg::OpenGLProgramBatch::getProgram(std::size_t handle) const {
+  auto const &entry{m_entries.at(handle)};
+  return entry.status == Status::Ready ? entry.program : 0U;
+}
+
+/**
+ * @brief Returns the fraction of programs that are either ready or failed.
+ *
+ * @return Progress between 0 and 1.
+ */
+float abcg::OpenGLProgramBatch::getProgress() const noexcept {
+  if (m_entries.empty())
+    return 1.0f;
+  return static_cast<float>(m_completed) /
+         static_cast<float>(m_entries.size());
+}
+
+void abcg::OpenGLProgramBatch::finish(Entry &entry) {
+  ++m_completed;
+  entry.status = Status::Failed;
+
+  auto compiled{true};
+  for (auto const &shader : entry.shaders) {
+    GLint compileStatus{};
+    glGetShaderiv(shader.shader, GL_COMPILE_STATUS, &compileStatus);
+    if (compileStatus == GL_FALSE) {
+      compiled = false;
+      // Errors that do not throw are still reported
+      if (!m_throwOnError) {
+        printShaderInfoLog(shader.shader, shaderStageToText(shader.stage));
+      }
+    }
+  }
+  auto const shaders{std::exchange(entry.shaders, {})};
+  if (!compiled) {
+    glDeleteProgram(std::exchange(entry.program, 0U));
+    // Prints the log and throws, or deletes the shaders
+    static_cast<void>(checkOpenGLShaderCompile(shaders, m_throwOnError));
+    return;
+  }
+
+  for (auto const &shader : shaders) {
+    glDetachShader(entry.program, shader.shader);
+  }
+  deleteShaders(shaders);
+
+  if (!m_throwOnError) {
+    GLint linkStatus{};
+    glGetProgramiv(entry.program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus == GL_FALSE) {
+      printProgramInfoLog(entry.program);
+    }
+  }
+  if (!checkOpenGLShaderLink(entry.program, m_throwOnError)) {
+    entry.program = 0;
+    return;
+  }
+
+  OpenGLProgramCache::store(entry.sources, entry.program);
+  entry.status = Status::Ready;
+}
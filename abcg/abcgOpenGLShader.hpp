@@ -14,11 +14,13 @@
 #include "abcgOpenGLExternal.hpp"
 #include "abcgShader.hpp"
 
+#include <cstddef>
 #include <vector>
 
 namespace abcg {
 struct OpenGLShader;
-}
+class OpenGLProgramBatch;
+} // namespace abcg
 
 /**
  * @brief OpenGL shader object and its corresponding stage.
@@ -30,6 +32,60 @@ struct abcg::OpenGLShader {
   GLuint stage{};
 };
 
+/**
+ * @brief Builds a group of programs in parallel across frames.
+ *
+ * Programs are added with abcg::OpenGLProgramBatch::add, which returns a
+ * handle. abcg::OpenGLProgramBatch::start issues the compilation of all
+ * shaders and the linking of all programs without waiting for any of them.
+ * abcg::OpenGLProgramBatch::poll is then called once per frame (e.g., in
+ * abcg::OpenGLWindow::onPaint) until abcg::OpenGLProgramBatch::isDone returns
+ * `true`, so that the application can render a loading screen meanwhile.
+ *
+ * If `KHR_parallel_shader_compile` is supported, the driver is allowed to use
+ * as many compiler threads as it wants, and the completion of each program is
+ * queried with `GL_COMPLETION_STATUS_KHR` without blocking. Otherwise, each
+ * call to abcg::OpenGLProgramBatch::poll waits for one program.
+ *
+ * Programs found in abcg::OpenGLProgramCache are ready after
+ * abcg::OpenGLProgramBatch::start.
+ *
+ * All member functions must be called from the thread where the OpenGL context
+ * is current. The programs are owned by the caller once they are ready.
+ */
+class abcg::OpenGLProgramBatch {
+public:
+  explicit OpenGLProgramBatch(bool throwOnError = true);
+
+  [[nodiscard]] std::size_t
+  add(std::vector<ShaderSource> const &pathsOrSources);
+  void start();
+  bool poll();
+  void wait();
+
+  [[nodiscard]] bool isDone() const noexcept;
+  [[nodiscard]] bool isReady(std::size_t handle) const;
+  [[nodiscard]] GLuint getProgram(std::size_t handle) const;
+  [[nodiscard]] float getProgress() const noexcept;
+
+private:
+  enum class Status { Queued, Building, Ready, Failed };
+
+  struct Entry {
+    std::vector<ShaderSource> sources;
+    std::vector<OpenGLShader> shaders;
+    GLuint program{};
+    Status status{Status::Queued};
+  };
+
+  void finish(Entry &entry);
+
+  bool m_throwOnError{};
+  bool m_parallel{};
+  std::vector<Entry> m_entries;
+  std::size_t m_completed{};
+};
+
 namespace abcg {
 [[nodiscard]] GLuint
 createOpenGLProgram(std::vector<ShaderSource> const &pathsOrSources,
@@ -0,0 +1,242 @@
+/**
+ * @file abcgOpenGLStateCache.cpp
+ * @brief Definition of abcg::OpenGLStateCache members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLStateCache.hpp"
+
+#include <array>
+#include <limits>
+#include <optional>
+#include <span>
+
+namespace {
+// Value of a binding that was not set through the cache
+constexpr GLuint unknown{std::numeric_limits<GLuint>::max()};
+
+constexpr std::array<GLenum, 7> trackedBufferTargets{
+    GL_ARRAY_BUFFER,       GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER,
+    GL_PIXEL_PACK_BUFFER,  GL_PIXEL_UNPACK_BUFFER,  GL_COPY_READ_BUFFER,
+    GL_COPY_WRITE_BUFFER};
+static_assert(trackedBufferTargets.at(1) == GL_ELEMENT_ARRAY_BUFFER);
+
+constexpr std::array<GLenum, 4> trackedTextureTargets{
+    GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_3D, GL_TEXTURE_2D_ARRAY};
+
+constexpr std::array<GLenum, 5> trackedCapabilities{
+    GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST, GL_STENCIL_TEST};
+
+constexpr std::size_t textureUnits{32};
+
+enum class Capability : std::uint8_t { Disabled, Enabled, Unknown };
+
+struct CacheState {
+  bool enabled{true};
+  std::uint64_t skipped{};
+
+  GLuint program{unknown};
+  GLuint vertexArray{unknown};
+  std::array<GLuint, trackedBufferTargets.size()> buffers{};
+  GLenum activeTexture{};
+  std::array<std::array<GLuint, trackedTextureTargets.size()>, textureUnits>
+      textures{};
+  std::array<Capability, trackedCapabilities.size()> capabilities{};
+  std::optional<std::array<GLint, 4>> viewport;
+};
+
+// Marks all states as unknown
+void reset(CacheState &state) {
+  state.program = unknown;
+  state.vertexArray = unknown;
+  state.buffers.fill(unknown);
+  state.activeTexture = 0;
+  for (auto &unit : state.textures) {
+    unit.fill(unknown);
+  }
+  state.capabilities.fill(Capability::Unknown);
+  state.viewport.reset();
+}
+
+CacheState &getState() {
+  static CacheState state{[] {
+    CacheState initial;
+    reset(initial);
+    return initial;
+  }()};
+  return state;
+}
+
+template <std::size_t N>
+std::optional<std::size_t> indexOf(std::array<GLenum, N> const &table,
+                                   GLenum value) {
+  for (std::size_t index{}; index < N; ++index) {
+    if (table.at(index) == value)
+      return index;
+  }
+  return std::nullopt;
+}
+
+GLuint &elementArrayBuffer(CacheState &state) {
+  return state.buffers.at(1);
+}
+
+// Updates a cached value. Returns whether the call must reach the driver.
+template <typename T> bool update(T &cached, T const &value) {
+  auto &state{getState()};
+  if (!state.enabled)
+    return true;
+  if (cached == value) {
+    ++state.skipped;
+    return false;
+  }
+  cached = value;
+  return true;
+}
+
+// Replaces the cached bindings of deleted objects with 0, as OpenGL does for
+// the bindings of the current context
+template <typename Range>
+void unbindDeleted(Range &&bindings, GLsizei n, GLuint const *names) {
+  if (names == nullptr)
+    return;
+  std::span const deleted{names, static_cast<std::size_t>(n)};
+  for (auto &binding : bindings) {
+    for (auto const name : deleted) {
+      if (name != 0 && binding == name) {
+        binding = 0;
+      }
+    }
+  }
+}
+} // namespace
+
+/**
+ * @brief Enables or disables the cache.
+ *
+ * When disabled, all calls reach the driver. The cache is invalidated when it
+ * is enabled again.
+ *
+ * @param enabled Whether the `abcg::gl*` wrappers should skip redundant calls.
+ */
+void abcg::OpenGLStateCache::setEnabled(bool enabled) noexcept {
+  auto &state{getState()};
+  if (enabled && !state.enabled) {
+    invalidate();
+  }
+  state.enabled = enabled;
+}
+
+/**
+ * @brief Returns whether the cache is enabled.
+ *
+ * @return `true` if the cache is enabled.
+ */
+bool abcg::OpenGLStateCache::isEnabled() noexcept {
+  return getState().enabled;
+}
+
+/**
+ * @brief Marks all cached states as unknown.
+ *
+ * Call this after the OpenGL state is changed without the `abcg::gl*`
+ * wrappers.
+ */
+void abcg::OpenGLStateCache::invalidate() noexcept { reset(getState()); }
+
+/**
+ * @brief Returns the number of calls that were skipped because they would not
+ * change the state.
+ *
+ * @return Number of redundant calls skipped since the start of the
+ * application.
+ */
+std::uint64_t abcg::OpenGLStateCache::getSkippedCount() noexcept {
+  return getState().skipped;
+}
+
+bool abcg::OpenGLStateCache::useProgram(GLuint program) noexcept {
+  return update(getState().program, program);
+}
+
+bool abcg::OpenGLStateCache::bindVertexArray(GLuint array) noexcept {
+  auto &state{getState()};
+  if (!update(state.vertexArray, array))
+    return false;
+  // The element array buffer binding is part of the vertex array state
+  elementArrayBuffer(state) = unknown;
+  return true;
+}
+
+bool abcg::OpenGLStateCache::bindBuffer(GLenum target, GLuint buffer) noexcept {
+  auto const index{indexOf(trackedBufferTargets, target)};
+  if (!index)
+    return true;
+  return update(getState().buffers.at(*index), buffer);
+}
+
+void abcg::OpenGLStateCache::bindBufferBase(GLenum target,
+                                            GLuint buffer) noexcept {
+  // Binding to an indexed target also binds to the generic target
+  if (auto const index{indexOf(trackedBufferTargets, target)}) {
+    getState().buffers.at(*index) = buffer;
+  }
+}
+
+bool abcg::OpenGLStateCache::activeTexture(GLenum texture) noexcept {
+  return update(getState().activeTexture, texture);
+}
+
+bool abcg::OpenGLStateCache::bindTexture(GLenum target,
+                                         GLuint texture) noexcept {
+  auto &state{getState()};
+  auto const index{indexOf(trackedTextureTargets, target)};
+  auto const unit{static_cast<std::size_t>(state.activeTexture - GL_TEXTURE0)};
+  if (!index || state.activeTexture == 0 || unit >= textureUnits)
+    return true;
+  return update(state.textures.at(unit).at(*index), texture);
+}
+
+bool abcg::OpenGLStateCache::setCapability(GLenum cap, bool enabled) noexcept {
+  auto const index{indexOf(trackedCapabilities, cap)};
+  if (!index)
+    return true;
+  return update(getState().capabilities.at(*index),
+                enabled ? Capability::Enabled : Capability::Disabled);
+}
+
+bool abcg::OpenGLStateCache::viewport(GLint x, GLint y, GLsizei width,
+                                      GLsizei height) noexcept {
+  return update(getState().viewport,
+                std::optional{std::array{x, y, width, height}});
+}
+
+void abcg::OpenGLStateCache::deleteBuffers(GLsizei n,
+                                           GLuint const *buffers) noexcept {
+  unbindDeleted(getState().buffers, n, buffers);
+}
+
+void abcg::OpenGLStateCache::deleteVertexArrays(GLsizei n,
+                                                GLuint const *arrays) noexcept {
+  auto &state{getState()};
+  if (arrays == nullptr)
+    return;
+  for (auto const array : std::span{arrays, static_cast<std::size_t>(n)}) {
+    if (array != 0 && state.vertexArray == array) {
+      // The default vertex array becomes bound
+      state.vertexArray = 0;
+      elementArrayBuffer(state) = unknown;
+    }
+  }
+}
+
+void abcg::OpenGLStateCache::deleteTextures(GLsizei n,
+                                            GLuint const *textures) noexcept {
+  for (auto &unit : getState().textures) {
+    unbindDeleted(unit, n, textures);
+  }
+}
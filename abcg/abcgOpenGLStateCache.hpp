@@ -0,0 +1,76 @@
+/**
+ * @file abcgOpenGLStateCache.hpp
+ * @brief Header file of abcg::OpenGLStateCache.
+ *
+ * Declaration of abcg::OpenGLStateCache.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_STATE_CACHE_HPP_
+#define ABCG_OPENGL_STATE_CACHE_HPP_
+
+#include <cstdint>
+
+#include "abcgOpenGLExternal.hpp"
+
+namespace abcg {
+class OpenGLStateCache;
+} // namespace abcg
+
+/**
+ * @brief Shadow copy of the OpenGL state set through the `abcg::gl*`
+ * wrappers.
+ *
+ * The wrappers of abcgOpenGLFunction.hpp consult the cache before calling the
+ * driver, and skip calls that would set a state to its current value. The
+ * cache tracks:
+ *
+ * - the program in use (`glUseProgram`);
+ * - the vertex array object (`glBindVertexArray`);
+ * - the buffer bound to each common target (`glBindBuffer`,
+ * `glBindBufferBase`, `glBindBufferRange`);
+ * - the active texture unit and the textures bound to the first 32 units
+ * (`glActiveTexture`, `glBindTexture`);
+ * - the `GL_BLEND`, `GL_CULL_FACE`, `GL_DEPTH_TEST`, `GL_SCISSOR_TEST` and
+ * `GL_STENCIL_TEST` capabilities (`glEnable`, `glDisable`);
+ * - the viewport (`glViewport`).
+ *
+ * Initially, and after abcg::OpenGLStateCache::invalidate, every state is
+ * unknown and the next call that sets it reaches the driver.
+ * abcg::OpenGLWindow invalidates the cache when the context is created, and
+ * after Dear ImGui renders its draw data.
+ *
+ * @remark OpenGL functions called without the `abcg::` prefix bypass the
+ * cache. Call abcg::OpenGLStateCache::invalidate after such calls, or disable
+ * the cache with abcg::OpenGLStateCache::setEnabled.
+ */
+class abcg::OpenGLStateCache {
+public:
+  static void setEnabled(bool enabled) noexcept;
+  [[nodiscard]] static bool isEnabled() noexcept;
+  static void invalidate() noexcept;
+  [[nodiscard]] static std::uint64_t getSkippedCount() noexcept;
+
+  // The functions below are called by the wrappers of abcgOpenGLFunction.hpp.
+  // Those that return a bool update the cache and return whether the call
+  // must reach the driver.
+
+  [[nodiscard]] static bool useProgram(GLuint program) noexcept;
+  [[nodiscard]] static bool bindVertexArray(GLuint array) noexcept;
+  [[nodiscard]] static bool bindBuffer(GLenum target, GLuint buffer) noexcept;
+  static void bindBufferBase(GLenum target, GLuint buffer) noexcept;
+  [[nodiscard]] static bool activeTexture(GLenum texture) noexcept;
+  [[nodiscard]] static bool bindTexture(GLenum target, GLuint texture) noexcept;
+  [[nodiscard]] static bool setCapability(GLenum cap, bool enabled) noexcept;
+  [[nodiscard]] static bool viewport(GLint x, GLint y, GLsizei width,
+                                     GLsizei height) noexcept;
+  static void deleteBuffers(GLsizei n, GLuint const *buffers) noexcept;
+  static void deleteVertexArrays(GLsizei n, GLuint const *arrays) noexcept;
+  static void deleteTextures(GLsizei n, GLuint const *textures) noexcept;
+};
+
+#endif
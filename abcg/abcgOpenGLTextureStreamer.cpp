@@ -0,0 +1,454 @@
+/**
+ * @file abcgOpenGLTextureStreamer.cpp
+ * @brief Definition of abcg::OpenGLTextureStreamer and
+ * abcg::OpenGLStreamedTexture members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLTextureStreamer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include "abcgException.hpp"
+#include "abcgImage.hpp"
+#include "abcgOpenGLFunction.hpp"
+#include "abcgProfiler.hpp"
+
+abcg::OpenGLStreamedTexture::~OpenGLStreamedTexture() {
+  if (m_texture != 0) {
+    abcg::glDeleteTextures(1, &m_texture);
+  }
+}
+
+/**
+ * @brief Creates the placeholder texture and the pixel unpack buffer.
+ *
+ * @param jobSystem Job system whose workers decode the images.
+ * @param bytesPerFrame Maximum number of bytes uploaded by each call to
+ * abcg::OpenGLTextureStreamer::update. At least one row of an image is
+ * uploaded per frame regardless of this value.
+ */
+void abcg::OpenGLTextureStreamer::create(JobSystem &jobSystem,
+                                         std::size_t bytesPerFrame) {
+  destroy();
+
+  m_jobSystem = &jobSystem;
+  m_bytesPerFrame = bytesPerFrame;
+
+  // Opaque white, so that lighting is still visible while loading
+  std::array<GLubyte, 4> const texel{255, 255, 255, 255};
+  abcg::glGenTextures(1, &m_placeholder);
+  abcg::glBindTexture(GL_TEXTURE_2D, m_placeholder);
+  abcg::glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, texel.data());
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+
+  abcg::glGenBuffers(1, &m_unpackBuffer);
+}
+
+/**
+ * @brief Waits for the images being decoded and deletes the placeholder
+ * texture and the pixel unpack buffer.
+ *
+ * Textures that are not live remain bound to the placeholder texture, which
+ * is deleted.
+ */
+void abcg::OpenGLTextureStreamer::destroy() {
+  std::scoped_lock const lock{m_mutex};
+  for (auto const &request : m_decoding) {
+    m_jobSystem->wait(request.counter);
+  }
+  m_decoding.clear();
+  m_uploading.clear();
+
+  abcg::glDeleteBuffers(1, &m_unpackBuffer);
+  abcg::glDeleteTextures(1, &m_placeholder);
+  m_unpackBuffer = 0;
+  m_placeholder = 0;
+}
+
+/**
+ * @brief Requests a 2D texture to be loaded asynchronously.
+ *
+ * May be called from any thread.
+ *
+ * @param createInfo Creation info, as in abcg::loadOpenGLTexture.
+ * @param onReady Function called on the thread that renders when the texture
+ * becomes live or fails to load. Check abcg::OpenGLStreamedTexture::getStatus
+ * to tell the two apart.
+ *
+ * @throw abcg::RuntimeError if abcg::OpenGLTextureStreamer::create was not
+ * called.
+ *
+ * @return Texture bound to the placeholder texture until it is live.
+ */
+std::shared_ptr<abcg::OpenGLStreamedTexture>
+abcg::OpenGLTextureStreamer::request(OpenGLTextureCreateInfo const &createInfo,
+                                     Callback onReady) {
+  std::scoped_lock const lock{m_mutex};
+  if (m_jobSystem == nullptr) {
+    throw abcg::RuntimeError("Texture streamer was not created");
+  }
+
+  auto texture{std::make_shared<OpenGLStreamedTexture>()};
+  texture->m_path = createInfo.path;
+  texture->m_placeholder = m_placeholder;
+
+  auto image{std::make_shared<Image>()};
+  auto counter{m_jobSystem->schedule(
+      [image, createInfo, path = texture->m_path] {
+        try {
+          decode(path, createInfo, *image);
+        } catch (std::exception const &exception) {
+          image->error = exception.what();
+        }
+      })};
+
+  m_decoding.push_back({.texture = texture,
+                        .createInfo = createInfo,
+                        .onReady = std::move(onReady),
+                        .image = std::move(image),
+                        .counter = std::move(counter)});
+  // The path of the copy must outlive the caller's string
+  m_decoding.back().createInfo.path = texture->m_path;
+  return texture;
+}
+
+/**
+ * @brief Uploads the decoded images within the budget of the frame.
+ *
+ * Called by abcg::OpenGLWindow at the beginning of each frame. Images are
+ * uploaded in the order their decoding finished. Requests whose textures are
+ * no longer referenced are dropped.
+ *
+ * If an image could not be loaded, a warning is printed, the texture remains
+ * bound to the placeholder texture, its status is set to
+ * abcg::OpenGLStreamedTexture::Status::Failed and its callback is called.
+ */
+void abcg::OpenGLTextureStreamer::update() {
+  std::vector<Request> ready;
+  {
+    std::scoped_lock const lock{m_mutex};
+    if (m_decoding.empty() && m_uploading.empty())
+      return;
+
+    ABCG_PROFILE_SCOPE("Texture streamer");
+
+    // Move the decoded images to the upload queue
+    for (auto iter{m_decoding.begin()}; iter != m_decoding.end();) {
+      if (!iter->counter->isDone()) {
+        ++iter;
+        continue;
+      }
+      auto request{std::move(*iter)};
+      iter = m_decoding.erase(iter);
+      // Extensions can only be queried on the thread of the context
+      if (auto &image{*request.image}; image.error.empty() &&
+                                       !image.container.levels.empty() &&
+                                       !isOpenGLTextureFormatSupported(
+                                           image.containerFormat)) {
+        image.error = fmt::format(
+            "Texture format of {} is not supported by the OpenGL context",
+            request.texture->m_path);
+      }
+      if (!request.image->error.empty()) {
+        fmt::print("Warning: {}\n", request.image->error);
+        request.image.reset();
+        request.texture->m_status.store(OpenGLStreamedTexture::Status::Failed,
+                                        std::memory_order_release);
+        ready.push_back(std::move(request));
+        continue;
+      }
+      m_uploading.push_back(std::move(request));
+    }
+
+    std::size_t budget{m_bytesPerFrame};
+    std::size_t uploaded{};
+    while (!m_uploading.empty() && (budget > 0 || uploaded == 0)) {
+      auto &request{m_uploading.front()};
+      if (request.texture.use_count() == 1) {
+        m_uploading.pop_front();
+        continue;
+      }
+      if (request.texture->m_texture == 0) {
+        startUpload(request);
+      }
+      uploaded += uploadRows(request, budget);
+      if (request.uploadedLevels < request.image->levelCount) {
+        if (budget == 0)
+          break;
+        continue;
+      }
+      finishUpload(request);
+      ready.push_back(std::move(request));
+      m_uploading.pop_front();
+    }
+    Profiler::setCounter("Texture upload bytes", static_cast<double>(uploaded));
+  }
+
+  // Called without the lock, as they may request other textures
+  for (auto &request : ready) {
+    if (request.onReady) {
+      request.onReady(*request.texture);
+    }
+  }
+}
+
+/**
+ * @brief Returns the number of requested textures that are not live yet.
+ *
+ * @return Number of textures being decoded or uploaded.
+ */
+std::size_t abcg::OpenGLTextureStreamer::getPendingCount() const {
+  std::scoped_lock const lock{m_mutex};
+  return m_decoding.size() + m_uploading.size();
+}
+
+// Returns the dimensions and the tightly packed rows of a level
+abcg::OpenGLTextureStreamer::Level
+abcg::OpenGLTextureStreamer::Image::getLevel(int level) const {
+  if (!container.levels.empty()) {
+    auto const &entry{container.levels.at(gsl::narrow<std::size_t>(level))};
+    // A compressed level is uploaded as a single row
+    return {.width = gsl::narrow<int>(entry.width),
+            .height = compressed ? 1 : gsl::narrow<int>(entry.height),
+            .rowSize = compressed ? entry.size : std::size_t{entry.width} * 4,
+            .pixels = std::next(container.data.data(),
+                                gsl::narrow<std::ptrdiff_t>(entry.offset))};
+  }
+  if (!baked.isOpen()) {
+    return {.width = width,
+            .height = height,
+            .rowSize = rowSize,
+            .pixels = pixels.data()};
+  }
+  auto const index{gsl::narrow<std::size_t>(level)};
+  auto const &entry{baked.getTextureLevels()[index]};
+  return {.width = gsl::narrow<int>(entry.width),
+          .height = gsl::narrow<int>(entry.height),
+          .rowSize = std::size_t{entry.width} * 4,
+          .pixels = baked.getLevelData(index).data()};
+}
+
+// Maps the baked version of an image, if there is one with the requested
+// orientation. Called on a worker.
+bool abcg::OpenGLTextureStreamer::map(std::string const &path,
+                                      OpenGLTextureCreateInfo const &createInfo,
+                                      Image &image) {
+  auto const direct{isBakedAsset(path)};
+  auto const bakedPath{direct ? path : findBakedAsset(path)};
+  if (bakedPath.empty())
+    return false;
+
+  auto &baked{image.baked};
+  baked.open(bakedPath);
+  auto const &header{baked.getHeader()};
+  if (header.kind != BakedAssetKind::Texture) {
+    throw abcg::RuntimeError(
+        fmt::format("{} is not a baked texture", bakedPath));
+  }
+  auto const flipped{(header.flags & BakedAssetHeader::FlippedUpsideDown) != 0};
+  if (!direct && flipped != createInfo.flipUpsideDown) {
+    baked.close();
+    return false;
+  }
+
+  auto const format{createInfo.sRGBToLinear ? toSRGB(baked.getTextureFormat())
+                                            : baked.getTextureFormat()};
+  auto const &texture{baked.getTextureHeader()};
+  image.width = gsl::narrow<int>(texture.width);
+  image.height = gsl::narrow<int>(texture.height);
+  image.internalFormat =
+      format == TextureFormat::RGBA8sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+  image.format = GL_RGBA;
+  image.rowSize = std::size_t{texture.width} * 4;
+  image.levelCount = createInfo.generateMipmaps
+                         ? gsl::narrow<int>(texture.levelCount)
+                         : 1;
+  return true;
+}
+
+// Reads the levels of a KTX2 or DDS file. Called on a worker.
+void abcg::OpenGLTextureStreamer::readContainer(
+    std::string const &path, OpenGLTextureCreateInfo const &createInfo,
+    Image &image) {
+  image.container = loadTextureContainer(path);
+  auto const &container{image.container};
+  image.containerFormat = createInfo.sRGBToLinear ? toSRGB(container.format)
+                                                  : container.format;
+  image.compressed = isCompressed(image.containerFormat);
+  image.width = gsl::narrow<int>(container.levels.front().width);
+  image.height = gsl::narrow<int>(container.levels.front().height);
+  image.internalFormat = getOpenGLInternalFormat(image.containerFormat);
+  image.format = GL_RGBA;
+  image.levelCount = gsl::narrow<int>(container.levels.size());
+}
+
+// Decodes an image to tightly packed RGB/RGBA rows. Called on a worker.
+void abcg::OpenGLTextureStreamer::decode(
+    std::string const &path, OpenGLTextureCreateInfo const &createInfo,
+    Image &image) {
+  if (isTextureContainer(path)) {
+    readContainer(path, createInfo, image);
+    return;
+  }
+  if (map(path, createInfo, image))
+    return;
+
+  SDL_Surface *const surface{IMG_Load(path.c_str())};
+  if (surface == nullptr) {
+    image.error = fmt::format("Failed to load texture file {}", path);
+    return;
+  }
+
+  // Enforce RGB/RGBA
+  SDL_Surface *formattedSurface{};
+  if (surface->format->BytesPerPixel == 3) {
+    formattedSurface =
+        SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0);
+    image.internalFormat = createInfo.sRGBToLinear ? GL_SRGB8 : GL_RGB8;
+    image.format = GL_RGB;
+  } else {
+    formattedSurface =
+        SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    image.internalFormat = createInfo.sRGBToLinear ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    image.format = GL_RGBA;
+  }
+  SDL_FreeSurface(surface);
+  if (formattedSurface == nullptr) {
+    image.error = fmt::format("Failed to convert texture file {}", path);
+    return;
+  }
+
+  // Flip upside down
+  if (createInfo.flipUpsideDown) {
+    flipVertically(formattedSurface);
+  }
+
+  // Remove the padding between rows
+  image.width = formattedSurface->w;
+  image.height = formattedSurface->h;
+  image.rowSize = gsl::narrow<std::size_t>(image.width) *
+                  formattedSurface->format->BytesPerPixel;
+  image.pixels.resize(image.rowSize * gsl::narrow<std::size_t>(image.height));
+  auto const *source{static_cast<std::byte const *>(formattedSurface->pixels)};
+  for (auto row{0}; row < image.height; ++row) {
+    std::memcpy(
+        std::next(image.pixels.data(),
+                  gsl::narrow<std::ptrdiff_t>(image.rowSize) * row),
+        std::next(source, static_cast<std::ptrdiff_t>(formattedSurface->pitch) *
+                              row),
+        image.rowSize);
+  }
+
+  SDL_FreeSurface(formattedSurface);
+}
+
+// Allocates the storage of each level of the texture. The storage of a
+// compressed level is allocated when the level is uploaded.
+void abcg::OpenGLTextureStreamer::startUpload(Request &request) {
+  auto const &image{*request.image};
+  auto &texture{request.texture->m_texture};
+  abcg::glGenTextures(1, &texture);
+  if (image.compressed)
+    return;
+  abcg::glBindTexture(GL_TEXTURE_2D, texture);
+  for (auto index{0}; index < image.levelCount; ++index) {
+    auto const level{image.getLevel(index)};
+    abcg::glTexImage2D(GL_TEXTURE_2D, index,
+                       gsl::narrow<GLint>(image.internalFormat), level.width,
+                       level.height, 0, image.format, GL_UNSIGNED_BYTE,
+                       nullptr);
+  }
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Uploads as many rows of the current level as the budget allows, and at
+// least one. Returns the number of bytes uploaded.
+std::size_t abcg::OpenGLTextureStreamer::uploadRows(Request &request,
+                                                    std::size_t &budget) {
+  auto const &image{*request.image};
+  auto const level{image.getLevel(request.uploadedLevels)};
+  auto const remainingRows{
+      gsl::narrow<std::size_t>(level.height - request.uploadedRows)};
+  auto const rows{
+      std::clamp<std::size_t>(budget / level.rowSize, 1, remainingRows)};
+  auto const size{rows * level.rowSize};
+  budget -= std::min(budget, size);
+
+  // Orphan and fill the unpack buffer. The copy to the texture is then done
+  // by the driver without stalling on the previous upload.
+  abcg::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_unpackBuffer);
+  abcg::glBufferData(GL_PIXEL_UNPACK_BUFFER, gsl::narrow<GLsizeiptr>(size),
+                     std::next(level.pixels,
+                               gsl::narrow<std::ptrdiff_t>(level.rowSize) *
+                                   request.uploadedRows),
+                     GL_STREAM_DRAW);
+
+  abcg::glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  abcg::glBindTexture(GL_TEXTURE_2D, request.texture->m_texture);
+  if (image.compressed) {
+    auto const &entry{image.container.levels.at(
+        gsl::narrow<std::size_t>(request.uploadedLevels))};
+    abcg::glCompressedTexImage2D(
+        GL_TEXTURE_2D, request.uploadedLevels, image.internalFormat,
+        gsl::narrow<GLsizei>(entry.width), gsl::narrow<GLsizei>(entry.height),
+        0, gsl::narrow<GLsizei>(size), nullptr);
+  } else {
+    abcg::glTexSubImage2D(GL_TEXTURE_2D, request.uploadedLevels, 0,
+                          request.uploadedRows, level.width,
+                          gsl::narrow<GLsizei>(rows), image.format,
+                          GL_UNSIGNED_BYTE, nullptr);
+  }
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+  abcg::glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  abcg::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  request.uploadedRows += gsl::narrow<int>(rows);
+  if (request.uploadedRows == level.height) {
+    ++request.uploadedLevels;
+    request.uploadedRows = 0;
+  }
+  return size;
+}
+
+// Sets the sampling parameters, generates the mipmap levels and makes the
+// texture live
+void abcg::OpenGLTextureStreamer::finishUpload(Request &request) {
+  abcg::glBindTexture(GL_TEXTURE_2D, request.texture->m_texture);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  auto const &image{*request.image};
+  if (auto const levelCount{image.levelCount}; levelCount > 1) {
+    // Sample only the levels stored in the baked or container file
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                          GL_LINEAR_MIPMAP_LINEAR);
+  } else if (image.compressed) {
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  } else if (request.createInfo.generateMipmaps && !image.baked.isOpen()) {
+    abcg::glGenerateMipmap(GL_TEXTURE_2D);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                          GL_LINEAR_MIPMAP_LINEAR);
+  }
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
+
+  // The decoded pixels or the mapped file are no longer needed
+  request.image.reset();
+  request.texture->m_status.store(OpenGLStreamedTexture::Status::Ready,
+                                  std::memory_order_release);
+}
@@ -0,0 +1,240 @@
+/**
+ * @file abcgOpenGLTextureStreamer.hpp
+ * @brief Header file of abcg::OpenGLTextureStreamer.
+ *
+ * Declaration of abcg::OpenGLTextureStreamer and
+ * abcg::OpenGLStreamedTexture.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_TEXTURE_STREAMER_HPP_
+#define ABCG_OPENGL_TEXTURE_STREAMER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "abcgBakedAsset.hpp"
+#include "abcgJobSystem.hpp"
+#include "abcgOpenGLExternal.hpp"
+#include "abcgOpenGLImage.hpp"
+#include "abcgTextureContainer.hpp"
+
+namespace abcg {
+class OpenGLStreamedTexture;
+class OpenGLTextureStreamer;
+} // namespace abcg
+
+/**
+ * @brief Texture loaded asynchronously by abcg::OpenGLTextureStreamer.
+ *
+ * Until the image is decoded and uploaded, abcg::OpenGLStreamedTexture::getID
+ * returns a 1x1 placeholder texture owned by the streamer. The texture object
+ * is deleted when the last reference is released. Release all references
+ * before the OpenGL context is destroyed (e.g., in
+ * abcg::OpenGLWindow::onDestroy).
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::OpenGLStreamedTexture {
+public:
+  /** @brief Loading status of the texture. */
+  enum class Status {
+    /** @brief The image is being decoded or uploaded. */
+    Loading,
+    /** @brief The texture is live. */
+    Ready,
+    /** @brief The image could not be loaded. */
+    Failed
+  };
+
+  OpenGLStreamedTexture() = default;
+  OpenGLStreamedTexture(OpenGLStreamedTexture const &) = delete;
+  OpenGLStreamedTexture(OpenGLStreamedTexture &&) = delete;
+  OpenGLStreamedTexture &operator=(OpenGLStreamedTexture const &) = delete;
+  OpenGLStreamedTexture &operator=(OpenGLStreamedTexture &&) = delete;
+  ~OpenGLStreamedTexture();
+
+  /**
+   * @brief Returns the ID of the texture object to bind.
+   *
+   * @return ID of the texture, or of the placeholder texture if the texture
+   * is not ready.
+   */
+  [[nodiscard]] GLuint getID() const noexcept {
+    return getStatus() == Status::Ready ? m_texture : m_placeholder;
+  }
+
+  /**
+   * @brief Returns the loading status of the texture.
+   *
+   * @return Current status.
+   */
+  [[nodiscard]] Status getStatus() const noexcept {
+    return m_status.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Returns whether the texture is live.
+   *
+   * @return `true` if abcg::OpenGLStreamedTexture::getID returns the loaded
+   * texture.
+   */
+  [[nodiscard]] bool isReady() const noexcept {
+    return getStatus() == Status::Ready;
+  }
+
+  /**
+   * @brief Returns the path of the texture file.
+   *
+   * @return Path the texture was requested with.
+   */
+  [[nodiscard]] std::string const &getPath() const noexcept { return m_path; }
+
+private:
+  friend OpenGLTextureStreamer;
+
+  std::string m_path;
+  GLuint m_texture{};
+  GLuint m_placeholder{};
+  std::atomic<Status> m_status{Status::Loading};
+};
+
+/**
+ * @brief Loads 2D textures without blocking the thread that renders.
+ *
+ * abcg::OpenGLTextureStreamer::request returns immediately. The image is
+ * loaded, converted to RGB/RGBA and flipped on a worker of the job system.
+ * The decoded image is then uploaded by abcg::OpenGLTextureStreamer::update
+ * through a pixel unpack buffer, a few rows at a time, so that at most a given
+ * number of bytes is uploaded per frame. The mipmap levels are generated after
+ * the last rows are uploaded, and the texture becomes live.
+ *
+ * If an image cannot be loaded, a warning is printed and the texture keeps
+ * the placeholder texture, with status
+ * abcg::OpenGLStreamedTexture::Status::Failed.
+ *
+ * If the file was baked by `abcg_bake` (see abcg::findBakedAsset), the worker
+ * maps the baked file instead of decoding the image, and the precomputed
+ * mipmap levels are uploaded from the mapping within the same budget.
+ *
+ * abcg::OpenGLWindow owns a streamer (see
+ * abcg::OpenGLWindow::getTextureStreamer) and calls
+ * abcg::OpenGLTextureStreamer::update at the beginning of each frame.
+ *
+ * KTX2 and DDS files are read by the worker with abcg::loadTextureContainer,
+ * and their stored levels are uploaded as they are, as in
+ * abcg::loadOpenGLTexture. Levels of compressed formats are uploaded whole,
+ * one or more per frame within the budget. For these files,
+ * abcg::OpenGLTextureCreateInfo::flipUpsideDown is ignored.
+ *
+ * @sa abcg::loadOpenGLTexture for loading a texture synchronously.
+ */
+class abcg::OpenGLTextureStreamer {
+public:
+  /** @brief Function called when a requested texture becomes live or fails
+   * to load. */
+  using Callback = std::function<void(OpenGLStreamedTexture &)>;
+
+  OpenGLTextureStreamer() = default;
+  OpenGLTextureStreamer(OpenGLTextureStreamer const &) = delete;
+  OpenGLTextureStreamer(OpenGLTextureStreamer &&) = delete;
+  OpenGLTextureStreamer &operator=(OpenGLTextureStreamer const &) = delete;
+  OpenGLTextureStreamer &operator=(OpenGLTextureStreamer &&) = delete;
+  ~OpenGLTextureStreamer() = default;
+
+  void create(JobSystem &jobSystem,
+              std::size_t bytesPerFrame = 4 * 1024 * 1024);
+  void destroy();
+
+  [[nodiscard]] std::shared_ptr<OpenGLStreamedTexture>
+  request(OpenGLTextureCreateInfo const &createInfo, Callback onReady = {});
+
+  void update();
+
+  /**
+   * @brief Returns the maximum number of bytes uploaded per frame.
+   *
+   * @return Upload budget of each call to abcg::OpenGLTextureStreamer::update.
+   */
+  [[nodiscard]] std::size_t getBytesPerFrame() const noexcept {
+    return m_bytesPerFrame;
+  }
+
+  /**
+   * @brief Returns the number of requested textures that are not live yet.
+   *
+   * @return Number of textures being decoded or uploaded.
+   */
+  [[nodiscard]] std::size_t getPendingCount() const;
+
+private:
+  struct Level {
+    int width{};
+    int height{};
+    std::size_t rowSize{};
+    std::byte const *pixels{};
+  };
+
+  struct Image {
+    int width{};
+    int height{};
+    GLenum internalFormat{};
+    GLenum format{};
+    std::size_t rowSize{};
+    std::vector<std::byte> pixels;
+    // Mapped file of a baked texture, used instead of the decoded pixels
+    BakedAsset baked;
+    // Levels of a KTX2 or DDS file, used instead of the decoded pixels
+    TextureContainer container;
+    TextureFormat containerFormat{};
+    bool compressed{};
+    int levelCount{1};
+    std::string error;
+
+    [[nodiscard]] Level getLevel(int level) const;
+  };
+
+  struct Request {
+    std::shared_ptr<OpenGLStreamedTexture> texture;
+    OpenGLTextureCreateInfo createInfo;
+    Callback onReady;
+    std::shared_ptr<Image> image;
+    JobSystem::Counter counter;
+    int uploadedLevels{};
+    int uploadedRows{};
+  };
+
+  static void decode(std::string const &path,
+                     OpenGLTextureCreateInfo const &createInfo, Image &image);
+  static bool map(std::string const &path,
+                  OpenGLTextureCreateInfo const &createInfo, Image &image);
+  static void readContainer(std::string const &path,
+                            OpenGLTextureCreateInfo const &createInfo,
+                            Image &image);
+  void startUpload(Request &request);
+  std::size_t uploadRows(Request &request, std::size_t &budget);
+  void finishUpload(Request &request);
+
+  JobSystem *m_jobSystem{};
+  std::size_t m_bytesPerFrame{};
+  GLuint m_placeholder{};
+  GLuint m_unpackBuffer{};
+
+  mutable std::mutex m_mutex;
+  // Requests whose images are being decoded
+  std::vector<Request> m_decoding;
+  // Requests whose images are being uploaded, in order of completion
+  std::deque<Request> m_uploading;
+};
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * @file abcgOpenGLUniformRing.cpp
+ * @brief Definition of abcg::OpenGLUniformRing members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgOpenGLUniformRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include "abcgException.hpp"
+#include "abcgOpenGLFunction.hpp"
+#include "abcgProfiler.hpp"
+
+namespace {
+std::size_t alignUp(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+#if !defined(__EMSCRIPTEN__)
+constexpr GLbitfield mapFlags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                              GL_MAP_COHERENT_BIT};
+#endif
+} // namespace
+
+/**
+ * @brief Sets the size of the region of each frame.
+ *
+ * Deletes the current buffer, if any. The new buffer is allocated on the next
+ * call to abcg::OpenGLUniformRing::push.
+ *
+ * @param frameSize Maximum number of bytes pushed per frame, including the
+ * padding between ranges.
+ */
+void abcg::OpenGLUniformRing::create(std::size_t frameSize) {
+  destroy();
+
+  GLint alignment{};
+  abcg::glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  m_alignment = std::max<std::size_t>(1, gsl::narrow<std::size_t>(alignment));
+  m_frameSize = alignUp(frameSize, m_alignment);
+
+#if defined(__EMSCRIPTEN__)
+  m_persistent = false;
+#else
+  m_persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+#endif
+}
+
+/**
+ * @brief Waits for the frames in flight and deletes the buffer.
+ */
+void abcg::OpenGLUniformRing::destroy() {
+  for (auto &fence : m_fences) {
+    if (fence != nullptr) {
+      abcg::glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                             GL_TIMEOUT_IGNORED);
+      abcg::glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  if (m_buffer != 0) {
+    if (m_mapped != nullptr) {
+      abcg::glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+      abcg::glUnmapBuffer(GL_UNIFORM_BUFFER);
+      abcg::glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    abcg::glDeleteBuffers(1, &m_buffer);
+  }
+  m_buffer = 0;
+  m_mapped = nullptr;
+  m_frame = 0;
+  m_head = 0;
+}
+
+/**
+ * @brief Starts writing to the region of the next frame.
+ *
+ * With a persistently mapped buffer, waits until the GPU has finished the
+ * frame that last used the region. Otherwise, orphans the buffer if the
+ * previous frame used it.
+ */
+void abcg::OpenGLUniformRing::beginFrame() {
+  if (m_buffer == 0) {
+    m_head = 0;
+    return;
+  }
+
+  if (m_persistent) {
+    if (auto &fence{m_fences.at(m_frame)}; fence != nullptr) {
+      ABCG_PROFILE_SCOPE("Wait uniform ring");
+      abcg::glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                             GL_TIMEOUT_IGNORED);
+      abcg::glDeleteSync(fence);
+      fence = nullptr;
+    }
+  } else if (m_head > 0) {
+    abcg::glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    abcg::glBufferData(GL_UNIFORM_BUFFER,
+                       gsl::narrow<GLsizeiptr>(m_frameSize), nullptr,
+                       GL_STREAM_DRAW);
+    abcg::glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+  m_head = 0;
+}
+
+/**
+ * @brief Finishes writing to the region of the current frame.
+ *
+ * With a persistently mapped buffer, inserts the fence that guards the region.
+ */
+void abcg::OpenGLUniformRing::endFrame() {
+  Profiler::setCounter("Uniform ring bytes", static_cast<double>(m_head));
+  if (m_buffer == 0 || !m_persistent)
+    return;
+
+  if (m_head > 0) {
+    m_fences.at(m_frame) = abcg::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+  m_frame = (m_frame + 1) % frameCount;
+}
+
+/**
+ * @brief Copies a block of uniform data to the region of the current frame.
+ *
+ * The data remains valid until the end of the frame.
+ *
+ * @param data Pointer to the data, with the layout of the uniform block
+ * (e.g., `std140`).
+ * @param size Size of the data, in bytes.
+ *
+ * @throw abcg::RuntimeError if the region of the frame is full.
+ *
+ * @return Range of the copy, to be used with abcg::OpenGLUniformRing::bind.
+ */
+abcg::OpenGLUniformRing::Range
+abcg::OpenGLUniformRing::push(void const *data, std::size_t size) {
+  if (m_frameSize == 0) {
+    create();
+  }
+  if (m_buffer == 0) {
+    allocate();
+  }
+
+  auto const offset{alignUp(m_head, m_alignment)};
+  if (offset + size > m_frameSize) {
+    throw abcg::RuntimeError(fmt::format(
+        "Uniform ring is full ({} bytes per frame)", m_frameSize));
+  }
+  m_head = offset + size;
+
+  Range const range{.offset = gsl::narrow<GLintptr>(offset),
+                    .size = gsl::narrow<GLsizeiptr>(size)};
+  if (m_persistent) {
+    auto const bufferOffset{m_frame * m_frameSize + offset};
+    std::memcpy(std::next(m_mapped, gsl::narrow<std::ptrdiff_t>(bufferOffset)),
+                data, size);
+    return {.offset = gsl::narrow<GLintptr>(bufferOffset), .size = range.size};
+  }
+
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+  abcg::glBufferSubData(GL_UNIFORM_BUFFER, range.offset, range.size, data);
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return range;
+}
+
+/**
+ * @brief Binds a range of the buffer to a uniform block binding point.
+ *
+ * @param binding Uniform buffer binding point (see `glUniformBlockBinding`
+ * or the `binding` layout qualifier).
+ * @param range Range returned by abcg::OpenGLUniformRing::push in the current
+ * frame.
+ */
+void abcg::OpenGLUniformRing::bind(GLuint binding, Range const &range) const {
+  abcg::glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_buffer, range.offset,
+                          range.size);
+}
+
+void abcg::OpenGLUniformRing::allocate() {
+  abcg::glGenBuffers(1, &m_buffer);
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+#if !defined(__EMSCRIPTEN__)
+  if (m_persistent) {
+    auto const size{gsl::narrow<GLsizeiptr>(m_frameSize * frameCount)};
+    glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, mapFlags);
+    m_mapped = static_cast<std::byte *>(
+        abcg::glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, mapFlags));
+    if (m_mapped == nullptr) {
+      throw abcg::RuntimeError("Failed to map uniform ring");
+    }
+  } else
+#endif
+  {
+    abcg::glBufferData(GL_UNIFORM_BUFFER,
+                       gsl::narrow<GLsizeiptr>(m_frameSize), nullptr,
+                       GL_STREAM_DRAW);
+  }
+  abcg::glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
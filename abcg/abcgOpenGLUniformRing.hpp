@@ -0,0 +1,128 @@
+/**
+ * @file abcgOpenGLUniformRing.hpp
+ * @brief Header file of abcg::OpenGLUniformRing.
+ *
+ * Declaration of abcg::OpenGLUniformRing.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OPENGL_UNIFORM_RING_HPP_
+#define ABCG_OPENGL_UNIFORM_RING_HPP_
+
+#include <array>
+#include <cstddef>
+
+#include "abcgOpenGLExternal.hpp"
+
+namespace abcg {
+class OpenGLUniformRing;
+} // namespace abcg
+
+/**
+ * @brief Ring buffer of uniform data written once per frame.
+ *
+ * A single uniform buffer object is split into one region per frame in
+ * flight. Each call to abcg::OpenGLUniformRing::push copies a block of
+ * uniform data to the region of the current frame, at an offset aligned to
+ * `GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT`, and abcg::OpenGLUniformRing::bind
+ * binds it to a uniform block binding point with `glBindBufferRange`. Setting
+ * the constants of an object is then one copy and one bind.
+ *
+ * With OpenGL 4.4 or `ARB_buffer_storage`, the buffer is persistently mapped
+ * and push is a `memcpy`. A fence is inserted at the end of each frame, and
+ * the region of a frame is reused only after its fence is signaled.
+ * Otherwise (OpenGL 3.3, OpenGL ES and WebGL), the buffer is orphaned with
+ * `glBufferData` at the beginning of each frame and push calls
+ * `glBufferSubData`.
+ *
+ * abcg::OpenGLWindow owns a ring (see abcg::OpenGLWindow::getUniformRing) and
+ * calls abcg::OpenGLUniformRing::beginFrame and
+ * abcg::OpenGLUniformRing::endFrame around abcg::OpenGLWindow::onPaint. The
+ * buffer is allocated on the first push.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::OpenGLUniformRing {
+public:
+  /** @brief Number of frames whose regions may be in use by the GPU. */
+  static constexpr std::size_t frameCount{3};
+
+  /** @brief Block of uniform data returned by abcg::OpenGLUniformRing::push.
+   */
+  struct Range {
+    /** @brief Offset in the buffer, in bytes. */
+    GLintptr offset{};
+    /** @brief Size of the block, in bytes. */
+    GLsizeiptr size{};
+  };
+
+  OpenGLUniformRing() = default;
+  OpenGLUniformRing(OpenGLUniformRing const &) = delete;
+  OpenGLUniformRing(OpenGLUniformRing &&) = delete;
+  OpenGLUniformRing &operator=(OpenGLUniformRing const &) = delete;
+  OpenGLUniformRing &operator=(OpenGLUniformRing &&) = delete;
+  ~OpenGLUniformRing() = default;
+
+  void create(std::size_t frameSize = 1024 * 1024);
+  void destroy();
+
+  void beginFrame();
+  void endFrame();
+
+  [[nodiscard]] Range push(void const *data, std::size_t size);
+  void bind(GLuint binding, Range const &range) const;
+
+  /**
+   * @brief Copies an object to the region of the current frame.
+   *
+   * @param data Object with the layout of the uniform block (e.g., `std140`).
+   *
+   * @return Range of the copy, to be used with abcg::OpenGLUniformRing::bind.
+   */
+  template <typename T> [[nodiscard]] Range push(T const &data) {
+    return push(&data, sizeof(T));
+  }
+
+  /**
+   * @brief Returns whether the buffer is persistently mapped.
+   *
+   * @return `true` if `glBufferStorage` is supported.
+   */
+  [[nodiscard]] bool isPersistent() const noexcept { return m_persistent; }
+
+  /**
+   * @brief Returns the alignment of the offsets of the ranges.
+   *
+   * @return Value of `GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT`.
+   */
+  [[nodiscard]] std::size_t getAlignment() const noexcept {
+    return m_alignment;
+  }
+
+  /**
+   * @brief Returns the number of bytes pushed in the current frame, including
+   * padding.
+   *
+   * @return Used size of the region of the current frame.
+   */
+  [[nodiscard]] std::size_t getUsedSize() const noexcept { return m_head; }
+
+private:
+  void allocate();
+
+  std::size_t m_frameSize{};
+  std::size_t m_alignment{1};
+  bool m_persistent{};
+
+  GLuint m_buffer{};
+  std::byte *m_mapped{};
+  std::array<GLsync, frameCount> m_fences{};
+  std::size_t m_frame{};
+  std::size_t m_head{};
+};
+
+#endif
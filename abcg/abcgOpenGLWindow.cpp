@@ -11,12 +11,13 @@
 #include "abcgOpenGLWindow.hpp"
 
 #include <SDL_events.h>
-#include <SDL_image.h>
 #include <imgui_impl_opengl3.h>
 #include <imgui_impl_sdl.h>
 
+#include "abcgApplication.hpp"
 #include "abcgEmbeddedFonts.hpp"
 #include "abcgException.hpp"
+#include "abcgOpenGLProgramCache.hpp"
 #include "abcgWindow.hpp"
 
 /**
@@ -47,33 +48,49 @@ void abcg::OpenGLWindow::setOpenGLSettings(
 /**
  * @brief Takes a snapshot of the screen and saves it to a file.
  *
+ * The snapshot is taken at the end of the current frame, after the UI is
+ * rendered. The framebuffer is read back asynchronously and the file is
+ * written by a background thread a few frames later.
+ *
  * @param filename String view to the filename.
+ *
+ * @sa abcg::OpenGLFrameCapture.
  */
 void abcg::OpenGLWindow::saveScreenshotPNG(std::string_view filename) const {
-  auto const size{getWindowSize()};
-  auto const bitsPerPixel{8};
-  auto const channels{4};
-  auto const pitch{gsl::narrow<long>(size.x * channels)};
+  m_frameCapture->requestScreenshot(filename);
+}
 
-  auto const numPixels{gsl::narrow<std::size_t>(size.x * size.y * channels)};
-  std::vector<unsigned char> pixels(numPixels);
-  glReadBuffer(m_openGLSettings.doubleBuffering ? GL_BACK : GL_FRONT);
-  glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+/**
+ * @brief Starts recording the frames of the window to a YUV4MPEG2 video file.
+ *
+ * Every rendered frame is appended to the file until
+ * abcg::OpenGLWindow::stopRecording is called. The frames are read back
+ * asynchronously and written by a background thread. The frame size must not
+ * change while recording; frames of a different size are skipped.
+ *
+ * @param filename Name of the video file (usually with extension `.y4m`).
+ * @param framesPerSecond Frame rate written to the header of the file.
+ *
+ * @throw abcg::RuntimeError if the file cannot be created.
+ */
+void abcg::OpenGLWindow::startRecording(std::string_view filename,
+                                        int framesPerSecond) {
+  m_frameCapture->startRecording(filename, framesPerSecond);
+}
 
-  // Flip upside down
-  for (auto const line : iter::range(size.y / 2)) {
-    std::swap_ranges(pixels.begin() + pitch * line,
-                     pixels.begin() + pitch * (line + 1),
-                     pixels.begin() + pitch * (size.y - line - 1));
-  }
+/**
+ * @brief Stops recording the frames of the window.
+ */
+void abcg::OpenGLWindow::stopRecording() { m_frameCapture->stopRecording(); }
 
-  if (auto *const surface{SDL_CreateRGBSurfaceFrom(
-          pixels.data(), size.x, size.y, channels * bitsPerPixel,
-          gsl::narrow<int>(pitch), 0x000000FF, 0x0000FF00, 0x00FF0000,
-          0xFF000000)}) {
-    IMG_SavePNG(surface, filename.data());
-    SDL_FreeSurface(surface);
-  }
+/**
+ * @brief Returns whether the frames of the window are being recorded.
+ *
+ * @return `true` between calls to abcg::OpenGLWindow::startRecording and
+ * abcg::OpenGLWindow::stopRecording.
+ */
+bool abcg::OpenGLWindow::isRecording() const noexcept {
+  return m_frameCapture->isRecording();
 }
 
 /**
@@ -99,11 +116,41 @@ void abcg::OpenGLWindow::onEvent([[maybe_unused]] SDL_Event const &event) {}
  */
 void abcg::OpenGLWindow::onCreate() { glClearColor(0, 0, 0, 1); }
 
+/**
+ * @brief Custom handler for copying the state used for rendering the frame.
+ *
+ * This virtual function is called for each frame of the rendering loop, after
+ * abcg::OpenGLWindow::onPaintUI and before abcg::OpenGLWindow::onPaint.
+ *
+ * If abcg::WindowSettings::threadedRendering is `true`,
+ * abcg::OpenGLWindow::onPaint runs on a render thread concurrently with the
+ * main thread, which is already processing the next frame. This function is
+ * then called on the main thread while the render thread is idle. Copy here
+ * the state written by the main thread (e.g., in abcg::OpenGLWindow::onEvent
+ * or abcg::OpenGLWindow::onUpdate) that is read by abcg::OpenGLWindow::onPaint.
+ * Within onPaint, read only these copies.
+ *
+ * If abcg::WindowSettings::threadedRendering is `false`, this function is
+ * called on the main thread just before abcg::OpenGLWindow::onPaint.
+ *
+ * This is not called when the window is minimized.
+ *
+ * Override it for custom behavior. By default, it does nothing.
+ */
+void abcg::OpenGLWindow::onSnapshot() {}
+
 /**
  * @brief Custom handler for rendering the OpenGL scene.
  *
  * This virtual function is called for each frame of the rendering loop, just
- * after abcg::OpenGLWindow::onPaintUI.
+ * after abcg::OpenGLWindow::onSnapshot.
+ *
+ * If abcg::WindowSettings::threadedRendering is `true`, this is called on the
+ * render thread, which owns the OpenGL context. In this case,
+ * abcg::OpenGLWindow::onCreate and abcg::OpenGLWindow::onDestroy are still
+ * called on the main thread, and abcg::OpenGLWindow::onResize is called on the
+ * render thread while the main thread waits for it to finish. The other hooks
+ * must not call OpenGL functions.
  *
  * This is not called when the window is minimized.
  *
@@ -132,31 +179,7 @@ void abcg::OpenGLWindow::onPaint() {
 void abcg::OpenGLWindow::onPaintUI() {
   // FPS counter
   if (abcg::Window::getWindowSettings().showFPS) {
-    auto fps{ImGui::GetIO().Framerate};
-
-    static auto offset{0UL};
-    static auto refreshTime{ImGui::GetTime()};
-    static std::array<float, 150> frames{};
-
-    while (refreshTime < ImGui::GetTime()) {
-      auto const refreshFrequency{60.0};
-      frames.at(offset) = fps;
-      offset = (offset + 1) % frames.size();
-      refreshTime += (1.0 / refreshFrequency);
-    }
-
-    ImGui::SetNextWindowPos(ImVec2(5, 5));
-    ImGui::Begin("FPS", nullptr,
-                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs |
-                     ImGuiWindowFlags_NoBringToFrontOnFocus |
-                     ImGuiWindowFlags_NoFocusOnAppearing);
-    auto const label{fmt::format("avg {:.1f} FPS", fps)};
-    ImGui::PlotLines("", frames.data(), gsl::narrow<int>(frames.size()),
-                     gsl::narrow<int>(offset), label.c_str(), 0.0f,
-                     // *std::ranges::max_element(frames) * 2,
-                     *std::max_element(frames.begin(), frames.end()) * 2,
-                     ImVec2(gsl::narrow<float>(frames.size()), 50));
-    ImGui::End();
+    getFrameStats().drawOverlay();
   }
 
   // Fullscreen button
@@ -213,6 +236,20 @@ void abcg::OpenGLWindow::onResize([[maybe_unused]] glm::ivec2 const &size) {}
  */
 void abcg::OpenGLWindow::onUpdate() {}
 
+/**
+ * @brief Custom handler called at a fixed rate for advancing the simulation.
+ *
+ * This virtual function is called zero or more times per frame, before
+ * abcg::OpenGLWindow::onUpdate, whenever abcg::WindowSettings::fixedTimeStep is
+ * greater than zero. The accumulated frame time that is left for the next
+ * frame can be queried with abcg::Window::getInterpolationAlpha.
+ *
+ * @param deltaTime Fixed time step, in seconds.
+ *
+ * Override it for custom behavior. By default, it does nothing.
+ */
+void abcg::OpenGLWindow::onFixedUpdate([[maybe_unused]] double deltaTime) {}
+
 /**
  * @brief Custom handler for cleaning up OpenGL resources.
  *
@@ -243,7 +280,7 @@ void abcg::OpenGLWindow::handleEvent(SDL_Event const &event) {
       break;
     case SDL_WINDOWEVENT_SIZE_CHANGED:
     case SDL_WINDOWEVENT_RESIZED: {
-      onResize(getWindowSize());
+      resize(getWindowSize());
     } break;
     default:
       break;
@@ -296,22 +333,30 @@ void abcg::OpenGLWindow::create() {
   m_GLSLVersion =
       fmt::format("#version {:d}{:02d}", majorVersion, minorVersion * 10);
 
+  int contextFlags{};
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+  // Debug output requires a debug context
+  if (m_openGLSettings.errorCheck == OpenGLErrorCheck::DebugOutput) {
+    contextFlags |= SDL_GL_CONTEXT_DEBUG_FLAG;
+  }
+#endif
+
   switch (profile) {
   case OpenGLProfile::Core:
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
-                        SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+                        contextFlags | SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
                         SDL_GL_CONTEXT_PROFILE_CORE);
     m_GLSLVersion += " core";
     break;
   case OpenGLProfile::Compatibility:
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, contextFlags);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
                         SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
     m_GLSLVersion += " compatibility";
     break;
   case OpenGLProfile::ES:
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, contextFlags);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
     m_GLSLVersion += " es";
     break;
@@ -356,12 +401,29 @@ void abcg::OpenGLWindow::create() {
     throw abcg::SDLError("SDL_GL_CreateContext failed");
   }
 
+  auto const headless{Application::getSettings().headless};
+
 #if !defined(__EMSCRIPTEN__)
-  SDL_GL_SetSwapInterval(m_openGLSettings.vSync ? 1 : 0);
+  if (m_openGLSettings.vSync && !headless) {
+    // Fall back to regular vsync if adaptive vsync is not supported
+    if (!m_openGLSettings.adaptiveVSync || SDL_GL_SetSwapInterval(-1) != 0) {
+      SDL_GL_SetSwapInterval(1);
+    }
+  } else {
+    SDL_GL_SetSwapInterval(0);
+  }
 #endif
 
 #if !defined(__EMSCRIPTEN__)
-  if (auto const err{glewInit()}; GLEW_OK != err) {
+  auto err{glewInit()};
+#if defined(GLEW_ERROR_NO_GLX_DISPLAY)
+  // GLEW loads the core entry points before failing to find a GLX display,
+  // which is expected when the context is created through EGL
+  if (headless && err == GLEW_ERROR_NO_GLX_DISPLAY) {
+    err = GLEW_OK;
+  }
+#endif
+  if (GLEW_OK != err) {
     throw abcg::Exception{fmt::format("Failed to initialize OpenGL loader: {}",
                                       glewGetErrorString(err))};
   }
@@ -373,6 +435,16 @@ void abcg::OpenGLWindow::create() {
   fmt::print("OpenGL version.: {}\n", glGetString(GL_VERSION));
   fmt::print("GLSL version...: {}\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+  if (m_openGLSettings.errorCheck == OpenGLErrorCheck::DebugOutput) {
+    if (OpenGLDebugOutput::enable(m_openGLSettings.errorCheckInterval)) {
+      fmt::print("Error checking.: debug output\n");
+    } else {
+      fmt::print("Error checking.: glGetError (debug output unavailable)\n");
+    }
+  }
+#endif
+
   /*
   // Print out extensions
   GLint numExtensions{};
@@ -413,18 +485,50 @@ void abcg::OpenGLWindow::create() {
     throw abcg::RuntimeError("Failed to load font file");
   }
 
+  // The state of the new context is unknown to the cache
+  OpenGLStateCache::invalidate();
+
+  m_gpuTimer.create(m_openGLSettings.pipelineStatistics);
+  m_programRegistry.setHotReload(Application::getSettings().hotReload);
+  m_uniformRing.create();
+  m_textureStreamer.create(getJobSystem());
+
   onCreate();
 
   onResize(getWindowSize());
+
+#if !defined(__EMSCRIPTEN__)
+  if (getWindowSettings().threadedRendering) {
+    // Create the device objects of the ImGui renderer while the context is
+    // still current on this thread
+    ImGui_ImplOpenGL3_NewFrame();
+
+    // Transfer the context to the render thread
+    SDL_GL_MakeCurrent(getSDLWindow(), nullptr);
+    m_drawDataSnapshot = std::make_unique<DrawDataSnapshot>();
+    m_renderThread = std::make_unique<RenderThread>();
+    m_renderThread->invoke(
+        [this] { SDL_GL_MakeCurrent(getSDLWindow(), m_GLContext); });
+  }
+#endif
+}
+
+void abcg::OpenGLWindow::fixedUpdate(double deltaTime) {
+  onFixedUpdate(deltaTime);
 }
 
 void abcg::OpenGLWindow::paint() {
-  onUpdate();
+  {
+    ABCG_PROFILE_SCOPE("onUpdate");
+    onUpdate();
+  }
 
   if (m_hidden || m_minimized)
     return;
 
-  SDL_GL_MakeCurrent(abcg::Window::getSDLWindow(), m_GLContext);
+  if (!m_renderThread) {
+    SDL_GL_MakeCurrent(abcg::Window::getSDLWindow(), m_GLContext);
+  }
 
 #if defined(__EMSCRIPTEN__)
   // Force window size in windowed mode
@@ -437,17 +541,88 @@ void abcg::OpenGLWindow::paint() {
   }
 #endif
 
-  ImGui_ImplOpenGL3_NewFrame();
-  ImGui_ImplSDL2_NewFrame();
-  ImGui::NewFrame();
+  {
+    ABCG_PROFILE_SCOPE("onPaintUI");
+    if (!m_renderThread) {
+      ImGui_ImplOpenGL3_NewFrame();
+    }
+    ImGui_ImplSDL2_NewFrame();
+    ImGui::NewFrame();
+
+    onPaintUI();
+
+    if (getWindowSettings().showProfiler) {
+      Profiler::drawOverlay();
+    }
+
+    ImGui::Render();
+  }
+
+  if (m_renderThread) {
+    {
+      // Frame N-1 must be fully rendered before the state of frame N is
+      // copied
+      ABCG_PROFILE_SCOPE("Wait render thread");
+      m_renderThread->wait();
+    }
+    {
+      ABCG_PROFILE_SCOPE("onSnapshot");
+      onSnapshot();
+      m_drawDataSnapshot->capture(*ImGui::GetDrawData());
+    }
+    m_renderThread->submit([this] { render(m_drawDataSnapshot->get()); });
+  } else {
+    {
+      ABCG_PROFILE_SCOPE("onSnapshot");
+      onSnapshot();
+    }
+    render(ImGui::GetDrawData());
+  }
+}
 
-  onPaintUI();
+void abcg::OpenGLWindow::resize(glm::ivec2 const &size) {
+  if (m_renderThread) {
+    m_renderThread->invoke([this, size] { onResize(size); });
+  } else {
+    onResize(size);
+  }
+}
+
+void abcg::OpenGLWindow::render(ImDrawData *drawData) {
+  ABCG_PROFILE_SCOPE("Render");
+
+  if (m_renderThread) {
+    runMainThreadJobs();
+  }
 
-  ImGui::Render();
+  // Programs and streamed textures are replaced only at frame boundaries
+  m_programRegistry.update();
+  m_textureStreamer.update();
+
+  m_gpuTimer.beginFrame();
+  {
+    ABCG_PROFILE_SCOPE("onPaint");
+    OpenGLGPUScope const gpuScope{m_gpuTimer, "Scene"};
+    m_uniformRing.beginFrame();
+    onPaint();
+    m_uniformRing.endFrame();
+  }
+  {
+    ABCG_PROFILE_SCOPE("ImGui render");
+    OpenGLGPUScope const gpuScope{m_gpuTimer, "ImGui"};
+    ImGui_ImplOpenGL3_RenderDrawData(drawData);
+    // The backend calls OpenGL directly
+    OpenGLStateCache::invalidate();
+  }
+  Profiler::setCounter(
+      "GL calls skipped",
+      static_cast<double>(OpenGLStateCache::getSkippedCount()));
+  m_gpuTimer.endFrame();
 
-  onPaint();
+  auto const readBuffer{m_openGLSettings.doubleBuffering ? GL_BACK : GL_FRONT};
+  m_frameCapture->capture(getWindowSize(), gsl::narrow<GLenum>(readBuffer));
 
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  ABCG_PROFILE_SCOPE("Swap");
   if (m_openGLSettings.doubleBuffering) {
     SDL_GL_SwapWindow(abcg::Window::getSDLWindow());
   } else {
@@ -456,7 +631,30 @@ void abcg::OpenGLWindow::paint() {
 }
 
 void abcg::OpenGLWindow::destroy() {
+  if (m_renderThread) {
+    // Transfer the context back to the main thread
+    m_renderThread->invoke(
+        [this] { SDL_GL_MakeCurrent(getSDLWindow(), nullptr); });
+    m_renderThread.reset();
+    m_drawDataSnapshot.reset();
+    SDL_GL_MakeCurrent(getSDLWindow(), m_GLContext);
+  }
+
+  m_gpuTimer.destroy();
+  m_frameCapture->destroy();
+
   onDestroy();
+  m_programRegistry.destroy();
+  m_uniformRing.destroy();
+  m_textureStreamer.destroy();
+
+  if (auto const lookups{OpenGLProgramCache::getHitCount() +
+                         OpenGLProgramCache::getMissCount()};
+      lookups > 0) {
+    fmt::print("Program cache..: {} hits, {} misses\n",
+               OpenGLProgramCache::getHitCount(),
+               OpenGLProgramCache::getMissCount());
+  }
 
   if (ImGui::GetCurrentContext() != nullptr) {
     ImGui_ImplOpenGL3_Shutdown();
@@ -464,6 +662,9 @@ void abcg::OpenGLWindow::destroy() {
     ImGui::DestroyContext();
   }
   if (m_GLContext != nullptr) {
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+    OpenGLDebugOutput::disable();
+#endif
     SDL_GL_DeleteContext(m_GLContext);
     m_GLContext = nullptr;
   }
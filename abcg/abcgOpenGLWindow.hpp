@@ -13,10 +13,18 @@
 #ifndef ABCG_OPENGL_WINDOW_HPP_
 #define ABCG_OPENGL_WINDOW_HPP_
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include "abcgExternal.hpp"
+#include "abcgOpenGLFrameCapture.hpp"
 #include "abcgOpenGLFunction.hpp"
+#include "abcgOpenGLGPUTimer.hpp"
+#include "abcgOpenGLProgramRegistry.hpp"
+#include "abcgOpenGLTextureStreamer.hpp"
+#include "abcgOpenGLUniformRing.hpp"
+#include "abcgRenderThread.hpp"
 #include "abcgWindow.hpp"
 
 namespace abcg {
@@ -75,8 +83,31 @@ struct abcg::OpenGLSettings {
   /** @brief Whether the swapping of the front and back frame buffers is
    * synchronized with the vertical retrace. */
   bool vSync{false};
+  /** @brief Whether to use adaptive vertical synchronization (swap interval
+   * -1), if supported, when abcg::OpenGLSettings::vSync is `true`. With
+   * adaptive vsync, late buffer swaps happen immediately instead of waiting
+   * for the next vertical retrace. */
+  bool adaptiveVSync{false};
   /** @brief Whether the output is double buffered. */
   bool doubleBuffering{true};
+  /** @brief Whether to collect pipeline statistics (e.g., number of vertex and
+   * fragment shader invocations) while the profiler is enabled, if
+   * `ARB_pipeline_statistics_query` is supported.
+   *
+   * @sa abcg::OpenGLGPUTimer::getPipelineStatistics.
+   */
+  bool pipelineStatistics{false};
+  /** @brief How the `abcg::gl*` wrappers check for errors in debug builds.
+   *
+   * With abcg::OpenGLErrorCheck::DebugOutput, a debug context is requested.
+   */
+  OpenGLErrorCheck errorCheck{OpenGLErrorCheck::GetError};
+  /** @brief With abcg::OpenGLErrorCheck::DebugOutput, number of wrapped calls
+   * between calls to `glGetError`, or 0 to rely on the debug output only.
+   *
+   * @sa abcg::OpenGLDebugOutput.
+   */
+  std::uint32_t errorCheckInterval{0};
 };
 
 /**
@@ -88,10 +119,13 @@ struct abcg::OpenGLSettings {
  *
  * @sa abcg::OpenGLWindow::onEvent for handling SDL events.
  * @sa abcg::OpenGLWindow::onCreate for initializing OpenGL resources.
+ * @sa abcg::OpenGLWindow::onSnapshot for copying the state used by onPaint.
  * @sa abcg::OpenGLWindow::onPaint for scene rendering.
  * @sa abcg::OpenGLWindow::onPaintUI for UI rendering.
  * @sa abcg::OpenGLWindow::onResize for handling of window resize events.
  * @sa abcg::OpenGLWindow::onUpdate for commands to be called every frame.
+ * @sa abcg::OpenGLWindow::onFixedUpdate for commands to be called at a fixed
+ * rate.
  * @sa abcg::OpenGLWindow::onDestroy for cleaning up OpenGL resources.
 
  * @remark Objects of this type cannot be copied or copy-constructed.
@@ -101,28 +135,92 @@ public:
   [[nodiscard]] OpenGLSettings const &getOpenGLSettings() const noexcept;
   void setOpenGLSettings(OpenGLSettings const &openGLSettings) noexcept;
   void saveScreenshotPNG(std::string_view filename) const;
+  void startRecording(std::string_view filename, int framesPerSecond = 60);
+  void stopRecording();
+  [[nodiscard]] bool isRecording() const noexcept;
+
+  /**
+   * @brief Returns the GPU timer of the window.
+   *
+   * Use it with abcg::OpenGLGPUScope to measure GPU zones in
+   * abcg::OpenGLWindow::onPaint.
+   *
+   * @return Reference to the GPU timer.
+   */
+  [[nodiscard]] OpenGLGPUTimer &getGPUTimer() noexcept { return m_gpuTimer; }
+
+  /**
+   * @brief Returns the program registry of the window.
+   *
+   * Programs requested with abcg::OpenGLProgramRegistry::request are built
+   * across frames and shared by all requests with the same shaders.
+   *
+   * @return Reference to the program registry.
+   */
+  [[nodiscard]] OpenGLProgramRegistry &getProgramRegistry() noexcept {
+    return m_programRegistry;
+  }
+
+  /**
+   * @brief Returns the uniform ring of the window.
+   *
+   * Use it in abcg::OpenGLWindow::onPaint to push per-object uniform blocks
+   * and bind them with `glBindBufferRange`.
+   *
+   * @return Reference to the uniform ring.
+   */
+  [[nodiscard]] OpenGLUniformRing &getUniformRing() noexcept {
+    return m_uniformRing;
+  }
+
+  /**
+   * @brief Returns the texture streamer of the window.
+   *
+   * Textures requested with abcg::OpenGLTextureStreamer::request are decoded
+   * by the job system and uploaded across frames.
+   *
+   * @return Reference to the texture streamer.
+   */
+  [[nodiscard]] OpenGLTextureStreamer &getTextureStreamer() noexcept {
+    return m_textureStreamer;
+  }
 
 protected:
   virtual void onEvent(SDL_Event const &event);
   virtual void onCreate();
+  virtual void onSnapshot();
   virtual void onPaint();
   virtual void onPaintUI();
   virtual void onResize(glm::ivec2 const &size);
   virtual void onUpdate();
+  virtual void onFixedUpdate(double deltaTime);
   virtual void onDestroy();
 
 private:
   void handleEvent(SDL_Event const &event) final;
   void create() final;
+  void fixedUpdate(double deltaTime) final;
   void paint() final;
   void destroy() final;
   [[nodiscard]] glm::ivec2 getWindowSize() const final;
 
+  void resize(glm::ivec2 const &size);
+  void render(ImDrawData *drawData);
+
   OpenGLSettings m_openGLSettings;
   std::string m_GLSLVersion;
   SDL_GLContext m_GLContext{};
+  OpenGLGPUTimer m_gpuTimer;
+  OpenGLProgramRegistry m_programRegistry;
+  OpenGLUniformRing m_uniformRing;
+  OpenGLTextureStreamer m_textureStreamer;
   bool m_hidden{};
   bool m_minimized{};
+
+  std::unique_ptr<RenderThread> m_renderThread;
+  std::unique_ptr<DrawDataSnapshot> m_drawDataSnapshot;
+  std::unique_ptr<OpenGLFrameCapture> m_frameCapture{
+      std::make_unique<OpenGLFrameCapture>()};
 };
 
 #endif
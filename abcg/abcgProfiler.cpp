@@ -0,0 +1,532 @@
+/**
+ * @file abcgProfiler.cpp
+ * @brief Definition of abcg::Profiler and abcg::ProfileScope members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgProfiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+#include <imgui.h>
+
+#include "abcgTimer.hpp"
+#include "abcgTraceWriter.hpp"
+
+namespace {
+// Single-producer, single-consumer ring of zones written by one thread and
+// read by the thread that calls abcg::Profiler::endFrame. Zones recorded while
+// the ring is full are dropped, so that the producer never overwrites a slot
+// that is being read
+struct ThreadBuffer {
+  static constexpr std::size_t capacity{4096};
+  std::array<abcg::ProfilerZone, capacity> zones{};
+  std::atomic<std::uint64_t> written{};
+  std::atomic<std::uint64_t> read{};
+  std::atomic<std::uint64_t> dropped{};
+  std::uint32_t track{};
+  std::uint32_t depth{};
+};
+
+// Frames kept in the history, and frames used for the table of top zones
+constexpr std::size_t historySize{240};
+constexpr std::size_t statisticsFrames{120};
+
+struct ProfilerState {
+  abcg::Timer epoch;
+  std::atomic<bool> enabled{};
+
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::vector<std::string> trackNames;
+  std::map<std::string, double, std::less<>> counters;
+
+  // Accessed only by the thread that calls abcg::Profiler::endFrame
+  std::deque<abcg::ProfilerFrame> history;
+  std::uint64_t frameIndex{};
+  double frameBegin{};
+  bool paused{};
+  abcg::ProfilerFrame pausedFrame;
+  std::unique_ptr<abcg::TraceWriter> traceWriter;
+};
+
+ProfilerState &getState() {
+  static ProfilerState state;
+  return state;
+}
+
+thread_local std::shared_ptr<ThreadBuffer> currentBuffer;
+
+ThreadBuffer &getThreadBuffer() {
+  if (!currentBuffer) {
+    auto &state{getState()};
+    std::scoped_lock lock{state.mutex};
+    currentBuffer = std::make_shared<ThreadBuffer>();
+    currentBuffer->track = gsl::narrow<std::uint32_t>(state.trackNames.size());
+    state.trackNames.push_back(
+        fmt::format("Thread {}", state.trackNames.size()));
+    state.buffers.push_back(currentBuffer);
+  }
+  return *currentBuffer;
+}
+
+ImU32 getZoneColor(std::string_view name) {
+  auto const hash{std::hash<std::string_view>{}(name)};
+  auto const hue{gsl::narrow_cast<float>(hash % 360) / 360.0f};
+  return ImColor::HSV(hue, 0.5f, 0.65f);
+}
+
+void drawFlameGraph(abcg::ProfilerFrame const &frame) {
+  auto const duration{frame.end - frame.begin};
+  if (duration <= 0.0)
+    return;
+
+  struct TrackLayout {
+    std::uint32_t depth{};
+    double begin{std::numeric_limits<double>::max()};
+    double end{std::numeric_limits<double>::lowest()};
+  };
+
+  // Number of rows and time span of each track
+  std::map<std::uint32_t, TrackLayout> layouts;
+  for (auto const &zone : frame.zones) {
+    auto &layout{layouts[zone.track]};
+    layout.depth = std::max(layout.depth, zone.depth + 1);
+    layout.begin = std::min(layout.begin, zone.begin);
+    layout.end = std::max(layout.end, zone.end);
+  }
+
+  auto *drawList{ImGui::GetWindowDrawList()};
+  auto const origin{ImGui::GetCursorScreenPos()};
+  auto const width{ImGui::GetContentRegionAvail().x};
+  auto const rowHeight{ImGui::GetTextLineHeight() + 4.0f};
+  auto const mouse{ImGui::GetIO().MousePos};
+
+  auto y{origin.y};
+  for (auto const &[track, layout] : layouts) {
+    // Zones read back with latency, such as GPU zones, ended before the frame
+    // began. These are aligned to the beginning of the frame
+    auto const offset{layout.end <= frame.begin ? frame.begin - layout.begin
+                                                : 0.0};
+    auto const trackName{abcg::Profiler::getTrackName(track)};
+    drawList->AddText(ImVec2(origin.x, y), ImGui::GetColorU32(ImGuiCol_Text),
+                      trackName.c_str());
+    y += rowHeight;
+
+    for (auto const &zone : frame.zones) {
+      if (zone.track != track)
+        continue;
+
+      auto const begin{
+          std::clamp(zone.begin + offset, frame.begin, frame.end)};
+      auto const end{std::clamp(zone.end + offset, frame.begin, frame.end)};
+      ImVec2 const min{origin.x + gsl::narrow_cast<float>(
+                                      (begin - frame.begin) / duration * width),
+                       y + gsl::narrow_cast<float>(zone.depth) * rowHeight};
+      ImVec2 const max{
+          origin.x +
+              gsl::narrow_cast<float>((end - frame.begin) / duration * width),
+          min.y + rowHeight - 1.0f};
+      if (max.x - min.x < 1.0f)
+        continue;
+
+      drawList->AddRectFilled(min, max, getZoneColor(zone.name));
+      drawList->PushClipRect(min, max, true);
+      drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f),
+                        IM_COL32(255, 255, 255, 255), zone.name);
+      drawList->PopClipRect();
+
+      if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y &&
+          mouse.y < max.y) {
+        ImGui::SetTooltip("%s: %.3f ms", zone.name,
+                          (zone.end - zone.begin) * 1000.0);
+      }
+    }
+    y += gsl::narrow_cast<float>(layout.depth) * rowHeight;
+  }
+
+  ImGui::Dummy(ImVec2(width, y - origin.y));
+}
+
+void drawTopZones(std::deque<abcg::ProfilerFrame> const &history) {
+  struct Statistics {
+    double total{};
+    double max{};
+    std::size_t calls{};
+  };
+
+  auto const frameCount{std::min(history.size(), statisticsFrames)};
+  if (frameCount == 0)
+    return;
+
+  std::unordered_map<std::string_view, Statistics> statistics;
+  for (auto it{history.end() - gsl::narrow<long>(frameCount)};
+       it != history.end(); ++it) {
+    for (auto const &zone : it->zones) {
+      auto &stats{statistics[zone.name]};
+      auto const time{zone.end - zone.begin};
+      stats.total += time;
+      stats.max = std::max(stats.max, time);
+      ++stats.calls;
+    }
+  }
+
+  std::vector<std::pair<std::string_view, Statistics>> sorted(
+      statistics.begin(), statistics.end());
+  std::sort(sorted.begin(), sorted.end(), [](auto const &a, auto const &b) {
+    return a.second.total > b.second.total;
+  });
+
+  auto const tableFlags{ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg};
+  if (ImGui::BeginTable("Top zones", 4, tableFlags)) {
+    ImGui::TableSetupColumn("Zone");
+    ImGui::TableSetupColumn("Avg ms/frame");
+    ImGui::TableSetupColumn("Max ms");
+    ImGui::TableSetupColumn("Calls/frame");
+    ImGui::TableHeadersRow();
+
+    auto const maxRows{std::size_t{16}};
+    auto const frames{gsl::narrow_cast<double>(frameCount)};
+    for (auto const &[name, stats] :
+         std::span{sorted.data(), std::min(sorted.size(), maxRows)}) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name.data(), name.data() + name.size());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.total / frames * 1000.0);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.max * 1000.0);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", gsl::narrow_cast<double>(stats.calls) / frames);
+    }
+    ImGui::EndTable();
+  }
+}
+
+void drawCounters(abcg::ProfilerFrame const &frame) {
+  if (frame.counters.empty())
+    return;
+
+  auto const tableFlags{ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg};
+  if (ImGui::BeginTable("Counters", 2, tableFlags)) {
+    ImGui::TableSetupColumn("Counter");
+    ImGui::TableSetupColumn("Value");
+    ImGui::TableHeadersRow();
+
+    for (auto const &[name, value] : frame.counters) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.0f", value);
+    }
+    ImGui::EndTable();
+  }
+}
+} // namespace
+
+/**
+ * @brief Enables or disables the recording of zones.
+ *
+ * @param enabled Whether to record zones.
+ */
+void abcg::Profiler::setEnabled(bool enabled) noexcept {
+  getState().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns whether the recording of zones is enabled.
+ *
+ * @return `true` if zones are being recorded.
+ */
+bool abcg::Profiler::isEnabled() noexcept {
+  return getState().enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the current time of the profiler clock.
+ *
+ * @return Time, in seconds, since the profiler epoch.
+ */
+double abcg::Profiler::now() { return getState().epoch.elapsed(); }
+
+/**
+ * @brief Sets the name of the track of the calling thread.
+ *
+ * @param name Name displayed for the zones recorded by the calling thread.
+ */
+void abcg::Profiler::setThreadName(std::string_view name) {
+  auto const track{getThreadBuffer().track};
+  auto &state{getState()};
+  std::scoped_lock lock{state.mutex};
+  state.trackNames.at(track) = name;
+}
+
+/**
+ * @brief Registers a track that is not tied to a thread, such as a GPU queue.
+ *
+ * @param name Name of the track.
+ *
+ * @return Track identifier to be used in abcg::ProfilerZone::track.
+ */
+std::uint32_t abcg::Profiler::registerTrack(std::string_view name) {
+  auto &state{getState()};
+  std::scoped_lock lock{state.mutex};
+  state.trackNames.emplace_back(name);
+  return gsl::narrow<std::uint32_t>(state.trackNames.size() - 1);
+}
+
+/**
+ * @brief Returns the name of a track.
+ *
+ * @param track Track identifier.
+ *
+ * @return Name of the track, or an empty string if the track does not exist.
+ */
+std::string abcg::Profiler::getTrackName(std::uint32_t track) {
+  auto &state{getState()};
+  std::scoped_lock lock{state.mutex};
+  return track < state.trackNames.size() ? state.trackNames.at(track) : "";
+}
+
+/**
+ * @brief Records a zone into the ring buffer of the calling thread.
+ *
+ * Use this function to record zones whose timing is not measured by an
+ * abcg::ProfileScope, e.g., GPU zones read back from timer queries.
+ *
+ * @param zone Zone to be recorded.
+ */
+void abcg::Profiler::record(ProfilerZone const &zone) {
+  if (!isEnabled())
+    return;
+
+  auto &buffer{getThreadBuffer()};
+  auto const index{buffer.written.load(std::memory_order_relaxed)};
+  if (index - buffer.read.load(std::memory_order_acquire) >=
+      ThreadBuffer::capacity) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer.zones.at(index % ThreadBuffer::capacity) = zone;
+  buffer.written.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Sets the value of a counter.
+ *
+ * Counters hold values that are not timings, such as the number of vertices
+ * submitted to the GPU. The current value of each counter is stored with every
+ * frame ended afterwards.
+ *
+ * @param name Counter name.
+ * @param value Counter value.
+ */
+void abcg::Profiler::setCounter(std::string_view name, double value) {
+  if (!isEnabled())
+    return;
+
+  auto &state{getState()};
+  std::scoped_lock lock{state.mutex};
+  if (auto it{state.counters.find(name)}; it != state.counters.end()) {
+    it->second = value;
+  } else {
+    state.counters.emplace(name, value);
+  }
+}
+
+/**
+ * @brief Ends the current frame.
+ *
+ * Gathers the zones recorded by all threads since the previous call and
+ * appends them to the frame history. The frame starts at the end of the
+ * previous frame.
+ */
+void abcg::Profiler::endFrame() {
+  auto &state{getState()};
+  auto const frameEnd{now()};
+
+  if (!isEnabled()) {
+    state.frameBegin = frameEnd;
+    return;
+  }
+
+  ProfilerFrame frame;
+  if (state.history.size() == historySize) {
+    // Reuse the storage of the oldest frame
+    frame = std::move(state.history.front());
+    state.history.pop_front();
+    frame.zones.clear();
+    frame.counters.clear();
+  }
+  frame.index = state.frameIndex++;
+  frame.track = getThreadBuffer().track;
+  frame.begin = state.frameBegin;
+  frame.end = frameEnd;
+
+  {
+    std::scoped_lock lock{state.mutex};
+    std::uint64_t dropped{};
+    for (auto const &buffer : state.buffers) {
+      auto const written{buffer->written.load(std::memory_order_acquire)};
+      auto read{buffer->read.load(std::memory_order_relaxed)};
+      for (; read < written; ++read) {
+        frame.zones.push_back(buffer->zones.at(read % ThreadBuffer::capacity));
+      }
+      // Release the slots to the producer only after they have been copied
+      buffer->read.store(read, std::memory_order_release);
+      dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    frame.counters.assign(state.counters.begin(), state.counters.end());
+    if (dropped > 0) {
+      frame.counters.emplace_back("Dropped zones",
+                                  gsl::narrow_cast<double>(dropped));
+    }
+  }
+
+  if (state.traceWriter) {
+    state.traceWriter->write(frame);
+  }
+
+  state.history.push_back(std::move(frame));
+  state.frameBegin = frameEnd;
+}
+
+/**
+ * @brief Returns the zones of the most recent frames.
+ *
+ * @return History of up to 240 frames, from the oldest to the newest.
+ */
+std::deque<abcg::ProfilerFrame> const &abcg::Profiler::getFrameHistory() {
+  return getState().history;
+}
+
+/**
+ * @brief Draws a Dear ImGui window with a flame graph of the last frame and a
+ * table of the zones that took most time in the last 120 frames.
+ *
+ * Must be called between `ImGui::NewFrame` and `ImGui::Render`.
+ */
+void abcg::Profiler::drawOverlay() {
+  auto &state{getState()};
+
+  ImGui::SetNextWindowSize(ImVec2(640, 400), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Profiler")) {
+    ImGui::End();
+    return;
+  }
+
+  if (ImGui::Checkbox("Pause", &state.paused) && state.paused &&
+      !state.history.empty()) {
+    state.pausedFrame = state.history.back();
+  }
+
+  if (state.history.empty()) {
+    ImGui::TextUnformatted("No frames recorded");
+    ImGui::End();
+    return;
+  }
+
+  auto const &frame{state.paused ? state.pausedFrame : state.history.back()};
+  ImGui::SameLine();
+  ImGui::Text("Frame %llu: %.3f ms",
+              static_cast<unsigned long long>(frame.index),
+              (frame.end - frame.begin) * 1000.0);
+
+  drawFlameGraph(frame);
+  ImGui::Separator();
+  drawTopZones(state.history);
+  drawCounters(frame);
+
+  ImGui::End();
+}
+
+/**
+ * @brief Starts capturing frames to a trace file.
+ *
+ * The frames ended while the capture is active are written to a file in the
+ * Chrome trace event format by a background thread. The window enables the
+ * profiler while a capture is active.
+ *
+ * Must be called from the thread that calls abcg::Profiler::endFrame. If a
+ * capture is already active, it is stopped first.
+ *
+ * @param path Path of the trace file.
+ *
+ * @throw abcg::RuntimeError if the file cannot be created.
+ *
+ * @sa abcg::TraceWriter.
+ */
+void abcg::Profiler::startCapture(std::string_view path) {
+  auto &state{getState()};
+  state.traceWriter.reset();
+  state.traceWriter = std::make_unique<TraceWriter>(path);
+}
+
+/**
+ * @brief Stops the active capture, if any, and closes the trace file.
+ *
+ * Blocks until the pending frames are written.
+ */
+void abcg::Profiler::stopCapture() {
+  auto &state{getState()};
+  if (state.traceWriter) {
+    auto const path{state.traceWriter->getPath()};
+    state.traceWriter.reset();
+    fmt::print("Trace written to {}\n", path);
+  }
+}
+
+/**
+ * @brief Returns whether a capture is active.
+ *
+ * @return `true` if the frames are being written to a trace file.
+ */
+bool abcg::Profiler::isCapturing() noexcept {
+  return getState().traceWriter != nullptr;
+}
+
+/**
+ * @brief Starts a zone.
+ *
+ * @param name Zone name. Must be a string with static storage duration, such
+ * as a string literal.
+ */
+abcg::ProfileScope::ProfileScope(char const *name)
+    : m_name{name}, m_active{Profiler::isEnabled()} {
+  if (m_active) {
+    m_depth = getThreadBuffer().depth++;
+    m_begin = Profiler::now();
+  }
+}
+
+/**
+ * @brief Ends the zone and records it.
+ */
+abcg::ProfileScope::~ProfileScope() {
+  if (m_active) {
+    auto &buffer{getThreadBuffer()};
+    --buffer.depth;
+    Profiler::record({.name = m_name,
+                      .begin = m_begin,
+                      .end = Profiler::now(),
+                      .depth = m_depth,
+                      .track = buffer.track});
+  }
+}
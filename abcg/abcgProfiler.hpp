@@ -0,0 +1,146 @@
+/**
+ * @file abcgProfiler.hpp
+ * @brief Header file of abcg::Profiler and abcg::ProfileScope.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_PROFILER_HPP_
+#define ABCG_PROFILER_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace abcg {
+struct ProfilerZone;
+struct ProfilerFrame;
+class Profiler;
+class ProfileScope;
+} // namespace abcg
+
+// @cond Skipped by Doxygen
+#define ABCG_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ABCG_PROFILE_CONCAT(a, b) ABCG_PROFILE_CONCAT_IMPL(a, b)
+// @endcond
+
+/**
+ * @brief Profiles the enclosing scope as a zone named @a name.
+ *
+ * @param name Zone name. Must be a string with static storage duration, such
+ * as a string literal.
+ *
+ * @sa abcg::ProfileScope
+ */
+#define ABCG_PROFILE_SCOPE(name)                                               \
+  abcg::ProfileScope const ABCG_PROFILE_CONCAT(abcgProfileScope,               \
+                                               __LINE__) {                     \
+    name                                                                       \
+  }
+
+/**
+ * @brief Timing of a profiled zone.
+ */
+struct abcg::ProfilerZone {
+  /** @brief Zone name. */
+  char const *name{};
+  /** @brief Start time, in seconds since the profiler epoch. */
+  double begin{};
+  /** @brief End time, in seconds since the profiler epoch. */
+  double end{};
+  /** @brief Nesting level of the zone within its track. */
+  std::uint32_t depth{};
+  /** @brief Track (thread or GPU queue) the zone belongs to. */
+  std::uint32_t track{};
+};
+
+/**
+ * @brief Zones recorded during a frame.
+ */
+struct abcg::ProfilerFrame {
+  /** @brief Frame index. */
+  std::uint64_t index{};
+  /** @brief Track of the thread that ended the frame. */
+  std::uint32_t track{};
+  /** @brief Start time, in seconds since the profiler epoch. */
+  double begin{};
+  /** @brief End time, in seconds since the profiler epoch. */
+  double end{};
+  /** @brief Zones that ended during the frame, in order of completion per
+   * track. */
+  std::vector<ProfilerZone> zones;
+  /** @brief Values of the counters at the end of the frame. */
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+/**
+ * @brief Hierarchical CPU frame profiler.
+ *
+ * Zones are recorded with abcg::ProfileScope (or the ABCG_PROFILE_SCOPE macro)
+ * into a ring buffer owned by the calling thread, without locking. At the end
+ * of each frame, abcg::Profiler::endFrame gathers the zones of all threads
+ * into a history of recent frames, which is displayed by
+ * abcg::Profiler::drawOverlay.
+ *
+ * The window records zones for each phase of the frame and calls
+ * abcg::Profiler::endFrame at the end of each frame. The profiler is enabled
+ * and its overlay is drawn when abcg::WindowSettings::showProfiler is `true`.
+ *
+ * @remark Zones are only recorded while the profiler is enabled.
+ *
+ * @remark The ring buffer of each thread holds 4096 zones. Zones recorded
+ * while it is full are dropped, and their number is reported in the
+ * "Dropped zones" counter of the frame.
+ */
+class abcg::Profiler {
+public:
+  static void setEnabled(bool enabled) noexcept;
+  [[nodiscard]] static bool isEnabled() noexcept;
+
+  [[nodiscard]] static double now();
+  static void setThreadName(std::string_view name);
+  [[nodiscard]] static std::uint32_t registerTrack(std::string_view name);
+  [[nodiscard]] static std::string getTrackName(std::uint32_t track);
+
+  static void record(ProfilerZone const &zone);
+  static void setCounter(std::string_view name, double value);
+  static void endFrame();
+
+  [[nodiscard]] static std::deque<ProfilerFrame> const &getFrameHistory();
+
+  static void drawOverlay();
+
+  static void startCapture(std::string_view path);
+  static void stopCapture();
+  [[nodiscard]] static bool isCapturing() noexcept;
+};
+
+/**
+ * @brief RAII object that records a profiler zone from its construction to
+ * its destruction.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::ProfileScope {
+public:
+  explicit ProfileScope(char const *name);
+  ProfileScope(ProfileScope const &) = delete;
+  ProfileScope(ProfileScope &&) = delete;
+  ProfileScope &operator=(ProfileScope const &) = delete;
+  ProfileScope &operator=(ProfileScope &&) = delete;
+  ~ProfileScope();
+
+private:
+  char const *m_name{};
+  double m_begin{};
+  std::uint32_t m_depth{};
+  bool m_active{};
+};
+
+#endif
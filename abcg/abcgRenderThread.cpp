@@ -0,0 +1,152 @@
+/**
+ * @file abcgRenderThread.cpp
+ * @brief Definition of abcg::RenderThread and abcg::DrawDataSnapshot members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgRenderThread.hpp"
+
+#include <cstring>
+#include <gsl/gsl>
+#include <span>
+#include <utility>
+
+#include "abcgProfiler.hpp"
+
+/**
+ * @brief Starts the render thread.
+ */
+abcg::RenderThread::RenderThread() : m_thread{[this] { loop(); }} {}
+
+/**
+ * @brief Waits for the pending task, if any, and joins the render thread.
+ *
+ * Exceptions thrown by the pending task are discarded.
+ */
+abcg::RenderThread::~RenderThread() {
+  {
+    std::unique_lock lock{m_mutex};
+    m_condition.wait(lock, [this] { return !m_task; });
+    m_quit = true;
+  }
+  m_condition.notify_all();
+  m_thread.join();
+}
+
+/**
+ * @brief Submits a task to be executed on the render thread.
+ *
+ * Blocks until the previous task, if any, has finished.
+ *
+ * @param task Function to be called on the render thread.
+ *
+ * @throw Any exception thrown by the previous task.
+ */
+void abcg::RenderThread::submit(std::function<void()> task) {
+  wait();
+  {
+    std::scoped_lock lock{m_mutex};
+    m_task = std::move(task);
+  }
+  m_condition.notify_all();
+}
+
+/**
+ * @brief Blocks until the render thread is idle.
+ *
+ * After this function returns, and until the next call to
+ * abcg::RenderThread::submit, no code is running on the render thread. Data
+ * shared with the tasks can then be accessed without further synchronization.
+ *
+ * @throw Any exception thrown by the last task.
+ */
+void abcg::RenderThread::wait() {
+  std::unique_lock lock{m_mutex};
+  m_condition.wait(lock, [this] { return !m_task; });
+  if (m_exception) {
+    std::rethrow_exception(std::exchange(m_exception, nullptr));
+  }
+}
+
+/**
+ * @brief Executes a task on the render thread and waits for it to finish.
+ *
+ * @param task Function to be called on the render thread.
+ *
+ * @throw Any exception thrown by the previous task or by @a task.
+ */
+void abcg::RenderThread::invoke(std::function<void()> task) {
+  submit(std::move(task));
+  wait();
+}
+
+void abcg::RenderThread::loop() {
+  Profiler::setThreadName("Render");
+
+  std::unique_lock lock{m_mutex};
+  while (true) {
+    m_condition.wait(lock, [this] { return m_quit || m_task; });
+    if (!m_task)
+      break;
+
+    lock.unlock();
+    std::exception_ptr exception;
+    try {
+      m_task();
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    lock.lock();
+
+    m_exception = exception;
+    m_task = nullptr;
+    m_condition.notify_all();
+  }
+}
+
+/**
+ * @brief Destroys the draw lists.
+ */
+abcg::DrawDataSnapshot::~DrawDataSnapshot() {
+  for (auto *drawList : m_drawLists) {
+    IM_DELETE(drawList);
+  }
+}
+
+/**
+ * @brief Copies the given draw data into the snapshot.
+ *
+ * @param drawData Draw data to be copied, usually the one returned by
+ * `ImGui::GetDrawData` after `ImGui::Render`.
+ */
+void abcg::DrawDataSnapshot::capture(ImDrawData const &drawData) {
+  auto const count{gsl::narrow<std::size_t>(drawData.CmdListsCount)};
+  while (m_drawLists.size() < count) {
+    m_drawLists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+  }
+
+  auto const copy{[](auto &dst, auto const &src) {
+    dst.resize(src.Size);
+    if (src.Size > 0) {
+      std::memcpy(dst.Data, src.Data,
+                  gsl::narrow<std::size_t>(src.size_in_bytes()));
+    }
+  }};
+
+  std::span const srcLists{drawData.CmdLists, count};
+  for (std::size_t index{}; index < count; ++index) {
+    auto const &src{*srcLists[index]};
+    auto &dst{*m_drawLists[index]};
+    copy(dst.CmdBuffer, src.CmdBuffer);
+    copy(dst.IdxBuffer, src.IdxBuffer);
+    copy(dst.VtxBuffer, src.VtxBuffer);
+    dst.Flags = src.Flags;
+  }
+
+  m_drawData = drawData;
+  m_drawData.CmdLists = m_drawLists.data();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file abcgRenderThread.hpp
+ * @brief Header file of abcg::RenderThread and abcg::DrawDataSnapshot.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_RENDER_THREAD_HPP_
+#define ABCG_RENDER_THREAD_HPP_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <imgui.h>
+
+namespace abcg {
+class RenderThread;
+class DrawDataSnapshot;
+} // namespace abcg
+
+/**
+ * @brief Worker thread that executes one rendering task at a time.
+ *
+ * The thread is started on construction and joined on destruction. Tasks are
+ * submitted with abcg::RenderThread::submit and run in submission order. At
+ * most one task is pending at any time: submitting a task blocks until the
+ * previous one has finished.
+ *
+ * If a task throws an exception, the exception is rethrown on the calling
+ * thread by the next call to abcg::RenderThread::wait,
+ * abcg::RenderThread::submit or abcg::RenderThread::invoke.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::RenderThread {
+public:
+  RenderThread();
+  RenderThread(RenderThread const &) = delete;
+  RenderThread(RenderThread &&) = delete;
+  RenderThread &operator=(RenderThread const &) = delete;
+  RenderThread &operator=(RenderThread &&) = delete;
+  ~RenderThread();
+
+  void submit(std::function<void()> task);
+  void wait();
+  void invoke(std::function<void()> task);
+
+private:
+  void loop();
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::function<void()> m_task;
+  std::exception_ptr m_exception;
+  bool m_quit{};
+  std::thread m_thread;
+};
+
+/**
+ * @brief Copy of the Dear ImGui draw data of a frame.
+ *
+ * The draw data returned by `ImGui::GetDrawData` is owned by the ImGui context
+ * and is invalidated by the next call to `ImGui::NewFrame`. This class keeps a
+ * deep copy that can be rendered on another thread while the next frame is
+ * being built. Draw lists and their buffers are reused between captures.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::DrawDataSnapshot {
+public:
+  DrawDataSnapshot() = default;
+  DrawDataSnapshot(DrawDataSnapshot const &) = delete;
+  DrawDataSnapshot(DrawDataSnapshot &&) = delete;
+  DrawDataSnapshot &operator=(DrawDataSnapshot const &) = delete;
+  DrawDataSnapshot &operator=(DrawDataSnapshot &&) = delete;
+  ~DrawDataSnapshot();
+
+  void capture(ImDrawData const &drawData);
+
+  /**
+   * @brief Returns the captured draw data.
+   *
+   * @return Pointer to the draw data of the last call to
+   * abcg::DrawDataSnapshot::capture.
+   */
+  [[nodiscard]] ImDrawData *get() noexcept { return &m_drawData; }
+
+private:
+  ImDrawData m_drawData;
+  std::vector<ImDrawList *> m_drawLists;
+};
+
+#endif
@@ -0,0 +1,374 @@
+/**
+ * @file abcgTextureContainer.cpp
+ * @brief Definition of the KTX2 and DDS texture container reader.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgTextureContainer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include <fmt/core.h>
+#include <gsl/gsl>
+
+#include "abcgException.hpp"
+
+namespace {
+using abcg::TextureFormat;
+
+struct FormatInfo {
+  std::uint32_t blockSize{};
+  std::uint32_t bytesPerBlock{};
+};
+
+FormatInfo getFormatInfo(TextureFormat format) noexcept {
+  switch (format) {
+  case TextureFormat::RGBA8:
+  case TextureFormat::RGBA8sRGB:
+    return {.blockSize = 1, .bytesPerBlock = 4};
+  case TextureFormat::BC1:
+  case TextureFormat::BC1sRGB:
+  case TextureFormat::BC4:
+  case TextureFormat::ETC2RGB8:
+  case TextureFormat::ETC2RGB8sRGB:
+    return {.blockSize = 4, .bytesPerBlock = 8};
+  default:
+    return {.blockSize = 4, .bytesPerBlock = 16};
+  }
+}
+
+std::size_t getLevelSize(TextureFormat format, std::uint32_t width,
+                         std::uint32_t height) noexcept {
+  auto const [blockSize, bytesPerBlock]{getFormatInfo(format)};
+  auto const blocksX{(width + blockSize - 1) / blockSize};
+  auto const blocksY{(height + blockSize - 1) / blockSize};
+  return std::size_t{blocksX} * blocksY * bytesPerBlock;
+}
+
+std::vector<std::byte> readFile(std::string_view path) {
+  std::ifstream stream{std::string{path}, std::ios::binary | std::ios::ate};
+  if (!stream) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to load texture file {}", path));
+  }
+  std::vector<std::byte> bytes(gsl::narrow<std::size_t>(stream.tellg()));
+  stream.seekg(0);
+  stream.read(reinterpret_cast<char *>(bytes.data()),
+              gsl::narrow<std::streamsize>(bytes.size()));
+  return bytes;
+}
+
+// Reads a little-endian value at the given offset of the file
+template <typename T>
+T read(std::vector<std::byte> const &bytes, std::size_t offset,
+       std::string_view path) {
+  if (offset + sizeof(T) > bytes.size()) {
+    throw abcg::RuntimeError(fmt::format("Truncated texture file {}", path));
+  }
+  T value{};
+  std::memcpy(&value,
+              std::next(bytes.data(), gsl::narrow<std::ptrdiff_t>(offset)),
+              sizeof(T));
+  return value;
+}
+
+// Appends a level, padded so that each level starts at a multiple of 16
+// bytes, as required by Vulkan buffer-to-image copies of compressed formats
+void appendLevel(abcg::TextureContainer &container,
+                 std::vector<std::byte> const &bytes, std::size_t offset,
+                 std::uint32_t width, std::uint32_t height,
+                 std::string_view path) {
+  auto const size{getLevelSize(container.format, width, height)};
+  if (offset + size > bytes.size()) {
+    throw abcg::RuntimeError(fmt::format("Truncated texture file {}", path));
+  }
+  auto const levelOffset{(container.data.size() + 15) / 16 * 16};
+  container.data.resize(levelOffset);
+  auto const first{
+      std::next(bytes.begin(), gsl::narrow<std::ptrdiff_t>(offset))};
+  container.data.insert(container.data.end(), first,
+                        std::next(first, gsl::narrow<std::ptrdiff_t>(size)));
+  container.levels.push_back(
+      {.width = width, .height = height, .offset = levelOffset, .size = size});
+}
+
+std::optional<TextureFormat> fromVkFormat(std::uint32_t vkFormat) {
+  switch (vkFormat) {
+  case 37: // VK_FORMAT_R8G8B8A8_UNORM
+    return TextureFormat::RGBA8;
+  case 43: // VK_FORMAT_R8G8B8A8_SRGB
+    return TextureFormat::RGBA8sRGB;
+  case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+  case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+    return TextureFormat::BC1;
+  case 132: // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+  case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+    return TextureFormat::BC1sRGB;
+  case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+    return TextureFormat::BC3;
+  case 138: // VK_FORMAT_BC3_SRGB_BLOCK
+    return TextureFormat::BC3sRGB;
+  case 139: // VK_FORMAT_BC4_UNORM_BLOCK
+    return TextureFormat::BC4;
+  case 141: // VK_FORMAT_BC5_UNORM_BLOCK
+    return TextureFormat::BC5;
+  case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+    return TextureFormat::BC7;
+  case 146: // VK_FORMAT_BC7_SRGB_BLOCK
+    return TextureFormat::BC7sRGB;
+  case 147: // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+    return TextureFormat::ETC2RGB8;
+  case 148: // VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+    return TextureFormat::ETC2RGB8sRGB;
+  case 151: // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+    return TextureFormat::ETC2RGBA8;
+  case 152: // VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+    return TextureFormat::ETC2RGBA8sRGB;
+  case 157: // VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+    return TextureFormat::ASTC4x4;
+  case 158: // VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+    return TextureFormat::ASTC4x4sRGB;
+  default:
+    return std::nullopt;
+  }
+}
+
+std::optional<TextureFormat> fromDXGIFormat(std::uint32_t dxgiFormat) {
+  switch (dxgiFormat) {
+  case 28: // DXGI_FORMAT_R8G8B8A8_UNORM
+    return TextureFormat::RGBA8;
+  case 29: // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+    return TextureFormat::RGBA8sRGB;
+  case 71: // DXGI_FORMAT_BC1_UNORM
+    return TextureFormat::BC1;
+  case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+    return TextureFormat::BC1sRGB;
+  case 77: // DXGI_FORMAT_BC3_UNORM
+    return TextureFormat::BC3;
+  case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+    return TextureFormat::BC3sRGB;
+  case 80: // DXGI_FORMAT_BC4_UNORM
+    return TextureFormat::BC4;
+  case 83: // DXGI_FORMAT_BC5_UNORM
+    return TextureFormat::BC5;
+  case 98: // DXGI_FORMAT_BC7_UNORM
+    return TextureFormat::BC7;
+  case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+    return TextureFormat::BC7sRGB;
+  default:
+    return std::nullopt;
+  }
+}
+
+constexpr std::uint32_t fourCC(std::string_view code) {
+  return static_cast<std::uint32_t>(code[0]) |
+         static_cast<std::uint32_t>(code[1]) << 8U |
+         static_cast<std::uint32_t>(code[2]) << 16U |
+         static_cast<std::uint32_t>(code[3]) << 24U;
+}
+
+abcg::TextureContainer parseKTX2(std::vector<std::byte> const &bytes,
+                                 std::string_view path) {
+  auto const vkFormat{read<std::uint32_t>(bytes, 12, path)};
+  auto const width{read<std::uint32_t>(bytes, 20, path)};
+  auto const height{read<std::uint32_t>(bytes, 24, path)};
+  auto const depth{read<std::uint32_t>(bytes, 28, path)};
+  auto const layerCount{read<std::uint32_t>(bytes, 32, path)};
+  auto const faceCount{read<std::uint32_t>(bytes, 36, path)};
+  auto const levelCount{
+      std::max(read<std::uint32_t>(bytes, 40, path), std::uint32_t{1})};
+  auto const supercompression{read<std::uint32_t>(bytes, 44, path)};
+
+  if (width == 0 || height == 0 || depth > 1 || layerCount > 1 ||
+      faceCount != 1) {
+    throw abcg::RuntimeError(
+        fmt::format("Only single 2D textures are supported in {}", path));
+  }
+  if (supercompression != 0) {
+    throw abcg::RuntimeError(
+        fmt::format("Supercompressed KTX2 files are not supported ({})", path));
+  }
+  auto const format{fromVkFormat(vkFormat)};
+  if (!format) {
+    throw abcg::RuntimeError(
+        fmt::format("Unsupported KTX2 format {} in {}", vkFormat, path));
+  }
+
+  abcg::TextureContainer container;
+  container.format = *format;
+  constexpr std::size_t levelIndexOffset{80};
+  constexpr std::size_t levelIndexEntrySize{24};
+  for (std::uint32_t level{}; level < levelCount; ++level) {
+    auto const entry{levelIndexOffset + level * levelIndexEntrySize};
+    auto const offset{read<std::uint64_t>(bytes, entry, path)};
+    appendLevel(container, bytes, gsl::narrow<std::size_t>(offset),
+                std::max(width >> level, 1U), std::max(height >> level, 1U),
+                path);
+  }
+  return container;
+}
+
+abcg::TextureContainer parseDDS(std::vector<std::byte> const &bytes,
+                                std::string_view path) {
+  auto const height{read<std::uint32_t>(bytes, 12, path)};
+  auto const width{read<std::uint32_t>(bytes, 16, path)};
+  auto const levelCount{
+      std::max(read<std::uint32_t>(bytes, 28, path), std::uint32_t{1})};
+  auto const pixelFlags{read<std::uint32_t>(bytes, 80, path)};
+  auto const code{read<std::uint32_t>(bytes, 84, path)};
+  auto const caps2{read<std::uint32_t>(bytes, 112, path)};
+
+  constexpr std::uint32_t cubemapFlag{0x200};
+  constexpr std::uint32_t volumeFlag{0x200000};
+  if (width == 0 || height == 0 || (caps2 & (cubemapFlag | volumeFlag)) != 0) {
+    throw abcg::RuntimeError(
+        fmt::format("Only single 2D textures are supported in {}", path));
+  }
+
+  std::optional<TextureFormat> format;
+  std::size_t dataOffset{128};
+  constexpr std::uint32_t fourCCFlag{0x4};
+  constexpr std::uint32_t rgbFlag{0x40};
+  if ((pixelFlags & fourCCFlag) != 0) {
+    if (code == fourCC("DX10")) {
+      auto const miscFlag{read<std::uint32_t>(bytes, 136, path)};
+      auto const arraySize{read<std::uint32_t>(bytes, 140, path)};
+      constexpr std::uint32_t cubeFlag{0x4};
+      if ((miscFlag & cubeFlag) != 0 || arraySize > 1) {
+        throw abcg::RuntimeError(
+            fmt::format("Only single 2D textures are supported in {}", path));
+      }
+      format = fromDXGIFormat(read<std::uint32_t>(bytes, 128, path));
+      dataOffset += 20;
+    } else if (code == fourCC("DXT1")) {
+      format = TextureFormat::BC1;
+    } else if (code == fourCC("DXT5")) {
+      format = TextureFormat::BC3;
+    } else if (code == fourCC("ATI1") || code == fourCC("BC4U")) {
+      format = TextureFormat::BC4;
+    } else if (code == fourCC("ATI2") || code == fourCC("BC5U")) {
+      format = TextureFormat::BC5;
+    }
+  } else if ((pixelFlags & rgbFlag) != 0 &&
+             read<std::uint32_t>(bytes, 88, path) == 32 &&
+             read<std::uint32_t>(bytes, 92, path) == 0x000000FF &&
+             read<std::uint32_t>(bytes, 96, path) == 0x0000FF00 &&
+             read<std::uint32_t>(bytes, 100, path) == 0x00FF0000) {
+    format = TextureFormat::RGBA8;
+  }
+  if (!format) {
+    throw abcg::RuntimeError(
+        fmt::format("Unsupported DDS format in {}", path));
+  }
+
+  abcg::TextureContainer container;
+  container.format = *format;
+  for (std::uint32_t level{}; level < levelCount; ++level) {
+    auto const levelWidth{std::max(width >> level, 1U)};
+    auto const levelHeight{std::max(height >> level, 1U)};
+    appendLevel(container, bytes, dataOffset, levelWidth, levelHeight, path);
+    dataOffset += container.levels.back().size;
+  }
+  return container;
+}
+} // namespace
+
+/**
+ * @brief Returns whether a file is a texture container, based on its
+ * extension.
+ *
+ * @param path Path to the file.
+ *
+ * @return `true` if the extension is `.ktx2` or `.dds` (in any case).
+ */
+bool abcg::isTextureContainer(std::string_view path) {
+  auto extension{std::filesystem::path{path}.extension().string()};
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char character) {
+                   return static_cast<char>(std::tolower(character));
+                 });
+  return extension == ".ktx2" || extension == ".dds";
+}
+
+/**
+ * @brief Reads a KTX2 or DDS file.
+ *
+ * Supports single 2D textures with one or more mipmap levels, in the formats
+ * of abcg::TextureFormat. KTX2 files must not be supercompressed.
+ *
+ * @param path Path to the file.
+ *
+ * @throw abcg::RuntimeError if the file cannot be read, is truncated, or is
+ * not supported.
+ *
+ * @return Texture with the levels stored in the file.
+ */
+abcg::TextureContainer abcg::loadTextureContainer(std::string_view path) {
+  auto const bytes{readFile(path)};
+
+  constexpr std::array<unsigned char, 12> ktx2Identifier{
+      0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+  if (bytes.size() >= ktx2Identifier.size() &&
+      std::memcmp(bytes.data(), ktx2Identifier.data(),
+                  ktx2Identifier.size()) == 0) {
+    return parseKTX2(bytes, path);
+  }
+  if (bytes.size() >= 4 &&
+      read<std::uint32_t>(bytes, 0, path) == fourCC("DDS ")) {
+    return parseDDS(bytes, path);
+  }
+  throw abcg::RuntimeError(
+      fmt::format("Unrecognized texture container {}", path));
+}
+
+/**
+ * @brief Returns whether a format is block compressed.
+ *
+ * @param format Texel format.
+ *
+ * @return `true` unless the format is uncompressed RGBA.
+ */
+bool abcg::isCompressed(TextureFormat format) noexcept {
+  return format != TextureFormat::RGBA8 && format != TextureFormat::RGBA8sRGB;
+}
+
+/**
+ * @brief Returns the sRGB variant of a format.
+ *
+ * @param format Texel format.
+ *
+ * @return Variant of @a format in sRGB space, or @a format if it has no such
+ * variant.
+ */
+abcg::TextureFormat abcg::toSRGB(TextureFormat format) noexcept {
+  switch (format) {
+  case TextureFormat::RGBA8:
+    return TextureFormat::RGBA8sRGB;
+  case TextureFormat::BC1:
+    return TextureFormat::BC1sRGB;
+  case TextureFormat::BC3:
+    return TextureFormat::BC3sRGB;
+  case TextureFormat::BC7:
+    return TextureFormat::BC7sRGB;
+  case TextureFormat::ETC2RGB8:
+    return TextureFormat::ETC2RGB8sRGB;
+  case TextureFormat::ETC2RGBA8:
+    return TextureFormat::ETC2RGBA8sRGB;
+  case TextureFormat::ASTC4x4:
+    return TextureFormat::ASTC4x4sRGB;
+  default:
+    return format;
+  }
+}
@@ -0,0 +1,106 @@
+/**
+ * @file abcgTextureContainer.hpp
+ * @brief Declaration of the KTX2 and DDS texture container reader.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TEXTURE_CONTAINER_HPP_
+#define ABCG_TEXTURE_CONTAINER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace abcg {
+enum class TextureFormat;
+struct TextureLevel;
+struct TextureContainer;
+
+[[nodiscard]] bool isTextureContainer(std::string_view path);
+[[nodiscard]] TextureContainer loadTextureContainer(std::string_view path);
+[[nodiscard]] bool isCompressed(TextureFormat format) noexcept;
+[[nodiscard]] TextureFormat toSRGB(TextureFormat format) noexcept;
+} // namespace abcg
+
+/**
+ * @brief Enumeration of the texel formats read from texture containers.
+ *
+ * Compressed formats use blocks of 4x4 texels.
+ */
+enum class abcg::TextureFormat {
+  /** @brief 8-bit RGBA, uncompressed. */
+  RGBA8,
+  /** @brief 8-bit RGBA in sRGB space, uncompressed. */
+  RGBA8sRGB,
+  /** @brief BC1 (DXT1) RGBA, 8 bytes per block. */
+  BC1,
+  /** @brief BC1 (DXT1) RGBA in sRGB space, 8 bytes per block. */
+  BC1sRGB,
+  /** @brief BC3 (DXT5) RGBA, 16 bytes per block. */
+  BC3,
+  /** @brief BC3 (DXT5) RGBA in sRGB space, 16 bytes per block. */
+  BC3sRGB,
+  /** @brief BC4 (RGTC1) single channel, 8 bytes per block. */
+  BC4,
+  /** @brief BC5 (RGTC2) two channels, 16 bytes per block. */
+  BC5,
+  /** @brief BC7 (BPTC) RGBA, 16 bytes per block. */
+  BC7,
+  /** @brief BC7 (BPTC) RGBA in sRGB space, 16 bytes per block. */
+  BC7sRGB,
+  /** @brief ETC2 RGB, 8 bytes per block. */
+  ETC2RGB8,
+  /** @brief ETC2 RGB in sRGB space, 8 bytes per block. */
+  ETC2RGB8sRGB,
+  /** @brief ETC2 RGBA, 16 bytes per block. */
+  ETC2RGBA8,
+  /** @brief ETC2 RGBA in sRGB space, 16 bytes per block. */
+  ETC2RGBA8sRGB,
+  /** @brief ASTC 4x4 LDR, 16 bytes per block. */
+  ASTC4x4,
+  /** @brief ASTC 4x4 LDR in sRGB space, 16 bytes per block. */
+  ASTC4x4sRGB
+};
+
+/**
+ * @brief Mipmap level of an abcg::TextureContainer.
+ */
+struct abcg::TextureLevel {
+  /** @brief Width of the level, in texels. */
+  std::uint32_t width{};
+  /** @brief Height of the level, in texels. */
+  std::uint32_t height{};
+  /** @brief Offset of the level in abcg::TextureContainer::data, in bytes.
+   * Multiple of 16. */
+  std::size_t offset{};
+  /** @brief Size of the level, in bytes. */
+  std::size_t size{};
+};
+
+/**
+ * @brief 2D texture read from a KTX2 or DDS file.
+ *
+ * The levels are stored as in the file, ready to be uploaded with
+ * `glCompressedTexImage2D` or copied from a Vulkan staging buffer. Level 0 is
+ * the base level.
+ *
+ * @remark KTX2 and DDS images are stored top row first, whereas images loaded
+ * with SDL_image are flipped upside down by default. Compressed images cannot
+ * be flipped at load time, so bake them with the orientation expected by the
+ * texture coordinates.
+ */
+struct abcg::TextureContainer {
+  /** @brief Texel format. */
+  TextureFormat format{};
+  /** @brief Mipmap levels, from the base level to the smallest level. */
+  std::vector<TextureLevel> levels;
+  /** @brief Texel data of all levels. */
+  std::vector<std::byte> data;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file abcgTraceWriter.cpp
+ * @brief Definition of abcg::TraceWriter members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgTraceWriter.hpp"
+
+#include <cmath>
+#include <utility>
+
+#include <fmt/core.h>
+
+#include "abcgException.hpp"
+
+namespace {
+// Escapes a string to be written as a JSON string
+std::string escape(std::string_view text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (auto const character : text) {
+    if (character == '"' || character == '\\') {
+      escaped += '\\';
+      escaped += character;
+    } else if (static_cast<unsigned char>(character) < 0x20) {
+      escaped += fmt::format("\\u{:04x}", static_cast<int>(character));
+    } else {
+      escaped += character;
+    }
+  }
+  return escaped;
+}
+
+// Trace timestamps are in microseconds
+double toMicroseconds(double seconds) { return seconds * 1e6; }
+} // namespace
+
+/**
+ * @brief Creates the trace file and starts the writer thread.
+ *
+ * @param path Path of the trace file.
+ *
+ * @throw abcg::RuntimeError if the file cannot be created.
+ */
+abcg::TraceWriter::TraceWriter(std::string_view path)
+    : m_path{path}, m_file{m_path} {
+  if (!m_file) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to create trace file {}", m_path));
+  }
+  m_file << R"({"displayTimeUnit":"ms","traceEvents":[)";
+  m_thread = std::thread{[this] { loop(); }};
+}
+
+/**
+ * @brief Writes the pending frames and the names of the tracks, closes the
+ * file and joins the writer thread.
+ */
+abcg::TraceWriter::~TraceWriter() {
+  {
+    std::scoped_lock lock{m_mutex};
+    m_quit = true;
+  }
+  m_condition.notify_one();
+  m_thread.join();
+
+  for (auto const track : m_tracks) {
+    writeEvent(fmt::format(
+        R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},)"
+        R"("args":{{"name":"{}"}}}})",
+        track, escape(Profiler::getTrackName(track))));
+  }
+  m_file << "]}\n";
+}
+
+/**
+ * @brief Queues a frame to be written by the writer thread.
+ *
+ * @param frame Frame to be written.
+ */
+void abcg::TraceWriter::write(ProfilerFrame frame) {
+  {
+    std::scoped_lock lock{m_mutex};
+    m_queue.push_back(std::move(frame));
+  }
+  m_condition.notify_one();
+}
+
+void abcg::TraceWriter::loop() {
+  std::unique_lock lock{m_mutex};
+  while (true) {
+    m_condition.wait(lock, [this] { return m_quit || !m_queue.empty(); });
+    if (m_queue.empty())
+      break;
+
+    auto frame{std::move(m_queue.front())};
+    m_queue.pop_front();
+
+    lock.unlock();
+    writeFrame(frame);
+    lock.lock();
+  }
+  m_file.flush();
+}
+
+void abcg::TraceWriter::writeFrame(ProfilerFrame const &frame) {
+  m_tracks.insert(frame.track);
+  writeEvent(fmt::format(
+      R"({{"name":"Frame","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f},)"
+      R"("args":{{"index":{}}}}})",
+      frame.track, toMicroseconds(frame.begin),
+      toMicroseconds(frame.end - frame.begin), frame.index));
+
+  for (auto const &zone : frame.zones) {
+    m_tracks.insert(zone.track);
+    writeEvent(fmt::format(
+        R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+        escape(zone.name), zone.track, toMicroseconds(zone.begin),
+        toMicroseconds(zone.end - zone.begin)));
+  }
+
+  for (auto const &[name, value] : frame.counters) {
+    // NaN and infinity cannot be written as JSON numbers
+    if (!std::isfinite(value))
+      continue;
+    writeEvent(fmt::format(
+        R"({{"name":"{}","ph":"C","pid":1,"ts":{:.3f},"args":{{"value":{}}}}})",
+        escape(name), toMicroseconds(frame.end), value));
+  }
+}
+
+void abcg::TraceWriter::writeEvent(std::string_view event) {
+  if (!m_firstEvent) {
+    m_file << ",\n";
+  }
+  m_firstEvent = false;
+  m_file << event;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file abcgTraceWriter.hpp
+ * @brief Header file of abcg::TraceWriter.
+ *
+ * Declaration of abcg::TraceWriter.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TRACE_WRITER_HPP_
+#define ABCG_TRACE_WRITER_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "abcgProfiler.hpp"
+
+namespace abcg {
+class TraceWriter;
+} // namespace abcg
+
+/**
+ * @brief Writes profiler frames to a file in the Chrome trace event format.
+ *
+ * The file can be opened in `chrome://tracing` or in the Perfetto UI
+ * (https://ui.perfetto.dev). Frames are written by a background thread, so
+ * that the frames being captured are not slowed down by file I/O.
+ *
+ * Each zone is written as a complete event on the track (thread) it was
+ * recorded on. Each frame is written as a "Frame" event on the track of the
+ * thread that ended it, and counters are written as counter events. Counter
+ * values that are not finite (NaN or infinity) are skipped, as they cannot be
+ * written as JSON numbers.
+ *
+ * @sa abcg::Profiler::startCapture.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::TraceWriter {
+public:
+  explicit TraceWriter(std::string_view path);
+  TraceWriter(TraceWriter const &) = delete;
+  TraceWriter(TraceWriter &&) = delete;
+  TraceWriter &operator=(TraceWriter const &) = delete;
+  TraceWriter &operator=(TraceWriter &&) = delete;
+  ~TraceWriter();
+
+  void write(ProfilerFrame frame);
+
+  /**
+   * @brief Returns the path of the trace file.
+   *
+   * @return Path passed to the constructor.
+   */
+  [[nodiscard]] std::string const &getPath() const noexcept { return m_path; }
+
+private:
+  void loop();
+  void writeFrame(ProfilerFrame const &frame);
+  void writeEvent(std::string_view event);
+
+  std::string m_path;
+  std::ofstream m_file;
+  std::set<std::uint32_t> m_tracks;
+  bool m_firstEvent{true};
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::deque<ProfilerFrame> m_queue;
+  bool m_quit{};
+  std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,352 @@
+/**
+ * @file abcgVulkanGPUTimer.cpp
+ * @brief Definition of abcg::VulkanGPUTimer and abcg::VulkanGPUScope members.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#include "abcgVulkanGPUTimer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include <gsl/gsl>
+
+#include "abcgExternal.hpp"
+#include "abcgProfiler.hpp"
+
+namespace {
+constexpr auto noZone{std::numeric_limits<std::uint32_t>::max()};
+
+// Results are written in the order of the bits
+constexpr vk::QueryPipelineStatisticFlags statisticsFlags{
+    vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+    vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+    vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+    vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+    vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+    vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations};
+constexpr std::uint32_t statisticsCount{6};
+} // namespace
+
+/**
+ * @brief Creates the query pools and command buffers of the timer.
+ *
+ * @param device Vulkan device.
+ * @param frameCount Number of in-flight frames of the swapchain.
+ * @param pipelineStatistics Whether to create pipeline statistics queries, if
+ * supported by the device.
+ */
+void abcg::VulkanGPUTimer::create(VulkanDevice const &device,
+                                  std::size_t frameCount,
+                                  bool pipelineStatistics) {
+  destroy();
+
+  auto const &physicalDevice{
+      static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())};
+  auto const graphicsFamily{
+      device.getPhysicalDevice().getQueuesFamilies().graphics.value()};
+  auto const validBits{
+      physicalDevice.getQueueFamilyProperties().at(graphicsFamily)
+          .timestampValidBits};
+  if (validBits == 0 || frameCount == 0)
+    return;
+
+  m_device = static_cast<vk::Device>(device);
+  m_timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+  m_timestampMask = validBits >= 64 ? std::numeric_limits<std::uint64_t>::max()
+                                    : (std::uint64_t{1} << validBits) - 1;
+  m_statisticsEnabled =
+      pipelineStatistics &&
+      physicalDevice.getFeatures().pipelineStatisticsQuery == VK_TRUE;
+
+  m_commandPool = m_device.createCommandPool(
+      {.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+       .queueFamilyIndex = graphicsFamily});
+  auto const commandBuffers{m_device.allocateCommandBuffers(
+      {.commandPool = m_commandPool,
+       .level = vk::CommandBufferLevel::ePrimary,
+       .commandBufferCount = gsl::narrow<uint32_t>(frameCount)})};
+
+  m_frames.resize(frameCount);
+  for (auto &&[frame, commandBuffer] : iter::zip(m_frames, commandBuffers)) {
+    frame.commandBuffer = commandBuffer;
+    frame.timestamps = m_device.createQueryPool(
+        {.queryType = vk::QueryType::eTimestamp, .queryCount = maxTimestamps});
+    if (m_statisticsEnabled) {
+      frame.statistics = m_device.createQueryPool(
+          {.queryType = vk::QueryType::ePipelineStatistics,
+           .queryCount = 1,
+           .pipelineStatistics = statisticsFlags});
+    }
+  }
+
+  m_track = Profiler::registerTrack("GPU");
+  m_supported = true;
+}
+
+/**
+ * @brief Destroys the query pools and command buffers of the timer.
+ *
+ * The device must be idle.
+ */
+void abcg::VulkanGPUTimer::destroy() {
+  if (!m_supported)
+    return;
+
+  for (auto &frame : m_frames) {
+    m_device.destroyQueryPool(frame.timestamps);
+    if (m_statisticsEnabled) {
+      m_device.destroyQueryPool(frame.statistics);
+    }
+  }
+  m_device.destroyCommandPool(m_commandPool);
+
+  m_frames.clear();
+  m_currentFrame = nullptr;
+  m_depth = 0;
+  m_supported = false;
+  m_recording = false;
+  m_statisticsEnabled = false;
+}
+
+/**
+ * @brief Starts measuring a frame.
+ *
+ * Must be called after the fence of the frame is signaled. Reads back the
+ * results of the previous use of the frame, records them into abcg::Profiler,
+ * and begins a command buffer that resets the queries of the frame.
+ *
+ * @param frameIndex Index of the in-flight frame.
+ *
+ * @return Command buffer in the recording state, to be ended by the caller and
+ * submitted before the other command buffers of the frame. Zones can be
+ * started in this command buffer.
+ */
+vk::CommandBuffer const &
+abcg::VulkanGPUTimer::beginFrame(std::uint32_t frameIndex) {
+  auto &frame{m_frames.at(frameIndex % m_frames.size())};
+  if (frame.pending) {
+    resolve(frame);
+    frame.pending = false;
+  }
+
+  m_currentFrame = &frame;
+  m_recording = Profiler::isEnabled();
+  m_depth = 0;
+  frame.queryCount = 0;
+  frame.zones.clear();
+  frame.statisticsWritten = false;
+  frame.cpuReference = Profiler::now();
+
+  frame.commandBuffer.reset();
+  frame.commandBuffer.begin(
+      {.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+  if (m_recording) {
+    frame.commandBuffer.resetQueryPool(frame.timestamps, 0, maxTimestamps);
+    if (m_statisticsEnabled) {
+      frame.commandBuffer.resetQueryPool(frame.statistics, 0, 1);
+    }
+  }
+  return frame.commandBuffer;
+}
+
+/**
+ * @brief Finishes measuring the current frame.
+ *
+ * Must be called after all zones of the frame were recorded.
+ */
+void abcg::VulkanGPUTimer::endFrame() {
+  if (m_currentFrame == nullptr)
+    return;
+
+  m_currentFrame->pending = m_recording;
+  m_currentFrame = nullptr;
+  m_recording = false;
+}
+
+/**
+ * @brief Starts a GPU zone.
+ *
+ * Zones can be nested, and must be ended in the reverse order they were
+ * started. Zones that do not fit in the query pool are ignored.
+ *
+ * @param commandBuffer Command buffer in the recording state.
+ * @param name Zone name. Must be a string with static storage duration, such
+ * as a string literal.
+ *
+ * @return Identifier of the zone to be passed to
+ * abcg::VulkanGPUTimer::endZone.
+ *
+ * @sa abcg::VulkanGPUScope
+ */
+std::uint32_t
+abcg::VulkanGPUTimer::beginZone(vk::CommandBuffer const &commandBuffer,
+                                char const *name) {
+  if (!m_recording || m_currentFrame->queryCount + 2 > maxTimestamps)
+    return noZone;
+
+  auto &frame{*m_currentFrame};
+  auto const query{frame.queryCount++};
+  commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                               frame.timestamps, query);
+  // Reserve the end query so that the zone can always be ended
+  frame.zones.push_back({.name = name,
+                         .depth = m_depth++,
+                         .beginQuery = query,
+                         .endQuery = frame.queryCount++});
+  return gsl::narrow<std::uint32_t>(frame.zones.size() - 1);
+}
+
+/**
+ * @brief Ends a GPU zone.
+ *
+ * @param commandBuffer Command buffer in the recording state. It can be
+ * different from the command buffer where the zone was started, as long as it
+ * is submitted after it.
+ * @param zone Identifier returned by abcg::VulkanGPUTimer::beginZone.
+ */
+void abcg::VulkanGPUTimer::endZone(vk::CommandBuffer const &commandBuffer,
+                                   std::uint32_t zone) {
+  if (!m_recording || zone == noZone)
+    return;
+
+  commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                               m_currentFrame->timestamps,
+                               m_currentFrame->zones.at(zone).endQuery);
+  --m_depth;
+}
+
+/**
+ * @brief Starts collecting pipeline statistics.
+ *
+ * Statistics are collected only if abcg::VulkanSettings::pipelineStatistics
+ * is `true` and the device supports pipeline statistics queries. Only one
+ * range of commands can be measured per frame, and it must begin and end in
+ * the same command buffer, e.g., around the main render pass recorded in
+ * abcg::VulkanWindow::onPaint.
+ *
+ * @param commandBuffer Command buffer in the recording state.
+ */
+void abcg::VulkanGPUTimer::beginPipelineStatistics(
+    vk::CommandBuffer const &commandBuffer) {
+  if (!m_recording || !m_statisticsEnabled ||
+      m_currentFrame->statisticsWritten)
+    return;
+
+  commandBuffer.beginQuery(m_currentFrame->statistics, 0, {});
+}
+
+/**
+ * @brief Stops collecting pipeline statistics.
+ *
+ * @param commandBuffer Command buffer where
+ * abcg::VulkanGPUTimer::beginPipelineStatistics was called.
+ */
+void abcg::VulkanGPUTimer::endPipelineStatistics(
+    vk::CommandBuffer const &commandBuffer) {
+  if (!m_recording || !m_statisticsEnabled ||
+      m_currentFrame->statisticsWritten)
+    return;
+
+  commandBuffer.endQuery(m_currentFrame->statistics, 0);
+  m_currentFrame->statisticsWritten = true;
+}
+
+void abcg::VulkanGPUTimer::resolve(Frame &frame) {
+  if (frame.queryCount > 0) {
+    // Pairs of result and availability of each query
+    auto &availability{m_queryResults};
+    availability.resize(std::size_t{frame.queryCount} * 2);
+
+    // The fence of the frame is signaled, so this does not wait. Queries of
+    // zones that were not ended are not available and are skipped
+    if (auto const result{m_device.getQueryPoolResults(
+            frame.timestamps, 0, frame.queryCount,
+            availability.size() * sizeof(std::uint64_t), availability.data(),
+            2 * sizeof(std::uint64_t),
+            vk::QueryResultFlagBits::e64 |
+                vk::QueryResultFlagBits::eWithAvailability)};
+        result == vk::Result::eSuccess || result == vk::Result::eNotReady) {
+      auto const firstTimestamp{
+          std::ranges::min(frame.zones, {}, [&](Zone const &zone) {
+            return availability.at(zone.beginQuery * 2) & m_timestampMask;
+          })};
+      auto const origin{availability.at(firstTimestamp.beginQuery * 2) &
+                        m_timestampMask};
+
+      // GPU timestamps are mapped to the profiler clock by aligning the first
+      // zone of the frame with the time the frame was recorded
+      auto const toSeconds{[&](std::uint32_t query) {
+        auto const ticks{(availability.at(query * 2) & m_timestampMask) -
+                         origin};
+        return frame.cpuReference +
+               static_cast<double>(ticks) * m_timestampPeriod * 1e-9;
+      }};
+
+      for (auto const &zone : frame.zones) {
+        if (availability.at(zone.beginQuery * 2 + 1) == 0 ||
+            availability.at(zone.endQuery * 2 + 1) == 0)
+          continue;
+        Profiler::record({.name = zone.name,
+                          .begin = toSeconds(zone.beginQuery),
+                          .end = toSeconds(zone.endQuery),
+                          .depth = zone.depth,
+                          .track = m_track});
+      }
+    }
+  }
+
+  if (m_statisticsEnabled && frame.statisticsWritten) {
+    std::array<std::uint64_t, statisticsCount> values{};
+    if (m_device.getQueryPoolResults(
+            frame.statistics, 0, 1, values.size() * sizeof(std::uint64_t),
+            values.data(), values.size() * sizeof(std::uint64_t),
+            vk::QueryResultFlagBits::e64) == vk::Result::eSuccess) {
+      m_pipelineStatistics = {.inputAssemblyVertices = values.at(0),
+                              .inputAssemblyPrimitives = values.at(1),
+                              .vertexShaderInvocations = values.at(2),
+                              .clippingInvocations = values.at(3),
+                              .clippingPrimitives = values.at(4),
+                              .fragmentShaderInvocations = values.at(5)};
+
+      auto const toDouble{
+          [](std::uint64_t value) { return static_cast<double>(value); }};
+      Profiler::setCounter("GPU input assembly vertices",
+                           toDouble(values.at(0)));
+      Profiler::setCounter("GPU input assembly primitives",
+                           toDouble(values.at(1)));
+      Profiler::setCounter("GPU vertex shader invocations",
+                           toDouble(values.at(2)));
+      Profiler::setCounter("GPU clipping invocations", toDouble(values.at(3)));
+      Profiler::setCounter("GPU clipping primitives", toDouble(values.at(4)));
+      Profiler::setCounter("GPU fragment shader invocations",
+                           toDouble(values.at(5)));
+    }
+  }
+}
+
+/**
+ * @brief Starts a GPU zone.
+ *
+ * @param timer GPU timer used for measuring the zone.
+ * @param commandBuffer Command buffer in the recording state.
+ * @param name Zone name. Must be a string with static storage duration, such
+ * as a string literal.
+ */
+abcg::VulkanGPUScope::VulkanGPUScope(VulkanGPUTimer &timer,
+                                     vk::CommandBuffer const &commandBuffer,
+                                     char const *name)
+    : m_timer{timer}, m_commandBuffer{commandBuffer},
+      m_zone{timer.beginZone(commandBuffer, name)} {}
+
+/**
+ * @brief Ends the GPU zone.
+ */
+abcg::VulkanGPUScope::~VulkanGPUScope() {
+  m_timer.endZone(m_commandBuffer, m_zone);
+}
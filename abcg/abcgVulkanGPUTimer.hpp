@@ -0,0 +1,150 @@
+/**
+ * @file abcgVulkanGPUTimer.hpp
+ * @brief Header file of abcg::VulkanGPUTimer and abcg::VulkanGPUScope.
+ *
+ * Declaration of abcg::VulkanGPUTimer and abcg::VulkanGPUScope.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VULKAN_GPU_TIMER_HPP_
+#define ABCG_VULKAN_GPU_TIMER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "abcgVulkanDevice.hpp"
+#include "abcgVulkanExternal.hpp"
+
+namespace abcg {
+struct VulkanPipelineStatistics;
+class VulkanGPUTimer;
+class VulkanGPUScope;
+} // namespace abcg
+
+/**
+ * @brief Pipeline statistics of a frame.
+ *
+ * @sa abcg::VulkanSettings::pipelineStatistics.
+ */
+struct abcg::VulkanPipelineStatistics {
+  /** @brief Number of vertices processed by the input assembly stage. */
+  std::uint64_t inputAssemblyVertices{};
+  /** @brief Number of primitives processed by the input assembly stage. */
+  std::uint64_t inputAssemblyPrimitives{};
+  /** @brief Number of vertex shader invocations. */
+  std::uint64_t vertexShaderInvocations{};
+  /** @brief Number of primitives processed by the clipping stage. */
+  std::uint64_t clippingInvocations{};
+  /** @brief Number of primitives output by the clipping stage. */
+  std::uint64_t clippingPrimitives{};
+  /** @brief Number of fragment shader invocations. */
+  std::uint64_t fragmentShaderInvocations{};
+};
+
+/**
+ * @brief GPU timer based on Vulkan timestamp queries.
+ *
+ * The timer keeps a timestamp query pool for each in-flight frame of the
+ * swapchain. Queries are written into the command buffers of the frame, and
+ * their results are read when the frame is acquired again, after its fence
+ * is known to be signaled. Thus, reading the results never blocks. Zones are
+ * recorded into a "GPU" track of abcg::Profiler.
+ *
+ * abcg::VulkanWindow owns a timer that measures the main pass (the commands
+ * recorded in abcg::VulkanWindow::onPaint) and the Dear ImGui pass.
+ * Additional zones can be measured in `onPaint` with abcg::VulkanGPUScope.
+ *
+ * Zones are only measured while abcg::Profiler is enabled, and only if the
+ * graphics queue supports timestamps.
+ */
+class abcg::VulkanGPUTimer {
+public:
+  /** @brief Maximum number of timestamps written per frame. */
+  static constexpr std::uint32_t maxTimestamps{256};
+
+  void create(VulkanDevice const &device, std::size_t frameCount,
+              bool pipelineStatistics = false);
+  void destroy();
+
+  [[nodiscard]] vk::CommandBuffer const &beginFrame(std::uint32_t frameIndex);
+  void endFrame();
+
+  [[nodiscard]] std::uint32_t beginZone(vk::CommandBuffer const &commandBuffer,
+                                        char const *name);
+  void endZone(vk::CommandBuffer const &commandBuffer, std::uint32_t zone);
+
+  void beginPipelineStatistics(vk::CommandBuffer const &commandBuffer);
+  void endPipelineStatistics(vk::CommandBuffer const &commandBuffer);
+
+  [[nodiscard]] bool isSupported() const noexcept { return m_supported; }
+  [[nodiscard]] VulkanPipelineStatistics const &
+  getPipelineStatistics() const noexcept {
+    return m_pipelineStatistics;
+  }
+
+private:
+  struct Zone {
+    char const *name{};
+    std::uint32_t depth{};
+    std::uint32_t beginQuery{};
+    std::uint32_t endQuery{};
+  };
+
+  struct Frame {
+    vk::CommandBuffer commandBuffer{};
+    vk::QueryPool timestamps{};
+    vk::QueryPool statistics{};
+    std::uint32_t queryCount{};
+    std::vector<Zone> zones;
+    double cpuReference{};
+    bool pending{};
+    bool statisticsWritten{};
+  };
+
+  void resolve(Frame &frame);
+
+  vk::Device m_device{};
+  vk::CommandPool m_commandPool{};
+  std::vector<Frame> m_frames;
+  Frame *m_currentFrame{};
+  double m_timestampPeriod{};
+  std::uint64_t m_timestampMask{};
+  std::uint32_t m_depth{};
+  std::uint32_t m_track{};
+  bool m_supported{};
+  bool m_recording{};
+  bool m_statisticsEnabled{};
+  VulkanPipelineStatistics m_pipelineStatistics{};
+  std::vector<std::uint64_t> m_queryResults;
+};
+
+/**
+ * @brief RAII object that measures a GPU zone with an abcg::VulkanGPUTimer
+ * from its construction to its destruction.
+ *
+ * The timestamps are written into the given command buffer, which must be in
+ * the recording state during the lifetime of this object.
+ *
+ * @remark Objects of this type cannot be copied or moved.
+ */
+class abcg::VulkanGPUScope {
+public:
+  VulkanGPUScope(VulkanGPUTimer &timer, vk::CommandBuffer const &commandBuffer,
+                 char const *name);
+  VulkanGPUScope(VulkanGPUScope const &) = delete;
+  VulkanGPUScope(VulkanGPUScope &&) = delete;
+  VulkanGPUScope &operator=(VulkanGPUScope const &) = delete;
+  VulkanGPUScope &operator=(VulkanGPUScope &&) = delete;
+  ~VulkanGPUScope();
+
+private:
+  VulkanGPUTimer &m_timer;
+  vk::CommandBuffer m_commandBuffer;
+  std::uint32_t m_zone{};
+};
+
+#endif
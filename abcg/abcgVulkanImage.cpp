@@ -12,16 +12,153 @@
 #include "abcgVulkanBuffer.hpp"
 
 #include <SDL_image.h>
+#include <array>
+#include <cmath>
 #include <cppitertools/itertools.hpp>
 #include <fmt/core.h>
 #include <gsl/gsl>
+#include <span>
+#include <vector>
 
+#include "abcgBakedAsset.hpp"
 #include "abcgException.hpp"
+#include "abcgProfiler.hpp"
+#include "abcgTextureContainer.hpp"
+
+namespace {
+vk::Format toVkFormat(abcg::TextureFormat format) {
+  using abcg::TextureFormat;
+  switch (format) {
+  case TextureFormat::RGBA8:
+    return vk::Format::eR8G8B8A8Unorm;
+  case TextureFormat::RGBA8sRGB:
+    return vk::Format::eR8G8B8A8Srgb;
+  case TextureFormat::BC1:
+    return vk::Format::eBc1RgbaUnormBlock;
+  case TextureFormat::BC1sRGB:
+    return vk::Format::eBc1RgbaSrgbBlock;
+  case TextureFormat::BC3:
+    return vk::Format::eBc3UnormBlock;
+  case TextureFormat::BC3sRGB:
+    return vk::Format::eBc3SrgbBlock;
+  case TextureFormat::BC4:
+    return vk::Format::eBc4UnormBlock;
+  case TextureFormat::BC5:
+    return vk::Format::eBc5UnormBlock;
+  case TextureFormat::BC7:
+    return vk::Format::eBc7UnormBlock;
+  case TextureFormat::BC7sRGB:
+    return vk::Format::eBc7SrgbBlock;
+  case TextureFormat::ETC2RGB8:
+    return vk::Format::eEtc2R8G8B8UnormBlock;
+  case TextureFormat::ETC2RGB8sRGB:
+    return vk::Format::eEtc2R8G8B8SrgbBlock;
+  case TextureFormat::ETC2RGBA8:
+    return vk::Format::eEtc2R8G8B8A8UnormBlock;
+  case TextureFormat::ETC2RGBA8sRGB:
+    return vk::Format::eEtc2R8G8B8A8SrgbBlock;
+  case TextureFormat::ASTC4x4:
+    return vk::Format::eAstc4x4UnormBlock;
+  case TextureFormat::ASTC4x4sRGB:
+    return vk::Format::eAstc4x4SrgbBlock;
+  }
+  return vk::Format::eUndefined;
+}
+
+// Converts the color channels of RGBA8 pixels from sRGB to linear, so that
+// they are sampled correctly from a UNORM image
+void linearizeRGBA8(std::span<std::byte> pixels) {
+  static auto const table{[] {
+    std::array<std::byte, 256> table{};
+    for (auto const index : iter::range(table.size())) {
+      auto const value{gsl::narrow_cast<float>(index) / 255.0f};
+      auto const linear{value <= 0.04045f
+                            ? value / 12.92f
+                            : std::pow((value + 0.055f) / 1.055f, 2.4f)};
+      table.at(index) = static_cast<std::byte>(std::lround(linear * 255.0f));
+    }
+    return table;
+  }()};
+
+  auto const pixelsSize{pixels.size() - pixels.size() % 4};
+  for (auto const offset :
+       iter::range(std::size_t{0}, pixelsSize, std::size_t{4})) {
+    for (auto const channel : iter::range(std::size_t{3})) {
+      auto &byte{pixels[offset + channel]};
+      byte = table.at(std::to_integer<std::size_t>(byte));
+    }
+  }
+}
+
+// Returns the format of RGBA8 images: sRGB if it can be sampled, or UNORM
+// otherwise, in which case the pixels must be converted with linearizeRGBA8
+vk::Format getRGBA8Format(abcg::VulkanDevice const &device,
+                          vk::FormatFeatureFlags features,
+                          std::string_view path) {
+  auto const format{device.getPhysicalDevice().getFirstSupportedFormat(
+      {vk::Format::eR8G8B8A8Srgb, vk::Format::eR8G8B8A8Unorm},
+      vk::ImageTiling::eOptimal, features)};
+  if (!format) {
+    throw abcg::RuntimeError("RGBA8 images are not supported by the device");
+  }
+  if (*format == vk::Format::eR8G8B8A8Unorm) {
+    fmt::print(stderr,
+               "Warning: sRGB images are not supported by the device; {} is "
+               "converted to linear RGBA8\n",
+               path);
+  }
+  return *format;
+}
+} // namespace
 
+/**
+ * @brief Creates a sampled image from a file.
+ *
+ * Files with extension `.ktx2` or `.dds` are read with
+ * abcg::loadTextureContainer, and each mipmap level stored in the file is
+ * copied from a staging buffer, without decoding. @a generateMipmaps is
+ * ignored for these files.
+ *
+ * If the file was baked by `abcg_bake` without flipping its rows (see
+ * abcg::findBakedAsset), the baked file is mapped and copied as a whole to the
+ * staging buffer, and its precomputed mipmap levels are copied to the image.
+ * Files with extension `.baked` are loaded likewise. Other files are loaded
+ * with SDL_image and converted to RGBA8.
+ *
+ * RGBA8 images are created with an sRGB format. If the device cannot sample
+ * sRGB images, a warning is printed, the color channels are converted to
+ * linear on the CPU, and a UNORM format is used instead.
+ *
+ * @param device Vulkan device.
+ * @param path Path to the image file.
+ * @param generateMipmaps Whether to generate the mipmap levels.
+ *
+ * @throw abcg::RuntimeError if the file cannot be loaded or its format cannot
+ * be sampled by the device.
+ */
 void abcg::VulkanImage::create(VulkanDevice const &device,
                                std::string_view path, bool generateMipmaps) {
+  ABCG_PROFILE_SCOPE("Load image");
   m_device = static_cast<vk::Device>(device);
 
+  if (isBakedAsset(path)) {
+    if (!createFromBaked(device, path, true, generateMipmaps)) {
+      throw abcg::RuntimeError(fmt::format("{} is not a baked texture", path));
+    }
+    return;
+  }
+  if (isTextureContainer(path)) {
+    createFromContainer(device, path);
+    return;
+  }
+  if (auto const bakedPath{findBakedAsset(path)}; !bakedPath.empty()) {
+    if (createFromBaked(device, bakedPath, false, generateMipmaps))
+      return;
+  }
+
+  auto const imageFormat{
+      getRGBA8Format(device, vk::FormatFeatureFlagBits::eSampledImage, path)};
+
   // Load the bitmap
   if (SDL_Surface *const surface{IMG_Load(path.data())}) {
     // Enforce RGBA
@@ -40,6 +177,11 @@ void abcg::VulkanImage::create(VulkanDevice const &device,
                     1;
     }
 
+    if (imageFormat == vk::Format::eR8G8B8A8Unorm) {
+      linearizeRGBA8({static_cast<std::byte *>(formattedSurface->pixels),
+                      gsl::narrow<std::size_t>(imageSize)});
+    }
+
     // Create staging buffer
     abcg::VulkanBuffer stagingBuffer{};
     stagingBuffer.create(
@@ -51,9 +193,6 @@ void abcg::VulkanImage::create(VulkanDevice const &device,
 
     SDL_FreeSurface(formattedSurface);
 
-    // TODO: Look for other formats if RGBA8 is not supported
-    auto const imageFormat{vk::Format::eR8G8B8A8Srgb};
-
     // Create image buffer
     std::tie(m_image, m_deviceMemory) = createImage(
         device,
@@ -117,45 +256,239 @@ void abcg::VulkanImage::create(VulkanDevice const &device,
                               .levelCount = 1,
                               .layerCount = 1}});
 
-    // Create sampler
-    vk::SamplerCreateInfo samplerCreateInfo{
-        .magFilter = vk::Filter::eLinear,
-        .minFilter = vk::Filter::eLinear,
-        .mipmapMode = vk::SamplerMipmapMode::eLinear,
-        .addressModeU = vk::SamplerAddressMode::eRepeat,
-        .addressModeV = vk::SamplerAddressMode::eRepeat,
-        .addressModeW = vk::SamplerAddressMode::eRepeat,
-        .mipLodBias = 0.0f,
-        .anisotropyEnable = VK_TRUE,
-        .maxAnisotropy =
-            static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())
-                .getProperties()
-                .limits.maxSamplerAnisotropy,
-        .compareEnable = VK_FALSE,
-        .compareOp = vk::CompareOp::eAlways,
-        .minLod = 0.0f,
-        .maxLod = 0.0f,
-        .borderColor = vk::BorderColor::eIntOpaqueBlack,
-        .unnormalizedCoordinates = VK_FALSE};
-
-    if (m_mipLevels > 1) {
-      samplerCreateInfo.mipmapMode = vk::SamplerMipmapMode::eLinear;
-      samplerCreateInfo.maxLod = gsl::narrow<float>(m_mipLevels);
-      // samplerCreateInfo.minLod = gsl::narrow<float>(m_mipLevels >> 1);
-    }
-    m_sampler = m_device.createSampler(samplerCreateInfo);
-
-    // Create descriptor info
-    m_descriptorImageInfo = {.sampler = m_sampler,
-                             .imageView = m_imageView,
-                             .imageLayout =
-                                 vk::ImageLayout::eShaderReadOnlyOptimal};
+    createSampler(device);
   } else {
     throw abcg::RuntimeError(
         fmt::format("Failed to load texture file {}", path));
   }
 }
 
+// Creates an image with the levels stored in a KTX2 or DDS file
+void abcg::VulkanImage::createFromContainer(VulkanDevice const &device,
+                                            std::string_view path) {
+  auto const container{loadTextureContainer(path)};
+  auto const imageFormat{device.getPhysicalDevice().getFirstSupportedFormat(
+      {toVkFormat(container.format)}, vk::ImageTiling::eOptimal,
+      vk::FormatFeatureFlagBits::eSampledImage |
+          vk::FormatFeatureFlagBits::eTransferDst)};
+  if (!imageFormat) {
+    throw abcg::RuntimeError(fmt::format(
+        "Texture format of {} is not supported by the device", path));
+  }
+
+  m_mipLevels = gsl::narrow<uint32_t>(container.levels.size());
+  auto const &baseLevel{container.levels.front()};
+
+  // Create staging buffer with all levels
+  abcg::VulkanBuffer stagingBuffer{};
+  stagingBuffer.create(
+      device, {.size = container.data.size(),
+               .usage = vk::BufferUsageFlagBits::eTransferSrc,
+               .properties = vk::MemoryPropertyFlagBits::eHostVisible |
+                             vk::MemoryPropertyFlagBits::eHostCoherent,
+               .data = container.data.data()});
+
+  // Create image buffer
+  std::tie(m_image, m_deviceMemory) = createImage(
+      device,
+      {.imageType = vk::ImageType::e2D,
+       .format = *imageFormat,
+       .extent = {.width = baseLevel.width,
+                  .height = baseLevel.height,
+                  .depth = 1},
+       .mipLevels = m_mipLevels,
+       .arrayLayers = 1,
+       .samples = vk::SampleCountFlagBits::e1,
+       .tiling = vk::ImageTiling::eOptimal,
+       .usage = vk::ImageUsageFlagBits::eTransferDst |
+                vk::ImageUsageFlagBits::eSampled,
+       .initialLayout = vk::ImageLayout::eUndefined},
+      vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  vk::ImageSubresourceRange const subresourceRange{
+      .aspectMask = vk::ImageAspectFlagBits::eColor,
+      .levelCount = m_mipLevels,
+      .layerCount = 1};
+  transitionImageLayout(device, vk::ImageLayout::eUndefined,
+                        vk::ImageLayout::eTransferDstOptimal,
+                        subresourceRange);
+
+  // One copy per level
+  std::vector<vk::BufferImageCopy> regions;
+  regions.reserve(container.levels.size());
+  for (auto &&[index, level] : iter::enumerate(container.levels)) {
+    regions.push_back(
+        {.bufferOffset = level.offset,
+         .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                              .mipLevel = gsl::narrow<uint32_t>(index),
+                              .layerCount = 1},
+         .imageExtent = {level.width, level.height, 1}});
+  }
+  device.withCommandBuffer(
+      [&](vk::CommandBuffer const &commandBuffer) {
+        commandBuffer.copyBufferToImage(
+            static_cast<vk::Buffer>(stagingBuffer), m_image,
+            vk::ImageLayout::eTransferDstOptimal, regions);
+      },
+      vk::QueueFlagBits::eTransfer);
+
+  transitionImageLayout(device, vk::ImageLayout::eTransferDstOptimal,
+                        vk::ImageLayout::eShaderReadOnlyOptimal,
+                        subresourceRange);
+
+  stagingBuffer.destroy();
+
+  // Create image view
+  m_imageView =
+      m_device.createImageView({.image = m_image,
+                                .viewType = vk::ImageViewType::e2D,
+                                .format = *imageFormat,
+                                .subresourceRange = subresourceRange});
+
+  createSampler(device);
+}
+
+// Creates an image with the levels stored in a file written by abcg_bake.
+// Returns false if the file is not a texture or, unless the file was given
+// directly, if its rows were flipped upside down.
+bool abcg::VulkanImage::createFromBaked(VulkanDevice const &device,
+                                        std::string_view path, bool direct,
+                                        bool generateMipmaps) {
+  BakedAsset asset;
+  asset.open(path);
+  auto const &header{asset.getHeader()};
+  if (header.kind != BakedAssetKind::Texture)
+    return false;
+  if (!direct && (header.flags & BakedAssetHeader::FlippedUpsideDown) != 0)
+    return false;
+
+  // Same formats as the images loaded with SDL_image
+  auto const imageFormat{
+      getRGBA8Format(device,
+                     vk::FormatFeatureFlagBits::eSampledImage |
+                         vk::FormatFeatureFlagBits::eTransferDst,
+                     path)};
+
+  auto const levels{asset.getTextureLevels()};
+  m_mipLevels =
+      generateMipmaps ? gsl::narrow<uint32_t>(levels.size()) : uint32_t{1};
+
+  // The level offsets in the file are used as offsets in the staging buffer.
+  // The texels are copied out of the mapping only if they must be converted
+  auto data{asset.getData()};
+  std::vector<std::byte> linearData;
+  if (imageFormat == vk::Format::eR8G8B8A8Unorm) {
+    linearData.assign(data.begin(), data.end());
+    for (auto const &level : levels) {
+      linearizeRGBA8(std::span{linearData}.subspan(
+          gsl::narrow<std::size_t>(level.offset),
+          gsl::narrow<std::size_t>(level.size)));
+    }
+    data = linearData;
+  }
+  abcg::VulkanBuffer stagingBuffer{};
+  stagingBuffer.create(
+      device, {.size = data.size(),
+               .usage = vk::BufferUsageFlagBits::eTransferSrc,
+               .properties = vk::MemoryPropertyFlagBits::eHostVisible |
+                             vk::MemoryPropertyFlagBits::eHostCoherent,
+               .data = data.data()});
+
+  std::tie(m_image, m_deviceMemory) = createImage(
+      device,
+      {.imageType = vk::ImageType::e2D,
+       .format = imageFormat,
+       .extent = {.width = levels.front().width,
+                  .height = levels.front().height,
+                  .depth = 1},
+       .mipLevels = m_mipLevels,
+       .arrayLayers = 1,
+       .samples = vk::SampleCountFlagBits::e1,
+       .tiling = vk::ImageTiling::eOptimal,
+       .usage = vk::ImageUsageFlagBits::eTransferDst |
+                vk::ImageUsageFlagBits::eSampled,
+       .initialLayout = vk::ImageLayout::eUndefined},
+      vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  vk::ImageSubresourceRange const subresourceRange{
+      .aspectMask = vk::ImageAspectFlagBits::eColor,
+      .levelCount = m_mipLevels,
+      .layerCount = 1};
+  transitionImageLayout(device, vk::ImageLayout::eUndefined,
+                        vk::ImageLayout::eTransferDstOptimal,
+                        subresourceRange);
+
+  std::vector<vk::BufferImageCopy> regions;
+  regions.reserve(m_mipLevels);
+  for (auto const index : iter::range(m_mipLevels)) {
+    auto const &level{levels[index]};
+    regions.push_back(
+        {.bufferOffset = level.offset,
+         .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                              .mipLevel = index,
+                              .layerCount = 1},
+         .imageExtent = {level.width, level.height, 1}});
+  }
+  device.withCommandBuffer(
+      [&](vk::CommandBuffer const &commandBuffer) {
+        commandBuffer.copyBufferToImage(
+            static_cast<vk::Buffer>(stagingBuffer), m_image,
+            vk::ImageLayout::eTransferDstOptimal, regions);
+      },
+      vk::QueueFlagBits::eTransfer);
+
+  transitionImageLayout(device, vk::ImageLayout::eTransferDstOptimal,
+                        vk::ImageLayout::eShaderReadOnlyOptimal,
+                        subresourceRange);
+
+  stagingBuffer.destroy();
+
+  m_imageView =
+      m_device.createImageView({.image = m_image,
+                                .viewType = vk::ImageViewType::e2D,
+                                .format = imageFormat,
+                                .subresourceRange = subresourceRange});
+
+  createSampler(device);
+  return true;
+}
+
+// Creates the sampler and the descriptor info of a sampled image
+void abcg::VulkanImage::createSampler(VulkanDevice const &device) {
+  vk::SamplerCreateInfo samplerCreateInfo{
+      .magFilter = vk::Filter::eLinear,
+      .minFilter = vk::Filter::eLinear,
+      .mipmapMode = vk::SamplerMipmapMode::eLinear,
+      .addressModeU = vk::SamplerAddressMode::eRepeat,
+      .addressModeV = vk::SamplerAddressMode::eRepeat,
+      .addressModeW = vk::SamplerAddressMode::eRepeat,
+      .mipLodBias = 0.0f,
+      .anisotropyEnable = VK_TRUE,
+      .maxAnisotropy =
+          static_cast<vk::PhysicalDevice>(device.getPhysicalDevice())
+              .getProperties()
+              .limits.maxSamplerAnisotropy,
+      .compareEnable = VK_FALSE,
+      .compareOp = vk::CompareOp::eAlways,
+      .minLod = 0.0f,
+      .maxLod = 0.0f,
+      .borderColor = vk::BorderColor::eIntOpaqueBlack,
+      .unnormalizedCoordinates = VK_FALSE};
+
+  if (m_mipLevels > 1) {
+    samplerCreateInfo.mipmapMode = vk::SamplerMipmapMode::eLinear;
+    samplerCreateInfo.maxLod = gsl::narrow<float>(m_mipLevels);
+    // samplerCreateInfo.minLod = gsl::narrow<float>(m_mipLevels >> 1);
+  }
+  m_sampler = m_device.createSampler(samplerCreateInfo);
+
+  // Create descriptor info
+  m_descriptorImageInfo = {.sampler = m_sampler,
+                           .imageView = m_imageView,
+                           .imageLayout =
+                               vk::ImageLayout::eShaderReadOnlyOptimal};
+}
+
 void abcg::VulkanImage::create(VulkanDevice const &device,
                                VulkanImageCreateInfo const &createInfo) {
   m_device = static_cast<vk::Device>(device);
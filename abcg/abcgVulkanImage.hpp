@@ -86,7 +86,8 @@ public:
    * If the image is created with `generateMipmaps = false`, the number of
    * mipmap levels is always 1. Otherwise, it is computed as \f$\lfloor
    * \log_2(\max(w, h)) \rfloor + 1\f$, where \f$w\f$ and \f$h\f$ are the
-   * texture width and height.
+   * texture width and height. For KTX2, DDS and baked files, it is the number
+   * of levels stored in the file.
    *
    * @return Number of mipmap levels.
    */
@@ -96,6 +97,11 @@ private:
   [[nodiscard]] std::pair<vk::Image, vk::DeviceMemory>
   createImage(VulkanDevice const &device, vk::ImageCreateInfo const &imageInfo,
               vk::MemoryPropertyFlags properties) const;
+  void createFromContainer(VulkanDevice const &device, std::string_view path);
+  [[nodiscard]] bool createFromBaked(VulkanDevice const &device,
+                                     std::string_view path, bool direct,
+                                     bool generateMipmaps);
+  void createSampler(VulkanDevice const &device);
   void transitionImageLayout(VulkanDevice const &device,
                              vk::ImageLayout oldImageLayout,
                              vk::ImageLayout newImageLayout,
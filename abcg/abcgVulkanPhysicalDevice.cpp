@@ -93,9 +93,12 @@ void abcg::VulkanPhysicalDevice::checkQueueFamily(
   }
 
   // Check for present queue
-  if (!m_queuesFamilies.present.has_value() &&
-      m_physicalDevice.getSurfaceSupportKHR(queueFamilyIndex, m_surfaceKHR) ==
-          VK_TRUE) {
+  if (!m_surfaceKHR) {
+    // Without a surface, nothing is presented. Use the graphics queue
+    m_queuesFamilies.present = m_queuesFamilies.graphics;
+  } else if (!m_queuesFamilies.present.has_value() &&
+             m_physicalDevice.getSurfaceSupportKHR(queueFamilyIndex,
+                                                   m_surfaceKHR) == VK_TRUE) {
     // Take the first index with surface support
     m_queuesFamilies.present = queueFamilyIndex;
   }
@@ -183,7 +186,10 @@ bool abcg::VulkanPhysicalDevice::isDeviceSuitable(
                                   m_queuesFamilies.present.has_value()};
 
   auto const &extensionsSupported{checkExtensionsSupport(extensions).empty()};
-  if (extensionsSupported) {
+  if (!m_surfaceKHR) {
+    // Frames are rendered to offscreen images
+    swapchainAdequate = true;
+  } else if (extensionsSupported) {
     swapchainAdequate =
         !m_physicalDevice.getSurfaceFormatsKHR(m_surfaceKHR).empty() &&
         !m_physicalDevice.getSurfacePresentModesKHR(m_surfaceKHR).empty();
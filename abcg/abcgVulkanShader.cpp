@@ -2,6 +2,8 @@
  * @file abcgVulkanShader.cpp
  * @brief Definition of helper functions for creating Vulkan shaders.
  *
+ * Definition of abcg::VulkanShader and abcg::VulkanShaderReloader members.
+ *
  * This file is part of ABCg (https://github.com/hbatagelo/abcg).
  *
  * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
@@ -11,12 +13,14 @@
 #include "abcgVulkanShader.hpp"
 #include "abcgApplication.hpp"
 #include "abcgException.hpp"
+#include "abcgProfiler.hpp"
 #include "abcgVulkanWindow.hpp"
 
 #include <glslang/SPIRV/GlslangToSpv.h>
 
 #include <fmt/core.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 
@@ -252,6 +256,19 @@ abcgStageToVulkanStage(abcg::ShaderStage stage) {
   return source.str();
 }
 
+// If filenameOrText is a filename, returns its canonical path. Otherwise,
+// returns an empty string.
+[[nodiscard]] static std::string toPath(std::string_view filenameOrText) {
+  static const std::size_t maxPathSize{260};
+  std::error_code error;
+  if (filenameOrText.size() > maxPathSize ||
+      !std::filesystem::exists(filenameOrText, error)) {
+    return {};
+  }
+  auto path{std::filesystem::weakly_canonical(filenameOrText, error)};
+  return error ? std::string{filenameOrText} : path.string();
+}
+
 // Compiles the given GLSL shader source into Vulkan SPIR-V.
 std::vector<uint32_t> GLSLtoSPV(abcg::ShaderSource shaderSource) {
   // Prints out log info for compiling and linking
@@ -310,7 +327,10 @@ std::vector<uint32_t> GLSLtoSPV(abcg::ShaderSource shaderSource) {
  */
 void abcg::VulkanShader::create(VulkanDevice const &device,
                                 ShaderSource const &pathOrSource) {
+  ABCG_PROFILE_SCOPE("Create shader");
   m_device = static_cast<vk::Device>(device);
+  m_sourceStage = pathOrSource.stage;
+  m_path = toPath(pathOrSource.source);
 
   ShaderSource source{.source = toSource(pathOrSource.source),
                       .stage = pathOrSource.stage};
@@ -333,4 +353,157 @@ void abcg::VulkanShader::destroy() {
   }
 
   m_device.destroyShaderModule(m_module);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Registers a shader to be rebuilt when its file changes.
+ *
+ * Shaders created from a source code instead of a file are ignored. The
+ * shader must be unregistered with abcg::VulkanShaderReloader::remove before
+ * it is destroyed, unless it lives until abcg::VulkanWindow::onDestroy.
+ *
+ * @param shader Shader created with abcg::VulkanShader::create.
+ * @param onReload Function called after the shader module is replaced, e.g.,
+ * to recreate the pipelines that use the shader.
+ */
+void abcg::VulkanShaderReloader::add(VulkanShader &shader,
+                                     std::function<void()> onReload) {
+  if (shader.getPath().empty())
+    return;
+
+  remove(shader);
+  auto &entry{m_entries.emplace_back()};
+  entry.shader = &shader;
+  entry.onReload = std::move(onReload);
+  if (m_watcher) {
+    m_watcher->watch(shader.getPath());
+  }
+}
+
+/**
+ * @brief Unregisters a shader.
+ *
+ * A compilation in progress is discarded.
+ *
+ * @param shader Shader registered with abcg::VulkanShaderReloader::add.
+ */
+void abcg::VulkanShaderReloader::remove(VulkanShader const &shader) {
+  std::erase_if(m_entries,
+                [&](auto const &entry) { return entry.shader == &shader; });
+}
+
+/**
+ * @brief Schedules the compilation of the modified shaders, and replaces the
+ * modules of the shaders whose compilation finished.
+ *
+ * Called by abcg::VulkanWindow at the beginning of each frame, when no command
+ * buffer is being recorded.
+ *
+ * @param jobSystem Job system where the shaders are compiled.
+ */
+void abcg::VulkanShaderReloader::update(JobSystem &jobSystem) {
+  if (m_watcher) {
+    for (auto const &file : m_watcher->poll()) {
+      fmt::print("Shader file changed: {}\n", file.string());
+      for (auto &entry : m_entries) {
+        if (entry.shader->getPath() != file.string())
+          continue;
+        if (entry.counter) {
+          entry.dirty = true;
+        } else {
+          schedule(entry, jobSystem);
+        }
+      }
+    }
+  }
+
+  auto waitedIdle{false};
+  std::vector<std::function<void()>> callbacks;
+  for (auto &entry : m_entries) {
+    if (!entry.counter || !entry.counter->isDone())
+      continue;
+
+    auto const code{std::move(entry.code)};
+    entry.counter.reset();
+    if (code->empty()) {
+      fmt::print("Warning: failed to rebuild shader {}, keeping the previous "
+                 "one\n",
+                 entry.shader->getPath());
+    } else {
+      auto &shader{*entry.shader};
+      // The previous module may still be used by pipelines in flight
+      if (!waitedIdle) {
+        ABCG_PROFILE_SCOPE("Wait device idle");
+        shader.m_device.waitIdle();
+        waitedIdle = true;
+      }
+      shader.m_device.destroyShaderModule(shader.m_module);
+      shader.m_module = shader.m_device.createShaderModule(
+          {.codeSize = code->size() * sizeof(uint32_t), .pCode = code->data()});
+      callbacks.push_back(entry.onReload);
+    }
+
+    if (std::exchange(entry.dirty, false)) {
+      schedule(entry, jobSystem);
+    }
+  }
+
+  // Callbacks may recreate pipelines that use more than one reloaded shader,
+  // so they are called after all modules are replaced
+  for (auto const &callback : callbacks) {
+    if (callback) {
+      callback();
+    }
+  }
+}
+
+/**
+ * @brief Unregisters all shaders and stops watching their files.
+ *
+ * Called by abcg::VulkanWindow before abcg::VulkanWindow::onDestroy.
+ * Compilations in progress are discarded.
+ */
+void abcg::VulkanShaderReloader::destroy() {
+  m_entries.clear();
+  m_watcher.reset();
+}
+
+/**
+ * @brief Enables or disables hot reload.
+ *
+ * @param enabled Whether to watch the files of the registered shaders.
+ */
+void abcg::VulkanShaderReloader::setEnabled(bool enabled) {
+  if (!enabled) {
+    m_watcher.reset();
+    return;
+  }
+  if (m_watcher)
+    return;
+
+  m_watcher = std::make_unique<FileWatcher>();
+  for (auto const &entry : m_entries) {
+    m_watcher->watch(entry.shader->getPath());
+  }
+}
+
+void abcg::VulkanShaderReloader::schedule(Entry &entry, JobSystem &jobSystem) {
+  // The job owns copies of its inputs, so that the entry can be removed while
+  // the job is running
+  auto code{std::make_shared<std::vector<uint32_t>>()};
+  entry.code = code;
+  entry.counter = jobSystem.schedule(
+      [code, path = entry.shader->getPath(),
+       stage = entry.shader->m_sourceStage] {
+        ABCG_PROFILE_SCOPE("Compile shader");
+        glslang::InitializeProcess();
+        try {
+          *code = GLSLtoSPV({.source = toSource(path), .stage = stage});
+        } catch (abcg::RuntimeError const &exception) {
+          // An empty code tells update that the compilation failed
+          fmt::print("Warning: {}\n", exception.what());
+          code->clear();
+        }
+        glslang::FinalizeProcess();
+      });
+}
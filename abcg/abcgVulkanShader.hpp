@@ -2,6 +2,8 @@
  * @file abcgVulkanShader.hpp
  * @brief Declaration of helper functions for creating Vulkan shaders.
  *
+ * Declaration of abcg::VulkanShader and abcg::VulkanShaderReloader.
+ *
  * This file is part of ABCg (https://github.com/hbatagelo/abcg).
  *
  * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
@@ -11,11 +13,19 @@
 #ifndef ABCG_VULKAN_SHADER_HPP_
 #define ABCG_VULKAN_SHADER_HPP_
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "abcgFileWatcher.hpp"
+#include "abcgJobSystem.hpp"
 #include "abcgShader.hpp"
 #include "abcgVulkanDevice.hpp"
 
 namespace abcg {
 class VulkanShader;
+class VulkanShaderReloader;
 } // namespace abcg
 
 /**
@@ -47,10 +57,71 @@ public:
     return m_module;
   }
 
+  /**
+   * @brief Returns the canonical path of the shader file.
+   *
+   * @return Path of the file the shader was created from, or an empty string
+   * if it was created from a source code.
+   */
+  [[nodiscard]] std::string const &getPath() const noexcept { return m_path; }
+
 private:
+  friend VulkanShaderReloader;
+
   vk::ShaderStageFlagBits m_stage{};
   vk::ShaderModule m_module{};
   vk::Device m_device{};
+  ShaderStage m_sourceStage{};
+  std::string m_path;
+};
+
+/**
+ * @brief Rebuilds Vulkan shaders when their files change.
+ *
+ * The shader files are watched with abcg::FileWatcher. When a file changes,
+ * its GLSL source is compiled to SPIR-V in a job of the abcg::JobSystem, so
+ * the frame is not blocked. When the compilation succeeds, the device is
+ * waited on, the shader module is replaced, and the callback given to
+ * abcg::VulkanShaderReloader::add is called so that the pipelines that use the
+ * shader can be recreated. When it fails, the previous module is kept.
+ *
+ * abcg::VulkanWindow owns a reloader (see
+ * abcg::VulkanWindow::getShaderReloader), which is enabled by
+ * abcg::ApplicationSettings::hotReload and updated at the beginning of each
+ * frame.
+ */
+class abcg::VulkanShaderReloader {
+public:
+  void add(VulkanShader &shader, std::function<void()> onReload);
+  void remove(VulkanShader const &shader);
+  void update(JobSystem &jobSystem);
+  void destroy();
+
+  void setEnabled(bool enabled);
+
+  /**
+   * @brief Returns whether the shader files are watched for changes.
+   *
+   * @return `true` if hot reload is enabled.
+   */
+  [[nodiscard]] bool isEnabled() const noexcept {
+    return m_watcher != nullptr;
+  }
+
+private:
+  struct Entry {
+    VulkanShader *shader{};
+    std::function<void()> onReload;
+    JobSystem::Counter counter;
+    std::shared_ptr<std::vector<uint32_t>> code;
+    // Whether the file changed again while it was being compiled
+    bool dirty{};
+  };
+
+  void schedule(Entry &entry, JobSystem &jobSystem);
+
+  std::vector<Entry> m_entries;
+  std::unique_ptr<FileWatcher> m_watcher;
 };
 
 #endif
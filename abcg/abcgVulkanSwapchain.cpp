@@ -17,6 +17,7 @@
 #include "abcgApplication.hpp"
 #include "abcgException.hpp"
 #include "abcgVulkanDevice.hpp"
+#include "abcgVulkanGPUTimer.hpp"
 #include "abcgVulkanPhysicalDevice.hpp"
 #include "abcgVulkanWindow.hpp"
 
@@ -122,30 +123,38 @@ void abcg::VulkanSwapchain::destroy() {
   destroyFrames();
   destroyRenderPasses();
 
-  device.destroySwapchainKHR(m_swapchainKHR);
+  // There is no swapchain when rendering to offscreen images
+  if (m_swapchainKHR) {
+    device.destroySwapchainKHR(m_swapchainKHR);
+  }
 }
 
 void abcg::VulkanSwapchain::render(
-    std::function<void(VulkanFrame const &)> const &fun) {
+    std::function<void(VulkanFrame const &)> const &fun, ImDrawData *drawData,
+    VulkanGPUTimer *gpuTimer) {
   auto const &device{static_cast<vk::Device>(m_device)};
 
   // Get current set of semaphores
   auto [presentCompleteSemaphore,
         renderCompleteSemaphore]{m_frameSemaphores.at(m_currentSemaphore)};
 
-  // Acquire an image from the swapchain
-  vk::Result result{};
-  try {
-    result = device.acquireNextImageKHR(
-        m_swapchainKHR, std::numeric_limits<uint64_t>::max(),
-        presentCompleteSemaphore, vk::Fence{}, &m_currentFrame);
-  } catch (vk::OutOfDateKHRError const &) {
-    result = vk::Result::eErrorOutOfDateKHR;
-  }
-  if (result == vk::Result::eErrorOutOfDateKHR ||
-      result == vk::Result::eSuboptimalKHR) {
-    m_swapChainRebuild = true;
-    return;
+  // Acquire an image from the swapchain. Offscreen images are not acquired;
+  // they are used in turn as present() advances m_currentFrame
+  auto const offscreen{isOffscreen()};
+  if (!offscreen) {
+    vk::Result result{};
+    try {
+      result = device.acquireNextImageKHR(
+          m_swapchainKHR, std::numeric_limits<uint64_t>::max(),
+          presentCompleteSemaphore, vk::Fence{}, &m_currentFrame);
+    } catch (vk::OutOfDateKHRError const &) {
+      result = vk::Result::eErrorOutOfDateKHR;
+    }
+    if (result == vk::Result::eErrorOutOfDateKHR ||
+        result == vk::Result::eSuboptimalKHR) {
+      m_swapChainRebuild = true;
+      return;
+    }
   }
 
   auto const &frame{m_frames.at(m_currentFrame)};
@@ -158,6 +167,20 @@ void abcg::VulkanSwapchain::render(
   device.resetFences(frame.fence);
   device.resetCommandPool(frame.commandPool);
 
+  std::vector<vk::CommandBuffer> commandBuffers;
+  commandBuffers.reserve(3);
+
+  // The timing of the main pass starts in a command buffer submitted before
+  // the one recorded by the user
+  auto const timed{gpuTimer != nullptr && gpuTimer->isSupported()};
+  std::uint32_t mainZone{};
+  if (timed) {
+    auto const &timerCommandBuffer{gpuTimer->beginFrame(m_currentFrame)};
+    mainZone = gpuTimer->beginZone(timerCommandBuffer, "Main pass");
+    timerCommandBuffer.end();
+    commandBuffers.push_back(timerCommandBuffer);
+  }
+
   // Main pass
   fun(frame);
 
@@ -165,6 +188,12 @@ void abcg::VulkanSwapchain::render(
   frame.commandBufferUI.begin(
       {.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
 
+  std::uint32_t uiZone{};
+  if (timed) {
+    gpuTimer->endZone(frame.commandBufferUI, mainZone);
+    uiZone = gpuTimer->beginZone(frame.commandBufferUI, "ImGui");
+  }
+
   std::array<vk::ClearValue, 2> const clearValues{};
 
   frame.commandBufferUI.beginRenderPass(
@@ -176,26 +205,37 @@ void abcg::VulkanSwapchain::render(
       vk::SubpassContents::eInline);
 
   // Record Dear ImGUI primitives into command buffer
-  ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), frame.commandBufferUI);
+  ImGui_ImplVulkan_RenderDrawData(drawData, frame.commandBufferUI);
 
   frame.commandBufferUI.endRenderPass();
 
+  if (timed) {
+    gpuTimer->endZone(frame.commandBufferUI, uiZone);
+    gpuTimer->endFrame();
+  }
+
   frame.commandBufferUI.end();
 
   std::array waitSemaphores{presentCompleteSemaphore};
   std::array waitStages{vk::PipelineStageFlags{
       vk::PipelineStageFlagBits::eColorAttachmentOutput}};
-  std::array commandBuffers{frame.commandBuffer, frame.commandBufferUI};
+  commandBuffers.push_back(frame.commandBuffer);
+  commandBuffers.push_back(frame.commandBufferUI);
   std::array signalSemaphores{renderCompleteSemaphore};
 
+  // Offscreen images are neither acquired nor presented, so there is nothing
+  // to wait for or to signal
+  auto const semaphoreCount{
+      offscreen ? 0U : gsl::narrow<uint32_t>(waitSemaphores.size())};
+
   // Submit command buffer
   m_device.getQueues().graphics.submit(
-      {{.waitSemaphoreCount = gsl::narrow<uint32_t>(waitSemaphores.size()),
+      {{.waitSemaphoreCount = semaphoreCount,
         .pWaitSemaphores = waitSemaphores.data(),
         .pWaitDstStageMask = waitStages.data(),
-        .commandBufferCount = commandBuffers.size(),
+        .commandBufferCount = gsl::narrow<uint32_t>(commandBuffers.size()),
         .pCommandBuffers = commandBuffers.data(),
-        .signalSemaphoreCount = gsl::narrow<uint32_t>(signalSemaphores.size()),
+        .signalSemaphoreCount = semaphoreCount,
         .pSignalSemaphores = signalSemaphores.data()}},
       frame.fence);
 }
@@ -204,6 +244,13 @@ void abcg::VulkanSwapchain::present() {
   if (m_swapChainRebuild)
     return;
 
+  // Offscreen images are not presented. Render to the next one
+  if (isOffscreen()) {
+    m_currentFrame =
+        (m_currentFrame + 1) % gsl::narrow<uint32_t>(m_frames.size());
+    return;
+  }
+
   // Set semaphores to wait
   auto &frameSemaphore{m_frameSemaphores.at(m_currentSemaphore)};
   std::array waitSemaphores{frameSemaphore.renderComplete};
@@ -248,6 +295,39 @@ bool abcg::VulkanSwapchain::checkRebuild(VulkanSettings const &settings,
   // Destroy old swapchain and in-flight frames data, if any
   destroy();
 
+  // Without a surface (headless mode), frames are rendered to offscreen
+  // images instead of swapchain images
+  if (isOffscreen()) {
+    if (!chooseOffscreenFormat(windowSize)) {
+      return false;
+    }
+  } else if (!createSwapchainKHR(settings, windowSize, oldSwapchain)) {
+    return false;
+  }
+
+  createRenderPasses(settings);
+
+  createFrames();
+
+  if (settings.depthBufferSize > 0 || settings.stencilBufferSize > 0) {
+    createDepthResources(settings);
+  }
+
+  if (m_device.getPhysicalDevice().getSampleCount() >
+      vk::SampleCountFlagBits::e1) {
+    createMSAAResources();
+  }
+
+  createFramebuffers(settings);
+
+  m_swapChainRebuild = false;
+
+  return true;
+}
+
+bool abcg::VulkanSwapchain::createSwapchainKHR(VulkanSettings const &settings,
+                                               glm::ivec2 const &windowSize,
+                                               vk::SwapchainKHR oldSwapchain) {
   auto const &physicalDevice{
       static_cast<vk::PhysicalDevice>(m_device.getPhysicalDevice())};
   auto const &surface{m_device.getPhysicalDevice().getSurfaceKHR()};
@@ -276,6 +356,8 @@ bool abcg::VulkanSwapchain::checkRebuild(VulkanSettings const &settings,
                            vk::PresentModeKHR::eFifo};
   if (!settings.vSync) {
     presentModes.insert(presentModes.begin(), vk::PresentModeKHR::eImmediate);
+  } else if (settings.adaptiveVSync) {
+    presentModes.insert(presentModes.begin(), vk::PresentModeKHR::eFifoRelaxed);
   }
 
   auto const presentMode{chooseSwapPresentMode(presentModes, surfaceCaps)};
@@ -340,33 +422,43 @@ bool abcg::VulkanSwapchain::checkRebuild(VulkanSettings const &settings,
     createInfo.imageSharingMode = vk::SharingMode::eExclusive;
   }
 
+  auto const &device{static_cast<vk::Device>(m_device)};
   m_swapchainKHR = device.createSwapchainKHR(createInfo);
 
-  device.destroySwapchainKHR(oldSwapchain);
-
-  createRenderPasses(settings);
-
-  createFrames();
-
-  if (settings.depthBufferSize > 0 || settings.stencilBufferSize > 0) {
-    createDepthResources(settings);
+  if (oldSwapchain) {
+    device.destroySwapchainKHR(oldSwapchain);
   }
 
-  if (m_device.getPhysicalDevice().getSampleCount() >
-      vk::SampleCountFlagBits::e1) {
-    createMSAAResources();
-  }
+  return true;
+}
 
-  createFramebuffers(settings);
+bool abcg::VulkanSwapchain::chooseOffscreenFormat(
+    glm::ivec2 const &windowSize) {
+  auto const format{m_device.getPhysicalDevice().getFirstSupportedFormat(
+      {vk::Format::eB8G8R8A8Unorm, vk::Format::eR8G8B8A8Unorm},
+      vk::ImageTiling::eOptimal,
+      vk::FormatFeatureFlagBits::eColorAttachment |
+          vk::FormatFeatureFlagBits::eTransferSrc)};
+  if (!format.has_value()) {
+    throw abcg::RuntimeError("Failed to find offscreen image format");
+  }
+  m_swapchainImageFormat = format.value();
 
-  m_swapChainRebuild = false;
+  // Offscreen images have the size of the window
+  m_swapchainExtent =
+      vk::Extent2D{.width = gsl::narrow<uint32_t>(std::max(windowSize.x, 0)),
+                   .height = gsl::narrow<uint32_t>(std::max(windowSize.y, 0))};
 
-  return true;
+  return m_swapchainExtent.width > 0 && m_swapchainExtent.height > 0;
 }
 
 void abcg::VulkanSwapchain::createFrames() {
+  // Offscreen images are created below, as they have no swapchain images
+  constexpr auto offscreenImageCount{2U};
   auto const swapchainImages{
-      static_cast<vk::Device>(m_device).getSwapchainImagesKHR(m_swapchainKHR)};
+      isOffscreen() ? std::vector<vk::Image>(offscreenImageCount)
+                    : static_cast<vk::Device>(m_device).getSwapchainImagesKHR(
+                          m_swapchainKHR)};
 
   // Create image views
   m_currentFrame = 0;
@@ -379,7 +471,22 @@ void abcg::VulkanSwapchain::createFrames() {
     frame.index = index;
     frame.colorImage.create(
         m_device,
-        {.viewInfo = {
+        {// Used only if image is undefined, i.e., for offscreen images
+         .info = {.imageType = vk::ImageType::e2D,
+                  .format = m_swapchainImageFormat,
+                  .extent = {.width = m_swapchainExtent.width,
+                             .height = m_swapchainExtent.height,
+                             .depth = 1},
+                  .mipLevels = 1,
+                  .arrayLayers = 1,
+                  .samples = vk::SampleCountFlagBits::e1,
+                  .tiling = vk::ImageTiling::eOptimal,
+                  .usage = vk::ImageUsageFlagBits::eColorAttachment |
+                           vk::ImageUsageFlagBits::eTransferSrc,
+                  .sharingMode = vk::SharingMode::eExclusive,
+                  .initialLayout = vk::ImageLayout::eUndefined},
+         .properties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+         .viewInfo = {
              .image = image,
              .viewType = vk::ImageViewType::e2D,
              .format = m_swapchainImageFormat,
@@ -555,6 +662,10 @@ void abcg::VulkanSwapchain::createRenderPasses(VulkanSettings const &settings) {
   auto const &device{static_cast<vk::Device>(m_device)};
   auto const sampleCount{m_device.getPhysicalDevice().getSampleCount()};
 
+  // Offscreen images are left ready to be copied from instead of presented
+  auto const presentLayout{isOffscreen() ? vk::ImageLayout::eTransferSrcOptimal
+                                         : vk::ImageLayout::ePresentSrcKHR};
+
   //
   // Main render pass
   //
@@ -570,7 +681,7 @@ void abcg::VulkanSwapchain::createRenderPasses(VulkanSettings const &settings) {
       // When multisampling is disabled, the image can be presented directly
       .finalLayout = sampleCount > vk::SampleCountFlagBits::e1
                          ? vk::ImageLayout::eColorAttachmentOptimal
-                         : vk::ImageLayout::ePresentSrcKHR};
+                         : presentLayout};
   attachments.push_back(colorAttachment);
 
   vk::AttachmentDescription depthAttachment{};
@@ -618,7 +729,7 @@ void abcg::VulkanSwapchain::createRenderPasses(VulkanSettings const &settings) {
                               .stencilStoreOp =
                                   vk::AttachmentStoreOp::eDontCare,
                               .initialLayout = vk::ImageLayout::eUndefined,
-                              .finalLayout = vk::ImageLayout::ePresentSrcKHR};
+                              .finalLayout = presentLayout};
 
     colorAttachmentResolveRef = {.attachment = attachmentCount++,
                                  .layout =
@@ -675,7 +786,7 @@ void abcg::VulkanSwapchain::createRenderPasses(VulkanSettings const &settings) {
   // main render pass
   colorAttachment.initialLayout = sampleCount > vk::SampleCountFlagBits::e1
                                       ? vk::ImageLayout::eColorAttachmentOptimal
-                                      : vk::ImageLayout::ePresentSrcKHR;
+                                      : presentLayout;
   attachments.push_back(colorAttachment);
 
   if (settings.depthBufferSize > 0 || settings.stencilBufferSize > 0) {
@@ -15,6 +15,7 @@
 
 #include <functional>
 #include <glm/fwd.hpp>
+#include <imgui.h>
 
 #include "abcgVulkanDevice.hpp"
 #include "abcgVulkanImage.hpp"
@@ -23,6 +24,7 @@ namespace abcg {
 class VulkanSwapchain;
 struct VulkanFrame;
 struct VulkanSettings;
+class VulkanGPUTimer;
 class VulkanPipeline;
 class VulkanWindow;
 } // namespace abcg
@@ -46,19 +48,26 @@ struct abcg::VulkanFrame {
  *
  * This class creates and manages the list of image buffers and other resources
  * that are used for presentation.
+ *
+ * If the physical device has no surface (headless mode), no swapchain is
+ * created. Frames are rendered in turn to offscreen images that are left in
+ * the vk::ImageLayout::eTransferSrcOptimal layout.
  */
 class abcg::VulkanSwapchain {
 public:
   void create(VulkanDevice const &device, VulkanSettings const &settings,
               glm::ivec2 const &windowSize);
   void destroy();
-  void render(std::function<void(VulkanFrame const &)> const &fun);
+  void render(std::function<void(VulkanFrame const &)> const &fun,
+              ImDrawData *drawData, VulkanGPUTimer *gpuTimer = nullptr);
   void present();
   bool checkRebuild(VulkanSettings const &settings,
                     glm::ivec2 const &windowSize);
 
   /**
    * @brief Conversion to vk::SwapchainKHR.
+   *
+   * The swapchain is null when rendering to offscreen images.
    */
   explicit operator vk::SwapchainKHR const &() const noexcept {
     return m_swapchainKHR;
@@ -128,6 +137,14 @@ public:
   }
 
 private:
+  [[nodiscard]] bool isOffscreen() const noexcept {
+    return !m_device.getPhysicalDevice().getSurfaceKHR();
+  }
+  bool createSwapchainKHR(VulkanSettings const &settings,
+                          glm::ivec2 const &windowSize,
+                          vk::SwapchainKHR oldSwapchain);
+  bool chooseOffscreenFormat(glm::ivec2 const &windowSize);
+
   void createFrames();
   void destroyFrames();
 
@@ -17,23 +17,27 @@
 #include <imgui_impl_sdl.h>
 #include <imgui_impl_vulkan.h>
 
+#include "abcgApplication.hpp"
 #include "abcgEmbeddedFonts.hpp"
 #include "abcgException.hpp"
 #include "abcgVulkanError.hpp"
 #include "abcgVulkanInstance.hpp"
 #include "abcgWindow.hpp"
 
+// If window is null (headless mode), no surface extensions are required
 [[nodiscard]] static std::vector<char const *>
-getRequiredExtensions(gsl::not_null<SDL_Window *> window) {
+getRequiredExtensions(SDL_Window *window) {
+  std::vector<char const *> extensions;
+
   uint32_t extensionCount{};
-  if (SDL_Vulkan_GetInstanceExtensions(window, &extensionCount, nullptr) !=
-      SDL_TRUE) {
+  if (window != nullptr &&
+      SDL_Vulkan_GetInstanceExtensions(window, &extensionCount, nullptr) !=
+          SDL_TRUE) {
     throw abcg::SDLError(
         "SDL_Vulkan_GetInstanceExtensions failed to get number of "
         "required extensions");
   }
 
-  std::vector<char const *> extensions;
   if (extensionCount > 0) {
     extensions.resize(extensionCount);
     if (SDL_Vulkan_GetInstanceExtensions(window, &extensionCount,
@@ -107,11 +111,39 @@ void abcg::VulkanWindow::onEvent([[maybe_unused]] SDL_Event const &event) {}
  */
 void abcg::VulkanWindow::onCreate() {}
 
+/**
+ * @brief Custom handler for copying the state used for rendering the frame.
+ *
+ * This virtual function is called for each frame of the rendering loop, after
+ * abcg::VulkanWindow::onPaintUI and before abcg::VulkanWindow::onPaint.
+ *
+ * If abcg::WindowSettings::threadedRendering is `true`,
+ * abcg::VulkanWindow::onPaint runs on a render thread concurrently with the
+ * main thread, which is already processing the next frame. This function is
+ * then called on the main thread while the render thread is idle. Copy here
+ * the state written by the main thread (e.g., in abcg::VulkanWindow::onEvent
+ * or abcg::VulkanWindow::onUpdate) that is read by abcg::VulkanWindow::onPaint.
+ * Within onPaint, read only these copies.
+ *
+ * If abcg::WindowSettings::threadedRendering is `false`, this function is
+ * called on the main thread just before abcg::VulkanWindow::onPaint.
+ *
+ * This is not called when the window is minimized.
+ *
+ * Override it for custom behavior. By default, it does nothing.
+ */
+void abcg::VulkanWindow::onSnapshot() {}
+
 /**
  * @brief Custom handler for rendering the Vulkan scene.
  *
  * This virtual function is called for each frame of the rendering loop, just
- * after abcg::VulkanWindow::onPaintUI.
+ * after abcg::VulkanWindow::onSnapshot.
+ *
+ * If abcg::WindowSettings::threadedRendering is `true`, this is called on the
+ * render thread, which owns the command submission to the graphics and present
+ * queues. abcg::VulkanWindow::onResize is called on the main thread while the
+ * render thread is idle.
  *
  * This is not called when the window is minimized.
  *
@@ -136,30 +168,7 @@ void abcg::VulkanWindow::onPaint([[maybe_unused]] VulkanFrame const &frame) {}
 void abcg::VulkanWindow::onPaintUI() {
   // FPS counter
   if (abcg::Window::getWindowSettings().showFPS) {
-    auto fps{ImGui::GetIO().Framerate};
-
-    static auto offset{0UL};
-    static auto refreshTime{ImGui::GetTime()};
-    static std::array<float, 150> frames{};
-
-    while (refreshTime < ImGui::GetTime()) {
-      auto const refreshFrequency{60.0};
-      frames.at(offset) = fps;
-      offset = (offset + 1) % frames.size();
-      refreshTime += (1.0 / refreshFrequency);
-    }
-
-    ImGui::SetNextWindowPos(ImVec2(5, 5));
-    ImGui::Begin("FPS", nullptr,
-                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs |
-                     ImGuiWindowFlags_NoBringToFrontOnFocus |
-                     ImGuiWindowFlags_NoFocusOnAppearing);
-    auto const label{fmt::format("avg {:.1f} FPS", fps)};
-    ImGui::PlotLines("", frames.data(), gsl::narrow<int>(frames.size()),
-                     gsl::narrow<int>(offset), label.c_str(), 0.0f,
-                     *std::ranges::max_element(frames) * 2,
-                     ImVec2(gsl::narrow<float>(frames.size()), 50));
-    ImGui::End();
+    getFrameStats().drawOverlay();
   }
 
   // Fullscreen button
@@ -205,6 +214,20 @@ void abcg::VulkanWindow::onResize() {}
  */
 void abcg::VulkanWindow::onUpdate() {}
 
+/**
+ * @brief Custom handler called at a fixed rate for advancing the simulation.
+ *
+ * This virtual function is called zero or more times per frame, before
+ * abcg::VulkanWindow::onUpdate, whenever abcg::WindowSettings::fixedTimeStep is
+ * greater than zero. The accumulated frame time that is left for the next
+ * frame can be queried with abcg::Window::getInterpolationAlpha.
+ *
+ * @param deltaTime Fixed time step, in seconds.
+ *
+ * Override it for custom behavior. By default, it does nothing.
+ */
+void abcg::VulkanWindow::onFixedUpdate([[maybe_unused]] double deltaTime) {}
+
 /**
  * @brief Custom handler for cleaning up Vulkan resources.
  *
@@ -242,18 +265,24 @@ void abcg::VulkanWindow::handleEvent(SDL_Event const &event) {
 }
 
 void abcg::VulkanWindow::create() {
+  // In headless mode, the window of the SDL offscreen video driver has no
+  // surface. Frames are rendered to offscreen images, without a swapchain
+  auto const headless{Application::getSettings().headless};
+
   // Create window fol Vulkan graphics
-  if (!createSDLWindow(SDL_WINDOW_VULKAN)) {
+  if (!createSDLWindow(headless ? SDL_WindowFlags{} : SDL_WINDOW_VULKAN)) {
     throw abcg::SDLError("SDL_CreateWindow failed");
   }
 
   // Create Vulkan instance
   auto const applicationName{abcg::Window::getWindowSettings().title};
-  auto const requiredExtensions{getRequiredExtensions(Window::getSDLWindow())};
+  auto const requiredExtensions{
+      getRequiredExtensions(headless ? nullptr : Window::getSDLWindow())};
   m_instance.create(m_layers, requiredExtensions, applicationName);
 
   // Create window surface
   if (VkSurfaceKHR surface{};
+      headless ||
       SDL_Vulkan_CreateSurface(abcg::Window::getSDLWindow(),
                                static_cast<vk::Instance>(m_instance),
                                &surface) == SDL_TRUE) {
@@ -272,15 +301,21 @@ void abcg::VulkanWindow::create() {
   }
   auto const sampleCount{gsl::narrow<vk::SampleCountFlagBits>(1 << exponent)};
 
+  // The swapchain extension is not required without a surface
+  auto const deviceExtensions{headless ? std::vector<char const *>{}
+                                       : m_deviceExtensions};
+
   // Select physical device
-  m_physicalDevice.create(m_instance, m_surface, m_deviceExtensions,
+  m_physicalDevice.create(m_instance, m_surface, deviceExtensions,
                           sampleCount);
 
   // Create logical device
-  m_device.create(m_physicalDevice, m_deviceExtensions);
+  m_device.create(m_physicalDevice, deviceExtensions);
 
   // Create swapchain
   m_swapchain.create(m_device, m_vulkanSettings, getWindowSize());
+  m_gpuTimer.create(m_device, m_swapchain.getFrames().size(),
+                    m_vulkanSettings.pipelineStatistics);
 
   // Create descriptol pool
   std::vector<vk::DescriptorPoolSize> const poolSizes{
@@ -368,39 +403,106 @@ void abcg::VulkanWindow::create() {
     ImGui_ImplVulkan_DestroyFontUploadObjects();
   }
 
+  m_shaderReloader.setEnabled(Application::getSettings().hotReload);
+
   onCreate();
 
   onResize();
+
+#if !defined(__EMSCRIPTEN__)
+  if (getWindowSettings().threadedRendering) {
+    m_drawDataSnapshot = std::make_unique<DrawDataSnapshot>();
+    m_renderThread = std::make_unique<RenderThread>();
+  }
+#endif
+}
+
+void abcg::VulkanWindow::fixedUpdate(double deltaTime) {
+  onFixedUpdate(deltaTime);
 }
 
 void abcg::VulkanWindow::paint() {
-  onUpdate();
+  {
+    ABCG_PROFILE_SCOPE("onUpdate");
+    onUpdate();
+  }
 
   if (m_hidden || m_minimized)
     return;
 
+  {
+    ABCG_PROFILE_SCOPE("onPaintUI");
+    ImGui_ImplVulkan_NewFrame();
+    ImGui_ImplSDL2_NewFrame();
+    ImGui::NewFrame();
+
+    onPaintUI();
+
+    if (getWindowSettings().showProfiler) {
+      Profiler::drawOverlay();
+    }
+
+    ImGui::Render();
+  }
+
+  if (m_renderThread) {
+    // Frame N-1 must be fully submitted before the swapchain is rebuilt and the
+    // state of frame N is copied
+    ABCG_PROFILE_SCOPE("Wait render thread");
+    m_renderThread->wait();
+  }
+
+  // Shader modules are replaced only while no frame is being recorded
+  m_shaderReloader.update(getJobSystem());
+
   if (m_swapchain.checkRebuild(m_vulkanSettings, getWindowSize())) {
+    // The number of in-flight frames may have changed
+    m_gpuTimer.create(m_device, m_swapchain.getFrames().size(),
+                      m_vulkanSettings.pipelineStatistics);
     onResize();
   }
 
   // ImGUI requires at least 2 images in the swapchain
   ImGui_ImplVulkan_SetMinImageCount(2);
 
-  ImGui_ImplVulkan_NewFrame();
-  ImGui_ImplSDL2_NewFrame();
-  ImGui::NewFrame();
+  {
+    ABCG_PROFILE_SCOPE("onSnapshot");
+    onSnapshot();
+  }
+
+  if (m_renderThread) {
+    m_drawDataSnapshot->capture(*ImGui::GetDrawData());
+    m_renderThread->submit([this] { render(m_drawDataSnapshot->get()); });
+  } else {
+    render(ImGui::GetDrawData());
+  }
+}
 
-  onPaintUI();
+void abcg::VulkanWindow::render(ImDrawData *drawData) {
+  ABCG_PROFILE_SCOPE("Render");
 
-  ImGui::Render();
+  if (m_renderThread) {
+    runMainThreadJobs();
+  }
 
-  m_swapchain.render([this](auto const &frame) { onPaint(frame); });
+  m_swapchain.render(
+      [this](auto const &frame) {
+        ABCG_PROFILE_SCOPE("onPaint");
+        onPaint(frame);
+      },
+      drawData, &m_gpuTimer);
+
+  ABCG_PROFILE_SCOPE("Present");
   m_swapchain.present();
 }
 
 void abcg::VulkanWindow::destroy() {
+  m_renderThread.reset();
+  m_drawDataSnapshot.reset();
+
   static_cast<vk::Device>(m_device).waitIdle();
 
+  m_shaderReloader.destroy();
   onDestroy();
 
   ImGui_ImplVulkan_Shutdown();
@@ -408,10 +510,13 @@ void abcg::VulkanWindow::destroy() {
   ImGui::DestroyContext();
 
   static_cast<vk::Device>(m_device).destroyDescriptorPool(m_UIdescriptorPool);
+  m_gpuTimer.destroy();
   m_swapchain.destroy();
   m_device.destroy();
   m_physicalDevice.destroy();
-  static_cast<vk::Instance>(m_instance).destroySurfaceKHR(m_surface);
+  if (m_surface) {
+    static_cast<vk::Instance>(m_instance).destroySurfaceKHR(m_surface);
+  }
   m_instance.destroy();
 }
 
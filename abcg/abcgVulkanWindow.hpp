@@ -14,11 +14,15 @@
 #define ABCG_VULKAN_WINDOW_HPP_
 
 #include <array>
+#include <memory>
 #include <string>
 
+#include "abcgRenderThread.hpp"
 #include "abcgVulkanDevice.hpp"
+#include "abcgVulkanGPUTimer.hpp"
 #include "abcgVulkanInstance.hpp"
 #include "abcgVulkanPhysicalDevice.hpp"
+#include "abcgVulkanShader.hpp"
 #include "abcgVulkanSwapchain.hpp"
 #include "abcgWindow.hpp"
 
@@ -60,6 +64,25 @@ struct abcg::VulkanSettings {
    * comes first.
    */
   bool vSync{false};
+
+  /** @brief Whether to use adaptive vertical synchronization.
+   *
+   * If `true` and abcg::VulkanSettings::vSync is also `true`, the internal
+   * present mode is set to the relaxed FIFO mode, which presents late frames
+   * immediately instead of waiting for the next vertical retrace. If the
+   * relaxed FIFO mode is not supported, the behavior is the same as if this
+   * option were `false`.
+   */
+  bool adaptiveVSync{false};
+
+  /** @brief Whether to create pipeline statistics queries, if supported by the
+   * device.
+   *
+   * Statistics are collected while the profiler is enabled, for the commands
+   * recorded between abcg::VulkanGPUTimer::beginPipelineStatistics and
+   * abcg::VulkanGPUTimer::endPipelineStatistics.
+   */
+  bool pipelineStatistics{false};
 };
 
 /**
@@ -71,10 +94,13 @@ struct abcg::VulkanSettings {
  *
  * @sa abcg::VulkanWindow::onEvent for handling SDL events.
  * @sa abcg::VulkanWindow::onCreate for initializing Vulkan resources.
+ * @sa abcg::VulkanWindow::onSnapshot for copying the state used by onPaint.
  * @sa abcg::VulkanWindow::onPaint for scene rendering.
  * @sa abcg::VulkanWindow::onPaintUI for UI rendering.
  * @sa abcg::VulkanWindow::onResize for handling swapchain rebuild events.
  * @sa abcg::VulkanWindow::onUpdate for commands to be called every frame.
+ * @sa abcg::VulkanWindow::onFixedUpdate for commands to be called at a fixed
+ * rate.
  * @sa abcg::VulkanWindow::onDestroy for cleaning up Vulkan resources.
  *
  * @remark Objects of this type cannot be copied or copy-constructed.
@@ -94,23 +120,49 @@ public:
   [[nodiscard]] VulkanSwapchain const &getSwapchain() noexcept {
     return m_swapchain;
   }
+  /**
+   * @brief Returns the GPU timer of the window.
+   *
+   * Use it with abcg::VulkanGPUScope to measure GPU zones in the command
+   * buffers recorded in abcg::VulkanWindow::onPaint.
+   *
+   * @return Reference to the GPU timer.
+   */
+  [[nodiscard]] VulkanGPUTimer &getGPUTimer() noexcept { return m_gpuTimer; }
+  /**
+   * @brief Returns the shader reloader of the window.
+   *
+   * Register the shaders created from files with
+   * abcg::VulkanShaderReloader::add to rebuild them when hot reload is
+   * enabled.
+   *
+   * @return Reference to the shader reloader.
+   */
+  [[nodiscard]] VulkanShaderReloader &getShaderReloader() noexcept {
+    return m_shaderReloader;
+  }
 
 protected:
   virtual void onEvent(SDL_Event const &event);
   virtual void onCreate();
+  virtual void onSnapshot();
   virtual void onPaint(VulkanFrame const &frame);
   virtual void onPaintUI();
   virtual void onResize();
   virtual void onUpdate();
+  virtual void onFixedUpdate(double deltaTime);
   virtual void onDestroy();
 
 private:
   void handleEvent(SDL_Event const &event) final;
   void create() final;
+  void fixedUpdate(double deltaTime) final;
   void paint() final;
   void destroy() final;
   [[nodiscard]] glm::ivec2 getWindowSize() const final;
 
+  void render(ImDrawData *drawData);
+
   VulkanSettings m_vulkanSettings;
   std::vector<char const *> const m_deviceExtensions{
       VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -124,10 +176,15 @@ private:
   VulkanPhysicalDevice m_physicalDevice{};
   VulkanDevice m_device{};
   VulkanSwapchain m_swapchain{};
+  VulkanGPUTimer m_gpuTimer{};
+  VulkanShaderReloader m_shaderReloader;
   vk::SurfaceKHR m_surface{};
   vk::DescriptorPool m_UIdescriptorPool{};
   bool m_hidden{};
   bool m_minimized{};
+
+  std::unique_ptr<RenderThread> m_renderThread;
+  std::unique_ptr<DrawDataSnapshot> m_drawDataSnapshot;
 };
 
 #endif
@@ -11,10 +11,17 @@
 #include "abcgWindow.hpp"
 
 #include <SDL_video.h>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
 #include <utility>
 
+#include <fmt/core.h>
 #include <imgui_impl_sdl.h>
 
+#include "abcgApplication.hpp"
+#include "abcgException.hpp"
+
 static ImVec4 ColorAlpha(ImVec4 const &color, float const alpha) {
   return {color.x, color.y, color.z, alpha};
 }
@@ -161,6 +168,10 @@ abcg::fullscreenchangeCallback(int eventType,
  * that, zero is returned. Internally, the delta time accumulates for the next
  * frame(s) until at least 2ms have passed.
  *
+ * While replaying an input log, this is the delta time of the recorded frame.
+ * If abcg::ApplicationSettings::fixedDeltaTime is greater than zero, this is
+ * the fixed delta time.
+ *
  * @returns Time in seconds.
  */
 double abcg::Window::getDeltaTime() const noexcept { return m_lastDeltaTime; }
@@ -168,9 +179,64 @@ double abcg::Window::getDeltaTime() const noexcept { return m_lastDeltaTime; }
 /**
  * @brief Returns the time that have passed since the window was created.
  *
+ * While replaying an input log or using a fixed delta time, this is the sum of
+ * the delta times of the frames rendered so far.
+ *
  * @returns Time in seconds.
  */
-double abcg::Window::getElapsedTime() const { return m_elapsedTime.elapsed(); }
+double abcg::Window::getElapsedTime() const {
+  return m_drivenElapsedTime ? *m_drivenElapsedTime : m_elapsedTime.elapsed();
+}
+
+/**
+ * @brief Returns the interpolation factor between the last two fixed-rate
+ * updates.
+ *
+ * When abcg::WindowSettings::fixedTimeStep is greater than zero, the time that
+ * is left in the accumulator after the fixed-rate updates of the current frame
+ * is smaller than one time step. This function returns that remaining time
+ * divided by the time step. It can be used during rendering to interpolate
+ * between the previous and the current simulation state, as in
+ * `previous + (current - previous) * alpha`.
+ *
+ * @returns Interpolation factor in the range [0, 1). If the fixed-rate update
+ * loop is disabled, the factor is always 1.
+ */
+double abcg::Window::getInterpolationAlpha() const noexcept {
+  return m_interpolationAlpha;
+}
+
+/**
+ * @brief Returns the frame pacing error of the last frame.
+ *
+ * @returns Time, in seconds, by which the last frame missed the deadline set by
+ * abcg::WindowSettings::targetFPS. A positive value means the frame was late.
+ * The value is zero if abcg::WindowSettings::targetFPS is zero.
+ */
+double abcg::Window::getPacingError() const noexcept {
+  return m_framePacer.getPacingError();
+}
+
+/**
+ * @brief Returns the job system of the application.
+ *
+ * The job system is available from the creation of the window (e.g.,
+ * abcg::OpenGLWindow::onCreate) until its destruction (e.g.,
+ * abcg::OpenGLWindow::onDestroy). Jobs scheduled with
+ * abcg::JobSystem::scheduleOnMainThread are run at the beginning of each
+ * frame, on the thread that renders the window.
+ *
+ * @returns Reference to the job system.
+ *
+ * @throw abcg::RuntimeError if called before the window is created or after it
+ * is destroyed.
+ */
+abcg::JobSystem &abcg::Window::getJobSystem() const {
+  if (m_jobSystem == nullptr) {
+    throw abcg::RuntimeError("Job system is not available");
+  }
+  return *m_jobSystem;
+}
 
 /**
  * @brief Returns the current configuration settings of the window.
@@ -206,6 +272,35 @@ void abcg::Window::setWindowSettings(WindowSettings const &windowSettings) {
   }
 
   m_windowSettings = windowSettings;
+  m_framePacer.setTargetFPS(m_windowSettings.targetFPS);
+}
+
+/**
+ * @brief Requests the window to be redrawn.
+ *
+ * When abcg::WindowSettings::lazyRedraw is `true`, call this function to
+ * render a new frame without waiting for an input event, e.g., while an
+ * animation is running. A single frame is rendered for each request; call it
+ * once per frame (e.g., from abcg::OpenGLWindow::onUpdate) to keep the window
+ * animating.
+ *
+ * This function has no effect if abcg::WindowSettings::lazyRedraw is `false`.
+ */
+void abcg::Window::requestRedraw() noexcept {
+  m_pendingRedrawFrames = std::max(m_pendingRedrawFrames, 1);
+}
+
+/**
+ * @brief Returns the frame time statistics of the window.
+ *
+ * The frame time is the time between the start of two consecutive frames,
+ * not including the time the main loop blocks waiting for events (see
+ * abcg::WindowSettings::lazyRedraw).
+ *
+ * @return Reference to the frame time statistics.
+ */
+abcg::FrameStats const &abcg::Window::getFrameStats() const noexcept {
+  return *m_frameStats;
 }
 
 /**
@@ -241,6 +336,9 @@ bool abcg::Window::createSDLWindow(SDL_WindowFlags extraFlags) {
     return false;
 
   auto commonFlags{SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI};
+  if (Application::getSettings().headless) {
+    commonFlags |= SDL_WINDOW_HIDDEN;
+  }
 
   m_window = SDL_CreateWindow(
       m_windowSettings.title.c_str(), SDL_WINDOWPOS_CENTERED,
@@ -319,6 +417,11 @@ void abcg::Window::templateHandleEvent(SDL_Event const &event, bool &done) {
   if (event.window.windowID != m_windowID)
     return;
 
+  // Dear ImGui may need a few frames to react to an input event
+  constexpr auto redrawFramesAfterEvent{3};
+  m_pendingRedrawFrames =
+      std::max(m_pendingRedrawFrames, redrawFramesAfterEvent);
+
   if (event.type == SDL_WINDOWEVENT) {
     switch (event.window.event) {
     case SDL_WINDOWEVENT_CLOSE:
@@ -354,6 +457,20 @@ void abcg::Window::templateHandleEvent(SDL_Event const &event, bool &done) {
 #endif
         toggleFullscreen();
     }
+#if !defined(__EMSCRIPTEN__)
+    if (event.key.keysym.sym == SDLK_F12) {
+      if (Profiler::isCapturing()) {
+        Profiler::stopCapture();
+      } else {
+        try {
+          Profiler::startCapture(
+              fmt::format("abcg_trace_{}.json", std::time(nullptr)));
+        } catch (abcg::RuntimeError const &exception) {
+          fmt::print("Warning: {}\n", exception.what());
+        }
+      }
+    }
+#endif
   }
 
   // Won't pass mouse events to the application if ImGUI has captured the
@@ -382,22 +499,128 @@ void abcg::Window::templateHandleEvent(SDL_Event const &event, bool &done) {
 void abcg::Window::templateCreate() {
   m_deltaTime.restart();
   m_elapsedTime.restart();
+  m_fixedTimeAccumulator = 0.0;
 
   create();
 
   // Set up our own Dear ImGui style
   setupImGuiStyle(true, 1.0f);
+
+  // Do not count the initialization in the time of the first frame
+  m_frameTime.restart();
+  m_idleTime = 0.0;
 }
 
 void abcg::Window::templatePaint() {
-  // Cap to 480 Hz
-  if (m_deltaTime.elapsed() >= 1.0 / 480.0) {
+  Profiler::setEnabled(m_windowSettings.showProfiler ||
+                       Profiler::isCapturing() ||
+                       !Application::getSettings().benchmarkPath.empty());
+
+  // Exclude the time spent blocked waiting for events
+  m_frameStats->addFrame(std::max(m_frameTime.restart() - m_idleTime, 0.0));
+  m_idleTime = 0.0;
+
+  if (m_pendingRedrawFrames > 0) {
+    --m_pendingRedrawFrames;
+  }
+
+  // With threaded rendering, these jobs are run on the render thread
+#if !defined(__EMSCRIPTEN__)
+  if (!m_windowSettings.threadedRendering)
+#endif
+  {
+    ABCG_PROFILE_SCOPE("Main thread jobs");
+    runMainThreadJobs();
+  }
+
+  if (m_drivenDeltaTime) {
+    // Set by abcg::Application from a replay or a fixed delta time
+    m_lastDeltaTime = *m_drivenDeltaTime;
+    m_drivenDeltaTime.reset();
+    m_drivenElapsedTime = m_drivenElapsedTime.value_or(0.0) + m_lastDeltaTime;
+  } else if (m_deltaTime.elapsed() >= 1.0 / 480.0) {
+    // Cap to 480 Hz
     m_lastDeltaTime = m_deltaTime.restart();
   } else {
     m_lastDeltaTime = 0.0;
   }
 
-  paint();
+  if (auto const fixedTimeStep{m_windowSettings.fixedTimeStep};
+      fixedTimeStep > 0.0) {
+    m_fixedTimeAccumulator += m_lastDeltaTime;
+
+    ABCG_PROFILE_SCOPE("Fixed update");
+    auto const maxSteps{std::max(m_windowSettings.maxFixedSteps, 1)};
+    auto steps{0};
+    while (m_fixedTimeAccumulator >= fixedTimeStep && steps < maxSteps) {
+      fixedUpdate(fixedTimeStep);
+      m_fixedTimeAccumulator -= fixedTimeStep;
+      ++steps;
+    }
+
+    // Drop the time that could not be caught up with
+    if (m_fixedTimeAccumulator >= fixedTimeStep) {
+      m_fixedTimeAccumulator =
+          std::fmod(m_fixedTimeAccumulator, fixedTimeStep);
+    }
+
+    m_interpolationAlpha = m_fixedTimeAccumulator / fixedTimeStep;
+  } else {
+    m_fixedTimeAccumulator = 0.0;
+    m_interpolationAlpha = 1.0;
+  }
+
+  {
+    ABCG_PROFILE_SCOPE("Paint");
+    paint();
+  }
+
+#if !defined(__EMSCRIPTEN__)
+  // Benchmark runs, replays and headless runs are not paced
+  if (auto const &settings{Application::getSettings()};
+      settings.benchmarkPath.empty() && settings.replayPath.empty() &&
+      !settings.headless) {
+    ABCG_PROFILE_SCOPE("Frame pacing");
+    m_framePacer.wait();
+  }
+#endif
+
+  Profiler::endFrame();
+}
+
+/**
+ * @brief Runs the jobs scheduled with abcg::JobSystem::scheduleOnMainThread.
+ *
+ * This is called at the beginning of each frame. If
+ * abcg::WindowSettings::threadedRendering is `true`, derived classes must call
+ * it on the render thread instead.
+ */
+void abcg::Window::runMainThreadJobs() {
+  if (m_jobSystem != nullptr) {
+    m_jobSystem->runMainThreadJobs();
+  }
+}
+
+int abcg::Window::templateGetEventTimeout() const {
+  // Benchmark runs and replays must not be throttled
+  if (auto const &settings{Application::getSettings()};
+      !settings.benchmarkPath.empty() || !settings.replayPath.empty()) {
+    return 0;
+  }
+
+  // Throttle updates while the window is not visible
+  constexpr auto hiddenTimeoutMs{100};
+  if (auto const flags{SDL_GetWindowFlags(m_window)};
+      (flags & (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED)) != 0U &&
+      !Application::getSettings().headless) {
+    return hiddenTimeoutMs;
+  }
+
+  if (m_windowSettings.lazyRedraw && m_pendingRedrawFrames == 0) {
+    return gsl::narrow_cast<int>(m_windowSettings.lazyRedrawTimeout * 1000.0);
+  }
+
+  return 0;
 }
 
 void abcg::Window::templateDestroy() {
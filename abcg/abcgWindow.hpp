@@ -13,9 +13,15 @@
 #ifndef ABCG_WINDOW_HPP_
 #define ABCG_WINDOW_HPP_
 
+#include <memory>
+#include <optional>
 #include <string>
 
 #include "abcgExternal.hpp"
+#include "abcgFramePacer.hpp"
+#include "abcgFrameStats.hpp"
+#include "abcgJobSystem.hpp"
+#include "abcgProfiler.hpp"
 #include "abcgTimer.hpp"
 
 #if defined(__EMSCRIPTEN__)
@@ -58,7 +64,12 @@ struct abcg::WindowSettings {
    * abcg::Window::getWindowSize.
    */
   int height{600};
-  /** @brief Whether to show an overlay window with a FPS counter. */
+  /** @brief Whether to show an overlay window with a FPS counter, a plot of
+   * the last frame times, the 99th percentile frame time and the number of
+   * hitches.
+   *
+   * @sa abcg::Window::getFrameStats.
+   */
   bool showFPS{true};
   /** @brief Whether to show a button to toggle fullscreen on/off. */
   bool showFullscreenButton{true};
@@ -68,6 +79,58 @@ struct abcg::WindowSettings {
   std::string fullscreenElementID{"#canvas"};
   /** @brief String containing the window title. */
   std::string title{"ABCg Window"};
+  /** @brief Time step, in seconds, of the fixed-rate update loop.
+   *
+   * If greater than zero, the fixed-rate update handler (e.g.,
+   * abcg::OpenGLWindow::onFixedUpdate) is called zero or more times per
+   * frame so that the simulation advances in steps of this size, regardless
+   * of the frame rate. If zero, the fixed-rate update loop is disabled.
+   */
+  double fixedTimeStep{0.0};
+  /** @brief Maximum number of fixed-rate updates per frame.
+   *
+   * When the frame rate drops below the rate of the fixed-rate loop, the
+   * simulation time that cannot be caught up with this number of steps is
+   * discarded, so that the application slows down instead of stalling.
+   */
+  int maxFixedSteps{8};
+  /** @brief Target frame rate, in frames per second.
+   *
+   * If greater than zero, the main loop sleeps after each frame until the
+   * deadline of the next frame, and spins only for the last part of the wait
+   * to meet the deadline precisely. If zero, the main loop runs as fast as
+   * possible (limited only by vertical synchronization, if enabled). This
+   * setting has no effect in WebAssembly builds, where the browser paces the
+   * main loop, and is ignored in benchmark, replay and headless runs.
+   */
+  double targetFPS{0.0};
+  /** @brief Whether to redraw the window only when needed.
+   *
+   * If `true`, the main loop blocks until an event arrives, a redraw is
+   * requested with abcg::Window::requestRedraw, or
+   * abcg::WindowSettings::lazyRedrawTimeout expires. A few additional frames
+   * are rendered after each event so that Dear ImGui can settle its state. This
+   * setting has no effect in WebAssembly builds.
+   */
+  bool lazyRedraw{false};
+  /** @brief Maximum time, in seconds, the main loop blocks waiting for events
+   * when abcg::WindowSettings::lazyRedraw is `true`. */
+  double lazyRedrawTimeout{0.5};
+  /** @brief Whether to render on a dedicated thread.
+   *
+   * If `true`, the main thread handles events, updates and the UI of frame
+   * N+1 while a render thread renders frame N (see abcg::OpenGLWindow::onPaint
+   * and abcg::VulkanWindow::onPaint). The state read by `onPaint` must be
+   * copied in `onSnapshot`, which is the only point where both threads are
+   * synchronized. This setting has no effect in WebAssembly builds.
+   */
+  bool threadedRendering{false};
+  /** @brief Whether to record CPU zones and show an overlay window with the
+   * profiler's flame graph.
+   *
+   * @sa abcg::Profiler.
+   */
+  bool showProfiler{false};
 };
 
 /**
@@ -106,6 +169,8 @@ public:
 
   [[nodiscard]] WindowSettings const &getWindowSettings() const noexcept;
   void setWindowSettings(WindowSettings const &windowSettings);
+  void requestRedraw() noexcept;
+  [[nodiscard]] FrameStats const &getFrameStats() const noexcept;
 
 protected:
   /**
@@ -126,6 +191,17 @@ protected:
    */
   virtual void create() = 0;
 
+  /**
+   * @brief Custom handler for fixed-rate updates.
+   *
+   * This is called zero or more times per frame, just before
+   * abcg::Window::paint, whenever abcg::WindowSettings::fixedTimeStep is
+   * greater than zero.
+   *
+   * @param deltaTime Fixed time step, in seconds.
+   */
+  virtual void fixedUpdate(double deltaTime) = 0;
+
   /**
    * @brief Custom handler for window repainting.
    *
@@ -154,18 +230,23 @@ protected:
 
   [[nodiscard]] double getDeltaTime() const noexcept;
   [[nodiscard]] double getElapsedTime() const;
+  [[nodiscard]] double getInterpolationAlpha() const noexcept;
+  [[nodiscard]] double getPacingError() const noexcept;
+  [[nodiscard]] JobSystem &getJobSystem() const;
   [[nodiscard]] SDL_Window *getSDLWindow() const noexcept;
   [[nodiscard]] Uint32 getSDLWindowID() const noexcept;
   [[nodiscard]] bool createSDLWindow(SDL_WindowFlags extraFlags);
 
   void setEnableResizingEventWatcher(bool enabled) noexcept;
   void toggleFullscreen();
+  void runMainThreadJobs();
 
 private:
   void templateHandleEvent(SDL_Event const &event, bool &done);
   void templateCreate();
   void templatePaint();
   void templateDestroy();
+  [[nodiscard]] int templateGetEventTimeout() const;
 
   SDL_Window *m_window{};
   Uint32 m_windowID{};
@@ -173,8 +254,20 @@ private:
   WindowSettings m_windowSettings;
 
   Timer m_deltaTime;
+  Timer m_frameTime;
+  // Time spent waiting for events since the last frame
+  double m_idleTime{};
+  // Heap-allocated since FrameStats is large and cannot be moved
+  std::unique_ptr<FrameStats> m_frameStats{std::make_unique<FrameStats>()};
   Timer m_elapsedTime;
   double m_lastDeltaTime{};
+  std::optional<double> m_drivenDeltaTime;
+  std::optional<double> m_drivenElapsedTime;
+  double m_fixedTimeAccumulator{};
+  double m_interpolationAlpha{1.0};
+  FramePacer m_framePacer;
+  int m_pendingRedrawFrames{};
+  JobSystem *m_jobSystem{};
 
   bool m_enableResizingEventWatcher{true};
 
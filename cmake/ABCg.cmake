@@ -1,3 +1,52 @@
+# Bakes the images and OBJ meshes of the assets directory of the current
+# project with abcg_bake. A file assets/foo.png is baked to foo.png.baked, which
+# is copied next to foo.png in the destination directory after the target is
+# built. OBJ meshes are baked with the options in ABCG_BAKE_MESH_OPTIONS, which
+# can be set before calling enable_abcg (e.g., --recompute-normals
+# --standardize).
+function(abcg_bake_assets project_target destination)
+  set(assets_dir ${CMAKE_CURRENT_SOURCE_DIR}/assets)
+  set(baked_dir ${CMAKE_CURRENT_BINARY_DIR}/baked)
+
+  file(
+    GLOB_RECURSE sources CONFIGURE_DEPENDS
+    RELATIVE ${assets_dir}
+    ${assets_dir}/*.png ${assets_dir}/*.jpg ${assets_dir}/*.jpeg
+    ${assets_dir}/*.bmp ${assets_dir}/*.tga ${assets_dir}/*.obj)
+
+  # Images are loaded upside down by abcg::loadOpenGLTexture only
+  set(bake_options "")
+  if(NOT ${GRAPHICS_API} MATCHES "OpenGL")
+    list(APPEND bake_options --no-flip)
+  endif()
+
+  set(baked_files "")
+  foreach(source ${sources})
+    set(baked_file ${baked_dir}/${source}.baked)
+    set(source_options ${bake_options})
+    if(source MATCHES "\\.obj$")
+      list(APPEND source_options ${ABCG_BAKE_MESH_OPTIONS})
+    endif()
+    add_custom_command(
+      OUTPUT ${baked_file}
+      COMMAND abcg_bake ${source_options} ${assets_dir}/${source}
+              ${baked_file}
+      DEPENDS abcg_bake ${assets_dir}/${source}
+      COMMENT "Baking ${source}"
+      VERBATIM)
+    list(APPEND baked_files ${baked_file})
+  endforeach()
+
+  if(baked_files)
+    add_custom_target(${project_target}_bake DEPENDS ${baked_files})
+    add_dependencies(${project_target} ${project_target}_bake)
+    add_custom_command(
+      TARGET ${project_target}
+      POST_BUILD
+      COMMAND ${CMAKE_COMMAND} -E copy_directory ${baked_dir} ${destination})
+  endif()
+endfunction()
+
 function(enable_abcg project_target)
 
   if(ARGC GREATER 1)
@@ -78,6 +127,9 @@ function(enable_abcg project_target)
           POST_BUILD
           COMMAND ${CMAKE_COMMAND} -E copy_directory
                   ${CMAKE_CURRENT_SOURCE_DIR}/assets ${output_dir}/assets)
+        if(ABCG_BAKE_ASSETS AND TARGET abcg_bake)
+          abcg_bake_assets(${project_target} ${output_dir}/assets)
+        endif()
       endif()
 
       # Copy DLLs of SDL2 Extract first string delimited by ';', extract path
@@ -123,6 +175,10 @@ function(enable_abcg project_target)
             ${CMAKE_COMMAND} -E copy_directory
             ${CMAKE_CURRENT_SOURCE_DIR}/assets
             ${output_dir}/${project_target}.dir/assets)
+        if(ABCG_BAKE_ASSETS AND TARGET abcg_bake)
+          abcg_bake_assets(${project_target}
+                           ${output_dir}/${project_target}.dir/assets)
+        endif()
       endif()
 
       # Take into account that, on Windows with MSVC, binaries are placed in a
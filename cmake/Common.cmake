@@ -17,6 +17,15 @@ option(ENABLE_IPO "Enable Interprocedural Optimization" ON)
 # mold
 option(ENABLE_MOLD "Enable mold (Modern Linker)" OFF)
 
+# Allocation counting in benchmark runs
+option(ABCG_BENCH_ALLOC_COUNT
+       "Replace the global operator new to count allocations in benchmarks"
+       OFF)
+
+# Offline asset baking
+option(ABCG_BAKE_ASSETS "Bake images and OBJ meshes of assets/ with abcg_bake"
+       ON)
+
 if(NOT ${CMAKE_SYSTEM_NAME} MATCHES "Emscripten")
   set(OPTIONS_TARGET options)
   set(SANITIZERS_TARGET sanitizers)
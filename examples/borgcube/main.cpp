@@ -6,7 +6,15 @@ int main(int argc, char **argv) {
 
     Window window;
     window.setOpenGLSettings({.samples = 4});
-    window.setWindowSettings({.width = 1400, .height = 1000, .showFPS = false, .title = "Game"});
+    window.setWindowSettings({.width = 1400, .height = 1000, .showFPS = false, .title = "Game", .fixedTimeStep = 0.01, .targetFPS = 60.0});
+    // Benchmark scenario: dodge around while moving forward
+    app.setBenchmarkScenario(abcg::BenchmarkScenario{}
+                                 .keyPress(0, SDLK_UP, 240)
+                                 .keyPress(30, SDLK_LEFT, 40)
+                                 .keyPress(90, SDLK_RIGHT, 40)
+                                 .keyPress(150, SDLK_a, 20)
+                                 .keyPress(190, SDLK_d, 20)
+                                 .loop(240));
     app.run(window);
   } catch (std::exception const &exception) {
     fmt::print(stderr, "{}\n", exception.what());
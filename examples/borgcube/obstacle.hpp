@@ -7,7 +7,7 @@
 
 class Obstacle {
 public:
-  void create(GLuint program);
+  void create(std::shared_ptr<abcg::OpenGLSharedProgram> program);
   void paint(glm::vec3 pos, glm::vec3 scale, glm::vec3 rotation);
   void destroy();
  
@@ -15,7 +15,10 @@ private:
   GLuint m_VAO{};
   
   Camera m_camera;
-  GLuint m_program{};
+  std::shared_ptr<abcg::OpenGLSharedProgram> m_program;
+  abcg::OpenGLProgram::Uniform m_projUniform{};
+  abcg::OpenGLProgram::Uniform m_viewUniform{};
+  abcg::OpenGLProgram::Uniform m_modelUniform{};
   
   unsigned int m_texture;
 
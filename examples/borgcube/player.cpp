@@ -23,30 +23,26 @@ void Player::paint(glm::vec3 scale, glm::vec3 rotation) {
   model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0,0,1));
 
   //Ativa os shaders 
-  glUseProgram(m_program);
+  auto &program{m_program->getProgram()};
+  program.use();
 
-  //Localização das variáveis e atribuição dos respectivos valores para proj, view e model, que serão utilizadas nos shaders
-  auto const viewMatrixLoc{glGetUniformLocation(m_program, "proj")};
-  auto const projMatrixLoc{glGetUniformLocation(m_program, "view")};
-  auto const modelMatrixLoc{glGetUniformLocation(m_program, "model")};
+  //Atribuição dos valores de proj, view e model, que serão utilizados nos shaders. Valores que não mudaram não são reenviados
+  program.setUniform(m_projUniform, projection);
+  program.setUniform(m_viewUniform, view);
+  program.setUniform(m_modelUniform, model);
 
 
-  glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, glm::value_ptr(projection));
-  glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, glm::value_ptr(view));
-  glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-
-	glBindVertexArray(m_VAO);
+	abcg::glBindVertexArray(m_VAO);
 
   //Utiliza a textura carregada e atribuída na variável m_texture
-  glBindTexture(GL_TEXTURE_2D, m_texture);
+  abcg::glBindTexture(GL_TEXTURE_2D, m_texture);
 
   //Renderiza de acordo com a quantidade de triângulos
-	glDrawArrays(GL_TRIANGLES, 0, 36);
+	abcg::glDrawArrays(GL_TRIANGLES, 0, 36);
 
   //Desativa os shaders
-  glBindVertexArray(0);
-  glUseProgram(0);
+  abcg::glBindVertexArray(0);
+  abcg::glUseProgram(0);
 }
 
 void Player::update(GameData m_gameData){
@@ -87,9 +83,15 @@ void Player::setMovement(GameData m_gameData){
   m_pos = glm::vec3(newXPosition, m_pos.y, newZPosition);
 }
 
-void Player::create(GLuint program) {
+void Player::create(std::shared_ptr<abcg::OpenGLSharedProgram> program) {
   //Atribuição da variável m_program de acordo com o parâmetro recebido já com os shaders necessários
-  m_program = program;
+  m_program = std::move(program);
+
+  //Localização das variáveis uniformes, feita uma única vez
+  auto &reflectedProgram{m_program->getProgram()};
+  m_projUniform = reflectedProgram.getUniform("proj");
+  m_viewUniform = reflectedProgram.getUniform("view");
+  m_modelUniform = reflectedProgram.getUniform("model");
 
   //Atribuição da variável m_VAO
   setVAO();
@@ -100,8 +102,8 @@ void Player::create(GLuint program) {
 
 //Liberação dos recursos alocados durante a aplicação
 void Player::destroy(){
-  glDeleteProgram(m_program);
-  glDeleteVertexArrays(1, &m_VAO);
+  abcg::glDeleteVertexArrays(1, &m_VAO);
+  m_program.reset();
 }
 
 void Player::setVAO() {
@@ -152,15 +154,15 @@ void Player::setVAO() {
 	};
 
   unsigned int VBO;
-	glGenVertexArrays(1, &m_VAO);
-	glGenBuffers(1, &VBO);
-	glBindVertexArray(m_VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(v), v, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3*sizeof(float)));
-	glEnableVertexAttribArray(1);
+	abcg::glGenVertexArrays(1, &m_VAO);
+	abcg::glGenBuffers(1, &VBO);
+	abcg::glBindVertexArray(m_VAO);
+	abcg::glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(v), v, GL_STATIC_DRAW);
+	abcg::glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	abcg::glEnableVertexAttribArray(0);
+  abcg::glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3*sizeof(float)));
+	abcg::glEnableVertexAttribArray(1);
 }
 
 //Carregamento da textura
@@ -169,10 +171,10 @@ void Player::loadTexture(){
   
   GLuint data = abcg::loadOpenGLTexture({.path = m_assetsPath + "./texture/cubo.jpg"});
   if(data){
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     //Atribuição da variável m_textura que posterioremente será utilizada para renderizar o player
     m_texture = data;
@@ -8,7 +8,7 @@
 
 class Player {
 public:
-  void create(GLuint program);
+  void create(std::shared_ptr<abcg::OpenGLSharedProgram> program);
   void paint(glm::vec3 scale, glm::vec3 rotation);
   void update(GameData m_gameData);
   void destroy();
@@ -18,7 +18,10 @@ public:
 private:
   GLuint m_VAO{};
   
-  GLuint m_program{};
+  std::shared_ptr<abcg::OpenGLSharedProgram> m_program;
+  abcg::OpenGLProgram::Uniform m_projUniform{};
+  abcg::OpenGLProgram::Uniform m_viewUniform{};
+  abcg::OpenGLProgram::Uniform m_modelUniform{};
   Camera m_camera;
   
   unsigned int m_texture;
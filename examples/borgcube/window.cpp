@@ -44,69 +44,65 @@ void Window::onCreate() {
     throw abcg::RuntimeError{"Cannot load font file"};
   }
 
-  //Criação dos programas OpenGL utilizando os respectivos shaders
-  m_program = abcg::createOpenGLProgram({{.source = m_assetsPath + "./shaders/main.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "./shaders/main.frag", .stage = abcg::ShaderStage::Fragment}});
-  m_playerProgram = abcg::createOpenGLProgram({{.source = m_assetsPath + "./shaders/obj.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "./shaders/obj.frag", .stage = abcg::ShaderStage::Fragment}});
-  m_obstacleProgram = abcg::createOpenGLProgram({{.source = m_assetsPath + "./shaders/obj.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "./shaders/obj.frag", .stage = abcg::ShaderStage::Fragment}});
+  //A semente do gerador de números aleatórios vem do framework, para que as execuções gravadas com --record sejam reproduzidas com --replay
+  std::srand(static_cast<unsigned int>(abcg::Application::getSettings().randomSeed));
+
+  //Criação dos programas OpenGL utilizando os respectivos shaders. Os programas são compilados e ligados em paralelo pelo registro da janela,
+  //enquanto onPaint exibe a tela de carregamento. O programa do player e o dos obstáculos são o mesmo, compilado uma única vez
+  auto &registry{getProgramRegistry()};
+  m_program = registry.request({{.source = m_assetsPath + "./shaders/main.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "./shaders/main.frag", .stage = abcg::ShaderStage::Fragment}});
+  m_playerProgram = registry.request({{.source = m_assetsPath + "./shaders/obj.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "./shaders/obj.frag", .stage = abcg::ShaderStage::Fragment}});
+  m_obstacleProgram = registry.request({{.source = m_assetsPath + "./shaders/obj.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "./shaders/obj.frag", .stage = abcg::ShaderStage::Fragment}});
 
   //Limpa a janela com a cor definida
   glClearColor(17.0f/255.0f, 21.0f/255.0f, 28.0f/255.0f, 0);
 
   abcg::glEnable(GL_DEPTH_TEST);
+}
 
-  //Chamada dos métodos create() para que os programas OpenGL sejam utilizados nas respectivas classes
+//Chamada dos métodos create() para que os programas OpenGL sejam utilizados nas respectivas classes, assim que os programas ficam prontos
+void Window::finishLoading() {
   m_player.create(m_playerProgram);
   m_obstacle.create(m_obstacleProgram);
+
+  m_gameTime.restart();
+  m_loaded = true;
 }
 
 void Window::onPaint() {
-  //Comportamento quando está jogando
-  if (m_gameData.m_state == State::Playing) {
-
-    //Interface é renderizada baseada em tempo ao invés do hardware, para minimizar a diferença entre dispositivos diferentes
-    if (m_deltaTime.elapsed() < 0.01) {
-      return;
-    }
+  //Limpa a janela e define os viewports
+  glClearColor(17.0f/255.0f, 21.0f/255.0f, 28.0f/255.0f, 0);
+  abcg::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  abcg::glViewport(0, 0, m_viewportSize.x, m_viewportSize.y);
 
-    //Reinicia o tempo ao entrar
-    m_deltaTime.restart();
-
-    //Limpa a janela e define os viewports
-    glClearColor(17.0f/255.0f, 21.0f/255.0f, 28.0f/255.0f, 0);
-    abcg::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    abcg::glViewport(0, 0, m_viewportSize.x, m_viewportSize.y);
-
-    //Utilizado para piscar o player, quando o tempo de colisão está no início, não printamos o player na tela em alguns intervalos
-    if(
-      (m_collisionTime.elapsed() >= 0.0 && m_collisionTime.elapsed() < 0.1) || 
-      (m_collisionTime.elapsed() >= 0.2 && m_collisionTime.elapsed() < 0.3) ||
-      (m_collisionTime.elapsed() >= 0.4 && m_collisionTime.elapsed() < 0.5)
-    ) {} else {
-      m_player.paint(glm::vec3(0.8f), glm::vec3(0, 0, 0));  
-    }
-
-    //A criação dos obstáculos possui seu próprio timer, eles são criados a cada 1 segundo
-    if (m_obstacleTime.elapsed() > 1) {
-      createObstacle();
-      m_obstacleTime.restart();
+  //Enquanto os programas não estão prontos, apenas exibimos a tela de carregamento
+  if (!m_loaded) {
+    if (m_program->isReady() && m_playerProgram->isReady() && m_obstacleProgram->isReady()) {
+      finishLoading();
     }
+    return;
+  }
 
-    //Renderizacao de todos os obstaculos, sempre incrementando a pos z para avançar em direção ao player
-    for(int i = 0; i < m_gameData.m_obstaclesCount; i++){
-      m_gameData.m_obstaclesPositions[i].z += 0.5;
-      m_obstacle.paint(m_gameData.m_obstaclesPositions[i], glm::vec3(1.f), glm::vec3(1000 * m_gameTime.elapsed()));
-    }
-  } else if (m_gameData.m_state == State::GameOver) {
+  //Quando estamos no estado GameOver, não printamos o player nem os obstáculos
+  if (m_gameData.m_state != State::Playing) {
+    return;
+  }
 
-    //Quando estamos no estado GameOver, não printamos o player nem os obstáculos
-    glClearColor(17.0f/255.0f, 21.0f/255.0f, 28.0f/255.0f, 0);
-    abcg::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    abcg::glViewport(0, 0, m_viewportSize.x, m_viewportSize.y);
+  //Utilizado para piscar o player, quando o tempo de colisão está no início, não printamos o player na tela em alguns intervalos
+  if(
+    (m_collisionTime.elapsed() >= 0.0 && m_collisionTime.elapsed() < 0.1) || 
+    (m_collisionTime.elapsed() >= 0.2 && m_collisionTime.elapsed() < 0.3) ||
+    (m_collisionTime.elapsed() >= 0.4 && m_collisionTime.elapsed() < 0.5)
+  ) {} else {
+    m_player.paint(glm::vec3(0.8f), glm::vec3(0, 0, 0));  
+  }
 
-    //Reinicie após 3 segundos
-    if(m_deltaTime.elapsed() > 3){
-      restart();
-    }
+  //Renderizacao de todos os obstaculos. A posição z é interpolada entre o passo de simulação anterior e o atual
+  auto const alpha{static_cast<float>(getInterpolationAlpha())};
+  for(int i = 0; i < m_gameData.m_obstaclesCount; i++){
+    auto position{m_gameData.m_obstaclesPositions[i]};
+    position.z -= 0.5f * (1.0f - alpha);
+    m_obstacle.paint(position, glm::vec3(1.f), glm::vec3(1000 * m_gameTime.elapsed()));
   }
 }
 
@@ -118,25 +114,41 @@ void Window::restart() {
   m_gameData.m_obstaclesCount = 0;
   m_gameData.m_lastHitIndex = -1;
   m_gameData.m_state = State::Playing;
-  m_deltaTime.restart();
-  m_obstacleTime.restart();
+  m_obstacleTime = 0.0;
+  m_gameOverTime = 0.0;
 }
 
-void Window::onUpdate() {
+//A simulação avança em passos fixos de 0.01s (definidos em main.cpp), independentemente da taxa de quadros
+void Window::onFixedUpdate(double deltaTime) {
+  //O jogo só começa depois do carregamento
+  if (!m_loaded) {
+    return;
+  }
+
   if (m_gameData.m_state == State::Playing){
-      
-  // interface update are based on time elapsed instead of hardware
-    if (m_updateTime.elapsed() < 0.01) {
-      return;
+    m_player.update(m_gameData);
+
+    //A criação dos obstáculos possui seu próprio contador de tempo, eles são criados a cada 1 segundo
+    m_obstacleTime += deltaTime;
+    if (m_obstacleTime > 1) {
+      createObstacle();
+      m_obstacleTime = 0.0;
+    }
+
+    //Incrementa a posição z dos obstáculos para avançar em direção ao player
+    for(int i = 0; i < m_gameData.m_obstaclesCount; i++){
+      m_gameData.m_obstaclesPositions[i].z += 0.5;
     }
 
-    m_player.update(m_gameData);
-    m_updateTime.restart();
     checkCollision();
     checkDeath();
 
   } else if (m_gameData.m_state == State::GameOver){
-    m_updateTime.restart();
+    //Reinicie após 3 segundos
+    m_gameOverTime += deltaTime;
+    if (m_gameOverTime > 3) {
+      restart();
+    }
   }
 }
 
@@ -149,6 +161,17 @@ void Window::onPaintUI() {
     ImGui::SetNextWindowSize(size);
     ImGuiWindowFlags const flags{ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoInputs};
     ImGui::PushFont(m_font);
+
+    //Tela de carregamento exibida enquanto os programas são compilados
+    if(!m_loaded){
+      auto const position{ImVec2((m_viewportSize.x - size.x) / 2.0f, (m_viewportSize.y - size.y) / 2.0f)};
+      ImGui::SetNextWindowPos(position);
+      ImGui::Begin(" ", nullptr, flags);
+      ImGui::Text("Carregando...");
+      ImGui::PopFont();
+      ImGui::End();
+      return;
+    }
     
     //Caso o estado do jogo seja "GameOver" então renderizamos a mensagem na tela
     if(m_gameData.m_state == State::GameOver){
@@ -175,9 +198,10 @@ void Window::onResize(glm::ivec2 const &size) {
 
 //Liberação dos recursos alocados durante a aplicação
 void Window::onDestroy() {
-  abcg::glDeleteProgram(m_program);
-  abcg::glDeleteProgram(m_playerProgram);
-  abcg::glDeleteProgram(m_obstacleProgram);
+  //Os programas são liberados pelo registro quando a última referência é descartada
+  m_program.reset();
+  m_playerProgram.reset();
+  m_obstacleProgram.reset();
   m_player.destroy();
   m_obstacle.destroy();
 }
@@ -192,6 +216,7 @@ void Window::createObstacle() {
 //Valida se houve colisão entre o player ou algum objeto, para isso percorremos o vetor de posição dos obstáculos e comparamos as respectivas posições x e z 
 //com as do player. Logo em seguida, incrementamos a quantidade de colisões e reiniciamos o timer da colisão, que será utilizado futuramente no método paint() para demonstrar que o player foi acertado
 void Window::checkCollision() {
+  ABCG_PROFILE_SCOPE("checkCollision");
   for (int i = 0; i < m_gameData.m_obstaclesCount; i++){
     glm::vec3 currentPosition = m_gameData.m_obstaclesPositions[i];
     if(currentPosition.x < m_player.m_pos.x + 1.f && currentPosition.x > m_player.m_pos.x - 1.f && currentPosition.z < m_player.m_pos.z + 1.f && currentPosition.z > m_player.m_pos.z - 1.f &&  m_gameData.m_lastHitIndex != i){
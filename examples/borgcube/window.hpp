@@ -5,6 +5,7 @@
 #include "gamedata.hpp"
 #include "player.hpp"
 #include "obstacle.hpp"
+#include <atomic>
 #include <string>
 
 class Window : public abcg::OpenGLWindow {
@@ -13,7 +14,7 @@ protected:
   void onCreate() override;
   void onPaint() override;
   void onPaintUI() override;
-  void onUpdate() override;
+  void onFixedUpdate(double deltaTime) override;
   void onResize(glm::ivec2 const &size) override;
   void onDestroy() override;
 
@@ -27,15 +28,21 @@ private:
   ImFont *m_font{};
   
   abcg::Timer m_gameTime;
-  abcg::Timer m_deltaTime;
-  abcg::Timer m_updateTime; 
-  abcg::Timer m_obstacleTime;
   abcg::Timer m_collisionTime;
 
-  GLuint m_program{};
-  GLuint m_playerProgram{};
-  GLuint m_obstacleProgram{};
+  //Tempo de simulação acumulado desde a criação do último obstáculo e desde o GameOver
+  double m_obstacleTime{};
+  double m_gameOverTime{};
 
+  //Programas compartilhados pelo registro da janela: player e obstáculos utilizam os mesmos shaders e, portanto, o mesmo programa
+  std::shared_ptr<abcg::OpenGLSharedProgram> m_program;
+  std::shared_ptr<abcg::OpenGLSharedProgram> m_playerProgram;
+  std::shared_ptr<abcg::OpenGLSharedProgram> m_obstacleProgram;
+
+  //Indica que os programas já foram ligados e que os objetos foram criados
+  std::atomic<bool> m_loaded{};
+
+  void finishLoading();
   void createObstacle();
   void checkCollision();
   void checkDeath();
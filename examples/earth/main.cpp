@@ -6,7 +6,13 @@ int main(int argc, char **argv) {
 
     Window window;
     window.setOpenGLSettings({.samples = 4});
-    window.setWindowSettings({.width = 600, .height = 600, .showFPS = false, .title = "Earth"});
+    window.setWindowSettings({.width = 600, .height = 600, .showFPS = false, .title = "Earth", .targetFPS = 60.0});
+    // Benchmark scenario: zoom in and out
+    abcg::BenchmarkScenario scenario;
+    for (auto const frame : iter::range(0, 60, 10)) {
+      scenario.mouseWheel(frame, 1).mouseWheel(frame + 60, -1);
+    }
+    app.setBenchmarkScenario(scenario.loop(120));
     app.run(window);
   } catch (std::exception const &exception) {
     fmt::print(stderr, "{}\n", exception.what());
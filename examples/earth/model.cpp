@@ -1,6 +1,7 @@
 #include "model.hpp"
 
 #include <filesystem>
+#include <fstream>
 #include <unordered_map>
 #include <iostream>
 
@@ -16,24 +17,39 @@ template <> struct std::hash<Vertex> {
   }
 };
 
-void Model::loadDiffuseTexture(std::string_view path) {
+void Model::loadDiffuseTexture(abcg::OpenGLTextureStreamer &streamer, std::string_view path) {
 
   // if file on path does not exist, return
   if (!std::filesystem::exists(path))
     return;
 
-  // release previous texture
-  abcg::glDeleteTextures(1, &m_diffuseTexture);
-
-  // load new texture with given path
-  m_diffuseTexture = abcg::loadOpenGLTexture({.path = path});
+  // request new texture with given path; the previous texture is released
+  // and a placeholder is bound until the new one is uploaded
+  m_diffuseTexture = streamer.request({.path = path});
 }
 
-void Model::loadObj(std::string_view path, bool standardize) {
+void Model::loadObj(abcg::JobSystem &jobSystem, abcg::OpenGLTextureStreamer &streamer, std::string_view path, bool standardize) {
 
   // get path from object
   auto const basePath{std::filesystem::path{path}.parent_path().string() + "/"};
 
+  // use the mesh baked by abcg_bake if there is one: its vertices are uploaded
+  // straight from the mapped file, so only the material file is parsed
+  if (auto const bakedPath{abcg::findBakedAsset(path)}; !bakedPath.empty() && loadBakedMesh(bakedPath, standardize)) {
+
+    // load material file with the same name as the object
+    std::vector<tinyobj::material_t> materials;
+    std::ifstream stream{std::filesystem::path{path}.replace_extension(".mtl")};
+    if (stream) {
+      std::map<std::string, int> materialMap;
+      std::string warning;
+      std::string error;
+      tinyobj::LoadMtl(&materialMap, &materials, &stream, &warning, &error);
+    }
+    applyMaterial(streamer, materials, basePath);
+    return;
+  }
+
   // load material file
   tinyobj::ObjReaderConfig readerConfig;
   readerConfig.mtl_search_path = basePath;
@@ -106,6 +122,22 @@ void Model::loadObj(std::string_view path, bool standardize) {
     }
   }
 
+  applyMaterial(streamer, materials, basePath);
+
+  // standardize our object based on our pipeline
+  if (standardize) {
+    Model::standardize(jobSystem);
+  }
+
+  // compute normal values from object
+  computeNormals(jobSystem);
+
+  // create VBO and EBO buffers
+  createBuffers(std::as_bytes(std::span{m_vertices}), m_indices);
+}
+
+void Model::applyMaterial(abcg::OpenGLTextureStreamer &streamer, std::vector<tinyobj::material_t> const &materials, std::string const &basePath) {
+
   // use properties of first material
   if (!materials.empty()) {
     auto const &mat{materials.at(0)};
@@ -116,7 +148,7 @@ void Model::loadObj(std::string_view path, bool standardize) {
 
     // load texture from material
     if (!mat.diffuse_texname.empty()) {
-      loadDiffuseTexture(basePath + mat.diffuse_texname);
+      loadDiffuseTexture(streamer, basePath + mat.diffuse_texname);
     }
   } 
 
@@ -127,20 +159,31 @@ void Model::loadObj(std::string_view path, bool standardize) {
     m_Ks = {1.0f, 1.0f, 1.0f, 1.0f};
     m_shininess = 25.0f;
   }
+}
 
-  // standardize our object based on our pipeline
-  if (standardize) {
-    Model::standardize();
-  }
+bool Model::loadBakedMesh(std::string const &path, bool standardize) {
 
-  // compute normal values from object
-  computeNormals();
+  // map baked file; vertices and indices are uploaded in place
+  abcg::BakedAsset baked;
+  baked.open(path);
 
-  // create VBO and EBO buffers
-  createBuffers();
+  // use baked mesh only if abcg_bake already computed the normals and positions
+  // as computeNormals and standardize do (see CMakeLists.txt)
+  auto const &header{baked.getHeader()};
+  auto const standardized{(header.flags & abcg::BakedAssetHeader::Standardized) != 0};
+  if (header.kind != abcg::BakedAssetKind::Mesh || (header.flags & abcg::BakedAssetHeader::RecomputedNormals) == 0 || standardized != standardize) {
+    return false;
+  }
+
+  // vertex layout matches abcg::BakedVertex
+  static_assert(sizeof(Vertex) == sizeof(abcg::BakedVertex));
+  m_vertices.clear();
+  m_indices.clear();
+  createBuffers(std::as_bytes(baked.getVertices()), baked.getIndices());
+  return true;
 }
 
-void Model::computeNormals() {
+void Model::computeNormals(abcg::JobSystem &jobSystem) {
 
   // clear previous vertices
   for (auto &vertex : m_vertices) {
@@ -148,7 +191,7 @@ void Model::computeNormals() {
   }
 
   // compute face normals
-  for (auto const offset : iter::range(0ULL, m_indices.size() , 3ULL)) {
+  for (auto const offset : iter::range(std::size_t{0}, m_indices.size() , std::size_t{3})) {
 
     // get face vertices
     auto &a{m_vertices.at(m_indices.at(offset + 0))};
@@ -166,13 +209,14 @@ void Model::computeNormals() {
     c.normal += normal;
   }
 
-  // normalize vertices
-  for (auto &vertex : m_vertices) {
-    vertex.normal = glm::normalize(vertex.normal);
-  }
+  // normalize vertices; each vertex is independent, so the mesh is split
+  // across the workers of the job system
+  jobSystem.wait(jobSystem.parallelFor(0, m_vertices.size(), [this](std::size_t i) {
+    m_vertices[i].normal = glm::normalize(m_vertices[i].normal);
+  }));
 }
 
-void Model::createBuffers() {
+void Model::createBuffers(std::span<std::byte const> vertices, std::span<GLuint const> indices) {
 
   // release previous element and array buffer
   abcg::glDeleteBuffers(1, &m_EBO);
@@ -181,14 +225,15 @@ void Model::createBuffers() {
   // generate VBO
   abcg::glGenBuffers(1, &m_VBO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-  abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices.at(0)) * m_vertices.size(), m_vertices.data(), GL_STATIC_DRAW);
+  abcg::glBufferData(GL_ARRAY_BUFFER, vertices.size_bytes(), vertices.data(), GL_STATIC_DRAW);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
 
   // generate EBO
   abcg::glGenBuffers(1, &m_EBO);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-  abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_indices.at(0)) * m_indices.size(), m_indices.data(), GL_STATIC_DRAW);
+  abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size_bytes(), indices.data(), GL_STATIC_DRAW);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  m_indexCount = indices.size();
 }
 
 void Model::render() const {
@@ -196,7 +241,7 @@ void Model::render() const {
   // create VAO and bind vertex attributes and texture to current VAO
   abcg::glBindVertexArray(m_VAO);
   abcg::glActiveTexture(GL_TEXTURE0);
-  abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+  abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture ? m_diffuseTexture->getID() : 0);
 
   // set minification and magnification parameters
   abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -207,13 +252,13 @@ void Model::render() const {
   abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
   // draw elements
-  abcg::glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, nullptr);
+  abcg::glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr);
 
   // end of binding to current VAO
   abcg::glBindVertexArray(0);
 }
 
-void Model::setupVAO(GLuint program) {
+void Model::setupVAO(abcg::OpenGLProgram const &program) {
 
   // release previous VAO
   abcg::glDeleteVertexArrays(1, &m_VAO);
@@ -227,20 +272,20 @@ void Model::setupVAO(GLuint program) {
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
   // bind vertex attributes
-  auto const positionAttribute{ abcg::glGetAttribLocation(program, "inPosition") };
+  auto const positionAttribute{ program.getAttributeLocation("inPosition") };
   if (positionAttribute >= 0) {
     abcg::glEnableVertexAttribArray(positionAttribute);
     abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
   }
 
-  auto const normalAttribute{ abcg::glGetAttribLocation(program, "inNormal") };
+  auto const normalAttribute{ program.getAttributeLocation("inNormal") };
   if (normalAttribute >= 0) {
     abcg::glEnableVertexAttribArray(normalAttribute);
     auto const offset{offsetof(Vertex, normal)};
     abcg::glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE,  sizeof(Vertex), reinterpret_cast<void *>(offset));
   }
 
-  auto const texCoordAttribute{ abcg::glGetAttribLocation(program, "inTexCoord") };
+  auto const texCoordAttribute{ program.getAttributeLocation("inTexCoord") };
   if (texCoordAttribute >= 0) {
     abcg::glEnableVertexAttribArray(texCoordAttribute);
     auto const offset{offsetof(Vertex, texCoord)};
@@ -252,7 +297,7 @@ void Model::setupVAO(GLuint program) {
   abcg::glBindVertexArray(0);
 }
 
-void Model::standardize() {
+void Model::standardize(abcg::JobSystem &jobSystem) {
   glm::vec3 max(std::numeric_limits<float>::lowest());
   glm::vec3 min(std::numeric_limits<float>::max());
   for (auto const &vertex : m_vertices) {
@@ -262,15 +307,15 @@ void Model::standardize() {
 
   auto const center{(min + max) / 2.0f};
   auto const scaling{2.0f / glm::length(max - min)};
-  for (auto &vertex : m_vertices) {
-    vertex.position = (vertex.position - center) * scaling;
-  }
+  jobSystem.wait(jobSystem.parallelFor(0, m_vertices.size(), [this, center, scaling](std::size_t i) {
+    m_vertices[i].position = (m_vertices[i].position - center) * scaling;
+  }));
 }
 
-void Model::destroy() const {
+void Model::destroy() {
 
   // release opengl resources that were allocated during application
-  abcg::glDeleteTextures(1, &m_diffuseTexture);
+  m_diffuseTexture.reset();
   abcg::glDeleteBuffers(1, &m_EBO);
   abcg::glDeleteBuffers(1, &m_VBO);
   abcg::glDeleteVertexArrays(1, &m_VAO);
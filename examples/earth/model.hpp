@@ -1,6 +1,8 @@
 #ifndef MODEL_HPP_
 #define MODEL_HPP_
 
+#include <span>
+
 #include "abcgOpenGL.hpp"
 
 struct Vertex {
@@ -13,14 +15,14 @@ struct Vertex {
 
 class Model {
 public:
-  void loadDiffuseTexture(std::string_view path);
-  void loadObj(std::string_view path, bool standardize = true);
+  void loadDiffuseTexture(abcg::OpenGLTextureStreamer &streamer, std::string_view path);
+  void loadObj(abcg::JobSystem &jobSystem, abcg::OpenGLTextureStreamer &streamer, std::string_view path, bool standardize = true);
   void render() const;
-  void setupVAO(GLuint program);
-  void destroy() const;
+  void setupVAO(abcg::OpenGLProgram const &program);
+  void destroy();
 
   [[nodiscard]] int getNumTriangles() const {
-    return gsl::narrow<int>(m_indices.size()) / 3;
+    return gsl::narrow<int>(m_indexCount) / 3;
   }
 
   [[nodiscard]] glm::vec4 getKa() const { return m_Ka; }
@@ -37,14 +39,17 @@ private:
   glm::vec4 m_Kd{};
   glm::vec4 m_Ks{};
   float m_shininess{};
-  GLuint m_diffuseTexture{};
+  std::shared_ptr<abcg::OpenGLStreamedTexture> m_diffuseTexture;
 
   std::vector<Vertex> m_vertices;
   std::vector<GLuint> m_indices;
+  std::size_t m_indexCount{};
 
-  void computeNormals();
-  void createBuffers();
-  void standardize();
+  void applyMaterial(abcg::OpenGLTextureStreamer &streamer, std::vector<tinyobj::material_t> const &materials, std::string const &basePath);
+  void computeNormals(abcg::JobSystem &jobSystem);
+  void createBuffers(std::span<std::byte const> vertices, std::span<GLuint const> indices);
+  bool loadBakedMesh(std::string const &path, bool standardize);
+  void standardize(abcg::JobSystem &jobSystem);
 };
 
 #endif
\ No newline at end of file
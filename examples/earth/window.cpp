@@ -21,7 +21,23 @@ void Window::onCreate() {
   abcg::glEnable(GL_DEPTH_TEST);
 
   // create an OpenGl program using earth.vert and earth.frag
-  m_program = abcg::createOpenGLProgram({{.source = m_assetsPath + "earth.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "earth.frag", .stage = abcg::ShaderStage::Fragment}});
+  m_program.create({{.source = m_assetsPath + "earth.vert", .stage = abcg::ShaderStage::Vertex}, {.source = m_assetsPath + "earth.frag", .stage = abcg::ShaderStage::Fragment}});
+
+  // get handles of uniform variables once
+  m_viewMatrixUniform = m_program.getUniform("viewMatrix");
+  m_projMatrixUniform = m_program.getUniform("projMatrix");
+  m_modelMatrixUniform = m_program.getUniform("modelMatrix");
+  m_normalMatrixUniform = m_program.getUniform("normalMatrix");
+  m_lightDirUniform = m_program.getUniform("lightDirWorldSpace");
+  m_shininessUniform = m_program.getUniform("shininess");
+  m_IaUniform = m_program.getUniform("Ia");
+  m_IdUniform = m_program.getUniform("Id");
+  m_IsUniform = m_program.getUniform("Is");
+  m_KaUniform = m_program.getUniform("Ka");
+  m_KdUniform = m_program.getUniform("Kd");
+  m_KsUniform = m_program.getUniform("Ks");
+  m_diffuseTexUniform = m_program.getUniform("diffuseTex");
+  m_mappingModeUniform = m_program.getUniform("mappingMode");
   
   // load model using earth.obj
   loadModel(m_assetsPath + "earth.obj");
@@ -32,10 +48,10 @@ void Window::loadModel(std::string_view path) {
   m_model.destroy();
 
   // load texture (earth.jpg)
-  m_model.loadDiffuseTexture(m_assetsPath + "earth.jpg");
+  m_model.loadDiffuseTexture(getTextureStreamer(), m_assetsPath + "earth.jpg");
 
   // load object (earth.obj)
-  m_model.loadObj(path);
+  m_model.loadObj(getJobSystem(), getTextureStreamer(), path);
   m_model.setupVAO(m_program);
 
   // use material properties from the loaded model
@@ -75,50 +91,35 @@ void Window::onPaint() {
   auto const aspect{gsl::narrow<float>(m_viewportSize.x) / gsl::narrow<float>(m_viewportSize.y)};
   m_projMatrix = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 5.0f);
 
-  // get location of uniform variables
-  auto const viewMatrixLoc{abcg::glGetUniformLocation(m_program, "viewMatrix")};
-  auto const projMatrixLoc{abcg::glGetUniformLocation(m_program, "projMatrix")};
-  auto const modelMatrixLoc{abcg::glGetUniformLocation(m_program, "modelMatrix")};
-  auto const normalMatrixLoc{abcg::glGetUniformLocation(m_program, "normalMatrix")};
-  auto const lightDirLoc{abcg::glGetUniformLocation(m_program, "lightDirWorldSpace")};
-  auto const shininessLoc{abcg::glGetUniformLocation(m_program, "shininess")};
-  auto const IaLoc{abcg::glGetUniformLocation(m_program, "Ia")};
-  auto const IdLoc{abcg::glGetUniformLocation(m_program, "Id")};
-  auto const IsLoc{abcg::glGetUniformLocation(m_program, "Is")};
-  auto const KaLoc{abcg::glGetUniformLocation(m_program, "Ka")};
-  auto const KdLoc{abcg::glGetUniformLocation(m_program, "Kd")};
-  auto const KsLoc{abcg::glGetUniformLocation(m_program, "Ks")};
-  auto const diffuseTexLoc{abcg::glGetUniformLocation(m_program, "diffuseTex")};
-  auto const mappingModeLoc{abcg::glGetUniformLocation(m_program, "mappingMode")};
+  // activate shaders before setting the uniform variables
+  m_program.use();
 
   // set uniform variables that have the same value for every model
-  abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_viewMatrix[0][0]);
-  abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_projMatrix[0][0]);
-  abcg::glUniform1i(diffuseTexLoc, 0);
-  abcg::glUniform1i(mappingModeLoc, 3);
+  // (values that did not change since the last frame are not sent again)
+  m_program.setUniform(m_viewMatrixUniform, m_viewMatrix);
+  m_program.setUniform(m_projMatrixUniform, m_projMatrix);
+  m_program.setUniform(m_diffuseTexUniform, 0);
+  m_program.setUniform(m_mappingModeUniform, 3);
 
   auto const lightDirRotated{m_modelMatrix * m_lightDir};
-  abcg::glUniform4fv(lightDirLoc, 1, &lightDirRotated.x);
-  abcg::glUniform4fv(IaLoc, 1, &m_Ia.x);
-  abcg::glUniform4fv(IdLoc, 1, &m_Id.x);
-  abcg::glUniform4fv(IsLoc, 1, &m_Is.x);
+  m_program.setUniform(m_lightDirUniform, lightDirRotated);
+  m_program.setUniform(m_IaUniform, m_Ia);
+  m_program.setUniform(m_IdUniform, m_Id);
+  m_program.setUniform(m_IsUniform, m_Is);
 
   // set uniform variables for the current model
-  abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &m_modelMatrix[0][0]);
-  abcg::glUniform4fv(KaLoc, 1, &m_Ka.x);
-  abcg::glUniform4fv(KdLoc, 1, &m_Kd.x);
-  abcg::glUniform4fv(KsLoc, 1, &m_Ks.x);
-  abcg::glUniform1f(shininessLoc, m_shininess);
+  m_program.setUniform(m_modelMatrixUniform, m_modelMatrix);
+  m_program.setUniform(m_KaUniform, m_Ka);
+  m_program.setUniform(m_KdUniform, m_Kd);
+  m_program.setUniform(m_KsUniform, m_Ks);
+  m_program.setUniform(m_shininessUniform, m_shininess);
 
   auto const modelViewMatrix{glm::mat3(m_viewMatrix * m_modelMatrix)};
   auto const normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-  abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
+  m_program.setUniform(m_normalMatrixUniform, normalMatrix);
 
   // rendering the model
   m_model.render();
-
-  // activate shaders
-  abcg::glUseProgram(m_program);
 }
 
 void Window::onResize(glm::ivec2 const &size) {
@@ -129,5 +130,5 @@ void Window::onResize(glm::ivec2 const &size) {
 void Window::onDestroy() {
   // release opengl resources that were allocated during application
   m_model.destroy();
-  abcg::glDeleteProgram(m_program);
+  m_program.destroy();
 }
\ No newline at end of file
@@ -18,7 +18,23 @@ private:
   glm::ivec2 m_viewportSize{};
 
   Model m_model;
-  GLuint m_program;
+  abcg::OpenGLProgram m_program;
+
+  // handles of uniform variables
+  abcg::OpenGLProgram::Uniform m_viewMatrixUniform{};
+  abcg::OpenGLProgram::Uniform m_projMatrixUniform{};
+  abcg::OpenGLProgram::Uniform m_modelMatrixUniform{};
+  abcg::OpenGLProgram::Uniform m_normalMatrixUniform{};
+  abcg::OpenGLProgram::Uniform m_lightDirUniform{};
+  abcg::OpenGLProgram::Uniform m_shininessUniform{};
+  abcg::OpenGLProgram::Uniform m_IaUniform{};
+  abcg::OpenGLProgram::Uniform m_IdUniform{};
+  abcg::OpenGLProgram::Uniform m_IsUniform{};
+  abcg::OpenGLProgram::Uniform m_KaUniform{};
+  abcg::OpenGLProgram::Uniform m_KdUniform{};
+  abcg::OpenGLProgram::Uniform m_KsUniform{};
+  abcg::OpenGLProgram::Uniform m_diffuseTexUniform{};
+  abcg::OpenGLProgram::Uniform m_mappingModeUniform{};
   
   float m_angle{};
   float m_zoom{};
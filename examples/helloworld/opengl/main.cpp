@@ -8,7 +8,19 @@ int main(int argc, char **argv) {
     // Create OpenGL window
     Window window;
     window.setWindowSettings(
-        {.width = 600, .height = 600, .title = "Hello, World!"});
+        {.width = 600,
+         .height = 600,
+         .title = "Hello, World!",
+         .targetFPS = 60.0});
+
+    // Toggle the demo window and move the mouse over the widgets when
+    // running a benchmark
+    app.setBenchmarkScenario(abcg::BenchmarkScenario{}
+                                 .mouseClick(10, {24, 152})
+                                 .mouseMove(40, {200, 300})
+                                 .mouseMove(80, {400, 150})
+                                 .mouseClick(110, {24, 152})
+                                 .loop(120));
 
     // Run application
     app.run(window);
@@ -4,13 +4,14 @@ void Window::onCreate() {
   // Enable Z-buffer test
   abcg::glEnable(GL_DEPTH_TEST);
 
-  // Create shader program
+  // Create shader program. Programs of the registry are rebuilt when their
+  // files change if the application is run with --hot-reload
   auto const path{abcg::Application::getAssetsPath()};
-  m_program =
-      abcg::createOpenGLProgram({{.source = path + "UnlitVertexColor.vert",
-                                  .stage = abcg::ShaderStage::Vertex},
-                                 {.source = path + "UnlitVertexColor.frag",
-                                  .stage = abcg::ShaderStage::Fragment}});
+  m_program = getProgramRegistry().load(
+      {{.source = path + "UnlitVertexColor.vert",
+        .stage = abcg::ShaderStage::Vertex},
+       {.source = path + "UnlitVertexColor.frag",
+        .stage = abcg::ShaderStage::Fragment}});
 
   // clang-format off
   std::array const vertices{glm::vec2(0.0f, 0.5f),
@@ -39,8 +40,9 @@ void Window::onCreate() {
 
   // Get location of attributes in the program
   auto const positionAttribute{
-      abcg::glGetAttribLocation(m_program, "inPosition")};
-  auto const colorAttribute{abcg::glGetAttribLocation(m_program, "inColor")};
+      abcg::glGetAttribLocation(m_program->getID(), "inPosition")};
+  auto const colorAttribute{
+      abcg::glGetAttribLocation(m_program->getID(), "inColor")};
 
   // Create VAO
   abcg::glGenVertexArrays(1, &m_vao);
@@ -75,7 +77,7 @@ void Window::onPaint() {
   abcg::glViewport(0, 0, m_viewportSize.x, m_viewportSize.y);
 
   // Start using the shader program
-  abcg::glUseProgram(m_program);
+  abcg::glUseProgram(m_program->getID());
   // Start using the VAO
   abcg::glBindVertexArray(m_vao);
 
@@ -170,7 +172,7 @@ void Window::onResize(glm::ivec2 const &size) { m_viewportSize = size; }
 
 void Window::onDestroy() {
   // Release OpenGL resources
-  abcg::glDeleteProgram(m_program);
+  m_program.reset();
   abcg::glDeleteBuffers(1, &m_vboVertices);
   abcg::glDeleteBuffers(1, &m_vboColors);
   abcg::glDeleteVertexArrays(1, &m_vao);
@@ -15,7 +15,7 @@ private:
   GLuint m_vao{};
   GLuint m_vboVertices{};
   GLuint m_vboColors{};
-  GLuint m_program{};
+  std::shared_ptr<abcg::OpenGLSharedProgram> m_program;
 
   glm::ivec2 m_viewportSize{};
 
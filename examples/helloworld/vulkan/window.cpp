@@ -29,10 +29,15 @@ void Window::onPaint(abcg::VulkanFrame const &frame) {
       vk::PipelineBindPoint::eGraphics,
       static_cast<vk::Pipeline>(m_graphicsPipeline));
 
-  // Record triangle drawing
-  frame.commandBuffer.bindVertexBuffers(
-      0, {static_cast<vk::Buffer>(m_vertexBuffer)}, {vk::DeviceSize{}});
-  frame.commandBuffer.draw(static_cast<uint32_t>(m_vertices.size()), 1, 0, 0);
+  // Record triangle drawing, measured in the GPU track of the profiler
+  {
+    abcg::VulkanGPUScope const gpuScope{getGPUTimer(), frame.commandBuffer,
+                                        "Triangle"};
+    frame.commandBuffer.bindVertexBuffers(
+        0, {static_cast<vk::Buffer>(m_vertexBuffer)}, {vk::DeviceSize{}});
+    frame.commandBuffer.draw(static_cast<uint32_t>(m_vertices.size()), 1, 0,
+                             0);
+  }
 
   frame.commandBuffer.endRenderPass();
 
@@ -151,6 +156,14 @@ void Window::createShaders() {
   m_fragmentShader.create(getDevice(),
                           {.source = assetsPath + "UnlitVertexColor.frag",
                            .stage = abcg::ShaderStage::Fragment});
+
+  // Recreate the pipeline when a shader is rebuilt by hot reload
+  auto const onReload{[this] {
+    destroyGraphicsPipeline();
+    createGraphicsPipeline();
+  }};
+  getShaderReloader().add(m_vertexShader, onReload);
+  getShaderReloader().add(m_fragmentShader, onReload);
 }
 
 void Window::destroyShaders() {
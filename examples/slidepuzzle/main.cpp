@@ -4,7 +4,15 @@ int main(int argc, char **argv) {
   try {
     abcg::Application app(argc, argv);
     Window window;
-    window.setWindowSettings({.width=480, .height=480, .title="Slidin'Puzzle"});
+    window.setWindowSettings({.width=480, .height=480, .title="Slidin'Puzzle", .targetFPS=60.0, .lazyRedraw=true});
+
+    // Benchmark scenario: click on each tile of the 3x3 board
+    abcg::BenchmarkScenario scenario;
+    for (auto const tile : iter::range(9)) {
+      scenario.mouseClick(tile * 10, {80 + (tile % 3) * 160, 140 + (tile / 3) * 125});
+    }
+    app.setBenchmarkScenario(scenario.loop(90));
+
     app.run(window);
 
   } catch (std::exception const &exception) {
@@ -10,6 +10,9 @@ void Window::onCreate() {
     throw abcg::RuntimeError{"Cannot load font file"};
   }
 
+  // Random seed from the framework, so that replays reproduce the board
+  m_randomEngine.seed(abcg::Application::getSettings().randomSeed);
+
   // Define default difficulty
   m_N = 3;
   m_board = easy_sequence;
@@ -181,9 +184,7 @@ void Window::onPaintUI() {
 
 void Window::shuffleBoard() {
   // Shuffle the array
-  std::random_device rd;
-  std::mt19937 g(rd());
-  std::shuffle(m_board.begin(), m_board.end(), g);
+  std::shuffle(m_board.begin(), m_board.end(), m_randomEngine);
 
   // Start the game
   m_gameState = GameState::Play;
@@ -1,6 +1,8 @@
 #ifndef WINDOW_HPP_
 #define WINDOW_HPP_
 
+#include <random>
+
 #include "abcgOpenGL.hpp"
 
 class Window : public abcg::OpenGLWindow {
@@ -20,6 +22,8 @@ private:
 
   ImFont *m_font{};
 
+  std::default_random_engine m_randomEngine;
+
   void winCheck();
   void shuffleBoard();
 };
@@ -15,8 +15,17 @@ int main(int argc, char **argv) {
       .showFPS = false,
       .showFullscreenButton = false,
       .title = "Snake Game",
+      .targetFPS = 60.0,
     });
 
+    // Benchmark scenario: move the snake in a square
+    app.setBenchmarkScenario(abcg::BenchmarkScenario{}
+                                 .keyPress(0, SDLK_UP)
+                                 .keyPress(60, SDLK_RIGHT)
+                                 .keyPress(120, SDLK_DOWN)
+                                 .keyPress(180, SDLK_LEFT)
+                                 .loop(240));
+
     app.run(window);
   } catch (std::exception const &exception) {
     fmt::print(stderr, "{}\n", exception.what());
@@ -41,8 +41,8 @@ void Window::onCreate() {
   abcg::glClearColor(0, 0, 0, 1);
   abcg::glClear(GL_COLOR_BUFFER_BIT);
 
-  // generate random seed
-  auto const seed{std::chrono::steady_clock::now().time_since_epoch().count()};
+  // random seed from the framework, so that replays reproduce the game
+  auto const seed{abcg::Application::getSettings().randomSeed};
   m_randomEngine.seed(seed);
 
   // call play function
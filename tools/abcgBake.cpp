@@ -0,0 +1,600 @@
+/**
+ * @file abcgBake.cpp
+ * @brief Offline asset baker.
+ *
+ * `abcg_bake` converts a source asset to a file that abcg::BakedAsset maps
+ * into memory without parsing:
+ *
+ * - Images (any format read by SDL_image) are converted to RGBA8, optionally
+ * flipped upside down, and stored with their whole mipmap chain, each level
+ * tightly packed and ready for `glTexImage2D` or a Vulkan staging buffer.
+ * - Wavefront OBJ meshes are triangulated and indexed, missing normals are
+ * computed, triangles are reordered for the post-transform vertex cache and
+ * vertices are reordered by first use, ready for `glBufferData`. Optionally,
+ * all normals are recomputed from the faces and the positions are centered
+ * and scaled to a bounding box with a diagonal of length 2, so that the
+ * application does not have to process the vertices after loading them.
+ *
+ * Usage:
+ *
+ *     abcg_bake [--no-flip] [--no-mipmaps] [--recompute-normals]
+ *               [--standardize] <input> <output>
+ *
+ * The build rules of cmake/ABCg.cmake run this tool on the assets of each
+ * target that uses ABCg.
+ *
+ * This file is part of ABCg (https://github.com/hbatagelo/abcg).
+ *
+ * @copyright (c) 2021--2022 Harlen Batagelo. All rights reserved.
+ * This project is released under the MIT License.
+ */
+
+#define SDL_MAIN_HANDLED
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL_image.h>
+#include <fmt/core.h>
+#include <glm/geometric.hpp>
+#include <gsl/gsl>
+#include <tiny_obj_loader.h>
+
+#include "abcgBakedAsset.hpp"
+#include "abcgException.hpp"
+#include "abcgImage.hpp"
+#include "abcgUtil.hpp"
+
+namespace {
+struct Options {
+  bool flipUpsideDown{true};
+  bool generateMipmaps{true};
+  bool recomputeNormals{};
+  bool standardize{};
+};
+
+struct Image {
+  std::uint32_t width{};
+  std::uint32_t height{};
+  std::vector<std::byte> texels;
+};
+
+struct Mesh {
+  std::vector<abcg::BakedVertex> vertices;
+  std::vector<std::uint32_t> indices;
+  bool computedNormals{};
+};
+
+struct VertexHash {
+  std::size_t operator()(abcg::BakedVertex const &vertex) const noexcept {
+    auto const &[position, normal, texCoord]{vertex};
+    return abcg::hashCombine(position.x, position.y, position.z, normal.x,
+                             normal.y, normal.z, texCoord.x, texCoord.y);
+  }
+};
+
+std::size_t alignUp(std::size_t offset) {
+  auto const alignment{abcg::bakedAssetAlignment};
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+void store(std::vector<std::byte> &file, std::size_t offset, T const &value) {
+  Expects(offset + sizeof(T) <= file.size());
+  std::memcpy(std::next(file.data(), gsl::narrow<std::ptrdiff_t>(offset)),
+              &value, sizeof(T));
+}
+
+void storeBytes(std::vector<std::byte> &file, std::size_t offset,
+                std::span<std::byte const> bytes) {
+  Expects(offset + bytes.size() <= file.size());
+  std::ranges::copy(
+      bytes, std::next(file.begin(), gsl::narrow<std::ptrdiff_t>(offset)));
+}
+
+abcg::BakedAssetHeader makeHeader(abcg::BakedAssetKind kind,
+                                  std::size_t fileSize, std::uint32_t flags) {
+  return {.magic = abcg::bakedAssetMagic,
+          .version = abcg::bakedAssetVersion,
+          .kind = kind,
+          .fileSize = fileSize,
+          .flags = flags,
+          .reserved = 0};
+}
+
+// Loads an image as tightly packed RGBA8 rows
+Image loadImage(std::string const &path, bool flipUpsideDown) {
+  SDL_Surface *const surface{IMG_Load(path.c_str())};
+  if (surface == nullptr) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to load image {} ({})", path, IMG_GetError()));
+  }
+  SDL_Surface *const formattedSurface{
+      SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0)};
+  SDL_FreeSurface(surface);
+  if (formattedSurface == nullptr) {
+    throw abcg::RuntimeError(fmt::format("Failed to convert image {}", path));
+  }
+
+  if (flipUpsideDown) {
+    abcg::flipVertically(formattedSurface);
+  }
+
+  Image image{.width = gsl::narrow<std::uint32_t>(formattedSurface->w),
+              .height = gsl::narrow<std::uint32_t>(formattedSurface->h),
+              .texels = {}};
+  auto const rowSize{std::size_t{image.width} * 4};
+  image.texels.resize(rowSize * image.height);
+  auto const *source{static_cast<std::byte const *>(formattedSurface->pixels)};
+  for (std::size_t row{}; row < image.height; ++row) {
+    std::memcpy(
+        std::next(image.texels.data(),
+                  gsl::narrow<std::ptrdiff_t>(row * rowSize)),
+        std::next(source, gsl::narrow<std::ptrdiff_t>(
+                              row * gsl::narrow<std::size_t>(
+                                        formattedSurface->pitch))),
+        rowSize);
+  }
+  SDL_FreeSurface(formattedSurface);
+  return image;
+}
+
+// Halves the dimensions of an image with a 2x2 box filter. The last row or
+// column of an odd dimension is clamped.
+Image downsample(Image const &source) {
+  Image target{.width = std::max(source.width / 2, 1U),
+               .height = std::max(source.height / 2, 1U),
+               .texels = {}};
+  target.texels.resize(std::size_t{target.width} * target.height * 4);
+
+  auto const texel{[&source](std::uint32_t x, std::uint32_t y,
+                             std::size_t channel) {
+    auto const index{(std::size_t{std::min(y, source.height - 1)} *
+                          source.width +
+                      std::min(x, source.width - 1)) *
+                         4 +
+                     channel};
+    return std::to_integer<unsigned>(source.texels[index]);
+  }};
+
+  for (std::uint32_t y{}; y < target.height; ++y) {
+    for (std::uint32_t x{}; x < target.width; ++x) {
+      for (std::size_t channel{}; channel < 4; ++channel) {
+        auto const sum{texel(2 * x, 2 * y, channel) +
+                       texel(2 * x + 1, 2 * y, channel) +
+                       texel(2 * x, 2 * y + 1, channel) +
+                       texel(2 * x + 1, 2 * y + 1, channel)};
+        target.texels[(std::size_t{y} * target.width + x) * 4 + channel] =
+            static_cast<std::byte>((sum + 2) / 4);
+      }
+    }
+  }
+  return target;
+}
+
+std::vector<std::byte> bakeTexture(std::string const &path,
+                                   Options const &options) {
+  std::vector<Image> levels;
+  levels.push_back(loadImage(path, options.flipUpsideDown));
+  while (options.generateMipmaps &&
+         (levels.back().width > 1 || levels.back().height > 1)) {
+    levels.push_back(downsample(levels.back()));
+  }
+
+  // Header, level table, then each level aligned
+  std::vector<abcg::BakedTextureLevel> table;
+  auto const tableOffset{sizeof(abcg::BakedAssetHeader) +
+                         sizeof(abcg::BakedTextureHeader)};
+  auto offset{alignUp(tableOffset +
+                      levels.size() * sizeof(abcg::BakedTextureLevel))};
+  for (auto const &level : levels) {
+    table.push_back({.width = level.width,
+                     .height = level.height,
+                     .offset = offset,
+                     .size = level.texels.size()});
+    offset = alignUp(offset + level.texels.size());
+  }
+  auto const fileSize{table.back().offset + table.back().size};
+
+  std::vector<std::byte> file(fileSize);
+  store(file, 0,
+        makeHeader(abcg::BakedAssetKind::Texture, fileSize,
+                   options.flipUpsideDown
+                       ? abcg::BakedAssetHeader::FlippedUpsideDown
+                       : 0U));
+  store(file, sizeof(abcg::BakedAssetHeader),
+        abcg::BakedTextureHeader{
+            .format = static_cast<std::uint32_t>(abcg::TextureFormat::RGBA8),
+            .width = levels.front().width,
+            .height = levels.front().height,
+            .levelCount = gsl::narrow<std::uint32_t>(levels.size())});
+  for (std::size_t index{}; index < levels.size(); ++index) {
+    store(file, tableOffset + index * sizeof(abcg::BakedTextureLevel),
+          table[index]);
+    storeBytes(file, table[index].offset, levels[index].texels);
+  }
+  return file;
+}
+
+// Loads an OBJ file as an indexed triangle mesh, merging identical vertices.
+// If recomputeNormals is true, the normals of the file are used only to merge
+// the vertices, and the normals of all vertices are computed from the faces
+Mesh loadObj(std::string const &path, bool recomputeNormals) {
+  tinyobj::ObjReaderConfig readerConfig;
+  readerConfig.mtl_search_path =
+      std::filesystem::path{path}.parent_path().string();
+
+  tinyobj::ObjReader reader;
+  if (!reader.ParseFromFile(path, readerConfig)) {
+    throw abcg::RuntimeError(
+        fmt::format("Failed to load model {} ({})", path, reader.Error()));
+  }
+  if (!reader.Warning().empty()) {
+    fmt::print(stderr, "Warning: {}\n", reader.Warning());
+  }
+
+  auto const &attrib{reader.GetAttrib()};
+  Mesh mesh;
+  std::vector<bool> missingNormals;
+  std::unordered_map<abcg::BakedVertex, std::uint32_t, VertexHash> hash;
+
+  for (auto const &shape : reader.GetShapes()) {
+    for (auto const &index : shape.mesh.indices) {
+      abcg::BakedVertex vertex{};
+      auto const position{3 * gsl::narrow<std::size_t>(index.vertex_index)};
+      vertex.position = {attrib.vertices.at(position + 0),
+                         attrib.vertices.at(position + 1),
+                         attrib.vertices.at(position + 2)};
+      if (index.normal_index >= 0) {
+        auto const normal{3 * gsl::narrow<std::size_t>(index.normal_index)};
+        vertex.normal = {attrib.normals.at(normal + 0),
+                         attrib.normals.at(normal + 1),
+                         attrib.normals.at(normal + 2)};
+      }
+      if (index.texcoord_index >= 0) {
+        auto const texCoord{2 *
+                            gsl::narrow<std::size_t>(index.texcoord_index)};
+        vertex.texCoord = {attrib.texcoords.at(texCoord + 0),
+                           attrib.texcoords.at(texCoord + 1)};
+      }
+
+      auto [iter, inserted]{hash.try_emplace(
+          vertex, gsl::narrow<std::uint32_t>(mesh.vertices.size()))};
+      if (inserted) {
+        mesh.vertices.push_back(vertex);
+        missingNormals.push_back(recomputeNormals || index.normal_index < 0);
+      }
+      mesh.indices.push_back(iter->second);
+    }
+  }
+
+  // Accumulate the face normals on the vertices without a normal, or on all
+  // vertices if the normals are recomputed
+  if (std::ranges::find(missingNormals, true) != missingNormals.end()) {
+    mesh.computedNormals = true;
+    for (std::size_t vertex{}; vertex < mesh.vertices.size(); ++vertex) {
+      if (missingNormals[vertex]) {
+        mesh.vertices[vertex].normal = {};
+      }
+    }
+    for (std::size_t offset{}; offset + 2 < mesh.indices.size(); offset += 3) {
+      auto const a{mesh.indices[offset + 0]};
+      auto const b{mesh.indices[offset + 1]};
+      auto const c{mesh.indices[offset + 2]};
+      auto const normal{glm::cross(
+          mesh.vertices[b].position - mesh.vertices[a].position,
+          mesh.vertices[c].position - mesh.vertices[a].position)};
+      for (auto const vertex : {a, b, c}) {
+        if (missingNormals[vertex]) {
+          mesh.vertices[vertex].normal += normal;
+        }
+      }
+    }
+    for (std::size_t vertex{}; vertex < mesh.vertices.size(); ++vertex) {
+      auto &normal{mesh.vertices[vertex].normal};
+      if (auto const length{glm::length(normal)};
+          missingNormals[vertex] && length > 0.0f) {
+        normal /= length;
+      }
+    }
+  }
+  return mesh;
+}
+
+// Centers the positions on their bounding box and scales them so that the
+// diagonal of the box has length 2
+void standardize(Mesh &mesh) {
+  glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+  glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+  for (auto const &vertex : mesh.vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+
+  auto const center{(boundsMin + boundsMax) / 2.0f};
+  auto const scaling{2.0f / glm::length(boundsMax - boundsMin)};
+  for (auto &vertex : mesh.vertices) {
+    vertex.position = (vertex.position - center) * scaling;
+  }
+}
+
+// Score of a vertex in the vertex cache optimization of T. Forsyth, "Linear-
+// Speed Vertex Cache Optimisation" (2006)
+constexpr int cacheSize{32};
+
+float getVertexScore(int cachePosition, std::size_t remainingTriangles) {
+  if (remainingTriangles == 0)
+    return -1.0f;
+  auto score{0.0f};
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      // Vertices of the last triangle get a fixed score, so that strips are
+      // not favored over fans
+      score = 0.75f;
+    } else {
+      auto const scale{1.0f / static_cast<float>(cacheSize - 3)};
+      score = std::pow(
+          1.0f - static_cast<float>(cachePosition - 3) * scale, 1.5f);
+    }
+  }
+  // Favor vertices with few triangles left, so that they leave the cache soon
+  score += 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+  return score;
+}
+
+// Reorders the triangles so that consecutive triangles reuse the vertices that
+// are still in the post-transform vertex cache
+std::vector<std::uint32_t>
+optimizeVertexCache(std::vector<std::uint32_t> const &indices,
+                    std::size_t vertexCount) {
+  auto const triangleCount{indices.size() / 3};
+  auto const corners{[&indices](std::size_t triangle) {
+    return std::span{indices}.subspan(triangle * 3, 3);
+  }};
+
+  // Triangles not emitted yet of each vertex
+  std::vector<std::vector<std::size_t>> trianglesOf(vertexCount);
+  for (std::size_t triangle{}; triangle < triangleCount; ++triangle) {
+    for (auto const vertex : corners(triangle)) {
+      trianglesOf[vertex].push_back(triangle);
+    }
+  }
+
+  std::vector<int> cachePositions(vertexCount, -1);
+  std::vector<float> vertexScores(vertexCount);
+  for (std::size_t vertex{}; vertex < vertexCount; ++vertex) {
+    vertexScores[vertex] = getVertexScore(-1, trianglesOf[vertex].size());
+  }
+
+  std::vector<float> triangleScores(triangleCount);
+  std::vector<bool> emitted(triangleCount);
+  auto const scoreTriangle{[&](std::size_t triangle) {
+    auto score{0.0f};
+    for (auto const vertex : corners(triangle)) {
+      score += vertexScores[vertex];
+    }
+    triangleScores[triangle] = score;
+  }};
+  for (std::size_t triangle{}; triangle < triangleCount; ++triangle) {
+    scoreTriangle(triangle);
+  }
+
+  std::vector<std::uint32_t> optimized;
+  optimized.reserve(indices.size());
+  std::vector<std::uint32_t> cache;
+  std::vector<std::uint32_t> nextCache;
+  std::optional<std::size_t> best;
+
+  while (optimized.size() < triangleCount * 3) {
+    if (!best) {
+      // No triangle left around the cached vertices: restart from the best
+      // remaining triangle
+      for (std::size_t triangle{}; triangle < triangleCount; ++triangle) {
+        if (!emitted[triangle] &&
+            (!best || triangleScores[triangle] > triangleScores[*best])) {
+          best = triangle;
+        }
+      }
+    }
+
+    emitted[*best] = true;
+    nextCache.clear();
+    for (auto const vertex : corners(*best)) {
+      optimized.push_back(vertex);
+      std::erase(trianglesOf[vertex], *best);
+      if (std::ranges::find(nextCache, vertex) == nextCache.end()) {
+        nextCache.push_back(vertex);
+      }
+    }
+    for (auto const vertex : cache) {
+      if (std::ranges::find(nextCache, vertex) == nextCache.end()) {
+        nextCache.push_back(vertex);
+      }
+    }
+
+    // Update the scores of the vertices that entered, moved in or left the
+    // cache, then pick the best triangle around the cached vertices
+    for (std::size_t position{}; position < nextCache.size(); ++position) {
+      auto const vertex{nextCache[position]};
+      cachePositions[vertex] =
+          position < cacheSize ? gsl::narrow<int>(position) : -1;
+      vertexScores[vertex] = getVertexScore(cachePositions[vertex],
+                                            trianglesOf[vertex].size());
+    }
+    best.reset();
+    for (auto const vertex : nextCache) {
+      for (auto const triangle : trianglesOf[vertex]) {
+        scoreTriangle(triangle);
+        if (cachePositions[vertex] >= 0 &&
+            (!best || triangleScores[triangle] > triangleScores[*best])) {
+          best = triangle;
+        }
+      }
+    }
+
+    nextCache.resize(std::min<std::size_t>(nextCache.size(), cacheSize));
+    cache.swap(nextCache);
+  }
+  return optimized;
+}
+
+// Reorders the vertices by first use in the index buffer and drops unused
+// vertices, so that vertex fetches are mostly sequential
+void optimizeVertexFetch(Mesh &mesh) {
+  auto constexpr unused{std::numeric_limits<std::uint32_t>::max()};
+  std::vector<std::uint32_t> remap(mesh.vertices.size(), unused);
+  std::vector<abcg::BakedVertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+  for (auto &index : mesh.indices) {
+    auto &target{remap[index]};
+    if (target == unused) {
+      target = gsl::narrow<std::uint32_t>(vertices.size());
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = target;
+  }
+  mesh.vertices = std::move(vertices);
+}
+
+std::vector<std::byte> bakeMesh(std::string const &path,
+                                Options const &options) {
+  auto mesh{loadObj(path, options.recomputeNormals)};
+  if (options.standardize && !mesh.vertices.empty()) {
+    standardize(mesh);
+  }
+  mesh.indices = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+  optimizeVertexFetch(mesh);
+  if (mesh.indices.empty()) {
+    throw abcg::RuntimeError(fmt::format("Model {} has no triangles", path));
+  }
+
+  abcg::BakedMeshHeader header{
+      .vertexCount = gsl::narrow<std::uint32_t>(mesh.vertices.size()),
+      .indexCount = gsl::narrow<std::uint32_t>(mesh.indices.size()),
+      .vertexStride = sizeof(abcg::BakedVertex),
+      .indexSize = sizeof(std::uint32_t),
+      .vertexOffset = 0,
+      .indexOffset = 0,
+      .boundsMin = {},
+      .boundsMax = {}};
+  auto boundsMin{mesh.vertices.front().position};
+  auto boundsMax{boundsMin};
+  for (auto const &vertex : mesh.vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+  header.boundsMin = {boundsMin.x, boundsMin.y, boundsMin.z};
+  header.boundsMax = {boundsMax.x, boundsMax.y, boundsMax.z};
+
+  auto const vertexBytes{std::as_bytes(std::span{mesh.vertices})};
+  auto const indexBytes{std::as_bytes(std::span{mesh.indices})};
+  header.vertexOffset = alignUp(sizeof(abcg::BakedAssetHeader) +
+                                sizeof(abcg::BakedMeshHeader));
+  header.indexOffset = alignUp(header.vertexOffset + vertexBytes.size());
+  auto const fileSize{header.indexOffset + indexBytes.size()};
+
+  std::uint32_t flags{};
+  if (mesh.computedNormals) {
+    flags |= abcg::BakedAssetHeader::ComputedNormals;
+  }
+  if (options.recomputeNormals) {
+    flags |= abcg::BakedAssetHeader::RecomputedNormals;
+  }
+  if (options.standardize) {
+    flags |= abcg::BakedAssetHeader::Standardized;
+  }
+
+  std::vector<std::byte> file(fileSize);
+  store(file, 0, makeHeader(abcg::BakedAssetKind::Mesh, fileSize, flags));
+  store(file, sizeof(abcg::BakedAssetHeader), header);
+  storeBytes(file, header.vertexOffset, vertexBytes);
+  storeBytes(file, header.indexOffset, indexBytes);
+  return file;
+}
+
+void writeFile(std::filesystem::path const &path,
+               std::span<std::byte const> bytes) {
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path());
+  }
+  std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+  stream.write(reinterpret_cast<char const *>(bytes.data()),
+               gsl::narrow<std::streamsize>(bytes.size()));
+  stream.close();
+  if (!stream) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    throw abcg::RuntimeError(
+        fmt::format("Failed to write {}", path.string()));
+  }
+}
+
+void printUsage() {
+  fmt::print(stderr,
+             "Usage: abcg_bake [--no-flip] [--no-mipmaps] "
+             "[--recompute-normals]\n"
+             "                 [--standardize] <input> <output>\n"
+             "\n"
+             "Bakes an image or a Wavefront OBJ mesh for abcg::BakedAsset.\n"
+             "  --no-flip            Do not flip the rows of an image upside "
+             "down\n"
+             "  --no-mipmaps         Store only the base level of an image\n"
+             "  --recompute-normals  Compute all normals of a mesh from its "
+             "faces\n"
+             "  --standardize        Center a mesh and scale it to a diagonal "
+             "of 2\n");
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    Options options;
+    std::vector<std::string> paths;
+    for (std::string_view const arg :
+         std::span{argv, gsl::narrow<std::size_t>(argc)}.subspan(1)) {
+      if (arg == "--no-flip") {
+        options.flipUpsideDown = false;
+      } else if (arg == "--no-mipmaps") {
+        options.generateMipmaps = false;
+      } else if (arg == "--recompute-normals") {
+        options.recomputeNormals = true;
+      } else if (arg == "--standardize") {
+        options.standardize = true;
+      } else if (arg.starts_with("--")) {
+        throw abcg::RuntimeError(fmt::format("Unknown option {}", arg));
+      } else {
+        paths.emplace_back(arg);
+      }
+    }
+    if (paths.size() != 2) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+
+    auto const &input{paths.front()};
+    auto extension{std::filesystem::path{input}.extension().string()};
+    std::ranges::transform(extension, extension.begin(),
+                           [](unsigned char character) {
+                             return static_cast<char>(std::tolower(character));
+                           });
+    auto const file{extension == ".obj" ? bakeMesh(input, options)
+                                        : bakeTexture(input, options)};
+    writeFile(paths.back(), file);
+  } catch (std::exception const &exception) {
+    fmt::print(stderr, "abcg_bake: {}\n", exception.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}